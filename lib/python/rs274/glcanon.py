@@ -82,6 +82,11 @@ limiticon = array.array('B',
 
 class GLCanon(Translated, ArcsToSegmentsMixin):
     lineno = -1
+    # merge consecutive colinear preview vertices when compiling the
+    # program display lists; off by default because the colinearity
+    # tolerance does not depend on the view, so merged vertices can show
+    # when zoomed in far enough
+    decimate_preview = False
     def __init__(self, colors, geometry, is_foam=0):
         # traverse list of tuples - [(line number, (start position), (end position), (tlo x, tlo y, tlo z))]
         self.traverse = []; self.traverse_append = self.traverse.append
@@ -182,7 +187,8 @@ class GLCanon(Translated, ArcsToSegmentsMixin):
         self.lineno = self.state.sequence_number
 
     def draw_lines(self, lines, for_selection, j=0, geometry=None):
-        return linuxcnc.draw_lines(geometry or self.geometry, lines, for_selection)
+        return linuxcnc.draw_lines(geometry or self.geometry, lines, for_selection,
+                self.decimate_preview)
 
     def colored_lines(self, color, lines, for_selection, j=0):
         if self.is_foam:
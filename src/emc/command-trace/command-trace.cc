@@ -0,0 +1,437 @@
+/********************************************************************
+* Description: command-trace.cc
+*   Drains the command trace ring of motion (see emc/motion/cmdtrace.h)
+*   and writes what it collected as a Chrome trace, for Perfetto
+*   (ui.perfetto.dev) or chrome://tracing.
+*
+*   Each command a user interface sent becomes an async slice from its
+*   first hop to its last one, cut into the stages between the hops:
+*
+*     to task          user interface wrote it .. task read it
+*     task plan        .. task issued it
+*     task issue       .. usrmot wrote the first motion command for it
+*     to servo thread  .. the motion command handler took that
+*     command handler  .. the handler was done with it
+*     motion queue     .. the first segment queued for it started
+*     echo             .. the user interface saw task echo the serial
+*
+*   Only the first of each hop counts, so for a program run the slice
+*   ends where its first segment starts.  Every motion command gets a
+*   slice of its own as well, and each hop is an instant event on the
+*   track of the process that stamped it.
+*
+*   Motion only sees the motion id of the segment that starts; that is
+*   matched to the oldest queued move with that id.  Consecutive
+*   segments with the same id (canned cycles) start unnoticed.
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+********************************************************************/
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "rtapi.h"
+#include "emc.hh"		// emcSymbolLookup()
+#include "motion.h"		// cmd_code_t, cmd_status_t
+#include "cmdtrace.h"
+
+static volatile sig_atomic_t done;
+
+static void quit(int sig)
+{
+    done = 1;
+}
+
+static const char *hop_names[CMDTRACE_HOPS] = {
+    NULL, "gui write", "task read", "task issue", "usrmot write",
+    "motion receive", "motion done", "segment start", "gui echo"
+};
+
+/* the stage that ends with each hop */
+static const char *stage_names[CMDTRACE_HOPS] = {
+    NULL, NULL, "to task", "task plan", "task issue", "to servo thread",
+    "command handler", "motion queue", "echo"
+};
+
+static const char *motion_name(int command)
+{
+    switch (command) {
+#define NAME(c) case c: return #c
+	NAME(EMCMOT_ABORT); NAME(EMCMOT_ENABLE);
+	NAME(EMCMOT_DISABLE); NAME(EMCMOT_PAUSE);
+	NAME(EMCMOT_REVERSE); NAME(EMCMOT_FORWARD);
+	NAME(EMCMOT_RESUME); NAME(EMCMOT_STEP);
+	NAME(EMCMOT_FREE); NAME(EMCMOT_COORD);
+	NAME(EMCMOT_TELEOP); NAME(EMCMOT_SPINDLE_SCALE);
+	NAME(EMCMOT_SS_ENABLE); NAME(EMCMOT_FEED_SCALE);
+	NAME(EMCMOT_RAPID_SCALE); NAME(EMCMOT_FS_ENABLE);
+	NAME(EMCMOT_FH_ENABLE); NAME(EMCMOT_AF_ENABLE);
+	NAME(EMCMOT_OVERRIDE_LIMITS); NAME(EMCMOT_SET_LINE);
+	NAME(EMCMOT_SET_CIRCLE); NAME(EMCMOT_SET_TELEOP_VECTOR);
+	NAME(EMCMOT_CLEAR_PROBE_FLAGS); NAME(EMCMOT_PROBE);
+	NAME(EMCMOT_RIGID_TAP); NAME(EMCMOT_SET_VEL);
+	NAME(EMCMOT_SET_VEL_LIMIT); NAME(EMCMOT_SET_ACC);
+	NAME(EMCMOT_SET_JERK); NAME(EMCMOT_SET_TERM_COND);
+	NAME(EMCMOT_SET_NUM_JOINTS); NAME(EMCMOT_SET_NUM_SPINDLES);
+	NAME(EMCMOT_SET_WORLD_HOME); NAME(EMCMOT_SET_DEBUG);
+	NAME(EMCMOT_SET_DOUT); NAME(EMCMOT_SET_AOUT);
+	NAME(EMCMOT_SET_SPINDLESYNC); NAME(EMCMOT_SPINDLE_ON);
+	NAME(EMCMOT_SPINDLE_OFF); NAME(EMCMOT_SPINDLE_INCREASE);
+	NAME(EMCMOT_SPINDLE_DECREASE); NAME(EMCMOT_SPINDLE_BRAKE_ENGAGE);
+	NAME(EMCMOT_SPINDLE_BRAKE_RELEASE); NAME(EMCMOT_SPINDLE_ORIENT);
+	NAME(EMCMOT_SET_OFFSET); NAME(EMCMOT_SET_MAX_FEED_OVERRIDE);
+	NAME(EMCMOT_SET_JOINT_LIMIT_SAMPLES); NAME(EMCMOT_SETUP_ARC_BLENDS);
+	NAME(EMCMOT_SET_PROBE_ERR_INHIBIT); NAME(EMCMOT_ENABLE_WATCHDOG);
+	NAME(EMCMOT_DISABLE_WATCHDOG); NAME(EMCMOT_JOG_CONT);
+	NAME(EMCMOT_JOG_INCR); NAME(EMCMOT_JOG_ABS);
+	NAME(EMCMOT_JOG_ABORT); NAME(EMCMOT_JOINT_ACTIVATE);
+	NAME(EMCMOT_JOINT_DEACTIVATE); NAME(EMCMOT_JOINT_ENABLE_AMPLIFIER);
+	NAME(EMCMOT_JOINT_DISABLE_AMPLIFIER); NAME(EMCMOT_JOINT_HOME);
+	NAME(EMCMOT_JOINT_UNHOME); NAME(EMCMOT_SET_JOINT_POSITION_LIMITS);
+	NAME(EMCMOT_SET_JOINT_BACKLASH); NAME(EMCMOT_SET_JOINT_MIN_FERROR);
+	NAME(EMCMOT_SET_JOINT_MAX_FERROR); NAME(EMCMOT_SET_JOINT_VEL_LIMIT);
+	NAME(EMCMOT_SET_JOINT_ACC_LIMIT); NAME(EMCMOT_SET_JOINT_HOMING_PARAMS);
+	NAME(EMCMOT_UPDATE_JOINT_HOMING_PARAMS); NAME(EMCMOT_SET_JOINT_MOTOR_OFFSET);
+	NAME(EMCMOT_SET_JOINT_COMP); NAME(EMCMOT_SET_AXIS_POSITION_LIMITS);
+	NAME(EMCMOT_SET_AXIS_VEL_LIMIT); NAME(EMCMOT_SET_AXIS_ACC_LIMIT);
+	NAME(EMCMOT_SET_AXIS_JERK_LIMIT); NAME(EMCMOT_SET_AXIS_LOCKING_JOINT);
+	NAME(EMCMOT_SET_SPINDLE_PARAMS);
+#undef NAME
+    }
+    return "EMCMOT_UNKNOWN";
+}
+
+static bool queues_segment(int command)
+{
+    return command == EMCMOT_SET_LINE || command == EMCMOT_SET_CIRCLE ||
+	command == EMCMOT_PROBE || command == EMCMOT_RIGID_TAP;
+}
+
+struct chain {
+    std::string name;
+    int serial;
+    int command;
+    const cmdtrace_event *hop[CMDTRACE_HOPS];	// first of each, or NULL
+
+    chain() : serial(0), command(0), hop() {}
+    void add(const cmdtrace_event &e) {
+	if (!hop[e.hop]) {
+	    hop[e.hop] = &e;
+	}
+    }
+};
+
+struct stage_stats {
+    long count;
+    double total, max;		// msec
+};
+
+static std::map<int, std::string> process_names;
+static stage_stats stats[CMDTRACE_HOPS];
+static long long t0;
+static bool first_event = true;
+
+static void name_process(int pid)
+{
+    char path[64], name[64] = "";
+
+    if (process_names.count(pid)) {
+	return;
+    }
+    if (pid == 0) {
+	process_names[pid] = "motion";
+	return;
+    }
+    snprintf(path, sizeof(path), "/proc/%d/comm", pid);
+    FILE *f = fopen(path, "r");
+    if (f) {
+	if (fgets(name, sizeof(name), f)) {
+	    name[strcspn(name, "\n")] = '\0';
+	}
+	fclose(f);
+    }
+    process_names[pid] = name[0] ? name : "pid " + std::to_string(pid);
+}
+
+/* starts the next event of traceEvents, up to its args */
+static void event(FILE *f, const char *ph, const char *cat, const char *name,
+		  long long time, int pid)
+{
+    fprintf(f, "%s\n{\"ph\":\"%s\",\"cat\":\"%s\",\"name\":\"%s\",\"ts\":%.3f,"
+	    "\"pid\":%d,\"tid\":%d", first_event ? "" : ",", ph, cat, name,
+	    (time - t0) / 1e3, pid, pid);
+    first_event = false;
+}
+
+static void hop_event(FILE *f, const cmdtrace_event &e)
+{
+    const char *type = NULL;
+
+    if (e.hop >= CMDTRACE_MOTION_WRITE && e.hop <= CMDTRACE_MOTION_DONE) {
+	type = motion_name(e.type);
+    } else if (e.type) {
+	type = emcSymbolLookup(e.type);
+    }
+    event(f, "i", "hop", hop_names[e.hop], e.time, e.pid);
+    fprintf(f, ",\"s\":\"t\",\"args\":{\"serial\":%d,\"command\":%d",
+	    e.serial, e.command);
+    if (type) {
+	fprintf(f, ",\"type\":\"%s\"", type);
+    }
+    if (e.hop == CMDTRACE_TP_START || e.hop == CMDTRACE_MOTION_RECEIVE) {
+	fprintf(f, ",\"id\":%d", e.arg);
+    } else if (e.hop == CMDTRACE_MOTION_DONE) {
+	fprintf(f, ",\"status\":%d", e.arg);
+    }
+    fprintf(f, "}}");
+}
+
+static bool earlier(const cmdtrace_event *a, const cmdtrace_event *b)
+{
+    return a->time < b->time;
+}
+
+/* an async slice for the chain with one nested slice per stage */
+static void chain_events(FILE *f, const chain &c, const char *cat, char kind,
+			 int id, bool count)
+{
+    std::vector<const cmdtrace_event *> hops;
+    char ids[32];
+
+    for (int h = 1; h < CMDTRACE_HOPS; h++) {
+	if (c.hop[h]) {
+	    hops.push_back(c.hop[h]);
+	}
+    }
+    if (hops.size() < 2) {
+	return;
+    }
+    std::stable_sort(hops.begin(), hops.end(), earlier);
+    int pid = hops[0]->pid;
+    snprintf(ids, sizeof(ids), ",\"id\":\"%c%d\"", kind, id);
+
+    event(f, "b", cat, c.name.c_str(), hops[0]->time, pid);
+    fprintf(f, "%s,\"args\":{\"serial\":%d,\"command\":%d,\"msec\":%.3f}}",
+	    ids, c.serial, c.command,
+	    (hops.back()->time - hops[0]->time) / 1e6);
+    for (size_t i = 1; i < hops.size(); i++) {
+	const char *stage = stage_names[hops[i]->hop];
+	event(f, "b", cat, stage, hops[i - 1]->time, pid);
+	fprintf(f, "%s}", ids);
+	event(f, "e", cat, stage, hops[i]->time, pid);
+	fprintf(f, "%s}", ids);
+	if (count) {
+	    stage_stats &s = stats[hops[i]->hop];
+	    double ms = (hops[i]->time - hops[i - 1]->time) / 1e6;
+	    s.count++;
+	    s.total += ms;
+	    s.max = std::max(s.max, ms);
+	}
+    }
+    event(f, "e", cat, c.name.c_str(), hops.back()->time, pid);
+    fprintf(f, "%s}", ids);
+}
+
+static bool by_time(const cmdtrace_event &a, const cmdtrace_event &b)
+{
+    return a.time < b.time;
+}
+
+static int write_trace(FILE *f, std::vector<cmdtrace_event> &events)
+{
+    std::map<int, chain> serials, commands;
+    std::deque<std::pair<int, int> > segments;	// queued (command, id)
+
+    std::stable_sort(events.begin(), events.end(), by_time);
+    t0 = events.empty() ? 0 : events[0].time;
+
+    for (const cmdtrace_event &e : events) {
+	chain *m = NULL;
+	int serial = e.serial;
+
+	if (e.hop <= 0 || e.hop >= CMDTRACE_HOPS) {
+	    continue;
+	}
+	if (e.command) {
+	    m = &commands[e.command];
+	    if (m->command == 0) {
+		m->command = e.command;
+		m->serial = e.serial;
+		m->name = std::string(motion_name(e.type)) + " #" +
+		    std::to_string(e.command);
+	    }
+	    serial = m->serial;
+	}
+	if (e.hop == CMDTRACE_MOTION_RECEIVE && e.type == EMCMOT_ABORT) {
+	    segments.clear();	// nothing queued before will start
+	}
+	if (e.hop == CMDTRACE_MOTION_DONE && e.arg == EMCMOT_COMMAND_OK &&
+	    queues_segment(e.type) && m->hop[CMDTRACE_MOTION_RECEIVE]) {
+	    segments.push_back(std::make_pair(e.command,
+		m->hop[CMDTRACE_MOTION_RECEIVE]->arg));
+	}
+	if (e.hop == CMDTRACE_TP_START) {
+	    auto it = segments.begin();
+	    while (it != segments.end() && it->second != e.arg) {
+		++it;
+	    }
+	    if (it == segments.end()) {
+		continue;
+	    }
+	    m = &commands[it->first];
+	    serial = m->serial;
+	    segments.erase(segments.begin(), it + 1);
+	}
+	if (m) {
+	    m->add(e);
+	}
+	if (serial) {
+	    chain &c = serials[serial];
+	    c.serial = serial;
+	    if (c.name.empty() && !e.command && e.type) {
+		c.name = std::string(emcSymbolLookup(e.type)) + " #" +
+		    std::to_string(serial);
+	    }
+	    c.add(e);
+	}
+    }
+
+    fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (auto &p : process_names) {
+	fprintf(f, "%s\n{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%d,"
+		"\"args\":{\"name\":\"%s\"}}", first_event ? "" : ",",
+		p.first, p.second.c_str());
+	first_event = false;
+    }
+    for (const cmdtrace_event &e : events) {
+	if (e.hop > 0 && e.hop < CMDTRACE_HOPS) {
+	    hop_event(f, e);
+	}
+    }
+    for (auto &p : serials) {
+	if (p.second.name.empty()) {
+	    p.second.name = "#" + std::to_string(p.first);
+	}
+	chain_events(f, p.second, "command", 's', p.first, true);
+    }
+    for (auto &p : commands) {
+	chain_events(f, p.second, "motion", 'm', p.first, false);
+    }
+    fprintf(f, "\n]}\n");
+
+    fprintf(stderr, "command-trace: %zu events, %zu commands, %zu motion commands\n",
+	    events.size(), serials.size(), commands.size());
+    for (int h = 1; h < CMDTRACE_HOPS; h++) {
+	const stage_stats &s = stats[h];
+	if (stage_names[h] && s.count) {
+	    fprintf(stderr, "  %-16s %6ld  %9.3f ms average  %9.3f ms max\n",
+		    stage_names[h], s.count, s.total / s.count, s.max);
+	}
+    }
+    return ferror(f) ? -1 : 0;
+}
+
+static int trace(const char *path, int oldest, double seconds, int poll_ms)
+{
+    struct cmdtrace *t;
+    struct cmdtrace_reader rd;
+    struct cmdtrace_event e;
+    std::vector<cmdtrace_event> events;
+    long long end = 0;
+    FILE *f;
+
+    t = cmdtrace_attach();
+    if (!t) {
+	fprintf(stderr, "command-trace: no command trace, is motmod loaded with cmdtrace=1?\n");
+	return 1;
+    }
+    f = strcmp(path, "-") ? fopen(path, "w") : stdout;
+    if (!f) {
+	fprintf(stderr, "command-trace: %s: %s\n", path, strerror(errno));
+	cmdtrace_detach();
+	return 1;
+    }
+    if (seconds > 0) {
+	end = cmdtrace_now() + (long long) (seconds * 1e9);
+    }
+
+    signal(SIGINT, quit);
+    signal(SIGTERM, quit);
+    cmdtrace_reader_init(t, &rd, oldest);
+    while (!done && (end == 0 || cmdtrace_now() < end)) {
+	if (cmdtrace_read(t, &rd, &e) < 0) {
+	    usleep(poll_ms * 1000);
+	    continue;
+	}
+	name_process(e.pid);
+	events.push_back(e);
+    }
+    cmdtrace_detach();
+
+    int retval = write_trace(f, events);
+    if (retval < 0) {
+	fprintf(stderr, "command-trace: %s: %s\n", path, strerror(errno));
+    }
+    if (f != stdout) {
+	fclose(f);
+    } else {
+	fflush(f);
+    }
+    if (rd.lost) {
+	fprintf(stderr, "command-trace: %u events lost\n", rd.lost);
+	return 2;
+    }
+    return retval < 0 ? 1 : 0;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+	    "usage: command-trace [-a] [-t seconds] [-p poll_ms] file\n"
+	    "Collects the hops of each command (motmod cmdtrace=1) until\n"
+	    "interrupted and writes them to file, '-' for stdout, as a Chrome trace.\n"
+	    "  -a  start with the oldest events still in the ring\n");
+}
+
+int main(int argc, char **argv)
+{
+    int opt, oldest = 0, poll_ms = 10;
+    double seconds = 0;
+
+    while ((opt = getopt(argc, argv, "at:p:h")) != -1) {
+	switch (opt) {
+	case 'a':
+	    oldest = 1;
+	    break;
+	case 't':
+	    seconds = atof(optarg);
+	    break;
+	case 'p':
+	    poll_ms = atoi(optarg);
+	    if (poll_ms < 1) {
+		poll_ms = 1;
+	    }
+	    break;
+	default:
+	    usage();
+	    return 1;
+	}
+    }
+    if (optind != argc - 1) {
+	usage();
+	return 1;
+    }
+    return trace(argv[optind], oldest, seconds, poll_ms);
+}
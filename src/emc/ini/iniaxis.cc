@@ -44,6 +44,7 @@ double ext_offset_a_or_v_ratio[EMCMOT_MAX_AXIS]; // all zero
   TYPE <LINEAR ANGULAR>        type of axis (hardcoded: X,Y,Z,U,V,W: LINEAR, A,B,C: ANGULAR)
   MAX_VELOCITY <float>         max vel for axis
   MAX_ACCELERATION <float>     max accel for axis
+  MAX_JERK <float>             max jerk for axis, 0 for no limit
   MIN_LIMIT <float>            minimum soft position limit
   MAX_LIMIT <float>            maximum soft position limit
 
@@ -53,6 +54,7 @@ double ext_offset_a_or_v_ratio[EMCMOT_MAX_AXIS]; // all zero
   emcAxisSetMaxPositionLimit(int axis, double limit);
   emcAxisSetMaxVelocity(int axis, double vel, double ext_offset_vel);
   emcAxisSetMaxAcceleration(int axis, double acc, double ext_offset_acc);
+  emcAxisSetMaxJerk(int axis, double jerk);
   */
 
 static int loadAxis(int axis, EmcIniFile *axisIniFile)
@@ -61,6 +63,7 @@ static int loadAxis(int axis, EmcIniFile *axisIniFile)
     double limit;
     double maxVelocity;
     double maxAcceleration;
+    double maxJerk;
     int    lockingjnum = -1; // -1 ==> locking joint not used
 
     // compose string to match, axis = 0 -> AXIS_X etc.
@@ -142,6 +145,16 @@ static int loadAxis(int axis, EmcIniFile *axisIniFile)
         }
         old_inihal_data.axis_max_acceleration[axis] = maxAcceleration;
 
+        // set maximum jerk for axis, 0 leaves it to [TRAJ]MAX_JERK
+        maxJerk = 0.0;
+        axisIniFile->Find(&maxJerk, "MAX_JERK", axisString);
+        if (0 != emcAxisSetMaxJerk(axis, maxJerk)) {
+            if (emc_debug & EMC_DEBUG_CONFIG) {
+                rcs_print_error("bad return from emcAxisSetMaxJerk\n");
+            }
+            return -1;
+        }
+
         axisIniFile->Find(&lockingjnum, "LOCKING_INDEXER_JOINT", axisString);
         if (0 != emcAxisSetLockingJoint(axis, lockingjnum)) {
             if (emc_debug & EMC_DEBUG_CONFIG) {
@@ -72,6 +72,8 @@ static int loadKins(EmcIniFile *trajInifile)
   MAX_LINEAR_VELOCITY <float>     max linear velocity
   DEFAULT_LINEAR_ACCELERATION <float> default linear acceleration
   MAX_LINEAR_ACCELERATION <float>     max linear acceleration
+  MAX_JERK <float>                max jerk along the path, 0 for no limit
+  JOINT_LIMIT_SAMPLES <int>       kinematics samples per move for joint limits
 
   calls:
 
@@ -81,6 +83,8 @@ static int loadKins(EmcIniFile *trajInifile)
   emcTrajSetAcceleration(double acc);
   emcTrajSetMaxVelocity(double vel);
   emcTrajSetMaxAcceleration(double acc);
+  emcTrajSetMaxJerk(double jerk);
+  emcSetJointLimitSamples(int samples);
   */
 
 static int loadTraj(EmcIniFile *trajInifile)
@@ -201,6 +205,15 @@ static int loadTraj(EmcIniFile *trajInifile)
         }
         old_inihal_data.traj_max_acceleration = acc;
 
+        double jerk = 0.0; // no jerk limit unless asked for
+        trajInifile->Find(&jerk, "MAX_JERK", "TRAJ");
+        if (0 != emcTrajSetMaxJerk(jerk)) {
+            if (emc_debug & EMC_DEBUG_CONFIG) {
+                rcs_print("bad return value from emcTrajSetMaxJerk\n");
+            }
+            return -1;
+        }
+
         int arcBlendEnable = 1;
         int arcBlendFallbackEnable = 0;
         int arcBlendOptDepth = 50;
@@ -240,6 +253,16 @@ static int loadTraj(EmcIniFile *trajInifile)
             }
             return -1;
         } 
+
+        // only used with non-trivial kinematics
+        int jointLimitSamples = 8;
+        trajInifile->Find(&jointLimitSamples, "JOINT_LIMIT_SAMPLES", "TRAJ");
+        if (0 != emcSetJointLimitSamples(jointLimitSamples)) {
+            if (emc_debug & EMC_DEBUG_CONFIG) {
+                rcs_print("bad return value from emcSetJointLimitSamples\n");
+            }
+            return -1;
+        }
         
         int j_inhibit = 0;
         int h_inhibit = 0;
@@ -86,6 +86,17 @@ static int      random_toolchanger  = 0;
 static tooldb_t io_db_mode          = DB_NOTUSED;
 static char     db_program[LINELEN] = {0};
 
+// how often io_wait() looks for new commands and HAL input changes, 0 to
+// sleep the whole cycle
+static double   io_poll_time        = 0;
+
+// idx of a tool the task prepared ahead of its T word, -1 if none
+static int      prefetch_idx        = -1;
+// etime() at which the current handshake phases started, 0 if idle
+static double   prepare_start       = 0;
+static double   prepare_wait_start  = 0;
+static double   change_start        = 0;
+
 struct iocontrol_str {
     hal_bit_t *user_enable_out;        /* output, TRUE when EMC wants stop */
     hal_bit_t *emc_enable_in;        /* input, TRUE on any external stop */
@@ -110,6 +121,11 @@ struct iocontrol_str {
     hal_bit_t *tool_change;        /* output, notifies a tool-change should happen (emc should be in the tool-change position) */
     hal_bit_t *tool_changed;        /* input, notifies tool has been changed */
 
+    // handshake timing, in seconds
+    hal_float_t *tool_prepare_time; /* output, tool-prepare to tool-prepared of the last prepare */
+    hal_float_t *tool_prepare_wait; /* output, time the last T word waited for its tool */
+    hal_float_t *tool_change_time;  /* output, tool-change to tool-changed of the last change */
+
     // note: spindle control has been moved to motion
 } * iocontrol_data;                        //pointer to the HAL-struct
 
@@ -237,6 +253,16 @@ static int iniLoad(const char *filename)
              filename, emc_io_cycle_time);
     }
 
+    temp = io_poll_time;
+    if (NULL != (inistring = inifile.Find("POLL_TIME", "EMCIO"))) {
+        if (1 != sscanf(inistring, "%lf", &io_poll_time) || io_poll_time < 0) {
+            io_poll_time = temp;
+            rtapi_print
+                ("invalid [EMCIO] POLL_TIME in %s (%s); using default %f\n",
+                 filename, inistring, io_poll_time);
+        }
+    }
+
     inifile.Find(&random_toolchanger, "RANDOM_TOOLCHANGER", "EMCIO");
 
     io_db_mode = DB_NOTUSED;
@@ -447,6 +473,36 @@ static int iocontrol_hal_init(void)
         hal_exit(comp_id);
         return -1;
     }
+    // tool-prepare-time
+    retval = hal_pin_float_newf(HAL_OUT, &(iocontrol_data->tool_prepare_time), comp_id,
+                                "iocontrol.%d.tool-prepare-time", n);
+    if (retval < 0) {
+        rtapi_print_msg(RTAPI_MSG_ERR,
+                        "IOCONTROL: ERROR: iocontrol %d pin tool-prepare-time export failed with err=%i\n",
+                        n, retval);
+        hal_exit(comp_id);
+        return -1;
+    }
+    // tool-prepare-wait
+    retval = hal_pin_float_newf(HAL_OUT, &(iocontrol_data->tool_prepare_wait), comp_id,
+                                "iocontrol.%d.tool-prepare-wait", n);
+    if (retval < 0) {
+        rtapi_print_msg(RTAPI_MSG_ERR,
+                        "IOCONTROL: ERROR: iocontrol %d pin tool-prepare-wait export failed with err=%i\n",
+                        n, retval);
+        hal_exit(comp_id);
+        return -1;
+    }
+    // tool-change-time
+    retval = hal_pin_float_newf(HAL_OUT, &(iocontrol_data->tool_change_time), comp_id,
+                                "iocontrol.%d.tool-change-time", n);
+    if (retval < 0) {
+        rtapi_print_msg(RTAPI_MSG_ERR,
+                        "IOCONTROL: ERROR: iocontrol %d pin tool-change-time export failed with err=%i\n",
+                        n, retval);
+        hal_exit(comp_id);
+        return -1;
+    }
     /* STEP 3b: export the in-pin(s) */
 
     // emc-enable-in
@@ -496,6 +552,8 @@ static void hal_init_pins(void)
     *(iocontrol_data->tool_from_pocket)=0;   /* output, always 0 at startup */
     *iocontrol_data->tool_prep_index=0;      /* output, pin that holds the internal index (idx) of the tool to be prepared, for debug */
     *(iocontrol_data->tool_change)=0;        /* output, notifies a tool-change should happen (emc should be in the tool-change position) */
+    prefetch_idx = -1;
+    prepare_start = prepare_wait_start = change_start = 0;
 }
 
 
@@ -620,6 +678,12 @@ void reload_tool_number(int toolno) {
 static int read_tool_inputs(void)
 {
     if (*iocontrol_data->tool_prepare && *iocontrol_data->tool_prepared) {
+        double now = etime();
+        *(iocontrol_data->tool_prepare_time) = now - prepare_start;
+        if (prepare_wait_start > 0) {
+            *(iocontrol_data->tool_prepare_wait) = now - prepare_wait_start;
+        }
+        prepare_start = prepare_wait_start = 0;
         emcioStatus.tool.pocketPrepped = *iocontrol_data->tool_prep_index; //check if tool has been (idx) prepared
         *(iocontrol_data->tool_prepare) = 0;
         emcioStatus.status = RCS_STATUS::DONE;  // we finally finished to do tool-changing, signal task with RCS_DONE
@@ -627,6 +691,8 @@ static int read_tool_inputs(void)
     }
 
     if (*iocontrol_data->tool_change && *iocontrol_data->tool_changed) {
+        *(iocontrol_data->tool_change_time) = etime() - change_start;
+        change_start = 0;
         if(!random_toolchanger && emcioStatus.tool.pocketPrepped == 0) {
             emcioStatus.tool.toolInSpindle = 0;
             emcioStatus.tool.toolFromPocket  =  *(iocontrol_data->tool_from_pocket) = 0;
@@ -655,6 +721,51 @@ static int read_tool_inputs(void)
     return 0;
 }
 
+/********************************************************************
+*
+* Description: io_wait(double period)
+*                        Sleeps for 'period' seconds.  With [EMCIO]POLL_TIME
+*                        set it polls in slices of that length instead,
+*                        and returns early when a new command arrives or a
+*                        handshake or status input changes, so each step
+*                        of a tool change costs one slice instead of a
+*                        whole cycle.  Neither HAL pins nor the command
+*                        buffer can wake it, so this costs a wakeup per
+*                        slice.
+*
+* Called By: main
+********************************************************************/
+static void io_wait(double period)
+{
+    if (io_poll_time <= 0) {
+        esleep(period);
+        return;
+    }
+
+    hal_bit_t prepared = *iocontrol_data->tool_prepared;
+    hal_bit_t changed = *iocontrol_data->tool_changed;
+    hal_bit_t enable = *iocontrol_data->emc_enable_in;
+    hal_bit_t level = *iocontrol_data->lube_level;
+    double end = etime() + period;
+
+    for (;;) {
+        double left = end - etime();
+        if (left <= 0) {
+            return;
+        }
+        esleep(left < io_poll_time ? left : io_poll_time);
+        if (*iocontrol_data->tool_prepared != prepared ||
+            *iocontrol_data->tool_changed != changed ||
+            *iocontrol_data->emc_enable_in != enable ||
+            *iocontrol_data->lube_level != level) {
+            return;
+        }
+        if (emcioCommandBuffer->check_if_read() == 0) {
+            return;
+        }
+    }
+}
+
 static void do_hal_exit(void) {
     hal_exit(comp_id);
 }
@@ -820,7 +931,7 @@ int main(int argc, char *argv[])
         /* read NML, run commands */
         if (-1 == emcioCommandBuffer->read()) {
             /* bad command, wait until next cycle */
-            esleep(emc_io_cycle_time);
+            io_wait(emc_io_cycle_time);
             /* and repeat */
             continue;
         }
@@ -829,7 +940,7 @@ int main(int argc, char *argv[])
             0 == emcioCommand->type ||        // bad command type
             emcioCommand->serial_number == emcioStatus.echo_serial_number) {        // command already finished
             /* wait until next cycle */
-            esleep(emc_io_cycle_time);
+            io_wait(emc_io_cycle_time);
             /* and repeat */
             continue;
         }
@@ -865,17 +976,44 @@ int main(int argc, char *argv[])
             *(iocontrol_data->coolant_flood)=0;                /* coolant flood output pin */
             *(iocontrol_data->tool_change)=0;                /* abort tool change if in progress */
             *(iocontrol_data->tool_prepare)=0;                /* abort tool prepare if in progress */
+            if (prefetch_idx != -1) {
+                // the T word the tool was prefetched for is gone with the
+                // program, unprepare it like a finished change does
+                emcioStatus.tool.pocketPrepped = -1;
+                *(iocontrol_data->tool_prep_number) = 0;
+                *(iocontrol_data->tool_prep_pocket) = 0;
+                *(iocontrol_data->tool_prep_index)  = 0;
+            }
+            prefetch_idx = -1;
+            prepare_start = prepare_wait_start = change_start = 0;
             break;
 
         case EMC_TOOL_PREPARE_TYPE:
             {
                 int idx = 0;
                 int toolno = ((EMC_TOOL_PREPARE*)emcioCommand)->tool;
+                int prefetch = ((EMC_TOOL_PREPARE*)emcioCommand)->prefetch;
                 CANON_TOOL_TABLE tdata;
                 idx  = tooldata_find_index_for_tool(toolno);
 #ifdef TOOL_NML
                 if (!random_toolchanger && toolno == 0) { idx = 0; }
 #endif
+                if (!prefetch && idx != -1 && idx == prefetch_idx) {
+                    // the T word of a tool the task already asked for:
+                    // wait only for what is left of its handshake
+                    rtapi_print_msg(RTAPI_MSG_DBG, "EMC_TOOL_PREPARE tool=%d idx=%d prefetched\n", toolno, idx);
+                    prefetch_idx = -1;
+                    if (*(iocontrol_data->tool_prepare)) {
+                        prepare_wait_start = etime();
+                        emcioStatus.status = RCS_STATUS::EXEC;
+                    } else {
+                        *(iocontrol_data->tool_prepare_wait) = 0;
+                    }
+                    break;
+                }
+                // a look-ahead prepare is acknowledged right away and
+                // finishes in the background, see read_tool_inputs()
+                prefetch_idx = prefetch ? idx : -1;
                 if (idx == -1) {  // not found
                     emcioStatus.tool.pocketPrepped = -1;
                 } else {
@@ -918,10 +1056,13 @@ int main(int argc, char *argv[])
 
                 /* then set the prepare pin to tell external logic to get started */
                 *(iocontrol_data->tool_prepare) = 1;
+                prepare_start = etime();
                 // the feedback logic is done inside read_hal_inputs()
                 // we only need to set RCS_EXEC if RCS_DONE is not already set by the above logic
-                if (tool_status != 10) //set above to 10 in case PREP already finished (HAL loopback machine)
+                if (tool_status != 10 && !prefetch) { //set above to 10 in case PREP already finished (HAL loopback machine)
+                    prepare_wait_start = prepare_start;
                     emcioStatus.status = RCS_STATUS::EXEC;
+                }
             }
             break;
         case EMC_TOOL_LOAD_TYPE:
@@ -946,6 +1087,7 @@ int main(int argc, char *argv[])
             if (emcioStatus.tool.pocketPrepped != -1) {
                 //notify HW for toolchange
                 *(iocontrol_data->tool_change) = 1;
+                change_start = etime();
                 // the feedback logic is done inside read_hal_inputs() we only
                 // need to set RCS_EXEC if RCS_DONE is not already set by the
                 // above logic
@@ -1125,7 +1267,7 @@ int main(int argc, char *argv[])
         emcioStatus.heartbeat++;
         emcioStatusBuffer->write(&emcioStatus);
 
-        esleep(emc_io_cycle_time);
+        io_wait(emc_io_cycle_time);
         /* clear reset line to allow for a later rising edge */
         *(iocontrol_data->user_request_enable) = 0;
 
@@ -1022,6 +1022,11 @@ int main(int argc, char *argv[])
             int idx = 0;
             int toolno = ((EMC_TOOL_PREPARE*)emcioCommand)->tool;
             CANON_TOOL_TABLE tdata;
+            // look-ahead prepares are not supported here, the T word
+            // itself will follow
+            if (((EMC_TOOL_PREPARE*)emcioCommand)->prefetch) {
+                break;
+            }
             idx = tooldata_find_index_for_tool(toolno);
 #ifdef TOOL_NML
             if (!random_toolchanger && toolno == 0) { idx = 0; }
@@ -49,7 +49,7 @@ struct emcmot_command_t *c = 0;
 struct emcmot_status_t *emcmotStatus = 0;
 struct emcmot_config_t *emcmotConfig = 0;
 struct emcmot_internal_t *emcmotInternal = 0;
-struct emcmot_error_t *emcmotError = 0;
+struct evring *emcmotError = 0;
 
 int mot_comp_id;
 
@@ -541,6 +541,10 @@ int main(int argc, char* argv[]) {
                 log_print("SET_AXIS_ACC_LIMIT axis=%d, acc=%.6g\n", c->axis, c->acc);
                 break;
 
+            case EMCMOT_SET_AXIS_JERK_LIMIT:
+                log_print("SET_AXIS_JERK_LIMIT axis=%d, jerk=%.6g\n", c->axis, c->jerk);
+                break;
+
             case EMCMOT_SET_JOINT_ACC_LIMIT:
                 log_print("SET_JOINT_ACC_LIMIT joint=%d, acc=%.6g\n", c->joint, c->acc);
                 break;
@@ -549,6 +553,10 @@ int main(int argc, char* argv[]) {
                 log_print("SET_ACC acc=%.6g\n", c->acc);
                 break;
 
+            case EMCMOT_SET_JERK:
+                log_print("SET_JERK jerk=%.6g\n", c->jerk);
+                break;
+
             case EMCMOT_SET_TERM_COND:
                 log_print("SET_TERM_COND termCond=%d, tolerance=%.6g\n", c->termCond, c->tolerance);
                 break;
@@ -663,6 +671,10 @@ int main(int argc, char* argv[]) {
                 log_print("SETUP_ARC_BLENDS\n");
                 break;
 
+            case EMCMOT_SET_JOINT_LIMIT_SAMPLES:
+                log_print("SET_JOINT_LIMIT_SAMPLES %d\n", c->jointLimitSamples);
+                break;
+
             case EMCMOT_SET_PROBE_ERR_INHIBIT:
                 log_print("SETUP_SET_PROBE_ERR_INHIBIT %d %d\n",
                           c->probe_jog_err_inhibit,
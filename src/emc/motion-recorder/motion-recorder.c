@@ -0,0 +1,273 @@
+/********************************************************************
+* Description: motion-recorder.c
+*   Drains the telemetry ring of motion (see emc/motion/telemetry.h)
+*   into a compact binary file, and prints such files as text.
+*
+*   The file is a header followed by one record per servo cycle, in
+*   native byte order and without padding:
+*
+*     header:  char magic[8] "LCNCTLM1", uint32 num_joints,
+*              uint32 reserved, int64 servo period in nsec
+*     record:  uint32 cycle, int32 motion id, int64 time in nsec,
+*              int32 line number, uint64 state tag flags,
+*              uint8 motion state, uint8 enabled,
+*              double feed scale, double velocity,
+*              double commanded pose[9], double actual pose[9],
+*              double joint cmd[num_joints], double joint fb[num_joints],
+*              double ferror[num_joints]
+*
+*   Samples that were lost show up as gaps in the cycle numbers.
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+********************************************************************/
+
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "rtapi.h"
+#include "telemetry.h"
+
+#define FILE_MAGIC "LCNCTLM1"
+#define HEADER_SIZE 24
+#define RECORD_FIXED (4 + 4 + 8 + 4 + 8 + 1 + 1 + 8 + 8 + 9 * 8 + 9 * 8)
+#define RECORD_MAX (RECORD_FIXED + 3 * EMCMOT_MAX_JOINTS * 8)
+
+static volatile sig_atomic_t done;
+
+static void quit(int sig)
+{
+    done = 1;
+}
+
+static unsigned char *put(unsigned char *p, const void *v, size_t n)
+{
+    memcpy(p, v, n);
+    return p + n;
+}
+
+static const unsigned char *get(const unsigned char *p, void *v, size_t n)
+{
+    memcpy(v, p, n);
+    return p + n;
+}
+
+static unsigned char *put_pose(unsigned char *p, const EmcPose *pose)
+{
+    const double v[9] = { pose->tran.x, pose->tran.y, pose->tran.z,
+	pose->a, pose->b, pose->c, pose->u, pose->v, pose->w };
+    return put(p, v, sizeof(v));
+}
+
+static size_t pack(unsigned char *buf, const struct telemetry_sample *s, uint32_t nj)
+{
+    unsigned char *p = buf;
+    int32_t line = s->tag.fields[GM_FIELD_LINE_NUMBER];
+    uint64_t flags = s->tag.packed_flags;
+    int64_t time = s->time;
+
+    p = put(p, &s->cycle, 4);
+    p = put(p, &s->id, 4);
+    p = put(p, &time, 8);
+    p = put(p, &line, 4);
+    p = put(p, &flags, 8);
+    p = put(p, &s->motion_state, 1);
+    p = put(p, &s->enabled, 1);
+    p = put(p, &s->feed_scale, 8);
+    p = put(p, &s->current_vel, 8);
+    p = put_pose(p, &s->carte_cmd);
+    p = put_pose(p, &s->carte_fb);
+    p = put(p, s->joint_cmd, nj * 8);
+    p = put(p, s->joint_fb, nj * 8);
+    p = put(p, s->ferror, nj * 8);
+    return p - buf;
+}
+
+static int record(const char *path, int oldest, double seconds, long count, int poll_ms)
+{
+    struct telemetry *t;
+    struct telemetry_reader rd;
+    struct telemetry_sample s;
+    unsigned char buf[RECORD_MAX];
+    unsigned char header[HEADER_SIZE], *p;
+    uint32_t nj, reserved = 0;
+    int64_t period;
+    long written = 0, limit = count;
+    FILE *f;
+
+    t = telemetry_attach();
+    if (!t) {
+	fprintf(stderr, "motion-recorder: no telemetry, is motmod loaded with telemetry=1?\n");
+	return 1;
+    }
+    nj = t->num_joints;
+    period = t->servo_period;
+    if (seconds > 0 && period > 0) {
+	long n = (long) (seconds * 1e9 / period);
+	if (limit <= 0 || n < limit) {
+	    limit = n;
+	}
+    }
+
+    f = strcmp(path, "-") ? fopen(path, "wb") : stdout;
+    if (!f) {
+	fprintf(stderr, "motion-recorder: %s: %s\n", path, strerror(errno));
+	telemetry_detach(t);
+	return 1;
+    }
+    setvbuf(f, NULL, _IOFBF, 1 << 20);
+
+    p = put(header, FILE_MAGIC, 8);
+    p = put(p, &nj, 4);
+    p = put(p, &reserved, 4);
+    p = put(p, &period, 8);
+    fwrite(header, 1, HEADER_SIZE, f);
+
+    signal(SIGINT, quit);
+    signal(SIGTERM, quit);
+    telemetry_reader_init(t, &rd, oldest);
+    while (!done && (limit <= 0 || written < limit)) {
+	if (telemetry_read(t, &rd, &s) < 0) {
+	    fflush(f);
+	    usleep(poll_ms * 1000);
+	    continue;
+	}
+	if (fwrite(buf, 1, pack(buf, &s, nj), f) == 0) {
+	    fprintf(stderr, "motion-recorder: %s: %s\n", path, strerror(errno));
+	    break;
+	}
+	written++;
+    }
+
+    fprintf(stderr, "motion-recorder: %ld samples recorded, %u lost\n", written, rd.lost);
+    if (f != stdout) {
+	fclose(f);
+    } else {
+	fflush(f);
+    }
+    telemetry_detach(t);
+    return rd.lost ? 2 : 0;
+}
+
+static int dump(const char *path)
+{
+    unsigned char header[HEADER_SIZE], buf[RECORD_MAX];
+    const unsigned char *p;
+    uint32_t nj, reserved, i;
+    int64_t period;
+    size_t size;
+    FILE *f;
+
+    f = strcmp(path, "-") ? fopen(path, "rb") : stdin;
+    if (!f) {
+	fprintf(stderr, "motion-recorder: %s: %s\n", path, strerror(errno));
+	return 1;
+    }
+    if (fread(header, 1, HEADER_SIZE, f) != HEADER_SIZE || memcmp(header, FILE_MAGIC, 8)) {
+	fprintf(stderr, "motion-recorder: %s: not a recording\n", path);
+	return 1;
+    }
+    p = get(header + 8, &nj, 4);
+    p = get(p, &reserved, 4);
+    p = get(p, &period, 8);
+    if (nj > EMCMOT_MAX_JOINTS) {
+	fprintf(stderr, "motion-recorder: %s: bad number of joints %u\n", path, nj);
+	return 1;
+    }
+    size = RECORD_FIXED + 3 * nj * 8;
+
+    printf("# servo period %lld ns, %u joints\n", (long long) period, nj);
+    printf("# cycle\ttime\tid\tline\tflags\tstate\tenabled\tfeed_scale\tvel"
+	   "\tx\ty\tz\ta\tb\tc\tu\tv\tw"
+	   "\tx_fb\ty_fb\tz_fb\ta_fb\tb_fb\tc_fb\tu_fb\tv_fb\tw_fb");
+    for (i = 0; i < nj; i++) {
+	printf("\tj%u_cmd\tj%u_fb\tj%u_ferror", i, i, i);
+    }
+    printf("\n");
+
+    while (fread(buf, 1, size, f) == size) {
+	uint32_t cycle;
+	int32_t id, line;
+	int64_t time;
+	uint64_t flags;
+	unsigned char state, enabled;
+	double d[2 + 18 + 3 * EMCMOT_MAX_JOINTS];
+
+	p = get(buf, &cycle, 4);
+	p = get(p, &id, 4);
+	p = get(p, &time, 8);
+	p = get(p, &line, 4);
+	p = get(p, &flags, 8);
+	p = get(p, &state, 1);
+	p = get(p, &enabled, 1);
+	p = get(p, d, (2 + 18 + 3 * nj) * 8);
+	printf("%u\t%lld\t%d\t%d\t0x%llx\t%u\t%u", cycle, (long long) time, id, line,
+	       (unsigned long long) flags, state, enabled);
+	for (i = 0; i < 20; i++) {
+	    printf("\t%.9g", d[i]);
+	}
+	for (i = 0; i < nj; i++) {
+	    printf("\t%.9g\t%.9g\t%.9g", d[20 + i], d[20 + nj + i], d[20 + 2 * nj + i]);
+	}
+	printf("\n");
+    }
+    return 0;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+	    "usage: motion-recorder [-a] [-n samples] [-t seconds] [-p poll_ms] file\n"
+	    "       motion-recorder -d file\n"
+	    "Records every servo cycle of motion (motmod telemetry=1) to file,\n"
+	    "'-' for stdout, until interrupted.  -d prints a recording as text.\n"
+	    "  -a  start with the oldest samples still in the ring\n");
+}
+
+int main(int argc, char **argv)
+{
+    int opt, oldest = 0, poll_ms = 10, to_text = 0;
+    long count = 0;
+    double seconds = 0;
+
+    while ((opt = getopt(argc, argv, "adn:t:p:h")) != -1) {
+	switch (opt) {
+	case 'a':
+	    oldest = 1;
+	    break;
+	case 'd':
+	    to_text = 1;
+	    break;
+	case 'n':
+	    count = atol(optarg);
+	    break;
+	case 't':
+	    seconds = atof(optarg);
+	    break;
+	case 'p':
+	    poll_ms = atoi(optarg);
+	    if (poll_ms < 1) {
+		poll_ms = 1;
+	    }
+	    break;
+	default:
+	    usage();
+	    return 1;
+	}
+    }
+    if (optind != argc - 1) {
+	usage();
+	return 1;
+    }
+    if (to_text) {
+	return dump(argv[optind]);
+    }
+    return record(argv[optind], oldest, seconds, count, poll_ms);
+}
@@ -0,0 +1,180 @@
+/********************************************************************
+* Description: cmdtrace.c
+*   Ring of command timestamps, see cmdtrace.h
+*
+*   Writers take the next index with an atomic increment and publish
+*   the event through the seq of its slot, so head may be ahead of
+*   events that are still being written.  Readers copy an event out
+*   like a seqlock and stop at one that is not complete yet.
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+********************************************************************/
+
+#include "rtapi.h"
+#include "rtapi_string.h"
+#include "cmdtrace.h"
+
+#define CMDTRACE_MASK (CMDTRACE_SLOTS - 1)
+
+/* indices wrap, compare them by their difference */
+static inline int after(unsigned int a, unsigned int b)
+{
+    return (int) (a - b) > 0;
+}
+
+void cmdtrace_init(struct cmdtrace *t)
+{
+    memset(t, 0, sizeof(*t));
+    t->event_size = sizeof(struct cmdtrace_event);
+    __atomic_store_n(&t->magic, CMDTRACE_MAGIC, __ATOMIC_RELEASE);
+}
+
+void cmdtrace_stamp(struct cmdtrace *t, int hop, int serial, int command,
+		    int type, int arg, int pid, long long time)
+{
+    unsigned int index = __atomic_fetch_add(&t->head, 1, __ATOMIC_ACQ_REL);
+    struct cmdtrace_slot *s = &t->slot[index & CMDTRACE_MASK];
+
+    __atomic_store_n(&s->seq, 2 * index + 1, __ATOMIC_RELAXED);
+    /* readers must see the odd seq before any of the new data */
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    s->e.time = time;
+    s->e.serial = serial;
+    s->e.command = command;
+    s->e.type = type;
+    s->e.arg = arg;
+    s->e.pid = pid;
+    s->e.hop = hop;
+    __atomic_store_n(&s->seq, 2 * index + 2, __ATOMIC_RELEASE);
+}
+
+void cmdtrace_reader_init(const struct cmdtrace *t, struct cmdtrace_reader *rd,
+			  int oldest)
+{
+    unsigned int head = __atomic_load_n(&t->head, __ATOMIC_ACQUIRE);
+
+    rd->next = head;
+    rd->lost = 0;
+    if (oldest) {
+	rd->next = head < CMDTRACE_SLOTS ? 0 : head - CMDTRACE_SLOTS;
+    }
+}
+
+int cmdtrace_read(const struct cmdtrace *t, struct cmdtrace_reader *rd,
+		  struct cmdtrace_event *e)
+{
+    for (;;) {
+	const struct cmdtrace_slot *slot;
+	unsigned int head, want, seq;
+
+	head = __atomic_load_n(&t->head, __ATOMIC_ACQUIRE);
+	if (!after(head, rd->next)) {
+	    return -1;
+	}
+	if (after(head - CMDTRACE_SLOTS, rd->next)) {
+	    /* lapped, the oldest events are gone */
+	    rd->lost += head - CMDTRACE_SLOTS - rd->next;
+	    rd->next = head - CMDTRACE_SLOTS;
+	}
+
+	slot = &t->slot[rd->next & CMDTRACE_MASK];
+	want = 2 * rd->next + 2;
+	seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+	if (seq != want && !after(seq, want)) {
+	    /* taken but not written yet, try again later */
+	    return -1;
+	}
+	rd->next++;
+	if (seq != want) {
+	    /* a writer is already a lap ahead in this slot */
+	    rd->lost++;
+	    continue;
+	}
+	memcpy(e, &slot->e, sizeof(*e));
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != want) {
+	    /* a writer took the slot while it was copied */
+	    rd->lost++;
+	    continue;
+	}
+	return 0;
+    }
+}
+
+#ifndef RTAPI
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+struct cmdtrace *cmdtrace_ring = NULL;
+int cmdtrace_serial = 0;
+
+static int module_id = -1;
+static int shmem_id = -1;
+static int pid;
+
+struct cmdtrace *cmdtrace_attach(void)
+{
+    char name[RTAPI_NAME_LEN + 1];
+    struct cmdtrace *t;
+
+    if (module_id >= 0) {
+	return cmdtrace_ring;	/* one ring per process */
+    }
+    pid = getpid();
+    snprintf(name, sizeof(name), "cmdtrace%d", pid);
+    module_id = rtapi_init(name);
+    if (module_id < 0) {
+	return NULL;
+    }
+    shmem_id = rtapi_shmem_new(CMDTRACE_SHMEM_KEY, module_id,
+			       sizeof(struct cmdtrace));
+    if (shmem_id < 0 || rtapi_shmem_getptr(shmem_id, (void **) &t) < 0) {
+	cmdtrace_detach();
+	return NULL;
+    }
+    /* a ring without the magic was only just created by us, motmod
+       was not loaded with cmdtrace=1 */
+    if (__atomic_load_n(&t->magic, __ATOMIC_ACQUIRE) != CMDTRACE_MAGIC ||
+	t->event_size != sizeof(struct cmdtrace_event)) {
+	rtapi_shmem_delete(shmem_id, module_id);
+	shmem_id = -1;
+	return NULL;
+    }
+    cmdtrace_ring = t;
+    return t;
+}
+
+void cmdtrace_detach(void)
+{
+    cmdtrace_ring = NULL;
+    if (shmem_id >= 0) {
+	rtapi_shmem_delete(shmem_id, module_id);
+	shmem_id = -1;
+    }
+    if (module_id >= 0) {
+	rtapi_exit(module_id);
+	module_id = -1;
+    }
+}
+
+long long cmdtrace_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void cmdtrace_user(int hop, int serial, int command, int type, int arg,
+		   long long time)
+{
+    if (cmdtrace_ring) {
+	cmdtrace_stamp(cmdtrace_ring, hop, serial, command, type, arg, pid,
+		       time ? time : cmdtrace_now());
+    }
+}
+#endif
@@ -0,0 +1,110 @@
+/********************************************************************
+* Description: cmdtrace.h
+*   Ring of timestamps a command collects on its way to the servo
+*   cycle
+*
+*   When motmod is loaded with cmdtrace=1 it allocates this ring in
+*   shared memory of its own, and each hop a command passes stamps it
+*   with the time: the user interface writing it to the NML command
+*   buffer, task reading and issuing it, usrmot handing a motion
+*   command to motion, the motion command handler, and the trajectory
+*   planner starting the segment it queued.  User space hops name the
+*   command by its NML serial number, motion ones by the motion
+*   commandNum; the usrmot hop has both and ties them together.
+*
+*   Unlike the telemetry ring there are many writers, which take slots
+*   with an atomic increment.  command-trace drains the ring into a
+*   Chrome trace.
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+********************************************************************/
+#ifndef CMDTRACE_H
+#define CMDTRACE_H
+
+#define CMDTRACE_SHMEM_KEY 0x434D4454	/* "CMDT" */
+#define CMDTRACE_MAGIC 0x434D4454
+#define CMDTRACE_SLOTS 8192	/* events kept, must be a power of two */
+
+enum cmdtrace_hop {
+    CMDTRACE_GUI_WRITE = 1,	/* user interface wrote the command */
+    CMDTRACE_TASK_READ,		/* task read it from the command buffer */
+    CMDTRACE_TASK_ISSUE,	/* task issued it, or a command the
+				   interpreter queued for it */
+    CMDTRACE_MOTION_WRITE,	/* usrmot wrote a motion command */
+    CMDTRACE_MOTION_RECEIVE,	/* the motion command handler took it */
+    CMDTRACE_MOTION_DONE,	/* ... and is done with it */
+    CMDTRACE_TP_START,		/* the motion id being executed changed */
+    CMDTRACE_GUI_ECHO,		/* user interface saw task echo the serial */
+    CMDTRACE_HOPS
+};
+
+struct cmdtrace_event {
+    long long time;		/* CLOCK_MONOTONIC in nsec, rtapi_get_time()
+				   in motion, which is the same on uspace */
+    int serial;			/* NML serial number, 0 in motion */
+    int command;		/* motion commandNum, 0 before usrmot */
+    int type;			/* NML type, or motion command code */
+    int arg;			/* motion id, or the command status once done */
+    int pid;			/* process that stamped it, 0 for motion */
+    int hop;			/* enum cmdtrace_hop */
+};
+
+/* seq is odd while a writer fills the slot, and 2*index+2 once event
+   number index is complete */
+struct cmdtrace_slot {
+    unsigned int seq;
+    struct cmdtrace_event e;
+};
+
+struct cmdtrace {
+    unsigned int magic;		/* CMDTRACE_MAGIC once set up */
+    unsigned int event_size;	/* sizeof(struct cmdtrace_event) */
+    unsigned int head;		/* events handed out to writers */
+    struct cmdtrace_slot slot[CMDTRACE_SLOTS];
+};
+
+/* one per reader, in the reader's own memory */
+struct cmdtrace_reader {
+    unsigned int next;		/* index of the next event to read */
+    unsigned int lost;		/* events overwritten before they were read */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    extern void cmdtrace_init(struct cmdtrace *t);
+    extern void cmdtrace_stamp(struct cmdtrace *t, int hop, int serial,
+			       int command, int type, int arg, int pid,
+			       long long time);
+
+/* readers; like telemetry_reader_init() and telemetry_read(), only an
+   event still being written ends the read until the next call */
+    extern void cmdtrace_reader_init(const struct cmdtrace *t,
+				     struct cmdtrace_reader *rd, int oldest);
+    extern int cmdtrace_read(const struct cmdtrace *t,
+			     struct cmdtrace_reader *rd,
+			     struct cmdtrace_event *e);
+#ifndef RTAPI
+/* the ring of a running motmod, attached once per process by
+   cmdtrace_attach(), NULL if motmod was not loaded with cmdtrace=1 */
+    extern struct cmdtrace *cmdtrace_ring;
+/* serial number task is issuing, for the usrmot hop */
+    extern int cmdtrace_serial;
+
+    extern struct cmdtrace *cmdtrace_attach(void);
+    extern void cmdtrace_detach(void);
+    extern long long cmdtrace_now(void);
+/* stamps an event of this process in cmdtrace_ring, if attached, at
+   time or now if that is 0 */
+    extern void cmdtrace_user(int hop, int serial, int command, int type,
+			      int arg, long long time);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -67,6 +67,7 @@
 #include "motion_types.h"
 #include "homing.h"
 #include "axis.h"
+#include "cmdtrace.h"
 
 #include "tp_debug.h"
 
@@ -271,6 +272,150 @@ STATIC int inRange(EmcPose pos, int id, char *move_type)
     return in_range;
 }
 
+/* movePose() gives the pose at fraction f of a move from start to end.
+   For a circle the xyz part follows it, the other axes move linearly
+   like they do in the planner. */
+STATIC void movePose(EmcPose const *start, EmcPose const *end,
+		     PmCircle const *circle, double f, EmcPose *pose)
+{
+    pose->tran.x = start->tran.x + f * (end->tran.x - start->tran.x);
+    pose->tran.y = start->tran.y + f * (end->tran.y - start->tran.y);
+    pose->tran.z = start->tran.z + f * (end->tran.z - start->tran.z);
+    pose->a = start->a + f * (end->a - start->a);
+    pose->b = start->b + f * (end->b - start->b);
+    pose->c = start->c + f * (end->c - start->c);
+    pose->u = start->u + f * (end->u - start->u);
+    pose->v = start->v + f * (end->v - start->v);
+    pose->w = start->w + f * (end->w - start->w);
+    if (circle) {
+	pmCirclePoint(circle, f * circle->angle, &pose->tran);
+    }
+}
+
+/* moveStep() is the path length between two poses of a move, measured
+   in the same axes the planner uses for the length of the segment */
+STATIC double moveStep(EmcPose const *p1, EmcPose const *p2, int use)
+{
+    switch (use) {
+    case 0:
+	return sqrt(pmSq(p2->tran.x - p1->tran.x) + pmSq(p2->tran.y - p1->tran.y) +
+		    pmSq(p2->tran.z - p1->tran.z));
+    case 1:
+	return sqrt(pmSq(p2->a - p1->a) + pmSq(p2->b - p1->b) + pmSq(p2->c - p1->c));
+    default:
+	return sqrt(pmSq(p2->u - p1->u) + pmSq(p2->v - p1->v) + pmSq(p2->w - p1->w));
+    }
+}
+
+/* jointLimitCaps() lowers the velocity and acceleration of a move so
+   that no joint goes past its own limits anywhere along it.  With
+   non-trivial kinematics a joint can move much faster than any axis,
+   most of all close to a singular pose, and the axis limits the
+   planner works with do not catch that.
+
+   The inverse kinematics is sampled at jointLimitSamples points along
+   the move, which gives each joint's rate along the path (dq/ds, the
+   Jacobian in the direction of motion) and its change (d2q/ds2).  A
+   joint moves at dq/ds * v and accelerates at dq/ds * a + d2q/ds2 * v^2,
+   so v is limited to keep up to half of the joint's acceleration for
+   the curvature part, and a to what the curvature leaves.  Moves that
+   stay clear of trouble keep their full speed.
+
+   All samples+1 kinematics calls run in the servo cycle that takes the
+   command, which is why the samples are capped at
+   EMCMOT_MAX_JOINT_LIMIT_SAMPLES. */
+STATIC void jointLimitCaps(EmcPose const *end, PmCircle const *circle,
+			   double *vel, double *ini_maxvel, double *acc)
+{
+    int samples = emcmotConfig->jointLimitSamples;
+    EmcPose start = emcmotInternal->coord_tp.goalPos;
+    EmcPose pose, prev_pose;
+    double q[EMCMOT_MAX_JOINTS], q_prev[EMCMOT_MAX_JOINTS];
+    double dq_prev[EMCMOT_MAX_JOINTS];
+    double dq_max[EMCMOT_MAX_JOINTS], ddq_max[EMCMOT_MAX_JOINTS];
+    double ds, ds_prev = 0.0;
+    double v_cap = *ini_maxvel, a_cap = *acc;
+    KINEMATICS_INVERSE_FLAGS iflags_sample = iflags;
+    KINEMATICS_FORWARD_FLAGS fflags_sample = fflags;
+    int use, k, joint_num;
+
+    if (samples <= 0 || emcmotConfig->kinType == KINEMATICS_IDENTITY) {
+	return;
+    }
+
+    /* measure along the axes the planner takes the length from */
+    use = 0;
+    if (!circle && moveStep(&start, end, 0) < 1e-9) {
+	use = moveStep(&start, end, 1) < 1e-9 ? 2 : 1;
+    }
+
+    for (joint_num = 0; joint_num < NO_OF_KINS_JOINTS; joint_num++) {
+	q[joint_num] = joints[joint_num].pos_cmd;
+	dq_max[joint_num] = 0.0;
+	ddq_max[joint_num] = 0.0;
+    }
+
+    for (k = 0; k <= samples; k++) {
+	movePose(&start, end, circle, (double) k / samples, &pose);
+	/* the last solution seeds the next one for iterative kinematics */
+	if (kinematicsInverse(&pose, q, &iflags_sample, &fflags_sample) != 0) {
+	    return;
+	}
+	for (joint_num = 0; joint_num < NO_OF_KINS_JOINTS; joint_num++) {
+	    if (!isfinite(q[joint_num])) {
+		return;
+	    }
+	}
+	if (k > 0 && (ds = moveStep(&prev_pose, &pose, use)) > 1e-9) {
+	    for (joint_num = 0; joint_num < NO_OF_KINS_JOINTS; joint_num++) {
+		double dq = (q[joint_num] - q_prev[joint_num]) / ds;
+		dq_max[joint_num] = fmax(dq_max[joint_num], fabs(dq));
+		if (ds_prev > 0.0) {
+		    double ddq = (dq - dq_prev[joint_num]) / (0.5 * (ds + ds_prev));
+		    ddq_max[joint_num] = fmax(ddq_max[joint_num], fabs(ddq));
+		}
+		dq_prev[joint_num] = dq;
+	    }
+	    ds_prev = ds;
+	}
+	prev_pose = pose;
+	for (joint_num = 0; joint_num < NO_OF_KINS_JOINTS; joint_num++) {
+	    q_prev[joint_num] = q[joint_num];
+	}
+    }
+
+    for (joint_num = 0; joint_num < NO_OF_KINS_JOINTS; joint_num++) {
+	emcmot_joint_t *joint = &joints[joint_num];
+	if (!GET_JOINT_ACTIVE_FLAG(joint)) {
+	    continue;
+	}
+	if (dq_max[joint_num] > 0.0 && joint->vel_limit > 0.0) {
+	    v_cap = fmin(v_cap, joint->vel_limit / dq_max[joint_num]);
+	}
+	if (ddq_max[joint_num] > 0.0 && joint->acc_limit > 0.0) {
+	    v_cap = fmin(v_cap, sqrt(0.5 * joint->acc_limit / ddq_max[joint_num]));
+	}
+    }
+    for (joint_num = 0; joint_num < NO_OF_KINS_JOINTS; joint_num++) {
+	emcmot_joint_t *joint = &joints[joint_num];
+	if (!GET_JOINT_ACTIVE_FLAG(joint) || dq_max[joint_num] <= 0.0 ||
+	    joint->acc_limit <= 0.0) {
+	    continue;
+	}
+	a_cap = fmin(a_cap, (joint->acc_limit - ddq_max[joint_num] * pmSq(v_cap)) /
+			    dq_max[joint_num]);
+    }
+
+    if (v_cap < *ini_maxvel || a_cap < *acc) {
+	rtapi_print_msg(RTAPI_MSG_DBG,
+			"joint limits cap move %d at vel %f acc %f\n",
+			emcmotInternal->coord_tp.nextId, v_cap, a_cap);
+    }
+    *vel = fmin(*vel, v_cap);
+    *ini_maxvel = fmin(*ini_maxvel, v_cap);
+    *acc = fmin(*acc, a_cap);
+}
+
 /* legacy note:
    clearHomes() will clear the homed flags for joints that have moved
    since homing, outside coordinated control, for machines with no
@@ -406,6 +551,12 @@ void emcmotCommandHandler_locked(void *arg, long servo_period)
 	/* clear status value by default */
 	emcmotStatus->commandStatus = EMCMOT_COMMAND_OK;
 
+	if (emcmotCmdtrace) {
+	    cmdtrace_stamp(emcmotCmdtrace, CMDTRACE_MOTION_RECEIVE, 0,
+		emcmotCommand->commandNum, emcmotCommand->command,
+		emcmotCommand->id, 0, rtapi_get_time());
+	}
+
 	/* ...and process command */
 
         joint = 0;
@@ -1024,12 +1175,17 @@ void emcmotCommandHandler_locked(void *arg, long servo_period)
 
 	    /* append it to the emcmotInternal->coord_tp */
 	    tpSetId(&emcmotInternal->coord_tp, emcmotCommand->id);
+	    /* slow it down where a joint would go past its limits */
+	    double line_vel = emcmotCommand->vel;
+	    double line_maxvel = emcmotCommand->ini_maxvel;
+	    double line_acc = emcmotCommand->acc;
+	    jointLimitCaps(&emcmotCommand->pos, NULL, &line_vel, &line_maxvel, &line_acc);
 	    int res_addline = tpAddLine(&emcmotInternal->coord_tp,
 					emcmotCommand->pos,
 					emcmotCommand->motion_type,
-					emcmotCommand->vel,
-					emcmotCommand->ini_maxvel,
-					emcmotCommand->acc,
+					line_vel,
+					line_maxvel,
+					line_acc,
 					emcmotStatus->enables_new,
 					issue_atspeed,
 					emcmotCommand->turn,
@@ -1085,11 +1241,22 @@ void emcmotCommandHandler_locked(void *arg, long servo_period)
             }
 	    /* append it to the emcmotInternal->coord_tp */
 	    tpSetId(&emcmotInternal->coord_tp, emcmotCommand->id);
+	    /* slow it down where a joint would go past its limits */
+	    double circle_vel = emcmotCommand->vel;
+	    double circle_maxvel = emcmotCommand->ini_maxvel;
+	    double circle_acc = emcmotCommand->acc;
+	    PmCircle circle;
+	    if (pmCircleInit(&circle, &emcmotInternal->coord_tp.goalPos.tran,
+			     &emcmotCommand->pos.tran, &emcmotCommand->center,
+			     &emcmotCommand->normal, emcmotCommand->turn) == 0) {
+		jointLimitCaps(&emcmotCommand->pos, &circle,
+			       &circle_vel, &circle_maxvel, &circle_acc);
+	    }
 	    int res_addcircle = tpAddCircle(&emcmotInternal->coord_tp, emcmotCommand->pos,
                             emcmotCommand->center, emcmotCommand->normal,
                             emcmotCommand->turn, emcmotCommand->motion_type,
-                            emcmotCommand->vel, emcmotCommand->ini_maxvel,
-                            emcmotCommand->acc, emcmotStatus->enables_new,
+                            circle_vel, circle_maxvel,
+                            circle_acc, emcmotStatus->enables_new,
 			    issue_atspeed, emcmotCommand->tag);
         if (res_addcircle < 0) {
             reportError(_("can't add circular move at line %d, error code %d"),
@@ -1166,6 +1333,12 @@ void emcmotCommandHandler_locked(void *arg, long servo_period)
 	    tpSetAmax(&emcmotInternal->coord_tp, emcmotStatus->acc);
 	    break;
 
+	case EMCMOT_SET_JERK:
+	    /* set the max jerk, applies to moves queued from now on */
+	    rtapi_print_msg(RTAPI_MSG_DBG, "SET_JERK");
+	    emcmotConfig->maxJerk = emcmotCommand->jerk;
+	    break;
+
 	case EMCMOT_PAUSE:
 	    /* pause the motion */
 	    /* can happen at any time */
@@ -1870,6 +2043,18 @@ void emcmotCommandHandler_locked(void *arg, long servo_period)
             axis_set_ext_offset_acc_limit(emcmotCommand->axis, emcmotCommand->ext_offset_acc);
             break;
 
+        case EMCMOT_SET_AXIS_JERK_LIMIT:
+	    /* set the max axis jerk */
+	    /* can be done at any time, applies to moves queued from now on */
+	    rtapi_print_msg(RTAPI_MSG_DBG, "SET_AXIS_JERK_LIMIT");
+	    rtapi_print_msg(RTAPI_MSG_DBG, " %d", emcmotCommand->axis);
+	    emcmot_config_change();
+            if ((emcmotCommand->axis < 0) || (emcmotCommand->axis >= EMCMOT_MAX_AXIS)) {
+                break;
+            }
+            emcmotConfig->axisJerk[emcmotCommand->axis] = emcmotCommand->jerk;
+            break;
+
         case EMCMOT_SET_AXIS_LOCKING_JOINT:
 	    rtapi_print_msg(RTAPI_MSG_DBG, "SET_AXIS_ACC_LOCKING_JOINT");
 	    rtapi_print_msg(RTAPI_MSG_DBG, " %d", emcmotCommand->axis);
@@ -1888,6 +2073,12 @@ void emcmotCommandHandler_locked(void *arg, long servo_period)
         case EMCMOT_SET_MAX_FEED_OVERRIDE:
             emcmotConfig->maxFeedScale = emcmotCommand->maxFeedScale;
             break;
+        case EMCMOT_SET_JOINT_LIMIT_SAMPLES:
+            emcmotConfig->jointLimitSamples = emcmotCommand->jointLimitSamples;
+            if (emcmotConfig->jointLimitSamples > EMCMOT_MAX_JOINT_LIMIT_SAMPLES) {
+                emcmotConfig->jointLimitSamples = EMCMOT_MAX_JOINT_LIMIT_SAMPLES;
+            }
+            break;
         case EMCMOT_SETUP_ARC_BLENDS:
             emcmotConfig->arcBlendEnable = emcmotCommand->arcBlendEnable;
             emcmotConfig->arcBlendFallbackEnable = emcmotCommand->arcBlendFallbackEnable;
@@ -1907,6 +2098,11 @@ void emcmotCommandHandler_locked(void *arg, long servo_period)
 		emcmotStatus->commandStatus);
 	}
 	rtapi_print_msg(RTAPI_MSG_DBG, "\n");
+	if (emcmotCmdtrace) {
+	    cmdtrace_stamp(emcmotCmdtrace, CMDTRACE_MOTION_DONE, 0,
+		emcmotCommand->commandNum, emcmotCommand->command,
+		emcmotStatus->commandStatus, 0, rtapi_get_time());
+	}
 	/* synch tail count */
 	emcmotStatus->tail = emcmotStatus->head;
 	emcmotConfig->tail = emcmotConfig->head;
@@ -33,6 +33,8 @@
 #include "homing.h"
 #include "axis.h"
 #include "kinematics.h"  //for kinematicsSwitchable()
+#include "telemetry.h"
+#include "cmdtrace.h"
 
 // Mark strings for translation, but defer translation to userspace
 #define _(s) (s)
@@ -188,6 +190,16 @@ static void output_to_hal(void);
 */
 static void update_status(void);
 
+/* 'record_telemetry()' stores this cycle's positions, following errors
+   and the executing segment in the telemetry ring, if there is one.
+*/
+static void record_telemetry(void);
+
+/* 'trace_segment_start()' stamps the command trace when the motion id
+   of the executing segment changes.
+*/
+static void trace_segment_start(void);
+
 static void handle_kinematicsSwitch(void);
 
 /***********************************************************************
@@ -269,6 +281,12 @@ void emcmotController(void *arg, long period)
     output_to_hal();
     write_homing_out_pins(ALL_JOINTS);
     update_status();
+    if (emcmotTelemetry) {
+        record_telemetry();
+    }
+    if (emcmotCmdtrace) {
+        trace_segment_start();
+    }
     /* here ends the core of the controller */
     emcmotStatus->heartbeat++;
     /* set tail to head, to indicate work complete */
@@ -2128,6 +2146,7 @@ static void update_status(void)
 
     /* motion emcmotInternal->coord_tp status */
     emcmotStatus->depth = tpQueueDepth(&emcmotInternal->coord_tp);
+    emcmotStatus->queueTime = tpQueueTime(&emcmotInternal->coord_tp);
     emcmotStatus->activeDepth = tpActiveDepth(&emcmotInternal->coord_tp);
     emcmotStatus->id = tpGetExecId(&emcmotInternal->coord_tp);
     //KLUDGE add an API call for this
@@ -2152,3 +2171,37 @@ static void update_status(void)
     }
 #endif
 }
+
+static void record_telemetry(void)
+{
+    struct telemetry_sample *s = telemetry_begin(emcmotTelemetry);
+    int joint_num;
+
+    s->id = emcmotStatus->id;
+    s->time = rtapi_get_time();
+    s->feed_scale = emcmotStatus->net_feed_scale;
+    s->current_vel = emcmotStatus->current_vel;
+    s->carte_cmd = emcmotStatus->carte_pos_cmd;
+    s->carte_fb = emcmotStatus->carte_pos_fb;
+    for (joint_num = 0; joint_num < ALL_JOINTS; joint_num++) {
+        emcmot_joint_t *joint = &joints[joint_num];
+        s->joint_cmd[joint_num] = joint->pos_cmd;
+        s->joint_fb[joint_num] = joint->pos_fb;
+        s->ferror[joint_num] = joint->ferror;
+    }
+    s->tag = emcmotStatus->tag;
+    s->motion_state = emcmotStatus->motion_state;
+    s->enabled = GET_MOTION_ENABLE_FLAG() ? 1 : 0;
+    telemetry_commit(emcmotTelemetry);
+}
+
+static void trace_segment_start(void)
+{
+    static int last_id = 0;
+
+    if (emcmotStatus->id != last_id) {
+        last_id = emcmotStatus->id;
+        cmdtrace_stamp(emcmotCmdtrace, CMDTRACE_TP_START, 0, 0, 0, last_id, 0,
+                       rtapi_get_time());
+    }
+}
@@ -35,11 +35,14 @@
 #define EMCMOT_MAX_AIO 64
 #define EMCMOT_MAX_MISC_ERROR 64
 
+/* most kinematics samples per move for joint limits, each one an
+   inverse kinematics call in the servo thread when the move is queued */
+#define EMCMOT_MAX_JOINT_LIMIT_SAMPLES 32
+
 #if (EMCMOT_MAX_DIO > 64) || (EMCMOT_MAX_AIO > 64)
 #error A 64 bit bitmask is used in the planner.  Don't increase these until that's fixed.
 #endif
 
-#define EMCMOT_ERROR_NUM 32	/* how many errors we can queue */
 #define EMCMOT_ERROR_LEN 1024	/* how long error string can be */
 
 /*
@@ -64,10 +67,13 @@
 #define DEFAULT_AIO 4
 #define DEFAULT_MISC_ERROR 0
 
-/* size of motion queue
- * a TC_STRUCT is about 512 bytes so this queue is
- * about a megabyte.  */
+/* size of motion queue, can be changed with the tc_queue_size parameter
+ * of motmod.  A queued segment takes about 800 bytes (TC_STRUCT plus its
+ * share of the synched IO pool) so the default queue is under two
+ * megabytes. */
 #define DEFAULT_TC_QUEUE_SIZE 2000
+#define MIN_TC_QUEUE_SIZE 50
+#define MAX_TC_QUEUE_SIZE 200000
 
 /* max following error */
 #define DEFAULT_MAX_FERROR 100
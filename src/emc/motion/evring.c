@@ -0,0 +1,211 @@
+/********************************************************************
+* Description: evring.c
+*   Event ring for passing messages from realtime to user space,
+*   see evring.h
+*
+*   Writers take a position with an atomic increment of head and then
+*   claim the slot for it by moving its seq from an even (complete)
+*   value of an older position to their own odd one.  If the slot is
+*   still owned by a writer of an older position, or a newer position
+*   already got it, the record is dropped and counted instead of
+*   waiting.  Readers work like a seqlock: the record is copied out and
+*   only used if seq did not change meanwhile.
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+********************************************************************/
+
+#include "rtapi.h"
+#include "rtapi_string.h"
+#include "evring.h"
+#include "dbuf.h"
+#include "stashf.h"
+
+#define EVRING_MASK (EVRING_SLOTS - 1)
+
+/* positions wrap, compare them by their difference */
+static inline int after(unsigned int a, unsigned int b)
+{
+    return (int) (a - b) > 0;
+}
+
+void evring_init(struct evring *r)
+{
+    memset(r, 0, sizeof(*r));
+}
+
+static void give_up(struct evring *r, struct evring_slot *s, unsigned int pos)
+{
+    unsigned int g = __atomic_load_n(&s->gave_up, __ATOMIC_RELAXED);
+
+    while (!after(g, pos) &&
+	   !__atomic_compare_exchange_n(&s->gave_up, &g, pos + 1, 1,
+					__ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+    __atomic_fetch_add(&r->dropped, 1, __ATOMIC_RELAXED);
+}
+
+static struct evring_slot *claim(struct evring *r, unsigned int *pos)
+{
+    struct evring_slot *s;
+    unsigned int seq, mine;
+
+    *pos = __atomic_fetch_add(&r->head, 1, __ATOMIC_RELAXED);
+    s = &r->slot[*pos & EVRING_MASK];
+    mine = 2 * *pos + 1;
+    seq = __atomic_load_n(&s->seq, __ATOMIC_RELAXED);
+    do {
+	if ((seq & 1) || after(seq, mine)) {
+	    give_up(r, s, *pos);
+	    return 0;
+	}
+    } while (!__atomic_compare_exchange_n(&s->seq, &seq, mine, 1,
+					  __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+    /* readers must see the odd seq before any of the new data */
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    return s;
+}
+
+static void publish(struct evring_slot *s, unsigned int pos)
+{
+    __atomic_store_n(&s->seq, 2 * pos + 2, __ATOMIC_RELEASE);
+}
+
+int evring_put(struct evring *r, int type, int level, const void *data, unsigned len)
+{
+    struct evring_slot *s;
+    unsigned int pos;
+
+    if (r == 0 || len > EVRING_DATA_LEN || !(s = claim(r, &pos))) {
+	return -1;
+    }
+    s->type = type;
+    s->level = level;
+    s->time = rtapi_get_time();
+    s->len = len;
+    memcpy(s->data, data, len);
+    publish(s, pos);
+    return 0;
+}
+
+int evring_putfv(struct evring *r, int type, int level, const char *fmt, va_list ap)
+{
+    struct evring_slot *s;
+    struct dbuf d;
+    struct dbuf_iter it;
+    unsigned int pos;
+
+    if (r == 0 || !(s = claim(r, &pos))) {
+	return -1;
+    }
+    s->type = type;
+    s->level = level;
+    s->time = rtapi_get_time();
+    dbuf_init(&d, s->data, EVRING_DATA_LEN);
+    dbuf_iter_init(&it, &d);
+    vstashf(&it, fmt, ap);
+    s->len = it.offset;
+    publish(s, pos);
+    return 0;
+}
+
+int evring_putf(struct evring *r, int type, int level, const char *fmt, ...)
+{
+    int result;
+    va_list ap;
+    va_start(ap, fmt);
+    result = evring_putfv(r, type, level, fmt, ap);
+    va_end(ap);
+    return result;
+}
+
+void evring_reader_init(const struct evring *r, struct evring_reader *rd, int oldest)
+{
+    unsigned int head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+
+    rd->next = head;
+    rd->lost = 0;
+    if (oldest) {
+	/* the ring starts out zeroed, so before the first lap there
+	   are fewer than EVRING_SLOTS records */
+	rd->next = head < EVRING_SLOTS ? 0 : head - EVRING_SLOTS;
+    }
+}
+
+int evring_read(const struct evring *r, struct evring_reader *rd, struct evring_record *rec)
+{
+    for (;;) {
+	const struct evring_slot *s;
+	unsigned int head, want, seq, g;
+
+	head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+	if (!after(head, rd->next)) {
+	    return -1;
+	}
+	if (after(head - EVRING_SLOTS, rd->next)) {
+	    /* lapped, the oldest records are gone */
+	    rd->lost += head - EVRING_SLOTS - rd->next;
+	    rd->next = head - EVRING_SLOTS;
+	}
+
+	s = &r->slot[rd->next & EVRING_MASK];
+	want = 2 * rd->next + 2;
+	seq = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+	if (seq != want) {
+	    if (after(seq, want)) {
+		/* overwritten by a later lap */
+		rd->lost++;
+		rd->next++;
+		continue;
+	    }
+	    g = __atomic_load_n(&s->gave_up, __ATOMIC_ACQUIRE);
+	    if (after(g, rd->next)) {
+		/* its writer found the slot busy and dropped it */
+		rd->lost++;
+		rd->next++;
+		continue;
+	    }
+	    /* still being written, or not yet claimed */
+	    return -1;
+	}
+
+	rec->pos = rd->next;
+	rec->type = s->type;
+	rec->level = s->level;
+	rec->time = s->time;
+	rec->len = s->len;
+	if (rec->len > EVRING_DATA_LEN) {
+	    rec->len = EVRING_DATA_LEN;
+	}
+	memcpy(rec->data, s->data, rec->len);
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	rd->next++;
+	if (__atomic_load_n(&s->seq, __ATOMIC_RELAXED) != want) {
+	    /* a writer took the slot while it was copied */
+	    rd->lost++;
+	    continue;
+	}
+	return 0;
+    }
+}
+
+#ifndef RTAPI
+#include <stdio.h>
+
+int evring_format(const struct evring_record *rec, char *buf, int n)
+{
+    struct dbuf d;
+    struct dbuf_iter it;
+
+    if (rec->type == EVRING_TRACE) {
+	return snprintf(buf, n, "trace event %d (%u bytes)", rec->level, rec->len);
+    }
+    /* not dbuf_init(), that clears the buffer */
+    d.data = (unsigned char *) rec->data;
+    d.sz = rec->len;
+    dbuf_iter_init(&it, &d);
+    return snprintdbuf(buf, n, &it);
+}
+#endif
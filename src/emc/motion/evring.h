@@ -0,0 +1,99 @@
+/********************************************************************
+* Description: evring.h
+*   Event ring for passing messages from realtime to user space
+*
+*   A fixed-size ring of typed, timestamped records living in shared
+*   memory.  Any number of realtime threads may write to it at the
+*   same time without locking, and any number of user space programs
+*   may read it, each with a cursor of its own, so a slow or missing
+*   reader never holds up a writer or another reader.  A reader that
+*   falls more than EVRING_SLOTS records behind loses the oldest ones
+*   and is told how many.
+*
+*   Messages are stored with stashf(), i.e. the format string and the
+*   arguments, and only formatted when a reader wants the text.
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+********************************************************************/
+#ifndef EVRING_H
+#define EVRING_H
+
+#include <stdarg.h>
+
+#define EVRING_SLOTS 64		/* records kept, must be a power of two */
+#define EVRING_DATA_LEN 1000	/* payload bytes per record */
+
+/* record types */
+#define EVRING_MESSAGE 1	/* rtapi_print_msg() text, level is the msg level */
+#define EVRING_FAULT 2		/* error reported by motion itself */
+#define EVRING_TRACE 3		/* binary payload, level is the event id */
+
+/* A slot is owned by a writer while its seq is odd.  A completed
+   record at position pos has seq 2*pos+2, so a reader can tell a
+   record it is waiting for from an older or newer one. */
+struct evring_slot {
+    unsigned int seq;
+    unsigned int gave_up;	/* newest position a writer dropped here, plus one */
+    unsigned short type;
+    unsigned short level;
+    unsigned int len;
+    long long time;		/* rtapi_get_time() when written */
+    unsigned char data[EVRING_DATA_LEN];
+};
+
+struct evring {
+    unsigned int head;		/* next position handed to a writer */
+    unsigned int dropped;	/* records writers had to drop */
+    struct evring_slot slot[EVRING_SLOTS];
+};
+
+/* a record as returned to a reader */
+struct evring_record {
+    unsigned int pos;
+    unsigned short type;
+    unsigned short level;
+    unsigned int len;
+    long long time;
+    unsigned char data[EVRING_DATA_LEN];
+};
+
+/* one per reader, in the reader's own memory */
+struct evring_reader {
+    unsigned int next;		/* position of the next record to read */
+    unsigned int lost;		/* records overwritten before they were read */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* writers; these return 0, or -1 when the record was dropped */
+    extern void evring_init(struct evring *r);
+    extern int evring_put(struct evring *r, int type, int level,
+			  const void *data, unsigned len);
+    extern int evring_putfv(struct evring *r, int type, int level,
+			    const char *fmt, va_list ap);
+    extern int evring_putf(struct evring *r, int type, int level,
+			   const char *fmt, ...)
+	__attribute__((format(printf, 4, 5)));
+
+/* readers; evring_reader_init() starts at the oldest record still in
+   the ring when 'oldest' is set, otherwise at the next one written.
+   evring_read() returns 0 and fills in 'rec', or -1 when there is
+   nothing (more) to read. */
+    extern void evring_reader_init(const struct evring *r,
+				   struct evring_reader *rd, int oldest);
+    extern int evring_read(const struct evring *r, struct evring_reader *rd,
+			   struct evring_record *rec);
+#ifndef RTAPI
+/* formats a MESSAGE or FAULT record into buf, returns like snprintf */
+    extern int evring_format(const struct evring_record *rec, char *buf, int n);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -223,7 +223,9 @@ extern struct emcmot_command_t *emcmotCommand;
 extern struct emcmot_status_t *emcmotStatus;
 extern struct emcmot_config_t *emcmotConfig;
 extern struct emcmot_internal_t *emcmotInternal;
-extern struct emcmot_error_t *emcmotError;
+extern struct evring *emcmotError;
+extern struct telemetry *emcmotTelemetry;	/* NULL unless telemetry=1 */
+extern struct cmdtrace *emcmotCmdtrace;	/* NULL unless cmdtrace=1 */
 
 /***********************************************************************
 *                    PUBLIC FUNCTION PROTOTYPES                        *
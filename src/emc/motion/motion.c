@@ -21,6 +21,8 @@
 #include "rtapi_math.h"
 #include "homing.h"
 #include "axis.h"
+#include "telemetry.h"
+#include "cmdtrace.h"
 
 // Mark strings for translation, but defer translation to userspace
 #define _(s) (s)
@@ -80,6 +82,12 @@ RTAPI_MP_ARRAY_STRING(names_misc_errors, MAX_IO, "names of errors");
 
 static int unlock_joints_mask = 0;/* mask to select joints for unlock pins */
 RTAPI_MP_INT(unlock_joints_mask, "mask to select joints for unlock pins");
+static int tc_queue_size = DEFAULT_TC_QUEUE_SIZE; /* segments in the motion queue */
+RTAPI_MP_INT(tc_queue_size, "number of segments in the motion queue");
+static int telemetry = 0;	/* per servo cycle samples for user space */
+RTAPI_MP_INT(telemetry, "record every servo cycle for motion-recorder");
+static int cmdtrace = 0;	/* command timestamps for user space */
+RTAPI_MP_INT(cmdtrace, "trace commands for command-trace");
 /***********************************************************************
 *                  GLOBAL VARIABLE DEFINITIONS                         *
 ************************************************************************/
@@ -108,7 +116,9 @@ struct emcmot_command_t *emcmotCommand = 0;
 struct emcmot_status_t *emcmotStatus = 0;
 struct emcmot_config_t *emcmotConfig = 0;
 struct emcmot_internal_t *emcmotInternal = 0;
-struct emcmot_error_t *emcmotError = 0;	/* unused for RT_FIFO */
+struct evring *emcmotError = 0;
+struct telemetry *emcmotTelemetry = 0;
+struct cmdtrace *emcmotCmdtrace = 0;
 
 /***********************************************************************
 *                  LOCAL VARIABLE DECLARATIONS                         *
@@ -116,6 +126,8 @@ struct emcmot_error_t *emcmotError = 0;	/* unused for RT_FIFO */
 
 /* RTAPI shmem ID - for comms with higher level user space stuff */
 static int emc_shmem_id;	/* the shared memory ID */
+static int telemetry_shmem_id;	/* the telemetry ring, if any */
+static int cmdtrace_shmem_id;	/* the command trace ring, if any */
 
 static int mot_comp_id;	/* component ID for motion module */
 
@@ -142,6 +154,16 @@ static int export_spindle(int num, spindle_hal_t * addr);
 */
 static int init_comm_buffers(void);
 
+/* init_telemetry() allocates the ring of per servo cycle samples
+   (telemetry.h) when motmod is loaded with telemetry=1.
+*/
+static int init_telemetry(void);
+
+/* init_cmdtrace() allocates the ring of command timestamps (cmdtrace.h)
+   when motmod is loaded with cmdtrace=1.
+*/
+static int init_cmdtrace(void);
+
 /* init_threads() creates realtime threads, exports functions to
    do the realtime control, and adds the functions to the threads.
 */
@@ -208,7 +230,7 @@ static void emc_message_handler(msg_level_t level, const char *fmt, va_list ap)
 {
     va_list apc;
     va_copy(apc, ap);
-    if(level == RTAPI_MSG_ERR) emcmotErrorPutfv(emcmotError, fmt, apc);
+    if(level == RTAPI_MSG_ERR) evring_putfv(emcmotError, EVRING_MESSAGE, level, fmt, apc);
     if(old_handler) old_handler(level, fmt, ap);
     va_end(apc);
 }
@@ -245,7 +267,7 @@ static int module_intfc() {
 }
 
 static int tp_init() {
-    if (-1 == tpCreate(&emcmotInternal->coord_tp, DEFAULT_TC_QUEUE_SIZE,mot_comp_id)) {
+    if (-1 == tpCreate(&emcmotInternal->coord_tp, tc_queue_size,mot_comp_id)) {
         rtapi_print_msg(RTAPI_MSG_ERR,
             "MOTION: tpCreate failed\n");
         return -1;
@@ -294,6 +316,14 @@ int rtapi_app_main(void)
             );
     }
 
+    if (( tc_queue_size < MIN_TC_QUEUE_SIZE ) || ( tc_queue_size > MAX_TC_QUEUE_SIZE )) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    _("MOTION: tc_queue_size is %d, must be between %d and %d\n"),
+	    tc_queue_size, MIN_TC_QUEUE_SIZE, MAX_TC_QUEUE_SIZE);
+	hal_exit(mot_comp_id);
+	return -1;
+    }
+
     if (( num_spindles < 0 ) || ( num_spindles > EMCMOT_MAX_SPINDLES )) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    _("MOTION: num_spindles is %d, must be between 0 and %d\n"), num_spindles, EMCMOT_MAX_SPINDLES);
@@ -376,6 +406,24 @@ int rtapi_app_main(void)
 	return -1;
     }
 
+    if (telemetry) {
+	retval = init_telemetry();
+	if (retval != 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR, _("MOTION: init_telemetry() failed\n"));
+	    hal_exit(mot_comp_id);
+	    return -1;
+	}
+    }
+
+    if (cmdtrace) {
+	retval = init_cmdtrace();
+	if (retval != 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR, _("MOTION: init_cmdtrace() failed\n"));
+	    hal_exit(mot_comp_id);
+	    return -1;
+	}
+    }
+
     if (module_intfc()) {
 	rtapi_print_msg(RTAPI_MSG_ERR, _("MOTION: module_intfc() failed\n"));
 	return -1;
@@ -425,6 +473,18 @@ void rtapi_app_exit(void)
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    _("MOTION: hal_stop_threads() failed, returned %d\n"), retval);
     }
+    if (emcmotTelemetry) {
+	emcmotTelemetry = 0;
+	rtapi_shmem_delete(telemetry_shmem_id, mot_comp_id);
+    }
+    if (emcmotCmdtrace) {
+	emcmotCmdtrace = 0;
+	rtapi_shmem_delete(cmdtrace_shmem_id, mot_comp_id);
+    }
+    /* free the motion queue, it is in shared memory of its own */
+    if (emcmotInternal) {
+	tpDelete(&emcmotInternal->coord_tp);
+    }
     /* free shared memory */
     retval = rtapi_shmem_delete(emc_shmem_id, mot_comp_id);
     if (retval < 0) {
@@ -976,6 +1036,58 @@ static int init_comm_buffers(void)
     return 0;
 }
 
+static int init_telemetry(void)
+{
+    int retval;
+
+    telemetry_shmem_id = rtapi_shmem_new(TELEMETRY_SHMEM_KEY, mot_comp_id,
+					 sizeof(struct telemetry));
+    if (telemetry_shmem_id < 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "MOTION: rtapi_shmem_new failed, returned %d\n", telemetry_shmem_id);
+	return -1;
+    }
+    retval = rtapi_shmem_getptr(telemetry_shmem_id, (void **) &emcmotTelemetry);
+    if (retval < 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "MOTION: rtapi_shmem_getptr failed, returned %d\n", retval);
+	rtapi_shmem_delete(telemetry_shmem_id, mot_comp_id);
+	emcmotTelemetry = 0;
+	return -1;
+    }
+    telemetry_init(emcmotTelemetry, num_joints, servo_period_nsec);
+    rtapi_print_msg(RTAPI_MSG_INFO,
+	"MOTION: telemetry ring of %d samples, %lu bytes\n",
+	TELEMETRY_SLOTS, (unsigned long) sizeof(struct telemetry));
+    return 0;
+}
+
+static int init_cmdtrace(void)
+{
+    int retval;
+
+    cmdtrace_shmem_id = rtapi_shmem_new(CMDTRACE_SHMEM_KEY, mot_comp_id,
+					sizeof(struct cmdtrace));
+    if (cmdtrace_shmem_id < 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "MOTION: rtapi_shmem_new failed, returned %d\n", cmdtrace_shmem_id);
+	return -1;
+    }
+    retval = rtapi_shmem_getptr(cmdtrace_shmem_id, (void **) &emcmotCmdtrace);
+    if (retval < 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "MOTION: rtapi_shmem_getptr failed, returned %d\n", retval);
+	rtapi_shmem_delete(cmdtrace_shmem_id, mot_comp_id);
+	emcmotCmdtrace = 0;
+	return -1;
+    }
+    cmdtrace_init(emcmotCmdtrace);
+    rtapi_print_msg(RTAPI_MSG_INFO,
+	"MOTION: command trace ring of %d events, %lu bytes\n",
+	CMDTRACE_SLOTS, (unsigned long) sizeof(struct cmdtrace));
+    return 0;
+}
+
 /* init_threads() creates realtime threads, exports functions to
    do the realtime control, and adds the functions to the threads.
 */
@@ -70,6 +70,7 @@ to another.
 #include <stdarg.h>
 #include "rtapi_bool.h"
 #include "state_tag.h"
+#include "evring.h"
 #include "tp_types.h"
 
 // define a special value to denote an invalid motion ID
@@ -129,6 +130,7 @@ extern "C" {
 	EMCMOT_SET_VEL,		/* set the velocity for subsequent moves */
 	EMCMOT_SET_VEL_LIMIT,	/* set the max vel for all moves (tooltip) */
 	EMCMOT_SET_ACC,		/* set the max accel for moves (tooltip) */
+	EMCMOT_SET_JERK,	/* set the max jerk for moves, 0 = unlimited */
 	EMCMOT_SET_TERM_COND,	/* set termination condition (stop, blend) */
 	EMCMOT_SET_NUM_JOINTS,	/* set the number of joints */
 	EMCMOT_SET_NUM_SPINDLES, /* set the number of spindles */
@@ -147,6 +149,7 @@ extern "C" {
 	EMCMOT_SPINDLE_ORIENT,          /* orient the spindle */
         EMCMOT_SET_OFFSET, /* set tool offsets */
         EMCMOT_SET_MAX_FEED_OVERRIDE,
+        EMCMOT_SET_JOINT_LIMIT_SAMPLES,
         EMCMOT_SETUP_ARC_BLENDS,
 
 	EMCMOT_SET_PROBE_ERR_INHIBIT,
@@ -177,6 +180,7 @@ extern "C" {
         EMCMOT_SET_AXIS_POSITION_LIMITS, /* set the axis position +/- limits */
         EMCMOT_SET_AXIS_VEL_LIMIT,      /* set the max axis vel */
         EMCMOT_SET_AXIS_ACC_LIMIT,      /* set the max axis acc */
+        EMCMOT_SET_AXIS_JERK_LIMIT,     /* set the max axis jerk */
         EMCMOT_SET_AXIS_LOCKING_JOINT,  /* set the axis locking joint */
 
         EMCMOT_SET_SPINDLE_PARAMS, /* One command to set all spindle params */
@@ -223,6 +227,7 @@ extern "C" {
         int motion_type;        /* this move is because of traverse, feed, arc, or toolchange */
         double spindlesync;     /* user units per spindle revolution, 0 = no sync */
 	double acc;		/* max acceleration */
+	double jerk;		/* max jerk */
 	double backlash;	/* amount of backlash */
 	int id;			/* id for motion */
 	int termCond;		/* termination condition */
@@ -266,6 +271,7 @@ extern "C" {
     double arcBlendRampFreq;
     double arcBlendTangentKinkRatio;
     double maxFeedScale;
+    int jointLimitSamples;      /* kinematics samples per move, 0 = off */
     double ext_offset_vel;	/* velocity for an external axis offset */
     double ext_offset_acc;	/* acceleration for an external axis offset */
     struct state_tag_t tag;
@@ -628,6 +634,7 @@ Suggestion: Split this in to an Error and a Status flag register..
 				   changed. */
 	int id;			/* id for executing motion */
 	int depth;		/* motion queue depth */
+	double queueTime;	/* estimated seconds of motion queued */
 	int activeDepth;	/* depth of active blend elements */
 	int queueFull;		/* Flag to indicate the tc queue is full */
 	int paused;		/* Flag to signal motion paused */
@@ -724,20 +731,13 @@ Suggestion: Split this in to an Error and a Status flag register..
         double arcBlendRampFreq;
         double arcBlendTangentKinkRatio;
         double maxFeedScale;
+        double maxJerk;         /* coordinated moves, 0 = unlimited */
+        double axisJerk[EMCMOT_MAX_AXIS]; /* per axis, 0 = unlimited */
+        int jointLimitSamples;  /* see jointLimitCaps() in command.c */
         int inhibit_probe_jog_error;
         int inhibit_probe_home_error;
     } emcmot_config_t;
 
-/* error structure - A ring buffer used to pass formatted printf strings to usr space */
-    typedef struct emcmot_error_t {
-	unsigned char head;	/* flag count for mutex detect */
-	char error[EMCMOT_ERROR_NUM][EMCMOT_ERROR_LEN];
-	int start;		/* index of oldest error */
-	int end;		/* index of newest error */
-	int num;		/* number of items */
-	unsigned char tail;	/* flag count for mutex detect */
-    } emcmot_error_t;
-
 
 typedef struct emcmot_internal_t {
     unsigned char head; /* flag count for mutex detect */
@@ -752,12 +752,12 @@ typedef struct emcmot_internal_t {
     int idForStep;      /* status id while stepping */
     } emcmot_internal_t;
 
-/* error ring buffer access functions */
-    extern int emcmotErrorInit(emcmot_error_t * errlog);
-    extern int emcmotErrorPut(emcmot_error_t * errlog, const char *error);
-    extern int emcmotErrorPutfv(emcmot_error_t * errlog, const char *fmt, va_list ap);
-    extern int emcmotErrorPutf(emcmot_error_t * errlog, const char *fmt, ...);
-    extern int emcmotErrorGet(emcmot_error_t * errlog, char *error);
+/* put errors into the event ring, as EVRING_FAULT records; user space
+   reads them back with usrmotReadEmcmotError() */
+    extern int emcmotErrorInit(struct evring *errlog);
+    extern int emcmotErrorPut(struct evring *errlog, const char *error);
+    extern int emcmotErrorPutfv(struct evring *errlog, const char *fmt, va_list ap);
+    extern int emcmotErrorPutf(struct evring *errlog, const char *fmt, ...);
 
 #define GET_JOINT_ACTIVE_FLAG(joint) ((joint)->flag & EMCMOT_JOINT_ACTIVE_BIT ? 1 : 0)
 #define GET_JOINT_INPOS_FLAG(joint) ((joint)->flag & EMCMOT_JOINT_INPOS_BIT ? 1 : 0)
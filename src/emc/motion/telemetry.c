@@ -0,0 +1,153 @@
+/********************************************************************
+* Description: telemetry.c
+*   Per servo cycle telemetry ring, see telemetry.h
+*
+*   The servo thread is the only writer, so a slot is taken by just
+*   marking it odd, and head only moves on once the sample is complete.
+*   Readers work like a seqlock: the sample is copied out and only used
+*   if seq did not change meanwhile.
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+********************************************************************/
+
+#include "rtapi.h"
+#include "rtapi_string.h"
+#include "telemetry.h"
+
+#define TELEMETRY_MASK (TELEMETRY_SLOTS - 1)
+
+/* cycles wrap, compare them by their difference */
+static inline int after(unsigned int a, unsigned int b)
+{
+    return (int) (a - b) > 0;
+}
+
+void telemetry_init(struct telemetry *t, int num_joints, long servo_period)
+{
+    memset(t, 0, sizeof(*t));
+    t->sample_size = sizeof(struct telemetry_sample);
+    t->num_joints = num_joints;
+    t->servo_period = servo_period;
+    __atomic_store_n(&t->magic, TELEMETRY_MAGIC, __ATOMIC_RELEASE);
+}
+
+struct telemetry_sample *telemetry_begin(struct telemetry *t)
+{
+    unsigned int head = t->head;
+    struct telemetry_slot *s = &t->slot[head & TELEMETRY_MASK];
+
+    __atomic_store_n(&s->seq, 2 * head + 1, __ATOMIC_RELAXED);
+    /* readers must see the odd seq before any of the new data */
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    s->s.cycle = head;
+    return &s->s;
+}
+
+void telemetry_commit(struct telemetry *t)
+{
+    unsigned int head = t->head;
+
+    __atomic_store_n(&t->slot[head & TELEMETRY_MASK].seq, 2 * head + 2,
+		     __ATOMIC_RELEASE);
+    __atomic_store_n(&t->head, head + 1, __ATOMIC_RELEASE);
+}
+
+void telemetry_reader_init(const struct telemetry *t, struct telemetry_reader *rd,
+			   int oldest)
+{
+    unsigned int head = __atomic_load_n(&t->head, __ATOMIC_ACQUIRE);
+
+    rd->next = head;
+    rd->lost = 0;
+    if (oldest) {
+	rd->next = head < TELEMETRY_SLOTS ? 0 : head - TELEMETRY_SLOTS;
+    }
+}
+
+int telemetry_read(const struct telemetry *t, struct telemetry_reader *rd,
+		   struct telemetry_sample *s)
+{
+    for (;;) {
+	const struct telemetry_slot *slot;
+	unsigned int head, want;
+
+	head = __atomic_load_n(&t->head, __ATOMIC_ACQUIRE);
+	if (!after(head, rd->next)) {
+	    return -1;
+	}
+	if (after(head - TELEMETRY_SLOTS, rd->next)) {
+	    /* lapped, the oldest samples are gone */
+	    rd->lost += head - TELEMETRY_SLOTS - rd->next;
+	    rd->next = head - TELEMETRY_SLOTS;
+	}
+
+	slot = &t->slot[rd->next & TELEMETRY_MASK];
+	want = 2 * rd->next + 2;
+	rd->next++;
+	if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != want) {
+	    /* the writer is already a lap ahead in this slot */
+	    rd->lost++;
+	    continue;
+	}
+	memcpy(s, &slot->s, sizeof(*s));
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != want) {
+	    /* the writer took the slot while it was copied */
+	    rd->lost++;
+	    continue;
+	}
+	return 0;
+    }
+}
+
+#ifndef RTAPI
+#include <stdio.h>
+#include <unistd.h>
+
+static int module_id = -1;
+static int shmem_id = -1;
+
+struct telemetry *telemetry_attach(void)
+{
+    char name[RTAPI_NAME_LEN + 1];
+    struct telemetry *t;
+
+    if (module_id >= 0) {
+	return NULL;		/* one ring per process */
+    }
+    snprintf(name, sizeof(name), "telemetry%d", (int) getpid());
+    module_id = rtapi_init(name);
+    if (module_id < 0) {
+	return NULL;
+    }
+    shmem_id = rtapi_shmem_new(TELEMETRY_SHMEM_KEY, module_id,
+			       sizeof(struct telemetry));
+    if (shmem_id < 0 || rtapi_shmem_getptr(shmem_id, (void **) &t) < 0) {
+	telemetry_detach(NULL);
+	return NULL;
+    }
+    /* a ring without the magic was only just created by us, motmod
+       was not loaded with telemetry=1 */
+    if (__atomic_load_n(&t->magic, __ATOMIC_ACQUIRE) != TELEMETRY_MAGIC ||
+	t->sample_size != sizeof(struct telemetry_sample)) {
+	telemetry_detach(t);
+	return NULL;
+    }
+    return t;
+}
+
+void telemetry_detach(struct telemetry *t)
+{
+    if (shmem_id >= 0) {
+	rtapi_shmem_delete(shmem_id, module_id);
+	shmem_id = -1;
+    }
+    if (module_id >= 0) {
+	rtapi_exit(module_id);
+	module_id = -1;
+    }
+}
+#endif
@@ -0,0 +1,95 @@
+/********************************************************************
+* Description: telemetry.h
+*   Per servo cycle telemetry ring for user space
+*
+*   When motmod is loaded with telemetry=1 the controller stores one
+*   sample per servo cycle (commanded and actual pose, joint positions,
+*   following errors, the executing segment and its state tag, the
+*   feed scale) in a ring in shared memory of its own.  There is a
+*   single writer, the servo thread, which never waits.  Any number of
+*   user space programs may drain the ring, each with a cursor of its
+*   own; a reader that falls more than TELEMETRY_SLOTS samples behind
+*   loses the oldest ones and is told how many.
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+********************************************************************/
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "emcpos.h"
+#include "emcmotcfg.h"
+#include "state_tag.h"
+
+#define TELEMETRY_SHMEM_KEY 0x544C4D31	/* "TLM1" */
+#define TELEMETRY_MAGIC 0x544C4D31
+#define TELEMETRY_SLOTS 4096	/* samples kept, must be a power of two;
+				   about one second at 4 kHz */
+
+struct telemetry_sample {
+    unsigned int cycle;		/* servo cycles since motmod was loaded */
+    int id;			/* motion id of the executing segment */
+    long long time;		/* rtapi_get_time() at the end of the cycle */
+    double feed_scale;		/* net feed scale */
+    double current_vel;		/* tool tip velocity */
+    EmcPose carte_cmd;		/* commanded pose */
+    EmcPose carte_fb;		/* actual pose */
+    double joint_cmd[EMCMOT_MAX_JOINTS];
+    double joint_fb[EMCMOT_MAX_JOINTS];
+    double ferror[EMCMOT_MAX_JOINTS];
+    struct state_tag_t tag;	/* state tag of the executing segment */
+    unsigned char motion_state;	/* EMCMOT_MOTION_FREE, _COORD, ... */
+    unsigned char enabled;
+};
+
+/* seq is odd while the writer fills the slot, and 2*cycle+2 once the
+   sample for that cycle is complete */
+struct telemetry_slot {
+    unsigned int seq;
+    struct telemetry_sample s;
+};
+
+struct telemetry {
+    unsigned int magic;		/* TELEMETRY_MAGIC once set up */
+    unsigned int sample_size;	/* sizeof(struct telemetry_sample) */
+    unsigned int num_joints;	/* joints filled in each sample */
+    unsigned int head;		/* samples written */
+    long servo_period;		/* nsec */
+    struct telemetry_slot slot[TELEMETRY_SLOTS];
+};
+
+/* one per reader, in the reader's own memory */
+struct telemetry_reader {
+    unsigned int next;		/* cycle of the next sample to read */
+    unsigned int lost;		/* samples overwritten before they were read */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* writer; telemetry_begin() hands out the slot for the next sample,
+   which becomes visible to readers with telemetry_commit() */
+    extern void telemetry_init(struct telemetry *t, int num_joints,
+			       long servo_period);
+    extern struct telemetry_sample *telemetry_begin(struct telemetry *t);
+    extern void telemetry_commit(struct telemetry *t);
+
+/* readers; like evring_reader_init() and evring_read() */
+    extern void telemetry_reader_init(const struct telemetry *t,
+				      struct telemetry_reader *rd, int oldest);
+    extern int telemetry_read(const struct telemetry *t,
+			      struct telemetry_reader *rd,
+			      struct telemetry_sample *s);
+#ifndef RTAPI
+/* attach to the ring of a running motmod, NULL if there is none */
+    extern struct telemetry *telemetry_attach(void);
+    extern void telemetry_detach(struct telemetry *t);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -20,7 +20,7 @@
 #include <float.h>		/* DBL_MIN */
 #include "motion.h"		/* emcmot_status_t,CMD */
 #include "motion_struct.h"      /* emcmot_struct_t */
-#include "emcmotcfg.h"		/* EMCMOT_ERROR_NUM,LEN */
+#include "emcmotcfg.h"		/* EMCMOT_ERROR_LEN */
 #include "emcmotglb.h"		/* SHMEM_KEY */
 #include "usrmotintf.h"		/* these decls */
 #include "_timer.h"
@@ -33,8 +33,8 @@
 
 #include "rtapi.h"
 
-#include "dbuf.h"
-#include "stashf.h"
+#include "evring.h"
+#include "cmdtrace.h"
 
 static int inited = 0;		/* flag if inited */
 
@@ -42,7 +42,9 @@ static emcmot_command_t *emcmotCommand = 0;
 static emcmot_status_t *emcmotStatus = 0;
 static emcmot_config_t *emcmotConfig = 0;
 static emcmot_internal_t *emcmotInternal = 0;
-static emcmot_error_t *emcmotError = 0;
+static struct evring *emcmotError = 0;
+static struct evring_reader errorReader;	/* cursor of usrmotReadEmcmotError() */
+static unsigned int errorsLost = 0;	/* lost records already reported */
 static emcmot_struct_t *emcmotStruct = 0;
 
 /* usrmotIniLoad() loads params (SHMEM_KEY, COMM_TIMEOUT)
@@ -90,10 +92,14 @@ int usrmotWriteEmcmotCommand(emcmot_command_t * c)
 	return EMCMOT_COMM_ERROR_CONNECT;
     }
 
-    /* copy entire command structure to shared memory */
+    /* copy entire command structure to shared memory, stamped before
+       motion can see it so the hop does not come after its receipt */
+    long long sent = cmdtrace_now();
     rtapi_mutex_get(&emcmotStruct->command_mutex);
     *emcmotCommand = *c;
     rtapi_mutex_give(&emcmotStruct->command_mutex);
+    cmdtrace_user(CMDTRACE_MOTION_WRITE, cmdtrace_serial, c->commandNum,
+		  c->command, c->id, sent);
 
     /* poll for receipt of command */
     /* set timeout for comm failure, now + timeout */
@@ -190,27 +196,51 @@ printf("ReadEmcmotInternal COMM_SPLIT_READ_TIMEOUT\n" );
 /* copies error to s */
 int usrmotReadEmcmotError(char *e)
 {
+    struct evring_record rec;
+
     /* check to see if ptr still around */
     if (emcmotError == 0) {
 	return -1;
     }
 
-    char data[EMCMOT_ERROR_LEN];
-    struct dbuf d;
-    dbuf_init(&d, (unsigned char *)data, EMCMOT_ERROR_LEN);
-
     /* returns 0 if something, -1 if not */
-    int result = emcmotErrorGet(emcmotError, data);
-    if(result < 0) return result;
-
-    struct dbuf_iter di;
-    dbuf_iter_init(&di, &d);
+    while (evring_read(emcmotError, &errorReader, &rec) == 0) {
+	if (errorReader.lost != errorsLost) {
+	    /* say so before the first error after the gap */
+	    snprintf(e, EMCMOT_ERROR_LEN, "%u messages from motion were lost",
+		     errorReader.lost - errorsLost);
+	    errorsLost = errorReader.lost;
+	    errorReader.next = rec.pos;
+	    return 0;
+	}
+	if (rec.type == EVRING_TRACE) {
+	    continue;
+	}
+	if (evring_format(&rec, e, EMCMOT_ERROR_LEN) < 0) {
+	    return -1;
+	}
+	return 0;
+    }
+    return -1;
+}
 
-    result =  snprintdbuf(e, EMCMOT_ERROR_LEN, &di);
-    if(result < 0) return result;
+int usrmotEventReaderInit(struct evring_reader *rd, int oldest)
+{
+    if (emcmotError == 0) {
+	return -1;
+    }
+    evring_reader_init(emcmotError, rd, oldest);
     return 0;
 }
 
+int usrmotReadEvent(struct evring_reader *rd, struct evring_record *rec)
+{
+    if (emcmotError == 0) {
+	return -1;
+    }
+    return evring_read(emcmotError, rd, rec);
+}
+
 /*
  htostr()
 
@@ -586,6 +616,11 @@ int usrmotInit(const char *modname)
     emcmotInternal = &(emcmotStruct->internal);
     emcmotConfig = &(emcmotStruct->config);
     emcmotError = &(emcmotStruct->error);
+    /* pick up whatever motion reported before we got here */
+    evring_reader_init(emcmotError, &errorReader, 1);
+    errorsLost = 0;
+    /* stamp the commands if motmod was loaded with cmdtrace=1 */
+    cmdtrace_attach();
 
     inited = 1;
 
@@ -598,6 +633,7 @@ int usrmotExit(void)
 	rtapi_shmem_delete(shmem_id, module_id);
 	rtapi_exit(module_id);
     }
+    cmdtrace_detach();
 
     emcmotStruct = 0;
     emcmotCommand = 0;
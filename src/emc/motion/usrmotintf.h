@@ -19,7 +19,8 @@ struct emcmot_status_t;
 struct emcmot_command_t;
 struct emcmot_config_t;
 struct emcmot_internal_t;
-struct emcmot_error_t;
+struct evring_reader;
+struct evring_record;
 
 #ifdef __cplusplus
 extern "C" {
@@ -42,9 +43,16 @@ extern "C" {
     extern int usrmotReadEmcmotInternal(emcmot_internal_t * s);
 
 /* usrmotReadEmcmotError() gets the earliest queued error string out of
-   the emcmot controller and puts it in arg */
+   the emcmot controller and puts it in arg, which must hold
+   EMCMOT_ERROR_LEN bytes */
     extern int usrmotReadEmcmotError(char *e);
 
+/* usrmotEventReaderInit() and usrmotReadEvent() let any other program
+   that called usrmotInit() follow the motion event ring (evring.h) with
+   a cursor of its own, independent of usrmotReadEmcmotError() */
+    extern int usrmotEventReaderInit(struct evring_reader *rd, int oldest);
+    extern int usrmotReadEvent(struct evring_reader *rd, struct evring_record *rec);
+
 /* usrmotPrintEmcmotStatus() prints the status in s, using which
    arg to select sub-prints */
     extern void usrmotPrintEmcmotStatus(emcmot_status_t *s, int which);
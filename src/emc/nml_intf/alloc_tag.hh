@@ -0,0 +1,57 @@
+/********************************************************************
+* Description: alloc_tag.hh
+*
+*   Tags for the allocation accounting in milltask.  Code that
+*   allocates on behalf of a subsystem opens an AllocTagScope, and
+*   every allocation made by the same thread until the scope closes
+*   is charged to that subsystem.  The accounting itself lives in
+*   task/taskalloc.cc; in every other program alloc_tag_set() is not
+*   defined and the scopes do nothing.
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+*
+********************************************************************/
+#ifndef ALLOC_TAG_HH
+#define ALLOC_TAG_HH
+
+enum alloc_tag {
+    ALLOC_TAG_OTHER,		// not in any scope
+    ALLOC_TAG_INTERP,		// reading and executing program lines
+    ALLOC_TAG_INTERP_LIST,	// messages queued for task by canon
+    ALLOC_TAG_CANON_QUEUE,	// canon calls held back by the interpreter
+    ALLOC_TAG_PYTHON,		// Python plugins, remaps and objects
+    ALLOC_TAG_NML,		// NML channels and their buffers
+    ALLOC_TAGS
+};
+
+static inline const char *alloc_tag_name(int tag)
+{
+    static const char *const names[ALLOC_TAGS] = {
+        "other", "interp", "interp_list", "canon_queue", "python", "nml"
+    };
+    return (tag >= 0 && tag < ALLOC_TAGS) ? names[tag] : "?";
+}
+
+// sets the tag of the calling thread, returns the previous one
+extern "C" int alloc_tag_set(int tag) __attribute__((weak));
+
+class AllocTagScope {
+public:
+    explicit AllocTagScope(int tag)
+        : prev(alloc_tag_set ? alloc_tag_set(tag) : 0) {}
+    ~AllocTagScope() {
+        if (alloc_tag_set) {
+            alloc_tag_set(prev);
+        }
+    }
+
+private:
+    AllocTagScope(const AllocTagScope &);
+    AllocTagScope &operator=(const AllocTagScope &);
+    int prev;
+};
+
+#endif
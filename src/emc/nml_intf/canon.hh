@@ -233,6 +233,12 @@ extern void CANON_UPDATE_END_POINT(double x, double y, double z,
 /* Called from emctask to update the canon position during skipping through
    programs started with start-from-line > 0. */
 
+extern void CANON_SAVE_STATE();
+extern void CANON_SWAP_STATE();
+/* Called from emctask around speculative interpretation: the first keeps
+   a copy of the canon state, the second exchanges the current state and
+   that copy. */
+
 extern void USE_LENGTH_UNITS(CANON_UNITS u);
 
 /* Use the specified units for length. Conceptually, the units must
@@ -17,6 +17,8 @@
 * Last change:
 ********************************************************************/
 
+#include <stddef.h>		// offsetof()
+
 // Include all NML, CMS, and RCS classes and functions
 #include "rcs.hh"
 
@@ -1015,6 +1017,7 @@ void EMC_TOOL_PREPARE::update(CMS * cms)
 
     EMC_TOOL_CMD_MSG::update(cms);
     cms->update(tool);
+    cms->update(prefetch);
 
 }
 
@@ -1095,9 +1098,9 @@ void EMC_JOINT_OVERRIDE_LIMITS::update(CMS * cms)
 */
 void PmCartesian_update(CMS * cms, PmCartesian * x)
 {
-    cms->update(x->x);
-    cms->update(x->y);
-    cms->update(x->z);
+    static_assert(offsetof(PmCartesian, z) == 2 * sizeof(double),
+		  "PmCartesian is not three doubles");
+    cms->update(&x->x, 3);
 
 }
 
@@ -1729,10 +1732,11 @@ void EMC_SPINDLE_DECREASE::update(CMS * cms)
 void CANON_TOOL_TABLE_update(CMS * cms, CANON_TOOL_TABLE * x)
 {
     cms->update(x->toolno);
-    EmcPose_update(cms, &x->offset);
-    cms->update(x->diameter);
-    cms->update(x->frontangle);
-    cms->update(x->backangle);
+    // the offset and the three after it
+    static_assert(offsetof(CANON_TOOL_TABLE, backangle) ==
+		  offsetof(CANON_TOOL_TABLE, offset) + 11 * sizeof(double),
+		  "CANON_TOOL_TABLE offset and angles are not contiguous");
+    cms->update(&x->offset.tran.x, 12);
 
 }
 
@@ -1983,6 +1987,10 @@ void EMC_TASK_STAT::update(CMS * cms)
     cms->update(interpreter_errcode);
     cms->update(input_timeout);
     cms->update(rotation_xy);
+    cms->update(memCurrent, ALLOC_TAGS);
+    cms->update(memPeak, ALLOC_TAGS);
+    cms->update(readaheadSegments);
+    cms->update(readaheadTime);
 
 }
 
@@ -2382,6 +2390,7 @@ void EMC_TRAJ_STAT::update(CMS * cms)
     cms->update(inpos);
     cms->update(queue);
     cms->update(activeQueue);
+    cms->update(queueTime);
     cms->update(queueFull);
     cms->update(id);
     cms->update(paused);
@@ -2570,13 +2579,10 @@ void EMC_COOLANT_FLOOD_OFF::update(CMS * cms)
 */
 void EmcPose_update(CMS * cms, EmcPose * x)
 {
-    PmCartesian_update(cms, &(x->tran));
-    cms->update(x->a);
-    cms->update(x->b);
-    cms->update(x->c);
-    cms->update(x->u);
-    cms->update(x->v);
-    cms->update(x->w);
+    // one array, which every updater encodes like the single doubles
+    static_assert(offsetof(EmcPose, w) == 8 * sizeof(double),
+		  "EmcPose is not nine doubles");
+    cms->update(&x->tran.x, 9);
 }
 
 /*
@@ -2737,12 +2743,9 @@ void EMC_TRAJ_SET_TELEOP_ENABLE::update(CMS * cms)
 */
 void CANON_POSITION_update(CMS * cms, CANON_POSITION * x)
 {
-    cms->update(x->x);
-    cms->update(x->y);
-    cms->update(x->z);
-    cms->update(x->a);
-    cms->update(x->b);
-    cms->update(x->c);
+    static_assert(offsetof(CANON_POSITION, c) == 5 * sizeof(double),
+		  "CANON_POSITION does not start with six doubles");
+    cms->update(&x->x, 6);
 
 }
 
@@ -341,6 +341,7 @@ extern int emcAxisSetMinPositionLimit(int axis, double limit);
 extern int emcAxisSetMaxPositionLimit(int axis, double limit);
 extern int emcAxisSetMaxVelocity(int axis, double vel, double ext_offset_vel);
 extern int emcAxisSetMaxAcceleration(int axis, double acc, double ext_offset_acc);
+extern int emcAxisSetMaxJerk(int axis, double jerk);
 extern double emcAxisGetMaxVelocity(int axis);
 extern double emcAxisGetMaxAcceleration(int axis);
 extern int emcAxisSetLockingJoint(int axis,int joint);
@@ -403,6 +404,7 @@ extern int emcTrajSetVelocity(double vel, double ini_maxvel);
 extern int emcTrajSetAcceleration(double acc);
 extern int emcTrajSetMaxVelocity(double vel);
 extern int emcTrajSetMaxAcceleration(double acc);
+extern int emcTrajSetMaxJerk(double jerk);
 extern int emcTrajSetScale(double scale);
 extern int emcTrajSetRapidScale(double scale);
 extern int emcTrajSetFOEnable(unsigned char mode);   //feed override enable
@@ -466,6 +468,7 @@ extern int emcToolInit();
 extern int emcToolHalt();
 extern int emcToolAbort();
 extern int emcToolPrepare(int tool);
+extern int emcToolPrefetch(int tool);
 extern int emcToolLoad();
 extern int emcToolUnload();
 extern int emcToolLoadToolTable(const char *file);
@@ -536,6 +539,7 @@ extern int emcHalt();
 extern int emcAbort();
 
 int emcSetMaxFeedOverride(double maxFeedScale);
+int emcSetJointLimitSamples(int samples);
 int emcSetupArcBlends(int arcBlendEnable,
         int arcBlendFallbackEnable,
         int arcBlendOptDepth,
@@ -23,6 +23,7 @@
 #include "modal_state.hh"
 #include "canon.hh"		// CANON_TOOL_TABLE, CANON_UNITS
 #include "rs274ngc.hh"		// ACTIVE_G_CODES, etc
+#include "alloc_tag.hh"		// ALLOC_TAGS
 
 // ------------------
 // CLASS DECLARATIONS
@@ -1042,6 +1043,7 @@ class EMC_TRAJ_STAT:public EMC_TRAJ_STAT_MSG {
     int queue;			// number of pending motions, counting
     // current
     int activeQueue;		// number of motions blending
+    double queueTime;		// estimated seconds of motion queued
     bool queueFull;		// non-zero means can't accept another motion
     int id;			// id of the currently executing motion
     bool paused;			// non-zero means motion paused
@@ -1518,6 +1520,10 @@ class EMC_TASK_STAT:public EMC_TASK_STAT_MSG {
     int task_paused;		// non-zero means task is paused
     double delayLeft;           // delay time left of G4, M66..
     int queuedMDIcommands;      // current length of MDI input queue
+    double memCurrent[ALLOC_TAGS];	// bytes in use per alloc_tag, with
+    double memPeak[ALLOC_TAGS];		// [TASK]ALLOC_ACCOUNTING only
+    int readaheadSegments;	// motions read but not yet executed
+    double readaheadTime;	// and their estimated seconds
 };
 
 // declarations for EMC_TOOL classes
@@ -1566,12 +1572,13 @@ class EMC_TOOL_ABORT:public EMC_TOOL_CMD_MSG {
 class EMC_TOOL_PREPARE:public EMC_TOOL_CMD_MSG {
   public:
     EMC_TOOL_PREPARE():EMC_TOOL_CMD_MSG(EMC_TOOL_PREPARE_TYPE,
-					sizeof(EMC_TOOL_PREPARE)) {
+					sizeof(EMC_TOOL_PREPARE)), prefetch(0) {
     };
 
     // For internal NML/CMS use only.
     void update(CMS * cms);
     int tool;
+    int prefetch;	// sent ahead of the T word, acknowledge without waiting
 };
 
 class EMC_TOOL_LOAD:public EMC_TOOL_CMD_MSG {
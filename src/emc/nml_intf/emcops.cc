@@ -65,6 +65,7 @@ EMC_TRAJ_STAT_MSG(EMC_TRAJ_STAT_TYPE, sizeof(EMC_TRAJ_STAT)),
     inpos = ON;
     queue = 0;
     activeQueue = 0;
+    queueTime = 0.0;
     queueFull = OFF;
     id = 0;
     paused = OFF;
@@ -150,6 +151,12 @@ EMC_TASK_STAT_MSG(EMC_TASK_STAT_TYPE, sizeof(EMC_TASK_STAT))
     task_paused = 0;
     delayLeft = 0.0;
     queuedMDIcommands = 0;
+    for (t = 0; t < ALLOC_TAGS; t++) {
+	memCurrent[t] = 0.0;
+	memPeak[t] = 0.0;
+    }
+    readaheadSegments = 0;
+    readaheadTime = 0.0;
 }
 
 EMC_TOOL_STAT::EMC_TOOL_STAT():
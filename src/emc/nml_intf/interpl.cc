@@ -21,6 +21,7 @@
 #include "emcglb.h"
 #include "nmlmsg.hh"            /* class NMLmsg */
 #include "rcs_print.hh"
+#include "alloc_tag.hh"
 
 NML_INTERP_LIST interp_list;	/* NML Union, for interpreter */
 
@@ -37,6 +38,7 @@ void NML_INTERP_LIST::set_line_number(int line)
 
 int NML_INTERP_LIST::append(NMLmsg * nml_msg_ptr)
 {
+    AllocTagScope alloc_tag(ALLOC_TAG_INTERP_LIST);
     /* check for invalid data */
     if (NULL == nml_msg_ptr) {
 	rcs_print_error
@@ -68,6 +70,12 @@ int NML_INTERP_LIST::append(NMLmsg * nml_msg_ptr)
 
     NML_INTERP_LIST_NODE node;
     node.line_number = next_line_number;
+    node.time = 0.0;
+    node.motion = estimator && estimator(nml_msg_ptr, &node.time);
+    if (node.motion) {
+        queued_motions++;
+        queued_time += node.time;
+    }
     node.command.reserve(nml_msg_ptr->size);
     // fill in the NML_INTERP_LIST_NODE
     node.command.insert(node.command.begin(), (char*)nml_msg_ptr, (char*)nml_msg_ptr + nml_msg_ptr->size);
@@ -90,7 +98,7 @@ NMLmsg *NML_INTERP_LIST::get()
 {
     NMLmsg *ret;
 
-    if(linked_list.empty()){
+    if(linked_list.empty() || (holding && visible == 0)){
         line_number = 0;
         return NULL;
     }
@@ -98,6 +106,10 @@ NMLmsg *NML_INTERP_LIST::get()
     // get it off the front
     node = linked_list.front();
     linked_list.pop_front();
+    forget(node);
+    if (holding) {
+        visible--;
+    }
 
     // save line number of this one, for use by get_line_number
     line_number = node.line_number;
@@ -116,12 +128,25 @@ NMLmsg *NML_INTERP_LIST::get()
     return ret;
 }
 
+// look at the n'th queued message without removing it; the pointer is
+// only valid until the list is next modified
+NMLmsg *NML_INTERP_LIST::peek(int n)
+{
+    if (n < 0 || n >= len()) {
+        return NULL;
+    }
+    return (NMLmsg *) linked_list[n].command.data();
+}
+
 void NML_INTERP_LIST::clear()
 {
     if (emc_debug & EMC_DEBUG_INTERP_LIST) {
         rcs_print("NML_INTERP_LIST(%p)::clear(): discarding %lu items\n", this, linked_list.size());
     }
 	linked_list.clear();
+    holding = false;
+    queued_motions = 0;
+    queued_time = 0.0;
 }
 
 void NML_INTERP_LIST::print()
@@ -138,7 +163,68 @@ void NML_INTERP_LIST::print()
 
 int NML_INTERP_LIST::len()
 {
-    return ((int) linked_list.size());
+    return ((int) (holding ? visible : linked_list.size()));
+}
+
+void NML_INTERP_LIST::hold()
+{
+    if (!holding) {
+        holding = true;
+        visible = linked_list.size();
+    }
+}
+
+// the held messages join the others
+void NML_INTERP_LIST::release()
+{
+    holding = false;
+}
+
+void NML_INTERP_LIST::drop_held()
+{
+    if (holding) {
+        if (emc_debug & EMC_DEBUG_INTERP_LIST) {
+            rcs_print("NML_INTERP_LIST(%p)::drop_held(): discarding %lu items\n",
+                      this, linked_list.size() - visible);
+        }
+        for (size_t i = visible; i < linked_list.size(); i++) {
+            forget(linked_list[i]);
+        }
+        linked_list.erase(linked_list.begin() + visible, linked_list.end());
+        holding = false;
+    }
+}
+
+int NML_INTERP_LIST::held_len()
+{
+    return ((int) (holding ? linked_list.size() - visible : 0));
+}
+
+void NML_INTERP_LIST::set_estimator(NML_INTERP_LIST_ESTIMATOR e)
+{
+    estimator = e;
+}
+
+int NML_INTERP_LIST::motions()
+{
+    return queued_motions;
+}
+
+double NML_INTERP_LIST::time()
+{
+    return queued_time;
+}
+
+// a message left the list
+void NML_INTERP_LIST::forget(const NML_INTERP_LIST_NODE &gone)
+{
+    if (gone.motion) {
+        queued_motions--;
+        queued_time -= gone.time;
+    }
+    if (queued_motions == 0) {
+        queued_time = 0.0;
+    }
 }
 
 int NML_INTERP_LIST::get_line_number()
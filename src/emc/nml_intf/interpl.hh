@@ -17,15 +17,21 @@
 #ifndef INTERP_LIST_HH
 #define INTERP_LIST_HH
 
+#include <stddef.h>
 #include <deque>
 #include <vector>
 
 // these go on the interp list
 struct NML_INTERP_LIST_NODE {
   int line_number;		// line number it was on
+  bool motion;			// counted by motions() and time()
+  double time;			// estimated seconds of motion
   std::vector<char> command;
 };
 
+// tells whether a message moves the machine and, if so, for how long
+typedef bool (*NML_INTERP_LIST_ESTIMATOR)(NMLmsg *, double *time);
+
 // here's the interp list itself
 class NML_INTERP_LIST {
   public:
@@ -34,12 +40,32 @@ class NML_INTERP_LIST {
     int append(NMLmsg &);
     int append(NMLmsg *);
     NMLmsg *get();
+    NMLmsg *peek(int n);
     void clear();
     void print();
     int len();
 
+    // messages appended after hold() stay out of get(), peek() and len()
+    // until they are either released or dropped
+    void hold();
+    void release();
+    void drop_held();
+    int held_len();
+
+    // how far the list reaches, held messages included; zero unless an
+    // estimator was set, which sees every message as it is appended
+    void set_estimator(NML_INTERP_LIST_ESTIMATOR estimator);
+    int motions();
+    double time();
+
   private:
     std::deque<NML_INTERP_LIST_NODE> linked_list;
+    bool holding = false;
+    size_t visible = 0;		// messages ahead of the held ones
+    NML_INTERP_LIST_ESTIMATOR estimator = NULL;
+    int queued_motions = 0;
+    double queued_time = 0.0;
+    void forget(const NML_INTERP_LIST_NODE &gone);
     int next_line_number = 0;	// line number used to fill temp_node
     int line_number = 0;		// line number of node from get()
     NML_INTERP_LIST_NODE node; // pointer returned by get
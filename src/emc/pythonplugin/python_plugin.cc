@@ -18,6 +18,7 @@
  */
 #include "python_plugin.hh"
 #include "inifile.hh"
+#include "alloc_tag.hh"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -57,6 +58,7 @@ static const char *strstore(const char *s);
 
 int PythonPlugin::run_string(const char *cmd, bp::object &retval, bool as_file)
 {
+    AllocTagScope alloc_tag(ALLOC_TAG_PYTHON);
     reload();
     try {
 	if (as_file)
@@ -83,6 +85,7 @@ int PythonPlugin::run_string(const char *cmd, bp::object &retval, bool as_file)
 
 int PythonPlugin::call_method(bp::object method, bp::object &retval) 
 {
+    AllocTagScope alloc_tag(ALLOC_TAG_PYTHON);
 
     logPP(1, "call_method()");
     if (status < PLUGIN_OK)
@@ -111,6 +114,7 @@ int PythonPlugin::call_method(bp::object method, bp::object &retval)
 int PythonPlugin::call(const char *module, const char *callable,
 		       bp::object tupleargs, bp::object kwargs, bp::object &retval)
 {
+    AllocTagScope alloc_tag(ALLOC_TAG_PYTHON);
     bp::object function;
 
     if (callable == NULL)
@@ -293,6 +297,7 @@ PythonPlugin::PythonPlugin(struct _inittab *inittab) :
     abs_path(0),
     log_level(0)
 {
+  AllocTagScope alloc_tag(ALLOC_TAG_PYTHON);
   if (abs_path) {
     wchar_t *program = Py_DecodeLocale(abs_path, NULL);
     Py_SetProgramName(program);
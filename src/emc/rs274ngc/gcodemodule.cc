@@ -44,6 +44,7 @@
 
 #include <Python.h>
 #include <structmember.h>
+#include <sys/stat.h>
 
 #include "rs274ngc.hh"
 #include "rs274ngc_interp.hh"
@@ -51,6 +52,8 @@
 #include "canon.hh"
 #include "config.h"		// LINELEN
 #include "units.h"
+#include "interp_cache.hh"
+#include "tooldata.hh"
 
 int _task = 0; // control preview behaviour when remapping
 
@@ -175,6 +178,98 @@ static InterpBase *pinterp;
 
 #define callmethod(o, m, f, ...) PyObject_CallMethod((o), (char*)(m), (char*)(f), ## __VA_ARGS__)
 
+/* The canon calls that reach the Python callback.  While a program is
+ * parsed they are also written to the program cache (interp_cache.hh),
+ * and a later parse of the same program with the same settings replays
+ * them from there instead of running the interpreter again.
+ */
+enum canon_call {
+    CC_NEXT_LINE, CC_ARC_FEED, CC_STRAIGHT_FEED, CC_STRAIGHT_TRAVERSE,
+    CC_SET_G5X_OFFSET, CC_SET_G92_OFFSET, CC_SET_XY_ROTATION, CC_SET_PLANE,
+    CC_SET_TRAVERSE_RATE, CC_CHANGE_TOOL, CC_SET_FEED_RATE, CC_DWELL,
+    CC_MESSAGE, CC_COMMENT, CC_TOOL_OFFSET, CC_STRAIGHT_PROBE, CC_RIGID_TAP,
+    CC_USER_DEFINED_FUNCTION,
+    CC_RESULT       // end of the stream: result, last line, error text
+};
+
+static const struct { const char *method, *format; } canon_calls[] = {
+    {"next_line", ""},
+    {"arc_feed", "ffffifffffff"},
+    {"straight_feed", "fffffffff"},
+    {"straight_traverse", "fffffffff"},
+    {"set_g5x_offset", "ifffffffff"},
+    {"set_g92_offset", "fffffffff"},
+    {"set_xy_rotation", "f"},
+    {"set_plane", "i"},
+    {"set_traverse_rate", "f"},
+    {"change_tool", "i"},
+    {"set_feed_rate", "f"},
+    {"dwell", "f"},
+    {"message", "s"},
+    {"comment", "s"},
+    {"tool_offset", "fffffffff"},
+    {"straight_probe", "fffffffff"},
+    {"rigid_tap", "fff"},
+    {"user_defined_function", "iff"},
+};
+
+static ProgramCacheWriter *recorder;
+static ProgramCacheDeps *recorded_deps;
+static std::string replayed_error;
+
+static PyObject *call_canon_args(int call, PyObject *args) {
+    PyObject *method = PyObject_GetAttrString(callback, canon_calls[call].method);
+    if(!method) { Py_DECREF(args); return NULL; }
+    PyObject *result = PyObject_Call(method, args, NULL);
+    Py_DECREF(method);
+    Py_DECREF(args);
+    return result;
+}
+
+static PyObject *call_canon(int call, ...) {
+    const char *fmt = canon_calls[call].format;
+    PyObject *args = PyTuple_New(strlen(fmt));
+    if(!args) return NULL;
+    if(recorder) recorder->put_u8(call);
+    va_list ap;
+    va_start(ap, call);
+    for(int i=0; fmt[i]; i++) {
+        PyObject *o;
+        if(fmt[i] == 'f') {
+            double d = va_arg(ap, double);
+            if(recorder) recorder->put_f64(d);
+            o = PyFloat_FromDouble(d);
+        } else if(fmt[i] == 'i') {
+            int v = va_arg(ap, int);
+            if(recorder) recorder->put_i32(v);
+            o = PyLong_FromLong(v);
+        } else {
+            const char *v = va_arg(ap, const char *);
+            if(recorder) recorder->put_str(v);
+            o = PyUnicode_FromString(v);
+        }
+        if(!o) { va_end(ap); Py_DECREF(args); return NULL; }
+        PyTuple_SET_ITEM(args, i, o);
+    }
+    va_end(ap);
+    return call_canon_args(call, args);
+}
+
+// remember what the callback told the interpreter, see check_answer()
+static void note_answer(const char *name, PyObject *result) {
+    if(!recorded_deps || !result) return;
+    PyObject *repr = PyObject_Repr(result);
+    const char *s = repr ? PyUnicode_AsUTF8(repr) : NULL;
+    if(s) {
+        recorded_deps->add_value(name, s);
+    } else {
+        // an answer we cannot record makes the entry useless
+        PyErr_Clear();
+        recorder->discard();
+    }
+    Py_XDECREF(repr);
+}
+
 static void maybe_new_line(int sequence_number=pinterp->sequence_number());
 static void maybe_new_line(int sequence_number) {
     if(!pinterp) return;
@@ -188,6 +283,12 @@ static void maybe_new_line(int sequence_number) {
     pinterp->active_m_codes(new_line_code->mcodes);
     new_line_code->gcodes[0] = sequence_number;
     last_sequence_number = sequence_number;
+    if(recorder) {
+        recorder->put_u8(CC_NEXT_LINE);
+        recorder->put(new_line_code->settings, sizeof(new_line_code->settings));
+        recorder->put(new_line_code->gcodes, sizeof(new_line_code->gcodes));
+        recorder->put(new_line_code->mcodes, sizeof(new_line_code->mcodes));
+    }
     PyObject *result = 
         callmethod(callback, "next_line", "O", new_line_code);
     Py_DECREF(new_line_code);
@@ -317,7 +418,7 @@ void ARC_FEED(int line_number,
     maybe_new_line(line_number);
     if(interp_error) return;
     PyObject *result =
-        callmethod(callback, "arc_feed", "ffffifffffff",
+        call_canon(CC_ARC_FEED,
                             first_end, second_end, first_axis, second_axis,
                             rotation, axis_end_point, 
                             a_position, b_position, c_position,
@@ -337,7 +438,7 @@ void STRAIGHT_FEED(int line_number,
     maybe_new_line(line_number);
     if(interp_error) return;
     PyObject *result =
-        callmethod(callback, "straight_feed", "fffffffff",
+        call_canon(CC_STRAIGHT_FEED,
                             x, y, z, a, b, c, u, v, w);
     if(result == NULL) interp_error ++;
     Py_XDECREF(result);
@@ -354,7 +455,7 @@ void STRAIGHT_TRAVERSE(int line_number,
     maybe_new_line(line_number);
     if(interp_error) return;
     PyObject *result =
-        callmethod(callback, "straight_traverse", "fffffffff",
+        call_canon(CC_STRAIGHT_TRAVERSE,
                             x, y, z, a, b, c, u, v, w);
     if(result == NULL) interp_error ++;
     Py_XDECREF(result);
@@ -368,7 +469,7 @@ void SET_G5X_OFFSET(int g5x_index,
     maybe_new_line();
     if(interp_error) return;
     PyObject *result =
-        callmethod(callback, "set_g5x_offset", "ifffffffff",
+        call_canon(CC_SET_G5X_OFFSET,
                             g5x_index, x, y, z, a, b, c, u, v, w);
     if(result == NULL) interp_error ++;
     Py_XDECREF(result);
@@ -381,7 +482,7 @@ void SET_G92_OFFSET(double x, double y, double z,
     maybe_new_line();
     if(interp_error) return;
     PyObject *result =
-        callmethod(callback, "set_g92_offset", "fffffffff",
+        call_canon(CC_SET_G92_OFFSET,
                             x, y, z, a, b, c, u, v, w);
     if(result == NULL) interp_error ++;
     Py_XDECREF(result);
@@ -391,7 +492,7 @@ void SET_XY_ROTATION(double t) {
     maybe_new_line();
     if(interp_error) return;
     PyObject *result =
-        callmethod(callback, "set_xy_rotation", "f", t);
+        call_canon(CC_SET_XY_ROTATION, t);
     if(result == NULL) interp_error ++;
     Py_XDECREF(result);
 };
@@ -402,7 +503,7 @@ void SELECT_PLANE(CANON_PLANE pl) {
     maybe_new_line();   
     if(interp_error) return;
     PyObject *result =
-        callmethod(callback, "set_plane", "i", pl);
+        call_canon(CC_SET_PLANE, (int)pl);
     if(result == NULL) interp_error ++;
     Py_XDECREF(result);
 }
@@ -411,7 +512,7 @@ void SET_TRAVERSE_RATE(double rate) {
     maybe_new_line();   
     if(interp_error) return;
     PyObject *result =
-        callmethod(callback, "set_traverse_rate", "f", rate);
+        call_canon(CC_SET_TRAVERSE_RATE, rate);
     if(result == NULL) interp_error ++;
     Py_XDECREF(result);
 }
@@ -431,7 +532,7 @@ void CHANGE_TOOL(int pocket) {
     maybe_new_line();
     if(interp_error) return;
     PyObject *result = 
-        callmethod(callback, "change_tool", "i", pocket);
+        call_canon(CC_CHANGE_TOOL, pocket);
     if(result == NULL) interp_error ++;
     Py_XDECREF(result);
 }
@@ -455,7 +556,7 @@ void SET_FEED_RATE(double rate) {
     if(interp_error) return;
     if(metric) rate /= 25.4;
     PyObject *result =
-        callmethod(callback, "set_feed_rate", "f", rate);
+        call_canon(CC_SET_FEED_RATE, rate);
     if(result == NULL) interp_error ++;
     Py_XDECREF(result);
 }
@@ -464,7 +565,7 @@ void DWELL(double time) {
     maybe_new_line();   
     if(interp_error) return;
     PyObject *result =
-        callmethod(callback, "dwell", "f", time);
+        call_canon(CC_DWELL, time);
     if(result == NULL) interp_error ++;
     Py_XDECREF(result);
 }
@@ -473,7 +574,7 @@ void MESSAGE(char *comment) {
     maybe_new_line();   
     if(interp_error) return;
     PyObject *result =
-        callmethod(callback, "message", "s", comment);
+        call_canon(CC_MESSAGE, comment);
     if(result == NULL) interp_error ++;
     Py_XDECREF(result);
 }
@@ -487,7 +588,7 @@ void COMMENT(const char *comment) {
     maybe_new_line();   
     if(interp_error) return;
     PyObject *result =
-        callmethod(callback, "comment", "s", comment);
+        call_canon(CC_COMMENT, comment);
     if(result == NULL) interp_error ++;
     Py_XDECREF(result);
 }
@@ -503,7 +604,7 @@ void USE_TOOL_LENGTH_OFFSET(EmcPose offset) {
     if(metric) {
         offset.tran.x /= 25.4; offset.tran.y /= 25.4; offset.tran.z /= 25.4;
         offset.u /= 25.4; offset.v /= 25.4; offset.w /= 25.4; }
-    PyObject *result = callmethod(callback, "tool_offset", "ddddddddd", offset.tran.x, offset.tran.y, offset.tran.z,
+    PyObject *result = call_canon(CC_TOOL_OFFSET, offset.tran.x, offset.tran.y, offset.tran.z,
         offset.a, offset.b, offset.c, offset.u, offset.v, offset.w);
     if(result == NULL) interp_error ++;
     Py_XDECREF(result);
@@ -541,6 +642,7 @@ extern bool GET_BLOCK_DELETE(void) {
     if(interp_error) return 0;
     PyObject *result =
         callmethod(callback, "get_block_delete", "");
+    note_answer("get_block_delete", result);
     if(result == NULL) {
         interp_error++;
     } else {
@@ -595,7 +697,7 @@ void STRAIGHT_PROBE(int line_number,
     maybe_new_line(line_number);
     if(interp_error) return;
     PyObject *result =
-        callmethod(callback, "straight_probe", "fffffffff",
+        call_canon(CC_STRAIGHT_PROBE,
                             x, y, z, a, b, c, u, v, w);
     if(result == NULL) interp_error ++;
     Py_XDECREF(result);
@@ -607,7 +709,7 @@ void RIGID_TAP(int line_number,
     maybe_new_line(line_number);
     if(interp_error) return;
     PyObject *result =
-        callmethod(callback, "rigid_tap", "fff",
+        call_canon(CC_RIGID_TAP,
             x, y, z);
     if(result == NULL) interp_error ++;
     Py_XDECREF(result);
@@ -655,6 +757,11 @@ CANON_TOOL_TABLE GET_EXTERNAL_TOOL_TABLE(int pocket) {
     if(interp_error) return tdata;
     PyObject *result =
         callmethod(callback, "get_tool", "i", pocket);
+    if(recorded_deps) {
+        char name[32];
+        snprintf(name, sizeof(name), "get_tool %d", pocket);
+        note_answer(name, result);
+    }
     if(result == NULL ||
        !PyArg_ParseTuple(result, "iddddddddddddi",
              &tdata.toolno,
@@ -677,8 +784,7 @@ static void user_defined_function(int num, double arg1, double arg2) {
     if(interp_error) return;
     maybe_new_line();
     PyObject *result =
-        callmethod(callback, "user_defined_function",
-                            "idd", num, arg1, arg2);
+        call_canon(CC_USER_DEFINED_FUNCTION, num, arg1, arg2);
     if(result == NULL) interp_error++;
     Py_XDECREF(result);
 }
@@ -721,6 +827,7 @@ int GET_EXTERNAL_AXIS_MASK() {
     if(interp_error) return 7;
     PyObject *result =
         callmethod(callback, "get_axis_mask", "");
+    note_answer("get_axis_mask", result);
     if(!result) { interp_error ++; return 7 /* XYZABC */; }
     if(!PyLong_Check(result)) { interp_error ++; return 7 /* XYZABC */; }
     int mask = PyLong_AsLong(result);
@@ -773,6 +880,7 @@ static bool PyFloat_CheckAndError(const char *func, PyObject *p)  {
 double GET_EXTERNAL_ANGLE_UNITS() {
     PyObject *result =
         callmethod(callback, "get_external_angular_units", "");
+    note_answer("get_external_angular_units", result);
     if(result == NULL) interp_error++;
 
     double dresult = 1.0;
@@ -788,6 +896,7 @@ double GET_EXTERNAL_ANGLE_UNITS() {
 double GET_EXTERNAL_LENGTH_UNITS() {
     PyObject *result =
         callmethod(callback, "get_external_length_units", "");
+    note_answer("get_external_length_units", result);
     if(result == NULL) interp_error++;
 
     double dresult = 0.03937007874016;
@@ -822,6 +931,134 @@ void SET_MOTION_CONTROL_MODE(CANON_MOTION_MODE mode) { motion_mode = mode; }
 CANON_MOTION_MODE GET_EXTERNAL_MOTION_CONTROL_MODE() { return motion_mode; }
 void SET_NAIVECAM_TOLERANCE(double tolerance) { }
 
+// ProgramCacheCheck for the answers recorded by note_answer()
+static bool check_answer(const std::string &name, const std::string &value) {
+    char method[64];
+    int arg;
+    PyObject *result;
+    if(sscanf(name.c_str(), "%63s %d", method, &arg) == 2)
+        result = callmethod(callback, method, "i", arg);
+    else
+        result = callmethod(callback, name.c_str(), "");
+    PyObject *repr = result ? PyObject_Repr(result) : NULL;
+    const char *s = repr ? PyUnicode_AsUTF8(repr) : NULL;
+    bool same = s && value == s;
+    if(!s) PyErr_Clear();
+    Py_XDECREF(repr);
+    Py_XDECREF(result);
+    return same;
+}
+
+/* Everything besides the callback's answers that the canon calls of a
+ * parse depend on: the program text, the arguments to parse(), the INI
+ * file, what is in the subroutine and remap module directories it names,
+ * the parameter file and the tool table.  Small programs are not worth
+ * caching.
+ */
+static bool preview_key(ProgramCacheKey &key, const char *f, PyObject *initcodes,
+        const char *unitcode, const char *initcode, const char *interpname) {
+    struct stat st;
+    if(stat(f, &st) != 0 || st.st_size < PROGRAM_CACHE_MIN_SIZE) return false;
+    if(program_cache_dir().empty()) return false;
+    if(!key.add_file(f)) return false;
+    key.add(PACKAGE_VERSION);
+    key.add(unitcode);
+    key.add(initcode);
+    key.add(interpname);
+    if(initcodes) {
+        for(int i=0; i<PyList_Size(initcodes); i++) {
+            const char *code = PyUnicode_AsUTF8(PyList_GetItem(initcodes, i));
+            if(!code) { PyErr_Clear(); return false; }
+            key.add(code);
+        }
+    }
+    const char *ini = getenv("INI_FILE_NAME");
+    key.add(ini);
+    if(ini) key.add_file(ini);
+    key.add_search_paths(ini);
+    PyObject *parameter_file = PyObject_GetAttrString(callback, "parameter_file");
+    const char *pf = parameter_file ? PyUnicode_AsUTF8(parameter_file) : NULL;
+    key.add(pf);
+    if(pf) key.add_file(pf);
+    PyErr_Clear();
+    Py_XDECREF(parameter_file);
+    for(int idx=0; idx<=tooldata_last_index_get(); idx++) {
+        CANON_TOOL_TABLE tdata;
+        if(tooldata_get(&tdata, idx) != IDX_OK) continue;
+        key.add(idx);
+        key.add(tdata.toolno);
+        key.add(tdata.pocketno);
+        key.add(&tdata.offset, sizeof(tdata.offset));
+        key.add(&tdata.diameter, sizeof(tdata.diameter));
+        key.add(&tdata.frontangle, sizeof(tdata.frontangle));
+        key.add(&tdata.backangle, sizeof(tdata.backangle));
+        key.add(tdata.orientation);
+    }
+    return true;
+}
+
+// feed the canon calls of an earlier parse to the callback again
+static PyObject *replay_preview(ProgramCacheReader &reader) {
+    struct timeval t0, t1;
+    int wait = 1;
+    uint8_t call;
+
+    gettimeofday(&t0, NULL);
+    while(reader.get_u8(call)) {
+        PyObject *result;
+        if(call == CC_RESULT) {
+            int32_t r, line;
+            if(!reader.get_i32(r) || !reader.get_i32(line) ||
+                    !reader.get_str(replayed_error))
+                break;
+            return Py_BuildValue("(ii)", r, line);
+        } else if(call == CC_NEXT_LINE) {
+            LineCode *new_line_code =
+                (LineCode*)(PyObject_New(LineCode, &LineCodeType));
+            if(!reader.get(new_line_code->settings, sizeof(new_line_code->settings)) ||
+                    !reader.get(new_line_code->gcodes, sizeof(new_line_code->gcodes)) ||
+                    !reader.get(new_line_code->mcodes, sizeof(new_line_code->mcodes))) {
+                Py_DECREF(new_line_code);
+                break;
+            }
+            result = callmethod(callback, "next_line", "O", new_line_code);
+            Py_DECREF(new_line_code);
+        } else if(call < CC_RESULT) {
+            const char *fmt = canon_calls[call].format;
+            PyObject *args = PyTuple_New(strlen(fmt));
+            bool ok = true;
+            for(int i=0; ok && fmt[i]; i++) {
+                double d;
+                int32_t v;
+                std::string str;
+                PyObject *o = NULL;
+                if(fmt[i] == 'f') {
+                    if((ok = reader.get_f64(d))) o = PyFloat_FromDouble(d);
+                } else if(fmt[i] == 'i') {
+                    if((ok = reader.get_i32(v))) o = PyLong_FromLong(v);
+                } else {
+                    if((ok = reader.get_str(str))) o = PyUnicode_FromString(str.c_str());
+                }
+                if(ok && !o) { Py_DECREF(args); return NULL; }
+                if(ok) PyTuple_SET_ITEM(args, i, o);
+            }
+            if(!ok) { Py_DECREF(args); break; }
+            result = call_canon_args(call, args);
+        } else {
+            break;
+        }
+        if(!result) return NULL;
+        Py_DECREF(result);
+        gettimeofday(&t1, NULL);
+        if(t1.tv_sec > t0.tv_sec + wait) {
+            if(check_abort()) return NULL;
+            t0 = t1;
+        }
+    }
+    PyErr_Format(PyExc_RuntimeError, "parse: damaged program cache entry");
+    return NULL;
+}
+
 #define RESULT_OK (result == INTERP_OK || result == INTERP_EXECUTE_FINISH)
 static PyObject *parse_file(PyObject *self, PyObject *args) {
     char *f;
@@ -841,6 +1078,31 @@ static PyObject *parse_file(PyObject *self, PyObject *args) {
             return NULL;
     }
 
+    replayed_error.clear();
+    ProgramCacheKey key("preview");
+    bool cacheable = preview_key(key, f, initcodes, unitcode, initcode, interpname);
+    if(cacheable) {
+        ProgramCacheReader reader;
+        if(reader.open(key, check_answer)) {
+            if(pinterp) {
+                delete pinterp;
+                pinterp = 0;
+            }
+            return replay_preview(reader);
+        }
+    }
+
+    // record this parse for the next time, see replay_preview()
+    ProgramCacheWriter writer;
+    ProgramCacheDeps deps;
+    struct recording_guard {
+        ~recording_guard() { recorder = 0; recorded_deps = 0; }
+    } guard;
+    if(cacheable && writer.open(key)) {
+        recorder = &writer;
+        recorded_deps = &deps;
+    }
+
     if(pinterp) {
         delete pinterp;
         pinterp = 0;
@@ -926,6 +1188,15 @@ out_error:
     PyErr_Clear();
     maybe_new_line();
     if(PyErr_Occurred()) { interp_error = 1; goto out_error; }
+    if(recorder && recorder->is_open()) {
+        char text[LINELEN+1] = "";
+        if(result > INTERP_MIN_ERROR) pinterp->error_text(result, text, LINELEN);
+        recorder->put_u8(CC_RESULT);
+        recorder->put_i32(result);
+        recorder->put_i32(last_sequence_number + error_line_offset);
+        recorder->put_str(text);
+        recorder->commit(deps);
+    }
     PyObject *retval = PyTuple_New(2);
     PyTuple_SetItem(retval, 0, PyLong_FromLong(result));
     PyTuple_SetItem(retval, 1, PyLong_FromLong(last_sequence_number + error_line_offset));
@@ -939,6 +1210,8 @@ static char savedError[LINELEN+1];
 static PyObject *rs274_strerror(PyObject *s, PyObject *o) {
     int err;
     if(!PyArg_ParseTuple(o, "i", &err)) return nullptr;
+    if(!pinterp) // the last parse was replayed from the program cache
+        return PyUnicode_FromString(replayed_error.c_str());
     pinterp->error_text(err, savedError, LINELEN);
     return PyUnicode_FromString(savedError);
 }
@@ -23,6 +23,28 @@
 
 InterpBase::~InterpBase() {}
 
+int InterpBase::restore_checkpoint(int, int *restored) {
+    *restored = 0;
+    return 0;
+}
+
+void InterpBase::record_checkpoints(bool) {
+}
+
+int InterpBase::speculate(int *speculating) {
+    *speculating = 0;
+    return 0;
+}
+
+bool InterpBase::speculation_blocked() {
+    return false;
+}
+
+int InterpBase::resolve_speculation(int *committed) {
+    *committed = 0;
+    return 0;
+}
+
 InterpBase *interp_from_shlib(const char *shlib) {
     void * interp_lib;
     char relative_interp[PATH_MAX];
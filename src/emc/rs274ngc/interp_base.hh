@@ -66,6 +66,19 @@ public:
     virtual void print_state_tag(StateTag const &tag) = 0;
     virtual void set_loglevel(int level) = 0;
     virtual void set_loop_on_main_m99(bool state) = 0;
+    // skip ahead to a saved state before 'line' of the program just
+    // opened; *restored is 0 when nothing was skipped
+    virtual int restore_checkpoint(int line, int *restored);
+    // take checkpoints while programs run from the start
+    virtual void record_checkpoints(bool on);
+    // go on reading past the queue buster just executed; *speculating
+    // is 0 when the caller has to wait for it as before
+    virtual int speculate(int *speculating);
+    // true once reading ahead reached a line that has to wait
+    virtual bool speculation_blocked();
+    // the queue buster completed: *committed is 1 when the lines read
+    // ahead stand, 0 when the interpreter went back to the line after it
+    virtual int resolve_speculation(int *committed);
 };
 
 InterpBase *interp_from_shlib(const char *shlib);
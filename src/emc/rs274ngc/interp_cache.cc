@@ -0,0 +1,516 @@
+/********************************************************************
+* Description: interp_cache.cc
+*
+*   On-disk cache for the results of running a program through the
+*   interpreter, see interp_cache.hh.
+*
+*   An entry is a single file:
+*     header   "LCNCPC01", key, kind
+*     payload  whatever the user of the cache wrote
+*     deps     count, then path, size and mtime of each file read;
+*              count, then name and value of each recorded answer
+*     trailer  offset of deps, "LCNCPCND"
+*   It is written under a temporary name and renamed into place, so
+*   readers only ever see complete entries.
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+*
+********************************************************************/
+
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <algorithm>
+
+#include "interp_cache.hh"
+#include "inifile.hh"
+
+static const char head_magic[8] = {'L','C','N','C','P','C','0','1'};
+static const char tail_magic[8] = {'L','C','N','C','P','C','N','D'};
+
+static inline uint64_t mix(uint64_t h, uint64_t w)
+{
+    h ^= w * 0x9e3779b97f4a7c15ULL;
+    h = (h << 31) | (h >> 33);
+    return h * 0xbf58476d1ce4e5b9ULL;
+}
+
+ProgramCacheKey::ProgramCacheKey(const char *kind) : kind_(kind), h(0x6c636e6370726f67ULL)
+{
+    add(kind);
+}
+
+void ProgramCacheKey::add(const void *data, size_t len)
+{
+    const unsigned char *p = (const unsigned char *) data;
+    size_t n = len;
+    uint64_t w;
+
+    while (n >= sizeof(w)) {
+        memcpy(&w, p, sizeof(w));
+        h = mix(h, w);
+        p += sizeof(w);
+        n -= sizeof(w);
+    }
+    w = 0;
+    memcpy(&w, p, n);
+    h = mix(h, w);
+    h = mix(h, len);
+}
+
+void ProgramCacheKey::add(const char *s)
+{
+    if (!s) {
+        add(-1);
+        return;
+    }
+    add(s, strlen(s));
+}
+
+bool ProgramCacheKey::add_file(const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        return false;
+    }
+    while (add_file_block(fp)) {
+    }
+    bool ok = !ferror(fp);
+    fclose(fp);
+    return ok;
+}
+
+bool ProgramCacheKey::add_file_block(FILE *fp)
+{
+    char buf[PROGRAM_CACHE_HASH_BLOCK];
+    size_t n = fread(buf, 1, sizeof(buf), fp);
+    if (n > 0) {
+        add(buf, n);
+    }
+    return n == sizeof(buf);
+}
+
+// the regular files in dir by name, size and mtime; a subroutine that
+// shadows another one in a later directory changes the key even though
+// the entry never depended on it
+static void add_dir(ProgramCacheKey &key, const std::string &dir)
+{
+    key.add(dir.c_str());
+    DIR *d = opendir(dir.c_str());
+    if (!d) {
+        key.add(-1);
+        return;
+    }
+    std::vector<std::string> names;
+    struct dirent *de;
+    while ((de = readdir(d))) {
+        names.push_back(de->d_name);
+    }
+    closedir(d);
+    std::sort(names.begin(), names.end());
+    for (auto &name : names) {
+        struct stat st;
+        if (stat((dir + "/" + name).c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        int64_t size = st.st_size;
+        int64_t mtime = (int64_t) st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+        key.add(name.c_str());
+        key.add(&size, sizeof(size));
+        key.add(&mtime, sizeof(mtime));
+    }
+}
+
+/* The directories are the ones the interpreter and its Python plugin
+   search: [DISPLAY]PROGRAM_PREFIX, [RS274NGC]SUBROUTINE_PATH, the
+   directory of [PYTHON]TOPLEVEL and [PYTHON]PATH_PREPEND/PATH_APPEND.
+   Relative paths are taken from the current directory as they are
+   there.  Modules imported from further down, out of packages, are
+   not covered. */
+void ProgramCacheKey::add_search_paths(const char *ini)
+{
+    IniFile inifile;
+    if (!ini || !inifile.Open(ini)) {
+        return;
+    }
+    std::vector<std::string> dirs;
+    char path[PATH_MAX];
+    auto add_path = [&](const char *p) {
+        if (inifile.TildeExpansion(p, path, sizeof(path)) == IniFile::ERR_NONE) {
+            dirs.push_back(path);
+        } else {
+            dirs.push_back(p);
+        }
+    };
+    const char *s;
+    if ((s = inifile.Find("PROGRAM_PREFIX", "DISPLAY"))) {
+        add_path(s);
+    }
+    if ((s = inifile.Find("SUBROUTINE_PATH", "RS274NGC"))) {
+        std::string subs = s;
+        size_t start = 0, end;
+        do {
+            end = subs.find(':', start);
+            std::string dir = subs.substr(start, end == std::string::npos ? end : end - start);
+            if (!dir.empty()) {
+                add_path(dir.c_str());
+            }
+            start = end + 1;
+        } while (end != std::string::npos);
+    }
+    if ((s = inifile.Find("TOPLEVEL", "PYTHON"))) {
+        std::string toplevel = s;
+        size_t slash = toplevel.rfind('/');
+        add_path(slash == std::string::npos ? "." :
+                 slash == 0 ? "/" : toplevel.substr(0, slash).c_str());
+    }
+    for (int n = 1; (s = inifile.Find("PATH_PREPEND", "PYTHON", n)); n++) {
+        add_path(s);
+    }
+    for (int n = 1; (s = inifile.Find("PATH_APPEND", "PYTHON", n)); n++) {
+        add_path(s);
+    }
+    inifile.Close();
+    for (auto &dir : dirs) {
+        add_dir(*this, dir);
+    }
+}
+
+static std::vector<ProgramCacheDeps *> active_deps;
+
+ProgramCacheDeps::ProgramCacheDeps()
+{
+    active_deps.push_back(this);
+}
+
+ProgramCacheDeps::~ProgramCacheDeps()
+{
+    active_deps.erase(std::remove(active_deps.begin(), active_deps.end(), this),
+                      active_deps.end());
+}
+
+static bool stat_dep(const char *path, int64_t &size, int64_t &mtime)
+{
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return false;
+    }
+    size = st.st_size;
+    mtime = (int64_t) st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+    return true;
+}
+
+void ProgramCacheDeps::add(const char *path)
+{
+    for (auto &d : deps) {
+        if (d.path == path) {
+            return;
+        }
+    }
+    Dep d;
+    d.path = path;
+    // a file that cannot be stat'ed now is recorded as missing, and
+    // the entry stays valid only as long as it stays missing
+    if (!stat_dep(path, d.size, d.mtime)) {
+        d.size = d.mtime = -1;
+    }
+    deps.push_back(d);
+}
+
+void ProgramCacheDeps::add_value(const std::string &name, const std::string &value)
+{
+    for (auto &v : values) {
+        if (v.first == name) {
+            return;
+        }
+    }
+    values.push_back(std::make_pair(name, value));
+}
+
+void program_cache_note_file(const char *path)
+{
+    if (!path) {
+        return;
+    }
+    for (auto d : active_deps) {
+        d->add(path);
+    }
+}
+
+std::string program_cache_dir()
+{
+    const char *s = getenv("LINUXCNC_PROGRAM_CACHE");
+    if (s) {
+        return s;
+    }
+    if ((s = getenv("XDG_CACHE_HOME")) && *s) {
+        return std::string(s) + "/linuxcnc/programs";
+    }
+    if ((s = getenv("HOME")) && *s) {
+        return std::string(s) + "/.cache/linuxcnc/programs";
+    }
+    return "";
+}
+
+static bool make_dirs(const std::string &dir)
+{
+    struct stat st;
+    if (stat(dir.c_str(), &st) == 0) {
+        return S_ISDIR(st.st_mode);
+    }
+    size_t slash = dir.rfind('/');
+    if (slash != std::string::npos && slash > 0 && !make_dirs(dir.substr(0, slash))) {
+        return false;
+    }
+    return mkdir(dir.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+static std::string entry_path(const std::string &dir, const ProgramCacheKey &key)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "-%016llx.cache", (unsigned long long) key.value());
+    return dir + "/" + key.kind() + name;
+}
+
+// remove all but the most recently used entries of one kind
+static void prune(const std::string &dir, const std::string &kind)
+{
+    DIR *d = opendir(dir.c_str());
+    if (!d) {
+        return;
+    }
+    std::vector<std::pair<int64_t, std::string> > entries;
+    std::string prefix = kind + "-";
+    struct dirent *de;
+    while ((de = readdir(d))) {
+        size_t len = strlen(de->d_name);
+        if (strncmp(de->d_name, prefix.c_str(), prefix.size()) ||
+            len < 6 || strcmp(de->d_name + len - 6, ".cache")) {
+            continue;
+        }
+        std::string path = dir + "/" + de->d_name;
+        int64_t size, mtime;
+        if (stat_dep(path.c_str(), size, mtime)) {
+            entries.push_back(std::make_pair(mtime, path));
+        }
+    }
+    closedir(d);
+    if (entries.size() <= PROGRAM_CACHE_MAX_ENTRIES) {
+        return;
+    }
+    std::sort(entries.begin(), entries.end());
+    for (size_t i = 0; i < entries.size() - PROGRAM_CACHE_MAX_ENTRIES; i++) {
+        unlink(entries[i].second.c_str());
+    }
+}
+
+ProgramCacheWriter::ProgramCacheWriter() : fp(NULL), failed(false)
+{
+}
+
+ProgramCacheWriter::~ProgramCacheWriter()
+{
+    discard();
+}
+
+bool ProgramCacheWriter::open(const ProgramCacheKey &key)
+{
+    discard();
+    std::string dir = program_cache_dir();
+    if (dir.empty() || !make_dirs(dir)) {
+        return false;
+    }
+    path = entry_path(dir, key);
+    tmppath = path + ".tmp" + std::to_string(getpid());
+    kind = key.kind();
+    fp = fopen(tmppath.c_str(), "wb");
+    if (!fp) {
+        return false;
+    }
+    failed = false;
+    uint64_t k = key.value();
+    put(head_magic, sizeof(head_magic));
+    put(&k, sizeof(k));
+    put_str(kind.c_str());
+    return !failed;
+}
+
+void ProgramCacheWriter::put(const void *data, size_t len)
+{
+    if (fp && !failed && fwrite(data, 1, len, fp) != len) {
+        failed = true;
+    }
+}
+
+void ProgramCacheWriter::put_str(const char *s)
+{
+    int32_t len = strlen(s);
+    put_i32(len);
+    put(s, len);
+}
+
+void ProgramCacheWriter::put_str(const std::string &s)
+{
+    put_i32(s.size());
+    put(s.data(), s.size());
+}
+
+bool ProgramCacheWriter::commit(const ProgramCacheDeps &deps)
+{
+    if (!fp) {
+        return false;
+    }
+    int64_t offset = ftell(fp);
+    put_i32(deps.deps.size());
+    for (auto &d : deps.deps) {
+        put_str(d.path.c_str());
+        put(&d.size, sizeof(d.size));
+        put(&d.mtime, sizeof(d.mtime));
+    }
+    put_i32(deps.values.size());
+    for (auto &v : deps.values) {
+        put_str(v.first.c_str());
+        put_str(v.second.c_str());
+    }
+    put(&offset, sizeof(offset));
+    put(tail_magic, sizeof(tail_magic));
+    if (fclose(fp) != 0) {
+        failed = true;
+    }
+    fp = NULL;
+    if (failed || rename(tmppath.c_str(), path.c_str()) != 0) {
+        unlink(tmppath.c_str());
+        return false;
+    }
+    prune(path.substr(0, path.rfind('/')), kind);
+    return true;
+}
+
+void ProgramCacheWriter::discard()
+{
+    if (fp) {
+        fclose(fp);
+        fp = NULL;
+        unlink(tmppath.c_str());
+    }
+}
+
+ProgramCacheReader::ProgramCacheReader() : fp(NULL), left(0)
+{
+}
+
+ProgramCacheReader::~ProgramCacheReader()
+{
+    close();
+}
+
+void ProgramCacheReader::close()
+{
+    if (fp) {
+        fclose(fp);
+        fp = NULL;
+    }
+    left = 0;
+}
+
+bool ProgramCacheReader::open(const ProgramCacheKey &key, const ProgramCacheCheck &check)
+{
+    close();
+    std::string dir = program_cache_dir();
+    if (dir.empty()) {
+        return false;
+    }
+    std::string path = entry_path(dir, key);
+    fp = fopen(path.c_str(), "rb");
+    if (!fp) {
+        return false;
+    }
+
+    char magic[8];
+    uint64_t k;
+    std::string kind;
+    int64_t offset;
+    left = INT64_MAX;
+    if (!get(magic, sizeof(magic)) || memcmp(magic, head_magic, sizeof(magic)) ||
+        !get(&k, sizeof(k)) || k != key.value() ||
+        !get_str(kind) || kind != key.kind()) {
+        close();
+        return false;
+    }
+    int64_t start = ftell(fp);
+    if (fseek(fp, -(long) (sizeof(offset) + sizeof(magic)), SEEK_END) != 0 ||
+        !get(&offset, sizeof(offset)) ||
+        !get(magic, sizeof(magic)) || memcmp(magic, tail_magic, sizeof(magic)) ||
+        offset < start || fseek(fp, offset, SEEK_SET) != 0) {
+        close();
+        return false;
+    }
+
+    int32_t n;
+    if (!get_i32(n)) {
+        close();
+        return false;
+    }
+    for (int32_t i = 0; i < n; i++) {
+        std::string dep;
+        int64_t size, mtime, cur_size, cur_mtime;
+        if (!get_str(dep) || !get(&size, sizeof(size)) || !get(&mtime, sizeof(mtime))) {
+            close();
+            return false;
+        }
+        if (!stat_dep(dep.c_str(), cur_size, cur_mtime)) {
+            cur_size = cur_mtime = -1;
+        }
+        if (cur_size != size || cur_mtime != mtime) {
+            close();
+            return false;
+        }
+    }
+    if (!get_i32(n)) {
+        close();
+        return false;
+    }
+    for (int32_t i = 0; i < n; i++) {
+        std::string name, value;
+        if (!get_str(name) || !get_str(value) || !check || !check(name, value)) {
+            close();
+            return false;
+        }
+    }
+
+    if (fseek(fp, start, SEEK_SET) != 0) {
+        close();
+        return false;
+    }
+    left = offset - start;
+    // mark it as recently used for prune()
+    utimes(path.c_str(), NULL);
+    return true;
+}
+
+bool ProgramCacheReader::get(void *data, size_t len)
+{
+    if (!fp || (int64_t) len > left || fread(data, 1, len, fp) != len) {
+        return false;
+    }
+    left -= len;
+    return true;
+}
+
+bool ProgramCacheReader::get_str(std::string &s)
+{
+    int32_t len;
+    if (!get_i32(len) || len < 0 || len > left) {
+        return false;
+    }
+    s.resize(len);
+    return get(&s[0], len);
+}
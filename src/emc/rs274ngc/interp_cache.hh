@@ -0,0 +1,144 @@
+/********************************************************************
+* Description: interp_cache.hh
+*
+*   On-disk cache for the results of running a program through the
+*   interpreter.  An entry is looked up by a key built from the
+*   program text and every setting that changes how it interprets,
+*   the files in the subroutine and remap module directories among
+*   them, and it remembers the other files the interpreter opened on
+*   the way (subroutines, the parameter file) so that editing any of
+*   them invalidates it.  What is stored in an entry is up to the
+*   user of the cache; see gcodemodule.cc for the preview stream.
+*
+*   The cache lives in $LINUXCNC_PROGRAM_CACHE, or else in
+*   $XDG_CACHE_HOME/linuxcnc/programs (~/.cache/linuxcnc/programs).
+*   Setting LINUXCNC_PROGRAM_CACHE to an empty string disables it.
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+*
+********************************************************************/
+#ifndef INTERP_CACHE_HH
+#define INTERP_CACHE_HH
+
+#include <stdint.h>
+#include <stdio.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+// programs smaller than this are quicker to interpret than to look up
+#define PROGRAM_CACHE_MIN_SIZE (256 * 1024)
+// add_file() hashes this much at a time
+#define PROGRAM_CACHE_HASH_BLOCK 4096
+// number of entries kept per kind, the least recently used go first
+#define PROGRAM_CACHE_MAX_ENTRIES 8
+
+class ProgramCacheKey {
+public:
+    explicit ProgramCacheKey(const char *kind);
+
+    void add(const void *data, size_t len);
+    void add(const char *s);
+    void add(int i) { add(&i, sizeof(i)); }
+    // hashes the file contents; false if it cannot be read
+    bool add_file(const char *path);
+    // the same one block at a time, for callers that cannot wait for a
+    // whole file; false once fp is at its end or failed, which ferror()
+    // tells apart
+    bool add_file_block(FILE *fp);
+    // adds the files in the directories the INI file has the
+    // interpreter look for subroutines and remap modules in
+    void add_search_paths(const char *ini);
+
+    const std::string &kind() const { return kind_; }
+    uint64_t value() const { return h; }
+
+private:
+    std::string kind_;
+    uint64_t h;
+};
+
+/* Collects the names of the files the interpreter opens while an
+   entry is being recorded.  Every collector alive sees every file,
+   so the preview cache and the checkpoints can record side by side.
+   Answers the interpreter got from its environment (tool table and
+   the like) are recorded as named values, which the reader has to
+   confirm before the entry is used. */
+class ProgramCacheDeps {
+public:
+    ProgramCacheDeps();
+    ~ProgramCacheDeps();
+    void add(const char *path);
+    void add_value(const std::string &name, const std::string &value);
+
+    struct Dep {
+        std::string path;
+        int64_t size;
+        int64_t mtime;
+    };
+    std::vector<Dep> deps;
+    std::vector<std::pair<std::string, std::string> > values;
+};
+
+// returns whether 'value' is still the current answer for 'name'
+typedef std::function<bool(const std::string &name, const std::string &value)> ProgramCacheCheck;
+
+// called by the interpreter for every file it reads a program from
+void program_cache_note_file(const char *path);
+
+class ProgramCacheWriter {
+public:
+    ProgramCacheWriter();
+    ~ProgramCacheWriter();
+
+    // false if the cache is disabled or the entry cannot be created
+    bool open(const ProgramCacheKey &key);
+    bool is_open() const { return fp != NULL; }
+
+    void put(const void *data, size_t len);
+    void put_u8(uint8_t v) { put(&v, sizeof(v)); }
+    void put_i32(int32_t v) { put(&v, sizeof(v)); }
+    void put_f64(double v) { put(&v, sizeof(v)); }
+    void put_str(const char *s);
+    // the string may hold any bytes, NUL included
+    void put_str(const std::string &s);
+
+    // writes the dependency list and makes the entry visible
+    bool commit(const ProgramCacheDeps &deps);
+    // throws the entry away
+    void discard();
+
+private:
+    FILE *fp;
+    bool failed;
+    std::string path, tmppath, kind;
+};
+
+class ProgramCacheReader {
+public:
+    ProgramCacheReader();
+    ~ProgramCacheReader();
+
+    // false unless a complete entry exists whose dependencies are unchanged
+    bool open(const ProgramCacheKey &key, const ProgramCacheCheck &check = nullptr);
+    void close();
+
+    // the get functions return false once the payload is exhausted
+    bool get(void *data, size_t len);
+    bool get_u8(uint8_t &v) { return get(&v, sizeof(v)); }
+    bool get_i32(int32_t &v) { return get(&v, sizeof(v)); }
+    bool get_f64(double &v) { return get(&v, sizeof(v)); }
+    bool get_str(std::string &s);
+
+private:
+    FILE *fp;
+    int64_t left;
+};
+
+// the directory entries are kept in, "" when caching is disabled
+std::string program_cache_dir();
+
+#endif
@@ -0,0 +1,490 @@
+/********************************************************************
+* Description: interp_checkpoint.cc
+*
+*   Checkpoints of the interpreter state for run-from-line.
+*
+*   While task's interpreter runs a program from the start, it notes
+*   every [RS274NGC]CHECKPOINT_INTERVAL lines the state needed to carry
+*   on from there: modal codes and settings, the numbered parameters
+*   the program changed, its named parameters, the o-word labels seen
+*   so far and the position in the file.  When the program is closed
+*   the checkpoints are written to the program cache (interp_cache.hh)
+*   under the program text.  A later run from line N restores the
+*   nearest checkpoint before N and only reads the lines after it.
+*   The preview does not record any: without a machine it gets other
+*   answers from probes and inputs than a run does.
+*
+*   Checkpoints are only taken at the top level of the main program,
+*   outside cutter compensation, with no canon calls queued, before
+*   the program changes any coordinate system offset and before it
+*   probes, so a restored state never hides offsets that were touched
+*   off since or values a probe would find different now.  The probe
+*   results the run started with are stored with the checkpoints, and
+*   they are only restored while those are unchanged.  Position and
+*   tool are never restored; task takes those from the machine as it
+*   always did for run-from-line.
+*
+*   The program text is hashed one block for each line read while
+*   recording, so closing a long program does not stall task.
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+*
+********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include "rs274ngc.hh"
+#include "rs274ngc_return.hh"
+#include "interp_return.hh"
+#include "interp_internal.hh"
+#include "interp_queue.hh"
+#include "rs274ngc_interp.hh"
+#include "interp_cache.hh"
+
+#define PROBE_FIRST 5061
+#define PROBE_LAST 5070
+
+// parameters that follow the machine rather than the program
+static bool volatile_param(int index)
+{
+    return (index >= PROBE_FIRST && index <= PROBE_LAST) ||
+        index == 5399 ||
+        (index >= 5400 && index <= 5428) ||
+        index >= 5600;
+}
+
+// coordinate system, G92 and G28/G30 parameters
+static bool offset_param(int index)
+{
+    return (index >= 5161 && index <= 5390);
+}
+
+struct checkpoint_recorder {
+    checkpoint_recorder() : disabled(false), hash_fp(NULL), key("checkpoints") {}
+    ~checkpoint_recorder() { if (hash_fp) fclose(hash_fp); }
+
+    std::string filename;       // the main program
+    bool disabled;
+    FILE *hash_fp;              // the program, as far as key has it
+    ProgramCacheKey key;
+    int high;                   // highest line read so far
+    int next;                   // line of the next checkpoint
+    std::vector<double> start;  // parameters when reading began
+    std::vector<std::string> points;
+    std::vector<int> lines;
+    ProgramCacheDeps deps;
+};
+
+// checkpoints are flat byte strings, built and taken apart with these
+class CheckpointBuf {
+public:
+    explicit CheckpointBuf(std::string &s) : s(s), pos(0), ok(true) {}
+
+    void put(const void *p, size_t len) { s.append((const char *) p, len); }
+    void put_i32(int32_t v) { put(&v, sizeof(v)); }
+    void put_i64(int64_t v) { put(&v, sizeof(v)); }
+    void put_f64(double v) { put(&v, sizeof(v)); }
+    void put_str(const char *str) {
+        if (!str) str = "";
+        put_i32(strlen(str));
+        put(str, strlen(str));
+    }
+
+    void get(void *p, size_t len) {
+        if (!ok || pos + len > s.size()) {
+            ok = false;
+            memset(p, 0, len);
+            return;
+        }
+        memcpy(p, s.data() + pos, len);
+        pos += len;
+    }
+    int32_t get_i32() { int32_t v; get(&v, sizeof(v)); return v; }
+    int64_t get_i64() { int64_t v; get(&v, sizeof(v)); return v; }
+    double get_f64() { double v; get(&v, sizeof(v)); return v; }
+    std::string get_str() {
+        int32_t len = get_i32();
+        if (!ok || len < 0 || pos + len > s.size()) {
+            ok = false;
+            return "";
+        }
+        std::string r(s, pos, len);
+        pos += len;
+        return r;
+    }
+    bool good() const { return ok; }
+
+private:
+    std::string &s;
+    size_t pos;
+    bool ok;
+};
+
+static bool big_enough(const char *filename)
+{
+    struct stat st;
+    return stat(filename, &st) == 0 && st.st_size >= PROGRAM_CACHE_MIN_SIZE;
+}
+
+// adds what comes after the program text
+static void checkpoint_key_rest(ProgramCacheKey &key, int interval)
+{
+    // remaps, features and subroutine paths all come from the INI file
+    const char *ini = getenv("INI_FILE_NAME");
+    if (ini) {
+        key.add_file(ini);
+    }
+    key.add_search_paths(ini);
+    key.add(interval);
+}
+
+static bool checkpoint_key(ProgramCacheKey &key, const char *filename, int interval)
+{
+    if (!key.add_file(filename)) {
+        return false;
+    }
+    checkpoint_key_rest(key, interval);
+    return true;
+}
+
+// what the probe found before the program started
+static void put_probe(ProgramCacheWriter &w, const std::vector<double> &start)
+{
+    for (int i = PROBE_FIRST; i <= PROBE_LAST; i++) {
+        w.put_f64(start[i]);
+    }
+}
+
+static bool same_probe(ProgramCacheReader &r, const double *parameters)
+{
+    bool same = true;
+    for (int i = PROBE_FIRST; i <= PROBE_LAST; i++) {
+        double v;
+        if (!r.get_f64(v)) {
+            return false;
+        }
+        same = same && v == parameters[i];
+    }
+    return same;
+}
+
+// hashes the next block of the program; false once it is all hashed
+static bool hash_some(checkpoint_recorder *rec)
+{
+    if (rec->hash_fp && !rec->key.add_file_block(rec->hash_fp)) {
+        if (ferror(rec->hash_fp)) {
+            rec->disabled = true;
+            rec->points.clear();
+        }
+        fclose(rec->hash_fp);
+        rec->hash_fp = NULL;
+    }
+    return rec->hash_fp != NULL;
+}
+
+/* Called from read() before each line of the open program.  Starts a
+   new recording on the first line after open(), then takes a checkpoint
+   whenever the program got CHECKPOINT_INTERVAL lines further. */
+void Interp::checkpoint_record()
+{
+    if (!_setup.record_checkpoints || _setup.checkpoint_interval <= 0) {
+        return;
+    }
+    if (!_checkpoints) {
+        _checkpoints = new checkpoint_recorder;
+        _checkpoints->filename = _setup.filename;
+        // small programs are read again quicker than looked up
+        _checkpoints->disabled = !big_enough(_setup.filename);
+        _checkpoints->high = _setup.sequence_number;
+        _checkpoints->next = _setup.sequence_number + _setup.checkpoint_interval;
+        if (!_checkpoints->disabled) {
+            _checkpoints->start.assign(_setup.parameters,
+                _setup.parameters + interp_param_global::RS274NGC_MAX_PARAMETERS);
+            _checkpoints->deps.add(_setup.filename);
+            _checkpoints->hash_fp = fopen(_setup.filename, "rb");
+            _checkpoints->disabled = !_checkpoints->hash_fp;
+        }
+        return;
+    }
+    checkpoint_recorder *rec = _checkpoints;
+    if (rec->disabled && rec->points.empty()) {
+        return;
+    }
+    hash_some(rec);
+    if (rec->disabled) {
+        return;
+    }
+    // what the program does after a probe depends on what the probe
+    // found this time
+    for (int i = PROBE_FIRST; i <= PROBE_LAST; i++) {
+        if (_setup.parameters[i] != rec->start[i]) {
+            rec->disabled = true;
+            return;
+        }
+    }
+    // line numbers only mean progress in the main program, and looping
+    // back does not make any
+    if (_setup.call_level != 0 ||
+        _setup.sequence_number <= rec->high) {
+        return;
+    }
+    rec->high = _setup.sequence_number;
+    if (_setup.sequence_number < rec->next || _setup.remap_level != 0 ||
+        _setup.defining_sub || _setup.skipping_o || _setup.skipping_to_sub ||
+        _setup.cutter_comp_side != CUTTER_COMP::OFF || !qc().empty()) {
+        return;
+    }
+
+    for (int i = 5161; i <= 5390; i++) {
+        if (_setup.parameters[i] != rec->start[i]) {
+            // the program set offsets itself; restoring past here would
+            // override whatever the operator touched off since
+            rec->disabled = true;
+            return;
+        }
+    }
+
+    std::string point;
+    CheckpointBuf b(point);
+    b.put_i64(ftell(_setup.file_pointer));
+
+    write_g_codes((block_pointer) NULL, &_setup);
+    write_m_codes((block_pointer) NULL, &_setup);
+    write_settings(&_setup);
+    b.put(_setup.active_g_codes, sizeof(_setup.active_g_codes));
+    b.put(_setup.active_m_codes, sizeof(_setup.active_m_codes));
+    b.put(_setup.active_settings, sizeof(_setup.active_settings));
+
+    b.put_i32(_setup.motion_mode);
+    b.put_f64(_setup.cycle_cc);
+    b.put_f64(_setup.cycle_i);
+    b.put_f64(_setup.cycle_j);
+    b.put_f64(_setup.cycle_k);
+    b.put_i32(_setup.cycle_l);
+    b.put_f64(_setup.cycle_p);
+    b.put_f64(_setup.cycle_q);
+    b.put_f64(_setup.cycle_r);
+    b.put_f64(_setup.cycle_il);
+    b.put_i32(_setup.cycle_il_flag);
+
+    std::vector<int> changed;
+    for (int i = 1; i < interp_param_global::RS274NGC_MAX_PARAMETERS; i++) {
+        if (!volatile_param(i) && !offset_param(i) &&
+            _setup.parameters[i] != rec->start[i]) {
+            changed.push_back(i);
+        }
+    }
+    b.put_i32(changed.size());
+    for (int i : changed) {
+        b.put_i32(i);
+        b.put_f64(_setup.parameters[i]);
+    }
+
+    std::vector<std::pair<const char *, parameter_value> > named;
+    for (auto &p : _setup.sub_context[0].named_params) {
+        if (!(p.second.attr & (PA_READONLY | PA_UNSET | PA_USE_LOOKUP |
+                               PA_FROM_INI | PA_PYTHON))) {
+            named.push_back(std::make_pair(p.first, p.second));
+        }
+    }
+    b.put_i32(named.size());
+    for (auto &p : named) {
+        b.put_str(p.first);
+        b.put_f64(p.second.value);
+        b.put_i32(p.second.attr);
+    }
+
+    b.put_i32(_setup.offset_map.size());
+    for (auto &o : _setup.offset_map) {
+        b.put_str(o.first);
+        b.put_i32(o.second.type);
+        b.put_str(o.second.filename);
+        b.put_i64(o.second.offset);
+        b.put_i32(o.second.sequence_number);
+        b.put_i32(o.second.repeat_count);
+    }
+
+    rec->points.push_back(point);
+    rec->lines.push_back(_setup.sequence_number);
+    rec->next = _setup.sequence_number + _setup.checkpoint_interval;
+}
+
+/* Called when the program is closed: writes what was recorded, unless
+   the cache already has checkpoints for the same probe results that
+   get at least as far. */
+void Interp::checkpoint_flush()
+{
+    checkpoint_recorder *rec = _checkpoints;
+    _checkpoints = NULL;
+    if (!rec) {
+        return;
+    }
+    // a program with long lines may end before all of it was hashed
+    while (!rec->points.empty() && hash_some(rec)) {
+    }
+    if (!rec->points.empty()) {
+        ProgramCacheKey &key = rec->key;
+        checkpoint_key_rest(key, _setup.checkpoint_interval);
+        ProgramCacheReader r;
+        int32_t count, last = 0;
+        if (!r.open(key) || !r.get_i32(count) || !r.get_i32(last) ||
+            !same_probe(r, rec->start.data()) || last < rec->lines.back()) {
+            r.close();
+            ProgramCacheWriter w;
+            if (w.open(key)) {
+                w.put_i32(rec->points.size());
+                w.put_i32(rec->lines.back());
+                put_probe(w, rec->start);
+                for (size_t i = 0; i < rec->points.size(); i++) {
+                    w.put_i32(rec->lines[i]);
+                    w.put_str(rec->points[i]);
+                }
+                w.commit(rec->deps);
+            }
+        }
+    }
+    delete rec;
+}
+
+/* Restores the last checkpoint of the open program that lies at least
+   two lines before 'line', so the caller still reads the line right
+   before it.  *restored is set to the line number the checkpoint was
+   taken at, the next read() returns the line after it, or to 0 if there
+   is none and the program has to be read from the start. */
+int Interp::restore_checkpoint(int line, int *restored)
+{
+    *restored = 0;
+    if (_setup.checkpoint_interval <= 0 || !_setup.file_pointer ||
+        _setup.lazy_closing || _setup.call_level != 0 ||
+        !big_enough(_setup.filename)) {
+        return INTERP_OK;
+    }
+
+    ProgramCacheKey key("checkpoints");
+    ProgramCacheReader r;
+    int32_t count, last;
+    if (!checkpoint_key(key, _setup.filename, _setup.checkpoint_interval) ||
+        !r.open(key) || !r.get_i32(count) || !r.get_i32(last) ||
+        !same_probe(r, _setup.parameters)) {
+        return INTERP_OK;
+    }
+    std::string point;
+    int32_t at = 0;
+    for (int32_t i = 0; i < count; i++) {
+        int32_t l;
+        std::string s;
+        if (!r.get_i32(l) || !r.get_str(s)) {
+            return INTERP_OK;
+        }
+        if (l >= line - 1) {
+            break;
+        }
+        at = l;
+        point.swap(s);
+    }
+    if (!at || at < _setup.sequence_number) {
+        return INTERP_OK;
+    }
+
+    CheckpointBuf b(point);
+    int64_t pos = b.get_i64();
+    context_pointer frame = &_setup.sub_context[0];
+    b.get(frame->saved_g_codes, sizeof(frame->saved_g_codes));
+    b.get(frame->saved_m_codes, sizeof(frame->saved_m_codes));
+    b.get(frame->saved_settings, sizeof(frame->saved_settings));
+
+    int motion_mode = b.get_i32();
+    double cycle_cc = b.get_f64();
+    double cycle_i = b.get_f64();
+    double cycle_j = b.get_f64();
+    double cycle_k = b.get_f64();
+    int cycle_l = b.get_i32();
+    double cycle_p = b.get_f64();
+    double cycle_q = b.get_f64();
+    double cycle_r = b.get_f64();
+    double cycle_il = b.get_f64();
+    int cycle_il_flag = b.get_i32();
+
+    std::vector<std::pair<int, double> > params;
+    for (int32_t n = b.get_i32(); b.good() && n > 0; n--) {
+        int i = b.get_i32();
+        double v = b.get_f64();
+        if (i <= 0 || i >= interp_param_global::RS274NGC_MAX_PARAMETERS) {
+            return INTERP_OK;
+        }
+        params.push_back(std::make_pair(i, v));
+    }
+    std::vector<std::pair<std::string, parameter_value> > named;
+    for (int32_t n = b.get_i32(); b.good() && n > 0; n--) {
+        std::string name = b.get_str();
+        parameter_value pv;
+        pv.value = b.get_f64();
+        pv.attr = b.get_i32();
+        named.push_back(std::make_pair(name, pv));
+    }
+    std::vector<std::pair<std::string, offset> > labels;
+    std::vector<std::string> label_files;
+    for (int32_t n = b.get_i32(); b.good() && n > 0; n--) {
+        std::string name = b.get_str();
+        offset o;
+        o.type = b.get_i32();
+        label_files.push_back(b.get_str());
+        o.filename = NULL;
+        o.offset = b.get_i64();
+        o.sequence_number = b.get_i32();
+        o.repeat_count = b.get_i32();
+        labels.push_back(std::make_pair(name, o));
+    }
+    if (!b.good() || fseek(_setup.file_pointer, pos, SEEK_SET) != 0) {
+        return INTERP_OK;
+    }
+
+    // nothing is changed before this point, so a damaged entry leaves
+    // the caller with the program opened at the start
+    _setup.sequence_number = at;
+    for (auto &p : params) {
+        _setup.parameters[p.first] = p.second;
+    }
+    for (auto &p : named) {
+        frame->named_params[strstore(p.first.c_str())] = p.second;
+    }
+    for (size_t i = 0; i < labels.size(); i++) {
+        offset o = labels[i].second;
+        o.filename = strstore(label_files[i].c_str());
+        _setup.offset_map[strstore(labels[i].first.c_str())] = o;
+    }
+
+    // the modal codes go through the M72 machinery so the canon calls
+    // they need are issued; motion mode and cycle values are not codes
+    CHP(restore_settings(&_setup, 0));
+    _setup.motion_mode = motion_mode;
+    _setup.cycle_cc = cycle_cc;
+    _setup.cycle_i = cycle_i;
+    _setup.cycle_j = cycle_j;
+    _setup.cycle_k = cycle_k;
+    _setup.cycle_l = cycle_l;
+    _setup.cycle_p = cycle_p;
+    _setup.cycle_q = cycle_q;
+    _setup.cycle_r = cycle_r;
+    _setup.cycle_il = cycle_il;
+    _setup.cycle_il_flag = cycle_il_flag;
+    write_g_codes((block_pointer) NULL, &_setup);
+
+    // the rest of this run does not start at the top
+    checkpoint_flush();
+    _checkpoints = new checkpoint_recorder;
+    _checkpoints->disabled = true;
+    *restored = at;
+    return INTERP_OK;
+}
+
+void Interp::record_checkpoints(bool on)
+{
+    _setup.record_checkpoints = on;
+}
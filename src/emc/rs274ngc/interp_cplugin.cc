@@ -0,0 +1,169 @@
+/********************************************************************
+* Description: interp_cplugin.cc
+*
+*   Loading and calling native remap handlers, see interp_cplugin.hh.
+*
+*   A native handler runs inside the same call frame and the same
+*   re-execution states as a Python one (CS_REEXEC_PROLOG,
+*   CS_REEXEC_PYBODY, CS_REEXEC_EPILOG), only without building Python
+*   arguments or taking the GIL for each call.
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+*
+********************************************************************/
+
+#include <dlfcn.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <config.h>
+
+#include "rs274ngc.hh"
+#include "rs274ngc_return.hh"
+#include "interp_return.hh"
+#include "interp_cplugin.hh"
+
+static void cplugin_set_error(struct cplugin_call *call, const char *fmt, ...)
+{
+    char msg[LINELEN];
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+    call->interp->setSavedError(msg);
+}
+
+// like self.execute() of a Python handler, see wrap_interp_execute_1()
+static int cplugin_execute(struct cplugin_call *call, const char *line)
+{
+    setup_pointer settings = call->settings;
+    block saved_block = settings->blocks[0];
+    int saved_call_state = settings->call_state;
+
+    settings->call_state = CS_NORMAL;
+    int status = call->interp->execute(line);
+    settings->call_state = saved_call_state;
+    settings->blocks[0] = saved_block;
+    return status;
+}
+
+static int cplugin_get_param(struct cplugin_call *call, const char *name,
+			     double *value)
+{
+    int found;
+
+    int status = call->interp->find_named_param(name, &found, value);
+    if (status == INTERP_OK && !found) {
+	call->interp->setError("Named parameter #<%s> not defined", name);
+	return INTERP_ERROR;
+    }
+    return status;
+}
+
+static int cplugin_set_param(struct cplugin_call *call, const char *name,
+			     double value)
+{
+    return call->interp->store_named_param(call->settings, name, value);
+}
+
+static const struct cplugin_ops cplugin_ops = {
+    sizeof(struct cplugin_ops),
+    cplugin_set_error,
+    cplugin_execute,
+    cplugin_get_param,
+    cplugin_set_param,
+#define CPLUGIN_CANON_ENTRY(name) name,
+    CPLUGIN_CANON(CPLUGIN_CANON_ENTRY)
+#undef CPLUGIN_CANON_ENTRY
+};
+
+/* Resolves lib.so:func to the handler, NULL with the error set if it
+   cannot.  Libraries stay loaded for as long as milltask runs. */
+cplugin_handler Interp::cplugin_load(const char *spec)
+{
+    static std::map<std::string, void *> libraries;
+    char path[PATH_MAX];
+    const char *ini, *slash;
+
+    const char *colon = strrchr(spec, ':');
+    if (colon == NULL || colon == spec || colon[1] == '\0') {
+	setError("'%s' is not lib.so:function", spec);
+	return NULL;
+    }
+    std::string lib(spec, colon - spec);
+    if (lib.find('/') == std::string::npos) {
+	snprintf(path, sizeof(path), "%s/%s", EMC2_HOME "/lib/linuxcnc", lib.c_str());
+    } else if (lib[0] != '/' && (ini = getenv("INI_FILE_NAME")) != NULL
+	       && (slash = strrchr(ini, '/')) != NULL) {
+	// relative to the configuration directory, not to wherever
+	// milltask happened to be started
+	snprintf(path, sizeof(path), "%.*s/%s", (int)(slash - ini), ini,
+		 lib.c_str());
+    } else {
+	snprintf(path, sizeof(path), "%s", lib.c_str());
+    }
+
+    void *handle;
+    auto it = libraries.find(path);
+    if (it != libraries.end()) {
+	handle = it->second;
+    } else {
+	handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+	if (handle == NULL) {
+	    setError("can't load '%s': %s", path, dlerror());
+	    return NULL;
+	}
+	libraries[path] = handle;
+    }
+
+    cplugin_handler handler = (cplugin_handler) dlsym(handle, colon + 1);
+    if (handler == NULL) {
+	setError("no function '%s' in '%s'", colon + 1, path);
+	return NULL;
+    }
+    return handler;
+}
+
+/* Calls a handler for the remap of the controlling block, the first
+   time or again after it returned INTERP_EXECUTE_FINISH. */
+int Interp::cplugin_run(setup_pointer settings, context_pointer frame,
+			cplugin_handler handler, int phase, bool resume)
+{
+    struct cplugin_call call;
+    block_pointer cblock = &CONTROLLING_BLOCK(*settings);
+
+    if (resume) {
+	// like a Python generator picking up after its yield
+	CHP(read_inputs(settings));
+	frame->cplugin_resumed++;
+    } else {
+	frame->cplugin_resumed = 0;
+    }
+    call.ops = &cplugin_ops;
+    call.interp = this;
+    call.settings = settings;
+    call.block = cblock;
+    call.frame = frame;
+    call.remap = cblock->executing_remap;
+    call.phase = phase;
+    call.resumed = frame->cplugin_resumed;
+    call.state = frame->cplugin_state;
+
+    logRemap("cplugin_run %s phase=%d resumed=%d", call.remap->name, phase,
+	     call.resumed);
+    int status = handler(&call);
+    if (status != INTERP_OK && status != INTERP_EXECUTE_FINISH) {
+	CHKS(status <= INTERP_MIN_ERROR,
+	     "%s: native handler returned %d", call.remap->name, status);
+	ERP(status);
+    }
+    return status;
+}
@@ -0,0 +1,146 @@
+/********************************************************************
+* Description: interp_cplugin.hh
+*
+*   Native remap handlers.
+*
+*   Next to ngc= and python=, a remapped code may be handled by a
+*   function in a shared library:
+*
+*     REMAP=M6 modalgroup=6 argspec=t cplugin=./libtoolchange.so:m6
+*
+*   with cprolog= and cepilog= for native prolog and epilog functions,
+*   which may also go with an ngc= handler.  The library is loaded once,
+*   when the INI file is read; a name without a slash is looked for in
+*   the LinuxCNC library directory, anything else is taken as a path
+*   (relative ones from the configuration directory).  It is loaded
+*   RTLD_LOCAL, and whoever embeds the interpreter need not export its
+*   canon (the gcode module of the preview does not), so the library
+*   reaches canon and the interpreter only through the function table
+*   in call->ops.
+*
+*   Each handler is a C function
+*
+*     extern "C" int m6(struct cplugin_call *call);
+*
+*   that gets the interpreter state and the block with the remapped code
+*   and calls canon as call->ops->SELECT_TOOL(...) and so on.  It
+*   returns like a Python handler: INTERP_OK when done, INTERP_ERROR
+*   after call->ops->set_error(), or
+*   INTERP_EXECUTE_FINISH to have task wait until motion and IO caught
+*   up.  In that case it is called again for the same block, with
+*   resumed counting the calls, and whatever it needs to go on from
+*   where it left off kept in state[], like the code after a 'yield
+*   INTERP_EXECUTE_FINISH' in Python.
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+*
+********************************************************************/
+#ifndef INTERP_CPLUGIN_HH
+#define INTERP_CPLUGIN_HH
+
+#include "rs274ngc_interp.hh"
+#include "interp_internal.hh"
+
+enum cplugin_phase {
+    CPLUGIN_PROLOG,
+    CPLUGIN_BODY,
+    CPLUGIN_EPILOG,
+};
+
+// canon functions a handler may call, in the order of cplugin_ops;
+// only ever append to it
+#define CPLUGIN_CANON(X) \
+    X(STRAIGHT_TRAVERSE) \
+    X(STRAIGHT_FEED) \
+    X(ARC_FEED) \
+    X(STRAIGHT_PROBE) \
+    X(RIGID_TAP) \
+    X(DWELL) \
+    X(SET_FEED_RATE) \
+    X(SET_FEED_MODE) \
+    X(SET_TRAVERSE_RATE) \
+    X(SET_MOTION_CONTROL_MODE) \
+    X(SELECT_PLANE) \
+    X(USE_LENGTH_UNITS) \
+    X(START_SPINDLE_CLOCKWISE) \
+    X(START_SPINDLE_COUNTERCLOCKWISE) \
+    X(SET_SPINDLE_SPEED) \
+    X(STOP_SPINDLE_TURNING) \
+    X(ORIENT_SPINDLE) \
+    X(WAIT_SPINDLE_ORIENT_COMPLETE) \
+    X(SELECT_TOOL) \
+    X(START_CHANGE) \
+    X(CHANGE_TOOL) \
+    X(CHANGE_TOOL_NUMBER) \
+    X(USE_TOOL_LENGTH_OFFSET) \
+    X(SET_TOOL_TABLE_ENTRY) \
+    X(RELOAD_TOOLDATA) \
+    X(MIST_ON) \
+    X(MIST_OFF) \
+    X(FLOOD_ON) \
+    X(FLOOD_OFF) \
+    X(SET_MOTION_OUTPUT_BIT) \
+    X(CLEAR_MOTION_OUTPUT_BIT) \
+    X(SET_AUX_OUTPUT_BIT) \
+    X(CLEAR_AUX_OUTPUT_BIT) \
+    X(SET_MOTION_OUTPUT_VALUE) \
+    X(SET_AUX_OUTPUT_VALUE) \
+    X(WAIT) \
+    X(TURN_PROBE_ON) \
+    X(TURN_PROBE_OFF) \
+    X(COMMENT) \
+    X(MESSAGE) \
+    X(PROGRAM_STOP) \
+    X(OPTIONAL_PROGRAM_STOP) \
+    X(PROGRAM_END) \
+    X(GET_EXTERNAL_POSITION_X) \
+    X(GET_EXTERNAL_POSITION_Y) \
+    X(GET_EXTERNAL_POSITION_Z) \
+    X(GET_EXTERNAL_POSITION_A) \
+    X(GET_EXTERNAL_POSITION_B) \
+    X(GET_EXTERNAL_POSITION_C) \
+    X(GET_EXTERNAL_POSITION_U) \
+    X(GET_EXTERNAL_POSITION_V) \
+    X(GET_EXTERNAL_POSITION_W) \
+    X(GET_EXTERNAL_PROBE_TRIPPED_VALUE) \
+    X(GET_EXTERNAL_DIGITAL_INPUT) \
+    X(GET_EXTERNAL_ANALOG_INPUT) \
+    X(GET_EXTERNAL_QUEUE_EMPTY) \
+    X(GET_EXTERNAL_TC_FAULT) \
+    X(GET_EXTERNAL_LENGTH_UNITS)
+
+// entry points of the interpreter that loaded the handler
+struct cplugin_ops {
+    int size;                   // sizeof(struct cplugin_ops)
+    // sets the error message for a handler returning INTERP_ERROR
+    void (*set_error)(struct cplugin_call *call, const char *fmt, ...)
+        __attribute__((format(printf,2,3)));
+    // executes a line of G-code like self.execute() in Python
+    int (*execute)(struct cplugin_call *call, const char *line);
+    // named parameters, the argspec words among them; return INTERP_OK
+    // or an error with the message set
+    int (*get_param)(struct cplugin_call *call, const char *name, double *value);
+    int (*set_param)(struct cplugin_call *call, const char *name, double value);
+#define CPLUGIN_CANON_MEMBER(name) decltype(::name) *name;
+    CPLUGIN_CANON(CPLUGIN_CANON_MEMBER)
+#undef CPLUGIN_CANON_MEMBER
+};
+
+struct cplugin_call {
+    const struct cplugin_ops *ops; // canon and the interpreter
+    Interp *interp;             // the data of it only, call through ops
+    setup_pointer settings;     // the interpreter state
+    block_pointer block;        // the block with the remapped code and its words
+    context_pointer frame;      // call frame, with the argspec words as locals
+    remap_pointer remap;        // the REMAP= line
+    int phase;                  // enum cplugin_phase
+    int resumed;                // 0, or calls since the first one returned
+                                // INTERP_EXECUTE_FINISH
+    double *state;              // CPLUGIN_STATE values, zero when the remap
+                                // starts and kept until it ends
+};
+
+#endif
@@ -39,4 +39,7 @@ struct offset_struct;
 typedef offset_struct *offset_pointer;
 typedef offset_struct offset;
 
+struct cplugin_call;
+typedef int (*cplugin_handler)(struct cplugin_call *call);
+
 #endif // INTERP_FWD_HH
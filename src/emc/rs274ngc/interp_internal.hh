@@ -307,6 +307,9 @@ std::string toString(GCodes g);
 // max number of local variables saved (?)
 #define MAX_NAMED_PARAMETERS 50
 
+// values a native remap handler keeps across yields
+#define CPLUGIN_STATE 8
+
 /**********************/
 /*      TYPEDEFS      */
 /**********************/
@@ -406,6 +409,13 @@ struct remap_struct {
     const char *remap_py;    // Py function maybe  null, OR
     const char *remap_ngc;   // NGC file, maybe  null
     const char *epilog_func; // Py function or null
+    // native handlers, see interp_cplugin.hh
+    const char *cprolog;        // lib.so:func or null
+    const char *remap_cplugin;  // lib.so:func, maybe null
+    const char *cepilog;        // lib.so:func or null
+    cplugin_handler cprolog_func;
+    cplugin_handler cbody_func;
+    cplugin_handler cepilog_func;
 };
 
 
@@ -425,7 +435,8 @@ typedef std::map<int, remap_pointer> int_remap_map;
 typedef int_remap_map::iterator int_remap_iterator;
 
 #define REMAP_FUNC(r) (r->remap_ngc ? r->remap_ngc: \
-		       (r->remap_py ? r->remap_py : "BUG-no-remap-func"))
+		       (r->remap_py ? r->remap_py : \
+			(r->remap_cplugin ? r->remap_cplugin : "BUG-no-remap-func")))
 
 struct block_struct
 {
@@ -610,6 +621,8 @@ struct context_struct {
     int call_type; // enum call_types
     pycontext pystuff;
     // Python-related stuff
+    int cplugin_resumed;        // native handler calls after a yield
+    double cplugin_state[CPLUGIN_STATE]; // kept for it until the remap ends
 };
 
 // context.context_status
@@ -810,6 +823,8 @@ struct setup
     bool loop_on_main_m99;
 
   int disable_g92_persistence;
+  int checkpoint_interval;          // lines between run-from-line checkpoints
+  bool record_checkpoints;          // only task's interpreter records them
 
 #define FEATURE(x) (_setup.feature_set & FEATURE_ ## x)
 #define FEATURE_RETAIN_G43           0x00000001
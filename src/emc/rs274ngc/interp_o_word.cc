@@ -34,6 +34,7 @@
 #include "rs274ngc_interp.hh"
 #include "python_plugin.hh"
 #include "interp_python.hh"
+#include "interp_cplugin.hh"
 #include <rtapi_string.h>
 
 namespace bp = boost::python;
@@ -336,6 +337,7 @@ int Interp::execute_call(setup_pointer settings,
 		// if named local parameters specified
 		CHP(add_parameters(settings, cblock, NULL));
 	    }
+	    memset(current_frame->cplugin_state, 0, sizeof(current_frame->cplugin_state));
 	    // fall through
 
 	case CS_REEXEC_PROLOG:
@@ -352,6 +354,15 @@ int Interp::execute_call(setup_pointer settings,
 		    //settings->sequence_number = previous_frame->sequence_number;
 		    CHP(status);
 		}
+	    } else if (remap->cprolog_func) {
+		status = cplugin_run(settings, current_frame, remap->cprolog_func,
+				     CPLUGIN_PROLOG, settings->call_state != CS_NORMAL);
+		if (status == INTERP_EXECUTE_FINISH) {
+		    settings->call_state = CS_REEXEC_PROLOG;
+		    return status;
+		}
+		settings->call_state = CS_NORMAL;
+		CHP(status);
 	    }
 	    // fall through
 
@@ -373,6 +384,21 @@ int Interp::execute_call(setup_pointer settings,
 		    ERP(remap_finished(-cblock->phase));
 		}
 	    }
+	    // a native body re-executes like a Python one
+	    if (remap->cbody_func) {
+		status = cplugin_run(settings, current_frame, remap->cbody_func,
+				     CPLUGIN_BODY, settings->call_state != CS_NORMAL);
+		if (status == INTERP_EXECUTE_FINISH) {
+		    settings->call_state = CS_REEXEC_PYBODY;
+		    return status;
+		}
+		settings->call_state = CS_NORMAL;
+		settings->sequence_number = previous_frame->sequence_number;
+		CHP(status);
+		// no epilog either
+		CHP(leave_context(settings,false));
+		ERP(remap_finished(-cblock->phase));
+	    }
 
 	    // call the NGC remap procedure
 	    assert(settings->call_state == CS_NORMAL);
@@ -436,6 +462,18 @@ int Interp::execute_return(setup_pointer settings, context_pointer current_frame
 		    CHP(status);
 		    // leave_context() is done by falling through into CT_NGC_OWORD_SUB code
 		}
+	    } else if (cblock->executing_remap && cblock->executing_remap->cepilog_func) {
+		status = cplugin_run(settings, current_frame,
+				     cblock->executing_remap->cepilog_func,
+				     CPLUGIN_EPILOG, settings->call_state != CS_NORMAL);
+		if (status == INTERP_EXECUTE_FINISH) {
+		    settings->call_state = CS_REEXEC_EPILOG;
+		    eblock->call_type = CT_REMAP;
+		    return status;
+		}
+		settings->call_state = CS_NORMAL;
+		settings->sequence_number = previous_frame->sequence_number;
+		CHP(status);
 	    }
 	}
 	// fall through to normal NGC return handling 
@@ -18,6 +18,7 @@
 #include "interp_queue.hh"
 #include "interp_internal.hh"
 #include "rs274ngc_interp.hh"
+#include "alloc_tag.hh"
 
 static int debug_qc = 0;
 
@@ -59,6 +60,11 @@ std::vector<queued_canon>& qc(void) {
     return c;
 }
 
+static void qc_push(const queued_canon &q) {
+    AllocTagScope alloc_tag(ALLOC_TAG_CANON_QUEUE);
+    qc().push_back(q);
+}
+
 void qc_reset(void) {
     if(debug_qc) printf("qc cleared\n");
     qc().clear();
@@ -75,7 +81,7 @@ void enqueue_SET_FEED_RATE(double feed) {
     q.type = QSET_FEED_RATE;
     q.data.set_feed_rate.feed = feed;
     if(debug_qc) printf("enqueue set feed rate %f\n", feed);
-    qc().push_back(q);
+    qc_push(q);
 }
 
 void enqueue_DWELL(double time) {
@@ -88,7 +94,7 @@ void enqueue_DWELL(double time) {
     q.type = QDWELL;
     q.data.dwell.time = time;
     if(debug_qc) printf("enqueue dwell %f\n", time);
-    qc().push_back(q);
+    qc_push(q);
 }
 
 void enqueue_SET_FEED_MODE(int spindle, int mode) {
@@ -102,7 +108,7 @@ void enqueue_SET_FEED_MODE(int spindle, int mode) {
     q.data.set_feed_mode.spindle = spindle;
     q.data.set_feed_mode.mode = mode;
     if(debug_qc) printf("enqueue set feed mode %d\n", mode);
-    qc().push_back(q);
+    qc_push(q);
 }
 
 void enqueue_MIST_ON(void) {
@@ -114,7 +120,7 @@ void enqueue_MIST_ON(void) {
     queued_canon q;
     q.type = QMIST_ON;
     if(debug_qc) printf("enqueue mist on\n");
-    qc().push_back(q);
+    qc_push(q);
 }
 
 void enqueue_MIST_OFF(void) {
@@ -126,7 +132,7 @@ void enqueue_MIST_OFF(void) {
     queued_canon q;
     q.type = QMIST_OFF;
     if(debug_qc) printf("enqueue mist off\n");
-    qc().push_back(q);
+    qc_push(q);
 }
 
 void enqueue_FLOOD_ON(void) {
@@ -138,7 +144,7 @@ void enqueue_FLOOD_ON(void) {
     queued_canon q;
     q.type = QFLOOD_ON;
     if(debug_qc) printf("enqueue flood on\n");
-    qc().push_back(q);
+    qc_push(q);
 }
 
 void enqueue_FLOOD_OFF(void) {
@@ -150,7 +156,7 @@ void enqueue_FLOOD_OFF(void) {
     queued_canon q;
     q.type = QFLOOD_OFF;
     if(debug_qc) printf("enqueue flood off\n");
-    qc().push_back(q);
+    qc_push(q);
 }
 
 void enqueue_START_SPINDLE_CLOCKWISE(int spindle) {
@@ -163,7 +169,7 @@ void enqueue_START_SPINDLE_CLOCKWISE(int spindle) {
     q.type = QSTART_SPINDLE_CLOCKWISE;
     q.data.set_spindle_speed.spindle = spindle;
     if(debug_qc) printf("enqueue spindle clockwise\n");
-    qc().push_back(q);
+    qc_push(q);
 }
 
 void enqueue_START_SPINDLE_COUNTERCLOCKWISE(int spindle) {
@@ -176,7 +182,7 @@ void enqueue_START_SPINDLE_COUNTERCLOCKWISE(int spindle) {
     q.type = QSTART_SPINDLE_COUNTERCLOCKWISE;
     q.data.set_spindle_speed.spindle = spindle;
     if(debug_qc) printf("enqueue spindle counterclockwise\n");
-    qc().push_back(q);
+    qc_push(q);
 }
 
 void enqueue_STOP_SPINDLE_TURNING(int spindle) {
@@ -189,7 +195,7 @@ void enqueue_STOP_SPINDLE_TURNING(int spindle) {
     q.type = QSTOP_SPINDLE_TURNING;
     q.data.set_spindle_speed.spindle = spindle;
     if(debug_qc) printf("enqueue spindle stop\n");
-    qc().push_back(q);
+    qc_push(q);
 }
 
 void enqueue_ORIENT_SPINDLE(int spindle, double orientation, int mode) {
@@ -204,7 +210,7 @@ void enqueue_ORIENT_SPINDLE(int spindle, double orientation, int mode) {
     q.data.orient_spindle.orientation = orientation;
     q.data.orient_spindle.mode = mode;
     if(debug_qc) printf("enqueue spindle orient\n");
-    qc().push_back(q);
+    qc_push(q);
 }
 
 void enqueue_WAIT_ORIENT_SPINDLE_COMPLETE(int spindle, double timeout) {
@@ -218,7 +224,7 @@ void enqueue_WAIT_ORIENT_SPINDLE_COMPLETE(int spindle, double timeout) {
     q.data.wait_orient_spindle_complete.spindle = spindle;
     q.data.wait_orient_spindle_complete.timeout = timeout;
     if(debug_qc) printf("enqueue wait spindle orient complete\n");
-    qc().push_back(q);
+    qc_push(q);
 }
 
 void enqueue_SET_SPINDLE_MODE(int spindle, double mode) {
@@ -232,7 +238,7 @@ void enqueue_SET_SPINDLE_MODE(int spindle, double mode) {
     q.data.set_spindle_mode.spindle = spindle;
     q.data.set_spindle_mode.mode = mode;
     if(debug_qc) printf("enqueue spindle mode %f\n", mode);
-    qc().push_back(q);
+    qc_push(q);
 }
 
 void enqueue_SET_SPINDLE_SPEED(int spindle, double speed) {
@@ -246,7 +252,7 @@ void enqueue_SET_SPINDLE_SPEED(int spindle, double speed) {
     q.data.set_spindle_speed.spindle = spindle;
     q.data.set_spindle_speed.speed = speed;
     if(debug_qc) printf("enqueue set spindle speed %f\n", speed);
-    qc().push_back(q);
+    qc_push(q);
 }
 
 void enqueue_COMMENT(const char *c) {
@@ -259,7 +265,7 @@ void enqueue_COMMENT(const char *c) {
     q.type = QCOMMENT;
     q.data.comment.comment = strdup(c);
     if(debug_qc) printf("enqueue comment \"%s\"\n", c);
-    qc().push_back(q);
+    qc_push(q);
 }
 
 int enqueue_STRAIGHT_FEED(setup_pointer settings, int l, 
@@ -296,7 +302,7 @@ int enqueue_STRAIGHT_FEED(setup_pointer settings, int l,
     q.data.straight_feed.u = u;
     q.data.straight_feed.v = v;
     q.data.straight_feed.w = w;
-    qc().push_back(q);
+    qc_push(q);
     if(debug_qc) printf("enqueue straight feed lineno %d to %f %f %f direction %f %f %f\n", l, x,y,z, dx, dy, dz);
     return 0;
 }
@@ -336,7 +342,7 @@ int enqueue_STRAIGHT_TRAVERSE(setup_pointer settings, int l,
     q.data.straight_traverse.v = v;
     q.data.straight_traverse.w = w;
     if(debug_qc) printf("enqueue straight traverse lineno %d to %f %f %f direction %f %f %f\n", l, x,y,z, dx, dy, dz);
-    qc().push_back(q);
+    qc_push(q);
     return 0;
 }
 
@@ -366,7 +372,7 @@ void enqueue_ARC_FEED(setup_pointer settings, int l,
     q.data.arc_feed.w = w;
 
     if(debug_qc) printf("enqueue arc lineno %d to %f %f center %f %f turn %d sweeping %f\n", l, end1, end2, center1, center2, turn, original_turns);
-    qc().push_back(q);
+    qc_push(q);
 }
 
 void enqueue_M_USER_COMMAND (int index, double p_number, double q_number) {
@@ -383,14 +389,14 @@ void enqueue_M_USER_COMMAND (int index, double p_number, double q_number) {
     q.data.mcommand.q_number = q_number;
     if(debug_qc) printf("enqueue M_USER_COMMAND index=%d p=%f q=%f\n",
                         index,p_number,q_number);
-    qc().push_back(q);
+    qc_push(q);
 }
 
 void enqueue_START_CHANGE (void) {
     queued_canon q;
     q.type = QSTART_CHANGE;
     if(debug_qc) printf("enqueue START_CHANGE\n");
-    qc().push_back(q);
+    qc_push(q);
 }
 
 
@@ -2053,6 +2053,8 @@ int Interp::read_parameter(
           NCE_PARAMETER_NUMBER_OUT_OF_RANGE);
       CHKS(((index >= 5420) && (index <= 5428) && (_setup.cutter_comp_side != CUTTER_COMP::OFF)),
            _("Cannot read current position with cutter radius compensation on"));
+      if (_speculation)
+          speculation_note(index);
       *double_ptr = parameters[index];
   }
   return INTERP_OK;
@@ -2193,6 +2195,8 @@ int Interp::read_parameter_setting(
           NCE_EQUAL_SIGN_MISSING_IN_PARAMETER_SETTING);
       *counter = (*counter + 1);
       CHP(read_real_value(line, counter, &value, parameters));
+      if (_speculation)
+          speculation_note(index);
       _setup.parameter_numbers[_setup.parameter_occurrence] = index;
       _setup.parameter_values[_setup.parameter_occurrence] = value;
       _setup.parameter_occurrence++;
@@ -345,6 +345,7 @@ remap_pointer Interp::remapping(const char *code)
 // parse options of the form:
 // REMAP= M420 modalgroup=6 argspec=pq prolog=setnamedvars ngc=m43.ngc epilog=ignore_retvalue
 // REMAP= M421 modalgroup=6 argspec=- prolog=setnamedvars python=m43func epilog=ignore_retvalue
+// REMAP= M6 modalgroup=6 argspec=t cprolog=libtc.so:prepare cplugin=libtc.so:change
 
 int Interp::parse_remap(const char *inistring, int lineno)
 {
@@ -439,6 +440,25 @@ int Interp::parse_remap(const char *inistring, int lineno)
 	    }
 	    continue;
 	}
+	if (!strncasecmp(kw,"cprolog",kwlen) ||
+	    !strncasecmp(kw,"cepilog",kwlen) ||
+	    !strncasecmp(kw,"cplugin",kwlen)) {
+	    cplugin_handler handler = cplugin_load(arg);
+	    if (handler == NULL) {
+		Error("%s - %d:REMAP = %s", getSavedError(), lineno, inistring);
+		errored = true;
+	    } else if (!strncasecmp(kw,"cprolog",kwlen)) {
+		r.cprolog = strstore(arg);
+		r.cprolog_func = handler;
+	    } else if (!strncasecmp(kw,"cepilog",kwlen)) {
+		r.cepilog = strstore(arg);
+		r.cepilog_func = handler;
+	    } else {
+		r.remap_cplugin = strstore(arg);
+		r.cbody_func = handler;
+	    }
+	    continue;
+	}
 	if (!strncasecmp(kw,"ngc",kwlen)) {
 	    if (r.remap_py) {
 		Error("can\'t remap to an ngc file and a Python function: -  %d:REMAP = %s",
@@ -486,6 +506,17 @@ int Interp::parse_remap(const char *inistring, int lineno)
 	goto fail;
     }
 
+    if ((r.remap_cplugin != NULL) + (r.remap_py != NULL) + (r.remap_ngc != NULL) > 1) {
+	Error("code '%s' - only one of ngc=, python= and cplugin= may be given : %d:REMAP = %s",
+	      code,lineno,inistring);
+	goto fail;
+    }
+    if ((r.prolog_func && r.cprolog) || (r.epilog_func && r.cepilog)) {
+	Error("code '%s' - a Python and a native prolog or epilog : %d:REMAP = %s",
+	      code,lineno,inistring);
+	goto fail;
+    }
+
     if (remapping(code)) {
 	Error("code '%s' already remapped : %d:REMAP = %s",
 	      code,lineno,inistring);
@@ -493,8 +524,8 @@ int Interp::parse_remap(const char *inistring, int lineno)
     }
 
     // it is an error not to define a remap function to call.
-    if ((r.remap_ngc == NULL) && (r.remap_py == NULL)) {
-	Error("code '%s' - no remap function given, use either 'python=<function>' or 'ngc=<basename>' : %d:REMAP = %s",
+    if ((r.remap_ngc == NULL) && (r.remap_py == NULL) && (r.remap_cplugin == NULL)) {
+	Error("code '%s' - no remap function given, use either 'python=<function>', 'cplugin=<lib.so:function>' or 'ngc=<basename>' : %d:REMAP = %s",
 	      code,lineno,inistring);
 	goto fail;
     }
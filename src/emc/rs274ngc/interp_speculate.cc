@@ -0,0 +1,220 @@
+/********************************************************************
+* Description: interp_speculate.cc
+*
+*   Speculative reading past queue busters.
+*
+*   A probe move (G38.x) or an input wait (M66) ends the block with
+*   INTERP_EXECUTE_FINISH: task drains its queue, waits for motion and
+*   only then lets the interpreter read on, with the probe result or the
+*   input in #5061-#5070 or #5399.  With speculation task asks the
+*   interpreter instead to copy its state at that point and read on as
+*   if the awaited values will come back unchanged, while it holds the
+*   resulting canon calls back.  Once the buster completed the values
+*   that really came in are read into the copy; if they and the position
+*   match what reading ahead assumed, or the program never looked at the
+*   ones that changed, the lines read ahead stand and task releases
+*   their canon calls.  Otherwise the copy becomes the interpreter
+*   state, the file goes back to the line after the buster and task
+*   drops what was held.
+*
+*   Only the main program is read ahead: speculation starts at call
+*   level 0 outside remaps and cutter compensation, and stops before any
+*   line that calls a subroutine, runs a remap (which may be Python with
+*   effects of its own), changes tools, switches cutter compensation or
+*   stops or ends the program.  Cutter compensation keeps the moves it
+*   has yet to clip in the canon queue of interp_queue.cc, outside the
+*   state that is copied here, so it is never turned on while reading
+*   ahead.
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+*
+********************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <memory>
+#include "rs274ngc.hh"
+#include "rs274ngc_return.hh"
+#include "interp_return.hh"
+#include "interp_internal.hh"
+#include "interp_queue.hh"
+#include "rs274ngc_interp.hh"
+
+// positions come back through unit conversions and offsets
+#define SPECULATION_TOLERANCE 1e-6
+
+struct speculation {
+    setup before;               // state at the buster, its flags still set
+    long offset;                // file position of the line after it
+    bool looked;                // the program used an awaited parameter
+    bool blocked;               // stopped at a line that has to wait
+};
+
+// copies the interpreter state, except the Python object, which stays
+// with the setup that owns it
+static void copy_state(setup &to, const setup &from)
+{
+    boost::python::object *pythis = to.pythis;
+    to = from;
+    to.pythis = pythis;
+}
+
+static bool awaited(const setup &s, int index)
+{
+    return (s.probe_flag && index >= 5061 && index <= 5070) ||
+        (s.input_flag && index == 5399);
+}
+
+static bool same_position(const setup &a, const setup &b)
+{
+    const double d[] = {
+        a.current_x - b.current_x, a.current_y - b.current_y,
+        a.current_z - b.current_z, a.AA_current - b.AA_current,
+        a.BB_current - b.BB_current, a.CC_current - b.CC_current,
+        a.u_current - b.u_current, a.v_current - b.v_current,
+        a.w_current - b.w_current,
+    };
+    for (double v : d) {
+        if (fabs(v) > SPECULATION_TOLERANCE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Called by task right after execute() returned INTERP_EXECUTE_FINISH.
+   Only probes and input waits are read past; a tool change reloads
+   the whole tool table, which reading ahead cannot guess. */
+int Interp::speculate(int *speculating)
+{
+    *speculating = 0;
+    if (_speculation || !_setup.file_pointer || _setup.lazy_closing ||
+        !(_setup.probe_flag || _setup.input_flag) || _setup.toolchange_flag ||
+        _setup.call_level != 0 || _setup.remap_level != 0 ||
+        _setup.call_state != CS_NORMAL || _setup.defining_sub ||
+        _setup.skipping_o || _setup.skipping_to_sub ||
+        _setup.cutter_comp_side != CUTTER_COMP::OFF || !qc().empty()) {
+        return INTERP_OK;
+    }
+
+    std::unique_ptr<speculation> spec(new speculation);
+    copy_state(spec->before, _setup);
+    spec->offset = ftell(_setup.file_pointer);
+    spec->looked = false;
+    spec->blocked = false;
+    if (spec->offset < 0) {
+        return INTERP_OK;
+    }
+
+    // read on as if the values came back as they are now
+    _setup.probe_flag = false;
+    _setup.input_flag = false;
+    _speculation = spec.release();
+    *speculating = 1;
+    return INTERP_OK;
+}
+
+bool Interp::speculation_blocked()
+{
+    return _speculation && _speculation->blocked;
+}
+
+/* Called by read() with each block read ahead.  A block that must not
+   run before the buster resolved is put back: the file goes back to
+   its start and read() hands out an empty line instead. */
+bool Interp::speculation_hold(block_pointer block, int sequence_number)
+{
+    if (!_speculation->blocked &&
+        (_setup.skipping_o || _setup.defining_sub ||
+         (block->remappings.empty() &&
+          block->o_type != O_call && block->o_type != M_98 &&
+          block->g_modes[GM_CUTTER_COMP] == -1 &&
+          block->m_modes[4] == -1 && block->m_modes[6] == -1))) {
+        return false;
+    }
+    fseek(_setup.file_pointer, block->offset, SEEK_SET);
+    _setup.sequence_number = sequence_number;
+    _speculation->blocked = true;
+    init_block(block);
+    _setup.line_length = 0;
+    _setup.linetext[0] = 0;
+    _setup.blocktext[0] = 0;
+    return true;
+}
+
+// a numbered parameter was read or set while reading ahead
+void Interp::speculation_note(int index)
+{
+    if (awaited(_speculation->before, index)) {
+        _speculation->looked = true;
+    }
+}
+
+void Interp::speculation_drop()
+{
+    delete _speculation;
+    _speculation = NULL;
+}
+
+/* Called by task once the buster completed and its queue is empty, so
+   synch() and read_inputs() see what the buster left behind. */
+int Interp::resolve_speculation(int *committed)
+{
+    *committed = 0;
+    if (!_speculation) {
+        return INTERP_OK;
+    }
+    std::unique_ptr<speculation> spec(_speculation);
+    _speculation = NULL;
+
+    std::unique_ptr<setup> ahead(new setup);
+    copy_state(*ahead, _setup);
+    copy_state(_setup, spec->before);
+    int status = synch();
+    if (status == INTERP_OK) {
+        status = read_inputs(&_setup);
+    }
+
+    bool held = status == INTERP_OK && same_position(_setup, spec->before) &&
+        _setup.current_pocket == spec->before.current_pocket &&
+        _setup.selected_pocket == spec->before.selected_pocket;
+    for (int i = 1; held && i < interp_param_global::RS274NGC_MAX_PARAMETERS; i++) {
+        if (i >= 5420 && i <= 5428) {
+            continue;           // the position, compared above
+        }
+        if (_setup.parameters[i] != spec->before.parameters[i] &&
+            (spec->looked || !awaited(spec->before, i))) {
+            held = false;
+        }
+    }
+
+    if (held) {
+        // the program never looked at the values that changed, so they
+        // can simply take their place
+        for (int i = 5061; i <= 5399; i++) {
+            if (awaited(spec->before, i)) {
+                ahead->parameters[i] = _setup.parameters[i];
+            }
+        }
+        copy_state(_setup, *ahead);
+        *committed = 1;
+        return INTERP_OK;
+    }
+
+    // read again from the line after the buster, with the real values;
+    // the canon queue is empty there, since compensation was off
+    qc_reset();
+    if (_setup.file_pointer != ahead->file_pointer) {
+        // should not happen, calls are never read ahead
+        ERS(_("Cannot go back to line %d after reading ahead"),
+            spec->before.sequence_number);
+    }
+    if (fseek(_setup.file_pointer, spec->offset, SEEK_SET) != 0) {
+        ERS(_("Cannot go back to line %d after reading ahead"),
+            spec->before.sequence_number);
+    }
+    return status;
+}
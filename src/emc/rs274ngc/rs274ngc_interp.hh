@@ -69,6 +69,16 @@ public:
 // synchronize your internal model with the external world
  int synch();
 
+// continue the open program from its last checkpoint before 'line'
+ int restore_checkpoint(int line, int *restored);
+ void record_checkpoints(bool on);
+
+// read on past a probe or input wait before it completes, see
+// interp_speculate.cc
+ int speculate(int *speculating);
+ bool speculation_blocked();
+ int resolve_speculation(int *committed);
+
 /* Interface functions to call to get information from the interpreter.
    If a function has a return value, the return value contains the information.
    If a function returns nothing, information is copied into one of the
@@ -411,6 +421,11 @@ public:
                       setup_pointer settings);
  int precedence(int an_operator);
  int _read(const char *command);
+ void checkpoint_record();
+ void checkpoint_flush();
+ bool speculation_hold(block_pointer block, int sequence_number);
+ void speculation_note(int index);
+ void speculation_drop();
  int read_a(char *line, int *counter, block_pointer block,
                   double *parameters);
  int read_atan(char *line, int *counter, double *double_ptr,
@@ -685,6 +700,10 @@ int read_inputs(setup_pointer settings);
 	       const char *funcname,
 	       int calltype);
     int py_execute(const char *cmd, bool as_file = false); // for (py, ....) comments
+    // native remap handlers, interp_cplugin.cc
+    cplugin_handler cplugin_load(const char *spec);
+    int cplugin_run(setup_pointer settings, context_pointer frame,
+		    cplugin_handler handler, int phase, bool resume);
     int py_reload();
     FILE *find_ngc_file(setup_pointer settings,const char *basename, char *foundhere = NULL);
 
@@ -718,6 +737,8 @@ int read_inputs(setup_pointer settings);
  static const read_function_pointer default_readers[256];
 
  setup _setup;
+ struct checkpoint_recorder *_checkpoints;
+ struct speculation *_speculation;
 
  enum {
      AXIS_MASK_X =   1, AXIS_MASK_Y =   2, AXIS_MASK_Z =   4,
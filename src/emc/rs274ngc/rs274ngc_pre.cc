@@ -97,6 +97,7 @@ include an option for suppressing superfluous commands.
 #include "rs274ngc_return.hh"
 #include "interp_internal.hh"	// interpreter private definitions
 #include "interp_queue.hh"
+#include "interp_cache.hh"
 #include "rs274ngc_interp.hh"
 #include <wordexp.h>
 #include "units.h"
@@ -128,7 +129,9 @@ static char savedError[LINELEN+1];
 
 Interp::Interp()
     : log_file(stderr),
-    _setup{}
+    _setup{},
+    _checkpoints(NULL),
+    _speculation(NULL)
 {
     _setup.init_once = 1;  
   init_named_parameters();  // need this before Python init.
@@ -179,6 +182,8 @@ InterpBase *makeInterp()
 }
 
 Interp::~Interp() {
+    checkpoint_flush();
+    speculation_drop();
     if(log_file) {
         if(log_file != stderr)
             fclose(log_file);
@@ -242,6 +247,7 @@ Called By: external programs
 int Interp::close()
 {
     logOword("Interp::close()");
+    checkpoint_flush();
     // be "lazy" only if we're not aborting a call in progress
     // in which case we need to reset() the call stack
     // this does not reset the filename properly 
@@ -1067,6 +1073,11 @@ int Interp::init()
 	  inifile.Find(&_setup.disable_fanuc_style_sub,
 		       "DISABLE_FANUC_STYLE_SUB",
 		       "RS274NGC");
+
+	  // lines between run-from-line checkpoints, 0 to disable
+	  inifile.Find(&_setup.checkpoint_interval,
+		       "CHECKPOINT_INTERVAL",
+		       "RS274NGC");
 	  logDebug("init:  DISABLE_FANUC_STYLE_SUB = %d",
 		   _setup.disable_fanuc_style_sub);
 
@@ -1398,6 +1409,7 @@ int Interp::open(const char *filename) //!< string: the name of the input NC-pro
       _setup.lazy_closing = 0;
     }
   CHKS((_setup.file_pointer != NULL), NCE_A_FILE_IS_ALREADY_OPEN);
+  checkpoint_flush();
   CHKS((strlen(filename) > (LINELEN - 1)), NCE_FILE_NAME_TOO_LONG);
   _setup.file_pointer = fopen(filename, "r");
   CHKS((_setup.file_pointer == NULL), NCE_UNABLE_TO_OPEN_FILE, filename);
@@ -1615,9 +1627,13 @@ int Interp::_read(const char *command)  //!< may be NULL or a string to read
   _setup.parameters[5427] = _setup.v_current;
   _setup.parameters[5428] = _setup.w_current;
 
+  int sequence_number = _setup.sequence_number;
   if(_setup.file_pointer)
   {
       EXECUTING_BLOCK(_setup).offset = ftell(_setup.file_pointer);
+      // lines read ahead of a queue buster may still be taken back
+      if (command == NULL && !_speculation)
+          checkpoint_record();
   }
 
   read_status =
@@ -1635,6 +1651,10 @@ int Interp::_read(const char *command)  //!< may be NULL or a string to read
       || (read_status == INTERP_OK)) {
     if (_setup.line_length != 0) {
 	CHP(parse_line(_setup.blocktext, &(EXECUTING_BLOCK(_setup)), &_setup));
+	if (_speculation && command == NULL &&
+	    speculation_hold(&(EXECUTING_BLOCK(_setup)), sequence_number)) {
+	    return INTERP_OK;
+	}
     }
 
     else // Blank line (zero length)
@@ -1782,6 +1802,7 @@ int Interp::reset()
     
     // drop any queued points in canon
     ON_RESET();
+    speculation_drop();
     
     unwind_call(INTERP_OK, __FILE__,__LINE__,__FUNCTION__);
     return INTERP_OK;
@@ -2749,6 +2770,8 @@ FILE *Interp::find_ngc_file(setup_pointer settings,const char *basename, char *f
     // pass what we found
     if (foundhere && (newFP != NULL)) 
         strcpy(foundhere, newFileName);
+    if (newFP)
+        program_cache_note_file(newFileName);
 
     // Not sure this is needed but the internet told me
     wordfree(&exp_result);
@@ -2769,9 +2792,11 @@ const char *strstore(const char *s)
 
 context_struct::context_struct()
 : position(0), sequence_number(0), filename(""), subName(""),
-  m98_loop_counter(-1), context_status(0), call_type(0)
+  m98_loop_counter(-1), context_status(0), call_type(0),
+  cplugin_resumed(0)
 {
     memset(saved_params, 0, sizeof(saved_params));
+    memset(cplugin_state, 0, sizeof(cplugin_state));
     memset(saved_g_codes, 0, sizeof(saved_g_codes));
     memset(saved_m_codes, 0, sizeof(saved_m_codes));
     memset(saved_settings, 0, sizeof(saved_settings));
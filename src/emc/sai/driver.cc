@@ -550,6 +550,7 @@ int main (int argc, char ** argv)
   int go_flag;
   char *inifile = NULL;
   int log_level = -1;
+  int run_from = -1;
   std::string interp;
 
   setvbuf(stdout, NULL, _IONBF, 0);
@@ -575,7 +576,7 @@ int main (int argc, char ** argv)
 #endif //}
 
   while(1) {
-      int c = getopt(argc, argv, "p:t:v:bsn:gi:l:T");
+      int c = getopt(argc, argv, "p:t:v:bsn:gi:l:Tr:");
       if(c == -1) break;
 
       switch(c) {
@@ -589,6 +590,7 @@ int main (int argc, char ** argv)
           case 'g': go_flag = !go_flag; break;
           case 'i': inifile = optarg; break;
           case 'T': _task = 1; break;
+          case 'r': run_from = atoi(optarg); break;
           case '?': default: goto usage;
       }
   }
@@ -613,6 +615,8 @@ usage:
             "    -i: specify the INI file (default: no INI file)\n"
             "    -T: call task_init()\n"
             "    -l: specify the log_level (default: -1)\n"
+            "    -r: record run-from-line checkpoints like task does, and\n"
+            "        if the line is not 0 start from the last one before it\n"
             , argv[0]);
       exit(1);
     }
@@ -687,6 +691,8 @@ usage:
 
   if (log_level != -1)
       interp_set_loglevel(log_level);
+  if (run_from >= 0)
+      interp_new.record_checkpoints(true);
 
 
   if (argc == 1)
@@ -699,6 +705,17 @@ usage:
           report_error(status, print_stack);
           exit(1);
         }
+      if (run_from > 0)
+        {
+          int restored;
+          status = interp_new.restore_checkpoint(run_from, &restored);
+          if (status != INTERP_OK)
+            {
+              report_error(status, print_stack);
+              exit(1);
+            }
+          fprintf(stderr, "restored checkpoint at line %d\n", restored);
+        }
       status = interpret_from_file(do_next, block_delete, print_stack);
       file_name(buffer, 5);  /* called to exercise the function */
       file_name(buffer, 79); /* called to exercise the function */
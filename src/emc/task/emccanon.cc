@@ -890,6 +890,7 @@ static VelData getStraightVelocity(CANON_POSITION pos)
             pos.w);
 }
 
+#include <utility>
 #include <vector>
 struct pt {
     double x, y, z, a, b, c, u, v, w;
@@ -903,6 +904,28 @@ static void drop_segments(void) {
     chained_points.clear();
 }
 
+/* Task keeps the canon state from where it started interpreting ahead
+   of a queue buster, to go back to if that work is thrown away. */
+static struct {
+    CanonConfig_t canon;
+    StateTag tag;
+    std::vector<struct pt> chained_points;
+} saved;
+
+void CANON_SAVE_STATE()
+{
+    saved.canon = canon;
+    saved.tag = _tag;
+    saved.chained_points = chained_points;
+}
+
+void CANON_SWAP_STATE()
+{
+    std::swap(saved.canon, canon);
+    std::swap(saved.tag, _tag);
+    std::swap(saved.chained_points, chained_points);
+}
+
 static void flush_segments(void) {
     if(chained_points.empty()) return;
 
@@ -433,9 +433,12 @@ static EMC_TASK_STATE determineState()
 }
 
 static int waitFlag = 0;
+static int speculating = 0;
+static int speculations = 0, rollbacks = 0;
 
 int emcTaskPlanInit()
 {
+    AllocTagScope alloc_tag(ALLOC_TAG_INTERP);
     if(!pinterp) {
 	IniFile inifile;
 	const char *inistring;
@@ -459,10 +462,13 @@ int emcTaskPlanInit()
     else  _is = 0;
     interp.ini_load(emc_inifile);
     waitFlag = 0;
+    speculating = 0;
 
     int retval = interp.init();
     // In task, enable M99 main program endless looping
     interp.set_loop_on_main_m99(true);
+    // and leave checkpoints for run-from-line behind
+    interp.record_checkpoints(true);
     if (retval > INTERP_MIN_ERROR) {  // I'd think this should be fatal.
 	print_interp_error(retval);
     } else {
@@ -547,6 +553,7 @@ void emcTaskPlanExit()
 
 int emcTaskPlanOpen(const char *file)
 {
+    AllocTagScope alloc_tag(ALLOC_TAG_INTERP);
     if (emcStatus != 0) {
 	emcStatus->task.motionLine = 0;
 	emcStatus->task.currentLine = 0;
@@ -568,8 +575,92 @@ int emcTaskPlanOpen(const char *file)
 }
 
 
+int emcTaskPlanRestoreCheckpoint(int line)
+{
+    AllocTagScope alloc_tag(ALLOC_TAG_INTERP);
+    int restored;
+    int retval = interp.restore_checkpoint(line, &restored);
+    if (retval > INTERP_MIN_ERROR) {
+	print_interp_error(retval);
+	return -1;
+    }
+
+    if (emc_debug & EMC_DEBUG_INTERP) {
+        rcs_print("emcTaskPlanRestoreCheckpoint(%d) restored line %d\n", line, restored);
+    }
+
+    return restored;
+}
+
+/* Lets the interpreter read on past the queue buster it just executed,
+   see interp_speculate.cc.  Everything canon queues meanwhile is held
+   back in interp_list.  Returns 1 if the interpreter does read on. */
+int emcTaskPlanSpeculate()
+{
+    AllocTagScope alloc_tag(ALLOC_TAG_INTERP);
+    int on;
+    int retval = interp.speculate(&on);
+    if (retval > INTERP_MIN_ERROR) {
+	print_interp_error(retval);
+	return 0;
+    }
+    if (on) {
+	CANON_SAVE_STATE();
+	interp_list.hold();
+	speculating = 1;
+    }
+    return on;
+}
+
+int emcTaskPlanIsSpeculating()
+{
+    return speculating;
+}
+
+int emcTaskPlanSpeculationBlocked()
+{
+    return speculating && interp.speculation_blocked();
+}
+
+/* Called once the queue buster completed.  Returns 1 when the lines read
+   ahead stand and their commands were released, 0 when the interpreter
+   went back and they were dropped, -1 on an interpreter error. */
+int emcTaskPlanResolveSpeculation()
+{
+    AllocTagScope alloc_tag(ALLOC_TAG_INTERP);
+    int committed;
+
+    if (!speculating) {
+	return 0;
+    }
+    speculating = 0;
+    // the interpreter resynchs against canon as the buster left it
+    CANON_SWAP_STATE();
+    int retval = interp.resolve_speculation(&committed);
+    speculations++;
+    if (committed) {
+	CANON_SWAP_STATE();
+	interp_list.release();
+    } else {
+	interp_list.drop_held();
+	rollbacks++;
+    }
+
+    if (emc_debug & EMC_DEBUG_INTERP) {
+        rcs_print("emcTaskPlanResolveSpeculation() %s, %d of %d rolled back\n",
+                  committed ? "committed" : "rolled back", rollbacks, speculations);
+    }
+    if (retval > INTERP_MIN_ERROR) {
+	print_interp_error(retval);
+	return -1;
+    }
+
+    return committed;
+}
+
 int emcTaskPlanRead()
 {
+    AllocTagScope alloc_tag(ALLOC_TAG_INTERP);
     int retval = interp.read();
     if (retval == INTERP_FILE_NOT_OPEN) {
 	if (emcStatus->task.file[0] != 0) {
@@ -593,6 +684,7 @@ int emcTaskPlanRead()
 
 int emcTaskPlanExecute(const char *command)
 {
+    AllocTagScope alloc_tag(ALLOC_TAG_INTERP);
     int inpos = emcStatus->motion.traj.inpos;	// 1 if in position, 0 if not.
 
     if (command != 0) {		// Command is 0 if in AUTO mode, non-null if in MDI mode.
@@ -618,6 +710,7 @@ int emcTaskPlanExecute(const char *command)
 
 int emcTaskPlanExecute(const char *command, int line_number)
 {
+    AllocTagScope alloc_tag(ALLOC_TAG_INTERP);
     int retval = interp.execute(command, line_number);
     if (retval > INTERP_MIN_ERROR) {
 	print_interp_error(retval);
@@ -646,6 +739,11 @@ int emcTaskPlanClose()
 
 int emcTaskPlanReset()
 {
+    if (speculating) {
+	CANON_SWAP_STATE();
+	interp_list.drop_held();
+	speculating = 0;
+    }
     int retval = interp.reset();
     if (retval > INTERP_MIN_ERROR) {
 	print_interp_error(retval);
@@ -738,6 +836,9 @@ int emcTaskUpdate(EMC_TASK_STAT * stat)
     
     //update state of block delete
     stat->block_delete_state = GET_BLOCK_DELETE();
+
+    emcTaskAllocUpdate(stat);
+    emcTaskReadaheadUpdate(stat);
     
     stat->heartbeat++;
 
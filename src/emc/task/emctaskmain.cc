@@ -84,6 +84,7 @@ fpu_control_t __fpu_control = _FPU_IEEE & ~(_FPU_MASK_IM | _FPU_MASK_ZM | _FPU_M
 #include "task.hh"		// emcTaskCommand etc
 #include "taskclass.hh"
 #include "motion.h"             // EMCMOT_ORIENT_*
+#include "cmdtrace.h"		// cmdtrace_user()
 #include "inihal.hh"
 
 static emcmot_config_t emcmotConfig;
@@ -129,6 +130,10 @@ static double taskExecDelayTimeout = 0.0;
 // emcTaskIssueCommand issues command immediately
 static int emcTaskIssueCommand(NMLmsg * cmd);
 
+// serial number of the last run, step, resume or MDI command; the
+// commands the interpreter queued for it are traced under it
+static int cmdtraceProgramSerial = 0;
+
 // pending command to be sent out by emcTaskExecute()
 NMLmsg *emcTaskCommand = 0;
 
@@ -434,6 +439,12 @@ int stepping = 0;
 int steppingWait = 0;
 static int steppedLine = 0;
 
+// how many queued messages to search for the next T word, 0 disables
+static int toolPrepareLookahead = 0;
+// tool number last sent to iocontrol ahead of its T word, reset by
+// emcIoAbort() since iocontrol forgets it then
+int prefetchedTool = -1;
+
 // Variables to handle MDI call interrupts
 // Depth of call level before interrupted MDI call
 static int mdi_execute_level = -1;
@@ -449,6 +460,15 @@ static NML_INTERP_LIST mdi_input_queue;
 #define  MAX_MDI_QUEUE 10
 static int max_mdi_queued_commands = MAX_MDI_QUEUE;
 
+// read on past probes and input waits before they complete, [TASK]SPECULATE
+static int speculate = 0;
+// what stopped reading ahead; only acted on if the lines read ahead stand
+static int speculationRead = INTERP_OK;
+static int speculationExec = INTERP_OK;
+
+// read on a thread of its own instead of in the plan, [TASK]READAHEAD_THREAD
+static int readaheadThread = 0;
+
 /*
   checkInterpList(NML_INTERP_LIST *il, EMC_STAT *stat) takes a pointer
   to an interpreter list and a pointer to the EMC status, pops each NML
@@ -497,15 +517,106 @@ static int checkInterpList(NML_INTERP_LIST * il, EMC_STAT * stat)
 }
 extern int emcTaskMopup();
 
-void readahead_reading(void)
+// a read that did not return a line: the interp is now in a paused state
+static void readahead_read_failed(void)
+{
+    /* Signal to the rest of the system that that the interp
+       is now in a paused state. */
+    emcStatus->task.interpState = EMC_TASK_INTERP::WAITING;
+}
+
+static void readahead_executed(int execRetval)
+{
+    if (execRetval > INTERP_MIN_ERROR) {
+	emcStatus->task.interpState =
+	    EMC_TASK_INTERP::WAITING;
+	interp_list.clear();
+	emcAbortCleanup(EMC_ABORT_INTERPRETER_ERROR,
+			"interpreter error"); 
+    } else if (execRetval == -1
+	    || execRetval == INTERP_EXIT ) {
+	emcStatus->task.interpState =
+	    EMC_TASK_INTERP::WAITING;
+    } else if (execRetval == INTERP_EXECUTE_FINISH) {
+	// INTERP_EXECUTE_FINISH signifies
+	// that no more reading should be done until
+	// everything
+	// outstanding is completed
+	emcTaskPlanSetWait();
+	// and resynch interp WM, unless the interp
+	// reads on meanwhile and resynchs when it is done
+	if (speculate && programStartLine == 0 &&
+	    emcTaskPlanSpeculate()) {
+	    speculationRead = INTERP_OK;
+	    speculationExec = INTERP_OK;
+	} else {
+	    emcTaskQueueCommand(&taskPlanSynchCmd);
+	}
+    } else if (execRetval != 0) {
+	// end of file
+	emcStatus->task.interpState =
+	    EMC_TASK_INTERP::WAITING;
+	emcStatus->task.motionLine = 0;
+	emcStatus->task.readLine = 0;
+    } else {
+
+	// executed a good line
+    }
+}
+
+// the interp reads ahead of a queue buster and may go on
+static int reading_ahead(void)
+{
+    return emcTaskPlanIsSpeculating() &&
+	speculationRead == INTERP_OK && speculationExec == INTERP_OK &&
+	!emcTaskPlanSpeculationBlocked();
+}
+
+/* Once the queue buster the interp read past completed, it finds out
+   whether what it read ahead stands.  If so the held commands go out
+   and whatever stopped reading ahead is acted on now; if not they are
+   dropped and reading goes on from the line after the buster. */
+static void readahead_resolve(void)
+{
+    if (interp_list.len() != 0 ||
+	emcTaskCommand != 0 ||
+	emcStatus->task.execState != EMC_TASK_EXEC::DONE) {
+	return;
+    }
+    int readRetval = speculationRead;
+    int execRetval = speculationExec;
+    speculationRead = INTERP_OK;
+    speculationExec = INTERP_OK;
+    emcTaskPlanClearWait();
+
+    int committed = emcTaskPlanResolveSpeculation();
+    if (committed < 0) {
+	readahead_executed(INTERP_ERROR);
+    } else if (committed) {
+	if (readRetval != INTERP_OK) {
+	    readahead_read_failed();
+	} else {
+	    readahead_executed(execRetval);
+	}
+    }
+}
+
+/* The READING part of the plan: reads up to lines lines while there is
+   room in interp_list, or none but still lifts the wait for a queue
+   buster once it completed. */
+void readahead_reading(int lines)
 {
     int readRetval;
     int execRetval;
 
-		if (interp_list.len() <= emc_task_interp_max_len) {
+    if (emcTaskPlanIsSpeculating()) {
+	readahead_resolve();
+    }
+		if (interp_list.len() + interp_list.held_len()
+			<= emc_task_interp_max_len) {
                     int count = 0;
 interpret_again:
-		    if (emcTaskPlanIsWait()) {
+		    if (emcTaskPlanIsWait() && !reading_ahead()) {
 			// delay reading of next line until all is done
 			if (interp_list.len() == 0 &&
 			    emcTaskCommand == 0 &&
@@ -513,7 +624,7 @@ interpret_again:
 			    EMC_TASK_EXEC::DONE) {
 			    emcTaskPlanClearWait();
 			 }
-		    } else {
+		    } else if (lines > 0) {
 			readRetval = emcTaskPlanRead();
 			/*! \todo MGS FIXME
 			   This if() actually evaluates to if (readRetval != INTERP_OK)...
@@ -523,14 +634,18 @@ interpret_again:
 				|| readRetval == INTERP_ENDFILE
 				|| readRetval == INTERP_EXIT
 				|| readRetval == INTERP_EXECUTE_FINISH) {
-			    /* emcTaskPlanRead retval != INTERP_OK
-			       Signal to the rest of the system that that the interp
-			       is now in a paused state. */
 			    /*! \todo FIXME The above test *should* be reduced to:
 			       readRetVal != INTERP_OK
 			       (N.B. Watch for negative error codes.) */
-			    emcStatus->task.interpState =
-				EMC_TASK_INTERP::WAITING;
+			    if (emcTaskPlanIsSpeculating()) {
+				// may not even happen once the interp went back
+				speculationRead = readRetval;
+			    } else {
+				readahead_read_failed();
+			    }
+			} else if (emcTaskPlanSpeculationBlocked()) {
+			    // the interp put back a line that has to wait
+			    // for the queue buster
 			} else {
 			    // got a good line
 			    // record the line number and command
@@ -544,33 +659,10 @@ interpret_again:
 			    // returns from subprograms in external
 			    // files
 			    emcStatus->task.readLine = emcTaskPlanLine();
-			    if (execRetval > INTERP_MIN_ERROR) {
-				emcStatus->task.interpState =
-				    EMC_TASK_INTERP::WAITING;
-				interp_list.clear();
-				emcAbortCleanup(EMC_ABORT_INTERPRETER_ERROR,
-						"interpreter error"); 
-			    } else if (execRetval == -1
-				    || execRetval == INTERP_EXIT ) {
-				emcStatus->task.interpState =
-				    EMC_TASK_INTERP::WAITING;
-			    } else if (execRetval == INTERP_EXECUTE_FINISH) {
-				// INTERP_EXECUTE_FINISH signifies
-				// that no more reading should be done until
-				// everything
-				// outstanding is completed
-				emcTaskPlanSetWait();
-				// and resynch interp WM
-				emcTaskQueueCommand(&taskPlanSynchCmd);
-			    } else if (execRetval != 0) {
-				// end of file
-				emcStatus->task.interpState =
-				    EMC_TASK_INTERP::WAITING;
-                                emcStatus->task.motionLine = 0;
-                                emcStatus->task.readLine = 0;
+			    if (emcTaskPlanIsSpeculating() && execRetval != 0) {
+				speculationExec = execRetval;
 			    } else {
-
-				// executed a good line
+				readahead_executed(execRetval);
 			    }
 
 			    // throw the results away if we're supposed to
@@ -621,9 +713,10 @@ interpret_again:
                                 }
 			    }
 
-                            if (count++ < emc_task_interp_max_len
+                            if (++count < lines
                                     && emcStatus->task.interpState == EMC_TASK_INTERP::READING
-                                    && interp_list.len() <= emc_task_interp_max_len * 2/3) {
+                                    && interp_list.len() + interp_list.held_len()
+                                        <= emc_task_interp_max_len * 2/3) {
                                 goto interpret_again;
                             }
 
@@ -632,6 +725,16 @@ interpret_again:
 		}		// if interp len is less than max
 }
 
+// whether the read-ahead thread has something to do
+int readahead_ready(void)
+{
+    return emcStatus->task.mode == EMC_TASK_MODE::AUTO &&
+	emcStatus->task.state == EMC_TASK_STATE::ON &&
+	emcStatus->task.interpState == EMC_TASK_INTERP::READING &&
+	interp_list.len() + interp_list.held_len() <= emc_task_interp_max_len &&
+	(!emcTaskPlanIsWait() || reading_ahead());
+}
+
 static void mdi_execute_abort(void)
 {
     int queued_mdi_commands;
@@ -1185,8 +1288,9 @@ static int emcTaskPlan(void)
 
 		}		// switch (type) in ON, AUTO, READING
 
-               // handle interp readahead logic
-                readahead_reading();
+               // handle interp readahead logic, unless the read-ahead
+               // thread reads
+                readahead_reading(readaheadThread ? 0 : emc_task_interp_max_len + 1);
                 
 		break;		// EMC_TASK_INTERP::READING
 
@@ -1648,6 +1752,16 @@ static int emcTaskIssueCommand(NMLmsg * cmd)
 	rcs_print("Issuing %s -- \t (%s)\n", emcSymbolLookup(cmd->type),
 		  emcCommandBuffer->msg2str(cmd));
     }
+    cmdtrace_serial = ((RCS_CMD_MSG *) cmd)->serial_number;
+    if (cmdtrace_serial == 0) {
+	cmdtrace_serial = cmdtraceProgramSerial;
+    } else if (cmd->type == EMC_TASK_PLAN_RUN_TYPE ||
+	       cmd->type == EMC_TASK_PLAN_STEP_TYPE ||
+	       cmd->type == EMC_TASK_PLAN_RESUME_TYPE ||
+	       cmd->type == EMC_TASK_PLAN_EXECUTE_TYPE) {
+	cmdtraceProgramSerial = cmdtrace_serial;
+    }
+    cmdtrace_user(CMDTRACE_TASK_ISSUE, cmdtrace_serial, 0, cmd->type, 0, 0);
     switch (cmd->type) {
 	// general commands
 
@@ -2064,6 +2178,7 @@ static int emcTaskIssueCommand(NMLmsg * cmd)
 
     case EMC_TOOL_PREPARE_TYPE:
 	tool_prepare_msg = (EMC_TOOL_PREPARE *) cmd;
+	prefetchedTool = -1;
 	retval = emcToolPrepare(tool_prepare_msg->tool);
 	break;
 
@@ -2305,6 +2420,21 @@ static int emcTaskIssueCommand(NMLmsg * cmd)
 	}
 	run_msg = (EMC_TASK_PLAN_RUN *) cmd;
 	programStartLine = run_msg->line;
+	if (programStartLine > 0) {
+	    // skip most of the lines before the start line if the
+	    // interpreter has a checkpoint of its state there
+	    int line = emcTaskPlanRestoreCheckpoint(programStartLine);
+	    if (line < 0) {
+		retval = -1;
+		break;
+	    }
+	    if (line > 0) {
+		// the canon calls that restored the modes are thrown away
+		// like those of the lines read through
+		interp_list.clear();
+		emcStatus->task.readLine = line;
+	    }
+	}
 	emcStatus->task.interpState = EMC_TASK_INTERP::READING;
 	emcStatus->task.task_paused = 0;
 	retval = 0;
@@ -2405,6 +2535,8 @@ static int emcTaskIssueCommand(NMLmsg * cmd)
 			    emc_symbol_lookup(cmd->type));
 	}
     }
+    // motion commands task sends on its own are not part of this one
+    cmdtrace_serial = 0;
     /* debug */
     if ((emc_debug & EMC_DEBUG_TASK_ISSUE) && retval) {
     	rcs_print("emcTaskIssueCommand() returning: %d\n", retval);
@@ -2539,6 +2671,50 @@ if (stepping) {                                                            \
   }                                                                        \
 }
 
+/*
+  Look past the queued motion for the next tool prepare and send it to
+  iocontrol early, so a changer can fetch the tool while the program
+  runs up to its T word.  Any other tool related message ends the
+  search, since it may depend on the tool state as it is now.
+*/
+static void emcTaskPrefetchTool(void)
+{
+    if (toolPrepareLookahead <= 0 ||
+	emcStatus->io.status != RCS_STATUS::DONE ||
+	emcStatus->io.tool.pocketPrepped != -1) {
+	return;
+    }
+
+    int n = interp_list.len();
+    if (n > toolPrepareLookahead) {
+	n = toolPrepareLookahead;
+    }
+    for (int i = 0; i < n; i++) {
+	NMLmsg *msg = interp_list.peek(i);
+	switch (msg->type) {
+	case EMC_TOOL_PREPARE_TYPE: {
+	    int tool = ((EMC_TOOL_PREPARE *) msg)->tool;
+	    if (tool != prefetchedTool) {
+		prefetchedTool = tool;
+		emcToolPrefetch(tool);
+	    }
+	    return;
+	}
+	case EMC_TOOL_LOAD_TYPE:
+	case EMC_TOOL_UNLOAD_TYPE:
+	case EMC_TOOL_START_CHANGE_TYPE:
+	case EMC_TOOL_SET_NUMBER_TYPE:
+	case EMC_TOOL_SET_OFFSET_TYPE:
+	case EMC_TOOL_LOAD_TOOL_TABLE_TYPE:
+	case EMC_EXEC_PLUGIN_CALL_TYPE:
+	case EMC_IO_PLUGIN_CALL_TYPE:
+	    return;
+	default:
+	    break;
+	}
+    }
+}
+
 // executor function
 static int emcTaskExecute(void)
 {
@@ -2606,6 +2782,7 @@ static int emcTaskExecute(void)
 	if (!emcStatus->motion.traj.queueFull &&
 	    emcStatus->task.interpState != EMC_TASK_INTERP::PAUSED) {
 	    if (0 == emcTaskCommand) {
+		emcTaskPrefetchTool();
 		// need a new command
 		emcTaskCommand = interp_list.get();
 		// interp_list now has line number associated with this-- get
@@ -2882,6 +3059,10 @@ static int emctask_startup()
     // // get our status data structure
     // emcStatus = new EMC_STAT;
 
+    // the channels and their buffers; the interpreter and Python
+    // started further down tag their own allocations
+    AllocTagScope alloc_tag(ALLOC_TAG_NML);
+
     // get the NML command buffer
     if (!(emc_debug & EMC_DEBUG_NML)) {
 	set_rcs_print_destination(RCS_PRINT_TO_NULL);	// inhibit diag
@@ -3212,6 +3393,15 @@ static int iniLoad(const char *filename)
 	// not found, use default
 	}
     }
+    if (NULL != (inistring = inifile.Find("TOOL_PREPARE_LOOKAHEAD", "EMCIO"))) {
+	if (1 != sscanf(inistring, "%d", &toolPrepareLookahead) ||
+	    toolPrepareLookahead < 0) {
+	    toolPrepareLookahead = 0;
+	    rcs_print("invalid [EMCIO] TOOL_PREPARE_LOOKAHEAD in %s (%s); disabled\n",
+		      filename, inistring);
+	}
+    }
+
     saveDouble = emc_task_cycle_time;
     EMC_TASK_CYCLE_TIME_ORIG = emc_task_cycle_time;
     emcTaskNoDelay = 0;
@@ -3267,6 +3457,16 @@ static int iniLoad(const char *filename)
 	max_mdi_queued_commands = atoi(inistring);
     }
 
+    // read on past probes and input waits
+    if (NULL != (inistring = inifile.Find("SPECULATE", "TASK"))) {
+	speculate = atoi(inistring) != 0;
+    }
+
+    // read the program on a thread of its own
+    if (NULL != (inistring = inifile.Find("READAHEAD_THREAD", "TASK"))) {
+	readaheadThread = atoi(inistring) != 0;
+    }
+
     // close it
     inifile.Close();
 
@@ -3303,6 +3503,9 @@ int main(int argc, char *argv[])
     signal(SIGFPE, backtrace);
     signal(SIGUSR1, backtrace);
 
+    // per-subsystem allocation accounting, SIGUSR2 prints it
+    emcTaskAllocInit();
+
     // set print destination to stdout, for console apps
     set_rcs_print_destination(RCS_PRINT_TO_STDOUT);
     // process command line args
@@ -3358,6 +3561,9 @@ int main(int argc, char *argv[])
 	emctask_shutdown();
 	exit(1);
     }
+    // Python is up by now, make sure its arenas are still counted
+    emcTaskAllocInit();
+    emcTaskReadaheadInit();
     // set the default startup modes
     emcMotionAbort();
     for (int s = 0; s < emcStatus->motion.traj.spindles; s++) emcSpindleAbort(s);
@@ -3385,11 +3591,19 @@ int main(int argc, char *argv[])
     if (0 != usrmotReadEmcmotConfig(&emcmotConfig)) {
         rcs_print("%s failed usrmotReadEmcmotconfig()\n",__FILE__);
     }
+    if (readaheadThread && 0 != emcTaskReadaheadStart()) {
+	rcs_print("task: can't start the read-ahead thread, reading in the plan\n");
+	readaheadThread = 0;
+    }
     while (!done) {
         static int gave_soft_limit_message = 0;
+	// the read-ahead thread only reads while this loop waits
+	emcTaskReadaheadLock();
         check_ini_hal_items(emcStatus->motion.traj.joints);
 	// read command
 	if (0 != emcCommandBuffer->read()) {
+	    cmdtrace_user(CMDTRACE_TASK_READ, emcCommand->serial_number, 0,
+			  emcCommand->type, 0, 0);
 	    // got a new command, so clear out errors
 	    taskPlanError = 0;
 	    taskExecuteError = 0;
@@ -3565,6 +3779,7 @@ int main(int argc, char *argv[])
 	// will be updated in the _update() functions above. There's
 	// no need to call the individual functions on all WM items.
 	emcStatusBuffer->write(emcStatus);
+	emcTaskReadaheadUnlock();
 
 	// wait on timer cycle, if specified, or calculate actual
 	// interval if INI file says to run full out via
@@ -3593,6 +3808,7 @@ int main(int argc, char *argv[])
 	}
     }
     // end of while (! done)
+    emcTaskReadaheadStop();
 
     rcs_print(
         "task: %u cycles, min=%.6f, max=%.6f, avg=%.6f, %u latency excursions (> %dx expected cycle time of %.6fs)\n",
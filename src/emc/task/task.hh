@@ -19,6 +19,7 @@
 extern NMLmsg *emcTaskCommand;
 extern int stepping;
 extern int steppingWait;
+extern int prefetchedTool;
 extern int emcTaskQueueCommand(NMLmsg *cmd);
 extern int emcPluginCall(EMC_EXEC_PLUGIN_CALL *call_msg);
 extern int emcIoPluginCall(EMC_IO_PLUGIN_CALL *call_msg);
@@ -30,6 +31,17 @@ int all_homed(void);
 bool jogging_is_active(void);
 
 int emcTaskInit();
+// allocation accounting, see taskalloc.cc
+int emcTaskAllocInit();
+int emcTaskAllocUpdate(EMC_TASK_STAT *stat);
+int emcTaskReadaheadInit(void);
+int emcTaskReadaheadStart(void);
+void emcTaskReadaheadStop(void);
+void emcTaskReadaheadLock(void);
+void emcTaskReadaheadUnlock(void);
+int emcTaskReadaheadUpdate(EMC_TASK_STAT *stat);
+void readahead_reading(int lines);
+int readahead_ready(void);
 int emcTaskHalt();
 int emcTaskStateRestore();
 int emcTaskAbort();
@@ -44,6 +56,11 @@ int emcTaskPlanSetOptionalStop(bool state);
 int emcTaskPlanSetBlockDelete(bool state);
 void emcTaskPlanExit();
 int emcTaskPlanOpen(const char *file);
+int emcTaskPlanRestoreCheckpoint(int line);
+int emcTaskPlanSpeculate();
+int emcTaskPlanIsSpeculating();
+int emcTaskPlanSpeculationBlocked();
+int emcTaskPlanResolveSpeculation();
 int emcTaskPlanRead();
 int emcTaskPlanExecute(const char *command);
 int emcTaskPlanExecute(const char *command, int line_number); //used in case of MDI to pass the pseudo line number to interp
@@ -0,0 +1,319 @@
+/********************************************************************
+* Description: taskalloc.cc
+*
+*   Allocation accounting for milltask.
+*
+*   When the environment variable LINUXCNC_TASK_ALLOC is set (the
+*   linuxcnc script sets it from [TASK]ALLOC_ACCOUNTING), every
+*   malloc() in the process gets a small header recording its size and
+*   the tag (alloc_tag.hh) of the thread that made it, and the bytes
+*   in use are counted per tag together with the peak of each.  C++
+*   new and the Python object allocator end up in malloc(), except for
+*   the pymalloc arenas which are counted through the arena hook.
+*
+*   The counters go to the task status (memCurrent, memPeak) and are
+*   printed when milltask gets SIGUSR2.  Without the variable the
+*   allocation functions go straight to the C library.
+*
+*   This replaces malloc the way the glibc manual describes: all of
+*   malloc, free, calloc, realloc, aligned_alloc, malloc_usable_size,
+*   memalign, posix_memalign, pvalloc and valloc are provided, on top
+*   of the __libc_ entry points.
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+*
+********************************************************************/
+
+#include <Python.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "rcs_print.hh"
+#include "emc_nml.hh"
+#include "alloc_tag.hh"
+#include "task.hh"
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *p, size_t size);
+void *__libc_memalign(size_t align, size_t size);
+void __libc_free(void *p);
+}
+
+#define ALLOC_MAGIC 0x7a6c0000u
+#define ALLOC_HEADER 16
+
+// sits right before each block handed out
+struct alloc_header {
+    uint32_t tag;       // ALLOC_MAGIC | tag
+    uint32_t skip;      // bytes from the start of the real block
+    uint64_t size;      // bytes asked for
+};
+
+static int accounting = -1;     // decided on the first allocation
+static __thread int current_tag;
+static int64_t in_use[ALLOC_TAGS];
+static int64_t peak[ALLOC_TAGS];
+static volatile sig_atomic_t dump_requested;
+
+static inline bool enabled()
+{
+    if (__builtin_expect(accounting < 0, 0)) {
+        const char *s = getenv("LINUXCNC_TASK_ALLOC");
+        accounting = (s && *s && strcmp(s, "0")) ? 1 : 0;
+    }
+    return accounting;
+}
+
+static inline void charge(int tag, int64_t bytes)
+{
+    int64_t now = __atomic_add_fetch(&in_use[tag], bytes, __ATOMIC_RELAXED);
+    int64_t p = __atomic_load_n(&peak[tag], __ATOMIC_RELAXED);
+    while (now > p &&
+           !__atomic_compare_exchange_n(&peak[tag], &p, now, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static inline alloc_header *header_of(void *p)
+{
+    return (alloc_header *) ((char *) p - ALLOC_HEADER);
+}
+
+static inline void *finish(void *base, size_t skip, size_t size)
+{
+    if (!base) {
+        return NULL;
+    }
+    void *p = (char *) base + skip;
+    alloc_header *h = header_of(p);
+    int tag = current_tag;
+    h->tag = ALLOC_MAGIC | tag;
+    h->skip = skip;
+    h->size = size;
+    charge(tag, size);
+    return p;
+}
+
+static void *aligned(size_t align, size_t size)
+{
+    if (align <= ALLOC_HEADER) {
+        return malloc(size);
+    }
+    if (size > SIZE_MAX - align) {
+        return NULL;
+    }
+    // the header goes into the first alignment unit
+    return finish(__libc_memalign(align, size + align), align, size);
+}
+
+extern "C" {
+
+int alloc_tag_set(int tag)
+{
+    int prev = current_tag;
+    current_tag = (tag >= 0 && tag < ALLOC_TAGS) ? tag : ALLOC_TAG_OTHER;
+    return prev;
+}
+
+void *malloc(size_t size)
+{
+    if (!enabled()) {
+        return __libc_malloc(size);
+    }
+    if (size > SIZE_MAX - ALLOC_HEADER) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return finish(__libc_malloc(size + ALLOC_HEADER), ALLOC_HEADER, size);
+}
+
+void free(void *p)
+{
+    if (!enabled() || !p) {
+        __libc_free(p);
+        return;
+    }
+    alloc_header *h = header_of(p);
+    charge(h->tag & 0xffff, -(int64_t) h->size);
+    __libc_free((char *) p - h->skip);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    if (!enabled()) {
+        return __libc_calloc(n, size);
+    }
+    if (size && n > (SIZE_MAX - ALLOC_HEADER) / size) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return finish(__libc_calloc(1, n * size + ALLOC_HEADER), ALLOC_HEADER, n * size);
+}
+
+void *realloc(void *p, size_t size)
+{
+    if (!enabled()) {
+        return __libc_realloc(p, size);
+    }
+    if (!p) {
+        return malloc(size);
+    }
+    if (!size) {
+        free(p);
+        return NULL;
+    }
+    alloc_header *h = header_of(p);
+    if (h->skip != ALLOC_HEADER) {
+        // aligned blocks are not moved by the C library, copy by hand
+        void *n = malloc(size);
+        if (n) {
+            memcpy(n, p, h->size < size ? h->size : size);
+            free(p);
+        }
+        return n;
+    }
+    if (size > SIZE_MAX - ALLOC_HEADER) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    // the block stays charged to whoever allocated it
+    int tag = h->tag & 0xffff;
+    int64_t old = h->size;
+    void *base = __libc_realloc((char *) p - ALLOC_HEADER, size + ALLOC_HEADER);
+    if (!base) {
+        return NULL;
+    }
+    h = (alloc_header *) base;
+    h->size = size;
+    charge(tag, (int64_t) size - old);
+    return (char *) base + ALLOC_HEADER;
+}
+
+void *memalign(size_t align, size_t size)
+{
+    if (!enabled()) {
+        return __libc_memalign(align, size);
+    }
+    return aligned(align, size);
+}
+
+void *aligned_alloc(size_t align, size_t size)
+{
+    return memalign(align, size);
+}
+
+int posix_memalign(void **pp, size_t align, size_t size)
+{
+    if (align < sizeof(void *) || (align & (align - 1))) {
+        return EINVAL;
+    }
+    void *p = memalign(align, size);
+    if (!p) {
+        return ENOMEM;
+    }
+    *pp = p;
+    return 0;
+}
+
+void *valloc(size_t size)
+{
+    return memalign(sysconf(_SC_PAGESIZE), size);
+}
+
+void *pvalloc(size_t size)
+{
+    size_t page = sysconf(_SC_PAGESIZE);
+    return memalign(page, (size + page - 1) & ~(page - 1));
+}
+
+size_t malloc_usable_size(void *p)
+{
+    if (!p) {
+        return 0;
+    }
+    if (!enabled()) {
+        static size_t (*libc_usable_size)(void *);
+        if (!libc_usable_size) {
+            libc_usable_size = (size_t (*)(void *)) dlsym(RTLD_NEXT, "malloc_usable_size");
+        }
+        return libc_usable_size ? libc_usable_size(p) : 0;
+    }
+    return header_of(p)->size;
+}
+
+}
+
+// the pymalloc arenas are mapped directly, not through malloc()
+static PyObjectArenaAllocator python_arenas;
+
+static void *arena_alloc(void *ctx, size_t size)
+{
+    void *p = python_arenas.alloc(python_arenas.ctx, size);
+    if (p) {
+        charge(ALLOC_TAG_PYTHON, size);
+    }
+    return p;
+}
+
+static void arena_free(void *ctx, void *p, size_t size)
+{
+    if (p) {
+        charge(ALLOC_TAG_PYTHON, -(int64_t) size);
+    }
+    python_arenas.free(python_arenas.ctx, p, size);
+}
+
+static void request_dump(int)
+{
+    dump_requested = 1;
+}
+
+/* Called at startup and again once the interpreter (and with it Python)
+   is up, in case initializing Python put its own arena hooks back. */
+int emcTaskAllocInit()
+{
+    if (!enabled()) {
+        return 0;
+    }
+    PyObjectArenaAllocator a;
+    PyObject_GetArenaAllocator(&a);
+    if (a.alloc != arena_alloc) {
+        python_arenas = a;
+        a.ctx = NULL;
+        a.alloc = arena_alloc;
+        a.free = arena_free;
+        PyObject_SetArenaAllocator(&a);
+    }
+    signal(SIGUSR2, request_dump);
+    return 0;
+}
+
+int emcTaskAllocUpdate(EMC_TASK_STAT *stat)
+{
+    if (!enabled()) {
+        return 0;
+    }
+    for (int i = 0; i < ALLOC_TAGS; i++) {
+        stat->memCurrent[i] = __atomic_load_n(&in_use[i], __ATOMIC_RELAXED);
+        stat->memPeak[i] = __atomic_load_n(&peak[i], __ATOMIC_RELAXED);
+    }
+    if (dump_requested) {
+        dump_requested = 0;
+        rcs_print("milltask allocations (bytes in use / peak):\n");
+        for (int i = 0; i < ALLOC_TAGS; i++) {
+            rcs_print("  %-12s %14.0f %14.0f\n", alloc_tag_name(i),
+                      stat->memCurrent[i], stat->memPeak[i]);
+        }
+    }
+    return 0;
+}
@@ -33,6 +33,7 @@
 
 #include "python_plugin.hh"
 #include "taskclass.hh"
+#include "task.hh"		// prefetchedTool
 #include <rtapi_string.h>
 
 #define BOOST_PYTHON_MAX_ARITY 4
@@ -276,7 +277,10 @@ int emcIoHalt() {
 }
 
 
-int emcIoAbort(int reason) { return task_methods->emcIoAbort(reason); }
+int emcIoAbort(int reason) {
+    prefetchedTool = -1;
+    return task_methods->emcIoAbort(reason);
+}
 int emcIoSetDebug(int debug) { return task_methods->emcIoSetDebug(debug); }
 int emcAuxEstopOn()  { return task_methods->emcAuxEstopOn(); }
 int emcAuxEstopOff() { return task_methods->emcAuxEstopOff(); }
@@ -287,6 +291,7 @@ int emcCoolantFloodOff() { return task_methods->emcCoolantFloodOff(); }
 int emcLubeOn() { return task_methods->emcLubeOn(); }
 int emcLubeOff() { return task_methods->emcLubeOff(); }
 int emcToolPrepare(int tool) { return task_methods->emcToolPrepare(tool); }
+int emcToolPrefetch(int tool) { return task_methods->emcToolPrefetch(tool); }
 int emcToolStartChange() { return task_methods->emcToolStartChange(); }
 int emcToolLoad() { return task_methods->emcToolLoad(); }
 int emcToolUnload()  { return task_methods->emcToolUnload(); }
@@ -679,6 +684,20 @@ int Task::emcToolPrepare(int tool)
     return 0;
 }
 
+// start preparing a tool whose T word is still queued behind an M6;
+// iocontrol acknowledges at once and the T word later only waits for
+// whatever is left of the handshake
+int Task::emcToolPrefetch(int tool)
+{
+    EMC_TOOL_PREPARE toolPrepareMsg;
+
+    toolPrepareMsg.tool = tool;
+    toolPrepareMsg.prefetch = 1;
+    sendCommand(&toolPrepareMsg);
+
+    return 0;
+}
+
 
 int Task::emcToolStartChange()
 {
@@ -42,6 +42,7 @@ public:
     virtual int emcToolSetOffset(int pocket, int toolno, EmcPose offset, double diameter,
 				 double frontangle, double backangle, int orientation);
     virtual int emcToolPrepare(int tool);
+    virtual int emcToolPrefetch(int tool);
     virtual int emcToolLoad();
     virtual int emcToolLoadToolTable(const char *file);
     virtual int emcToolUnload();
@@ -522,6 +522,29 @@ int emcAxisSetMaxAcceleration(int axis, double acc,double ext_offset_acc)
     return retval;
 }
 
+int emcAxisSetMaxJerk(int axis, double jerk)
+{
+    CATCH_NAN(std::isnan(jerk));
+
+    if (axis < 0 || axis >= EMCMOT_MAX_AXIS || !(TrajConfig.AxisMask & (1 << axis))) {
+	return 0;
+    }
+
+    if (jerk < 0.0) {
+	jerk = 0.0;
+    }
+
+    emcmotCommand.command = EMCMOT_SET_AXIS_JERK_LIMIT;
+    emcmotCommand.axis = axis;
+    emcmotCommand.jerk = jerk;
+    int retval = usrmotWriteEmcmotCommand(&emcmotCommand);
+
+    if (emc_debug & EMC_DEBUG_CONFIG) {
+        rcs_print("%s(%d, %.4g) returned %d\n", __FUNCTION__, axis, jerk, retval);
+    }
+    return retval;
+}
+
 int emcAxisSetLockingJoint(int axis, int joint)
 {
 
@@ -1165,6 +1188,23 @@ int emcTrajSetMaxAcceleration(double acc)
     return 0;
 }
 
+int emcTrajSetMaxJerk(double jerk)
+{
+    if (jerk < 0.0) {
+	jerk = 0.0;
+    }
+
+    emcmotCommand.command = EMCMOT_SET_JERK;
+    emcmotCommand.jerk = jerk;
+
+    int retval = usrmotWriteEmcmotCommand(&emcmotCommand);
+
+    if (emc_debug & EMC_DEBUG_CONFIG) {
+        rcs_print("%s(%.4g) returned %d\n", __FUNCTION__, jerk, retval);
+    }
+    return retval;
+}
+
 int emcTrajSetHome(EmcPose home)
 {
 #ifdef ISNAN_TRAP
@@ -1571,6 +1611,7 @@ int emcTrajUpdate(EMC_TRAJ_STAT * stat)
 
     stat->inpos = emcmotStatus.motionFlag & EMCMOT_MOTION_INPOS_BIT;
     stat->queue = emcmotStatus.depth;
+    stat->queueTime = emcmotStatus.queueTime;
     stat->activeQueue = emcmotStatus.activeDepth;
     stat->queueFull = emcmotStatus.queueFull;
     stat->id = emcmotStatus.id;
@@ -2115,6 +2156,17 @@ int emcSetMaxFeedOverride(double maxFeedScale) {
     return usrmotWriteEmcmotCommand(&emcmotCommand);
 }
 
+int emcSetJointLimitSamples(int samples) {
+    emcmotCommand.command = EMCMOT_SET_JOINT_LIMIT_SAMPLES;
+    if (samples > EMCMOT_MAX_JOINT_LIMIT_SAMPLES) {
+        rcs_print("JOINT_LIMIT_SAMPLES %d limited to %d\n",
+                  samples, EMCMOT_MAX_JOINT_LIMIT_SAMPLES);
+        samples = EMCMOT_MAX_JOINT_LIMIT_SAMPLES;
+    }
+    emcmotCommand.jointLimitSamples = samples < 0 ? 0 : samples;
+    return usrmotWriteEmcmotCommand(&emcmotCommand);
+}
+
 int emcSetProbeErrorInhibit(int j_inhibit, int h_inhibit) {
     emcmotCommand.command = EMCMOT_SET_PROBE_ERR_INHIBIT;
     emcmotCommand.probe_jog_err_inhibit = j_inhibit;
@@ -122,6 +122,7 @@ struct TaskWrap : public Task, public bp::wrapper<Task> {
     EXPAND1(emcIoSetDebug,int,debug)
 
     EXPAND1(emcToolPrepare, int, tool)
+    EXPAND1(emcToolPrefetch, int, tool)
     EXPAND(emcToolLoad)
     EXPAND1(emcToolLoadToolTable, const char *, file)
     EXPAND(emcToolUnload)
@@ -0,0 +1,235 @@
+/********************************************************************
+* Description: taskreadahead.cc
+*
+*   Reading the program on a thread of its own, and how far reading is
+*   ahead of the machine.
+*
+*   With [TASK]READAHEAD_THREAD the interpreter no longer reads only
+*   when the plan gets to it once per task cycle: a thread reads line
+*   after line into interp_list for as long as there is room, while the
+*   main loop sends what is queued to motion and handles commands.  The
+*   interpreter, canon and the task status are shared with everything
+*   else task does (synch, MDI, abort), so the two take turns: the main
+*   loop holds the plan lock for a whole cycle and lets go of it only
+*   while it waits for the next one, which is when the thread reads.
+*   Whoever holds the lock also holds the Python GIL, which the main
+*   thread otherwise releases, since remaps may run Python on either.
+*
+*   interp_list estimates each motion as it is queued, see
+*   readahead_estimate(); together with motion's queue this gives the
+*   readaheadSegments and readaheadTime of the task status.
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+*
+********************************************************************/
+
+#include <Python.h>
+#include <math.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+#include "rcs_print.hh"
+#include "emc.hh"
+#include "emc_nml.hh"
+#include "emcglb.h"
+#include "interpl.hh"
+#include "posemath.h"
+#include "task.hh"
+
+// how long the thread sleeps when nobody tells it there is more to do
+#define READAHEAD_POLL std::chrono::milliseconds(10)
+
+static std::mutex plan_mutex;
+static std::condition_variable plan_cond;
+static std::thread reader;
+static std::atomic<bool> quitting(false);
+static std::atomic<bool> main_waiting(false);
+static bool threaded = false;
+// the main thread's Python state while it does not hold the GIL
+static PyThreadState *main_python = NULL;
+static thread_local PyGILState_STATE gil;
+
+static void read_ahead(void)
+{
+    std::unique_lock<std::mutex> lock(plan_mutex);
+
+    while (!quitting) {
+	plan_cond.wait_for(lock, READAHEAD_POLL, [] {
+	    return quitting || (!main_waiting && readahead_ready());
+	});
+	if (quitting || main_waiting || !readahead_ready()) {
+	    continue;
+	}
+	if (main_python) {
+	    gil = PyGILState_Ensure();
+	}
+	readahead_reading(1);
+	if (main_python) {
+	    PyGILState_Release(gil);
+	}
+    }
+}
+
+int emcTaskReadaheadStart(void)
+{
+    if (Py_IsInitialized()) {
+	main_python = PyEval_SaveThread();
+    }
+    quitting = false;
+    try {
+	reader = std::thread(read_ahead);
+    } catch (std::system_error &e) {
+	rcs_print_error("emcTaskReadaheadStart: %s\n", e.what());
+	if (main_python) {
+	    PyEval_RestoreThread(main_python);
+	    main_python = NULL;
+	}
+	return -1;
+    }
+    threaded = true;
+    return 0;
+}
+
+void emcTaskReadaheadStop(void)
+{
+    if (!threaded) {
+	return;
+    }
+    quitting = true;
+    plan_cond.notify_one();
+    reader.join();
+    threaded = false;
+    if (main_python) {
+	PyEval_RestoreThread(main_python);
+	main_python = NULL;
+    }
+}
+
+void emcTaskReadaheadLock(void)
+{
+    if (!threaded) {
+	return;
+    }
+    main_waiting = true;
+    plan_mutex.lock();
+    main_waiting = false;
+    if (main_python) {
+	gil = PyGILState_Ensure();
+    }
+}
+
+void emcTaskReadaheadUnlock(void)
+{
+    if (!threaded) {
+	return;
+    }
+    if (main_python) {
+	PyGILState_Release(gil);
+    }
+    plan_mutex.unlock();
+    plan_cond.notify_one();
+    // with CYCLE_TIME <= 0 the main loop would take the lock right back
+    std::this_thread::yield();
+}
+
+// where the last motion queued ends, to measure the next one from
+static EmcPose last_end;
+
+static double distance(const EmcPose &from, const EmcPose &to)
+{
+    double d = hypot(hypot(to.tran.x - from.tran.x, to.tran.y - from.tran.y),
+		     to.tran.z - from.tran.z);
+    if (d > 1e-9) {
+	return d;
+    }
+    d = hypot(hypot(to.u - from.u, to.v - from.v), to.w - from.w);
+    if (d > 1e-9) {
+	return d;
+    }
+    return hypot(hypot(to.a - from.a, to.b - from.b), to.c - from.c);
+}
+
+static double arc_length(const EmcPose &from, const EMC_TRAJ_CIRCULAR_MOVE *move)
+{
+    PmCircle circle;
+    PmCartesian end = move->end.tran;
+    PmCartesian center = {move->center.x, move->center.y, move->center.z};
+    PmCartesian normal = {move->normal.x, move->normal.y, move->normal.z};
+    double helix;
+
+    if (pmCircleInit(&circle, &from.tran, &end, &center, &normal, move->turn) != 0) {
+	return distance(from, move->end);
+    }
+    pmCartMag(&circle.rHelix, &helix);
+    return hypot(circle.angle * circle.radius, helix);
+}
+
+/* The time of a motion at its requested velocity, as the planner will
+   see it; blends, accelerations and overrides are left out. */
+static bool readahead_estimate(NMLmsg *msg, double *time)
+{
+    if (interp_list.motions() == 0 && emcStatus->motion.traj.queue == 0) {
+	// nothing ahead, the next motion starts where the machine is
+	last_end = emcStatus->motion.traj.position;
+    }
+
+    double length, vel;
+    EmcPose end;
+    switch (msg->type) {
+    case EMC_TRAJ_LINEAR_MOVE_TYPE: {
+	EMC_TRAJ_LINEAR_MOVE *move = (EMC_TRAJ_LINEAR_MOVE *) msg;
+	length = distance(last_end, move->end);
+	vel = move->vel;
+	end = move->end;
+	break;
+    }
+    case EMC_TRAJ_CIRCULAR_MOVE_TYPE: {
+	EMC_TRAJ_CIRCULAR_MOVE *move = (EMC_TRAJ_CIRCULAR_MOVE *) msg;
+	length = arc_length(last_end, move);
+	vel = move->vel;
+	end = move->end;
+	break;
+    }
+    case EMC_TRAJ_PROBE_TYPE: {
+	EMC_TRAJ_PROBE *move = (EMC_TRAJ_PROBE *) msg;
+	length = distance(last_end, move->pos);
+	vel = move->vel;
+	end = move->pos;
+	break;
+    }
+    case EMC_TRAJ_RIGID_TAP_TYPE: {
+	// in and back out, ending where it started
+	EMC_TRAJ_RIGID_TAP *move = (EMC_TRAJ_RIGID_TAP *) msg;
+	length = 2 * distance(last_end, move->pos);
+	vel = move->vel;
+	end = last_end;
+	break;
+    }
+    default:
+	return false;
+    }
+
+    *time = vel > 0.0 ? length / vel : 0.0;
+    last_end = end;
+    return true;
+}
+
+int emcTaskReadaheadInit(void)
+{
+    interp_list.set_estimator(readahead_estimate);
+    return 0;
+}
+
+int emcTaskReadaheadUpdate(EMC_TASK_STAT *stat)
+{
+    stat->readaheadSegments = interp_list.motions() + emcStatus->motion.traj.queue;
+    stat->readaheadTime = interp_list.time() + emcStatus->motion.traj.queueTime;
+    return 0;
+}
@@ -225,13 +225,14 @@ void tooldata_last_index_set(int idx)  //force last_index
 
 int tooldata_last_index_get(void)
 {
+    // without a table there is no mutex to take either, as in a
+    // preview parse while linuxcnc is not running
+    if (!tool_mmap_base) {
+        return -1;
+    }
     tool_mmap_mutex_get();
     tooldata_header_t *hptr = HPTR();
-    if (tool_mmap_base) {
-        tool_mmap_mutex_give(); return hptr->last_index;
-    } else {
-        tool_mmap_mutex_give(); return -1;
-    }
+    tool_mmap_mutex_give(); return hptr->last_index;
 } // tooldata_last_index_get()
 
 toolidx_t tooldata_put(struct CANON_TOOL_TABLE tdata,int idx)
@@ -1858,3 +1858,77 @@ double pmCircleEffectiveMinRadius(PmCircle const * circle)
     return effective_radius;
 }
 
+
+/** Advance velocity, acceleration and distance by t at constant jerk j. */
+static inline void jerkPhase(double * const v, double * const a, double * const d,
+        double j, double t)
+{
+    if (t <= 0.0) {
+        return;
+    }
+    *d += *v * t + *a * t * t / 2.0 + j * t * t * t / 6.0;
+    *v += *a * t + j * t * t / 2.0;
+    *a += j * t;
+}
+
+
+/**
+ * Find the distance needed to slow from v_0 to v_f with jerk-limited
+ * deceleration.
+ * The profile starts at acceleration a_0, and ends with zero acceleration
+ * once v_f is reached (or undershot, if a_0 is already braking harder than
+ * needed). Acceleration stays within a_max, and changes at j_max.
+ */
+double findJerkStopDistance(double v_0, double a_0, double v_f,
+        double a_max, double j_max)
+{
+    double v = v_0;
+    double a = bisaturate(a_0, a_max, -a_max);
+    double d = 0.0;
+
+    // Stop accelerating first
+    if (a > 0.0) {
+        jerkPhase(&v, &a, &d, -j_max, a / j_max);
+        a = 0.0;
+    }
+
+    double dv = v - v_f;
+    // Velocity lost just bringing the acceleration back to zero
+    if (dv <= a * a / (2.0 * j_max)) {
+        jerkPhase(&v, &a, &d, j_max, -a / j_max);
+        return d;
+    }
+
+    // Peak deceleration of a profile without a constant acceleration phase
+    double a_peak = pmSqrt(j_max * dv + a * a / 2.0);
+    if (a_peak <= a_max) {
+        jerkPhase(&v, &a, &d, -j_max, (a_peak + a) / j_max);
+        jerkPhase(&v, &a, &d, j_max, a_peak / j_max);
+    } else {
+        double dv_ramps = (a_max * a_max - a * a) / (2.0 * j_max) +
+            a_max * a_max / (2.0 * j_max);
+        jerkPhase(&v, &a, &d, -j_max, (a_max + a) / j_max);
+        jerkPhase(&v, &a, &d, 0.0, (dv - dv_ramps) / a_max);
+        jerkPhase(&v, &a, &d, j_max, a_max / j_max);
+    }
+    return d;
+}
+
+
+/**
+ * Find the highest velocity from which a jerk-limited stop (starting and
+ * ending at zero acceleration) fits in the given distance.
+ */
+double findJerkStopVel(double a_max, double j_max, double distance)
+{
+    if (distance <= 0.0) {
+        return 0.0;
+    }
+    // Without a constant acceleration phase, d = v * sqrt(v / j)
+    if (distance <= a_max * a_max * a_max / (j_max * j_max)) {
+        return pow(distance * distance * j_max, 1.0 / 3.0);
+    }
+    // Otherwise d = v^2 / (2 a) + v a / (2 j)
+    double b = a_max / (2.0 * j_max);
+    return a_max * (pmSqrt(b * b + 2.0 * distance / a_max) - b);
+}
@@ -263,4 +263,8 @@ static inline double findVPeak(double a_t_max, double distance)
 {
     return pmSqrt(a_t_max * distance);
 }
+
+double findJerkStopDistance(double v_0, double a_0, double v_f,
+        double a_max, double j_max);
+double findJerkStopVel(double a_max, double j_max, double distance);
 #endif
@@ -220,7 +220,7 @@ int tcCanConsume(TC_STRUCT const * const tc)
         return false;
     }
 
-    if (tc->syncdio.anychanged || tc->blend_prev || tc->atspeed) {
+    if (tc->syncdio || tc->blend_prev || tc->atspeed) {
         //TODO add other conditions here (for any segment that should not be consumed by blending
         return false;
     }
@@ -97,7 +97,8 @@ typedef enum {
 typedef unsigned long long iomask_t; // 64 bits on both x86 and x86_64
 
 typedef struct {
-    char anychanged;
+    char anychanged;        // something to write; in a queue's pool this
+                            // also means the entry is taken
     iomask_t dio_mask;
     iomask_t aio_mask;
     signed char dios[EMCMOT_MAX_DIO];
@@ -116,12 +117,18 @@ typedef struct {
     RIGIDTAP_STATE state;
 } PmRigidTap;
 
+/* Segments are laid out so that what tpRunCycle touches every servo
+ * cycle comes first: the motion state and limits, the flags and then the
+ * geometry.  Planning-time and bookkeeping data follows, and the synched
+ * IO, which few segments carry, lives in a pool of the queue
+ * (see tcq.h). */
+#define TC_CACHE_LINE 64
+
 typedef struct {
-    double cycle_time;
     //Position stuff
+    double cycle_time;
     double target;          // actual segment length
     double progress;        // where are we in the segment?  0..target
-    double nominal_length;
 
     //Velocity
     double reqvel;          // vel requested by F word, calc'd by task
@@ -129,59 +136,68 @@ typedef struct {
     double maxvel;          // max possible vel (feed override stops here)
     double currentvel;      // keep track of current step (vel * cycle_time)
     double finalvel;        // velocity to aim for at end of segment
+    /* second cache line */
     double term_vel;        // actual velocity at termination of segment
     double kink_vel;        // Temporary way to store our calculation of maximum velocity we can handle if this segment is declared tangent with the next
-    double kink_accel_reduce_prev; // How much to reduce the allowed tangential acceleration to account for the extra acceleration at an approximate tangent intersection.
-    double kink_accel_reduce; // How much to reduce the allowed tangential acceleration to account for the extra acceleration at an approximate tangent intersection.
 
     //Acceleration
     double maxaccel;        // accel calc'd by task
     double acc_ratio_tan;// ratio between normal and tangential accel
-    
-    int id;                 // segment's serial number
-    struct state_tag_t tag; // state tag corresponding to running motion
+    double currentacc;      // tangential accel of the last cycle
 
-    union {                 // describes the segment's start and end positions
-        PmLine9 line;
-        PmCircle9 circle;
-        PmRigidTap rigidtap;
-        Arc9 arc;
-    } coords;
+    //Jerk
+    double maxjerk;         // jerk limit along the path, 0 = not limited
 
+    double blend_vel;       // velocity below which we should start blending
+    double uu_per_rev;      // for sync, user units per rev (e.g. 0.0625 for 16tpi)
+    /* third cache line */
     int motion_type;       // TC_LINEAR (coords.line) or
                             // TC_CIRCULAR (coords.circle) or
                             // TC_RIGIDTAP (coords.rigidtap)
-    int active;            // this motion is being executed
-    int canon_motion_type;  // this motion is due to which canon function?
     int term_cond;          // gcode requests continuous feed at the end of
                             // this segment (g64 mode)
+    int synchronized;       // spindle sync state
+    unsigned char active;   // this motion is being executed
+    unsigned char blending_next; // segment is being blended into following segment
+    unsigned char sync_accel; // we're accelerating up to sync with the spindle
+    unsigned char enables;  // Feed scale, etc, enable bits for this move
+    unsigned char atspeed;  // wait for the spindle to be at-speed before starting this move
+    unsigned char on_final_decel;
+    unsigned char blend_prev;
+    unsigned char accel_mode;
+    unsigned char splitting; // the segment is less than 1 cycle time
+                            // away from the end.
+    unsigned char remove;   // Flag to remove the segment from the queue
+    unsigned char finalized;
 
-    int blending_next;      // segment is being blended into following segment
-    double blend_vel;       // velocity below which we should start blending
+    // Temporary status flags (reset each cycle)
+    unsigned char is_blending;
+
+    union {                 // describes the segment's start and end positions
+        PmLine9 line;
+        PmCircle9 circle;
+        PmRigidTap rigidtap;
+        Arc9 arc;
+    } coords;
+
+    /* used while planning, or for status only */
+    double nominal_length;
+    double kink_accel_reduce_prev; // How much to reduce the allowed tangential acceleration to account for the extra acceleration at an approximate tangent intersection.
+    double kink_accel_reduce; // How much to reduce the allowed tangential acceleration to account for the extra acceleration at an approximate tangent intersection.
     double tolerance;       // during the blend at the end of this move,
                             // stay within this distance from the path.
-    int synchronized;       // spindle sync state
-    double uu_per_rev;      // for sync, user units per rev (e.g. 0.0625 for 16tpi)
     double vel_at_blend_start;
-    int sync_accel;         // we're accelerating up to sync with the spindle
-    unsigned char enables;  // Feed scale, etc, enable bits for this move
-    int atspeed;           // wait for the spindle to be at-speed before starting this move
-    syncdio_t syncdio;      // synched DIO's for this move. what to turn on/off
+    double queue_time;      // target / reqvel when queued, see tcqTime()
+    syncdio_t *syncdio;     // synched DIO's for this move. what to turn on/off,
+                            // NULL if there are none
+    int id;                 // segment's serial number
+    int canon_motion_type;  // this motion is due to which canon function?
     int indexer_jnum;  // which joint to unlock (for a locking indexer) to make this move, -1 for none
     int optimization_state;             // At peak velocity during blends)
-    int on_final_decel;
-    int blend_prev;
-    int accel_mode;
-    int splitting;          // the segment is less than 1 cycle time
-                            // away from the end.
-    int remove;             // Flag to remove the segment from the queue
     int active_depth;       /* Active depth (i.e. how many segments
                             * after this will it take to slow to zero
                             * speed) */
-    int finalized;
-
-    // Temporary status flags (reset each cycle)
-    int is_blending;
-} TC_STRUCT;
+    struct state_tag_t tag; // state tag corresponding to running motion
+} __attribute__((aligned(TC_CACHE_LINE))) TC_STRUCT;
 
 #endif				/* TC_TYPES_H */
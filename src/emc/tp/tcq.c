@@ -20,6 +20,13 @@
 #include "tcq.h"
 #include <stddef.h>
 
+/*!
+ * \def TCQ_DIO_MARGIN
+ * free synched IO entries kept back like TC_QUEUE_MARGIN below
+ */
+#define TCQ_DIO_MARGIN 20
+#define TCQ_DIO_MIN (2 * TCQ_DIO_MARGIN)
+
 /** Return 0 if queue is valid, -1 if not */
 static inline int tcqCheck(TC_QUEUE_STRUCT const * const tcq)
 {
@@ -39,30 +46,48 @@ static inline int tcqCheck(TC_QUEUE_STRUCT const * const tcq)
  *
  * @param    tcq       pointer to the new TC_QUEUE_STRUCT
  * @param	 _size	   size of the new queue
- * @param	 tcSpace   holds the space allocated for the new queue, allocated in motion.c
+ * @param	 tcSpace   holds the space allocated for the new queue, allocated in tpCreate()
+ * @param	 _dioSize  entries in dioSpace, see tcqDioSize()
+ * @param	 dioSpace  pool for the synched IO of the queued elements
  *
  * @return	 int	   returns success or failure
  */
-int tcqCreate(TC_QUEUE_STRUCT * const tcq, int _size, TC_STRUCT * const tcSpace)
+int tcqCreate(TC_QUEUE_STRUCT * const tcq, int _size, TC_STRUCT * const tcSpace,
+        int _dioSize, syncdio_t * const dioSpace)
 {
-    if (!tcq || !tcSpace || _size < 1) {
+    if (!tcq || !tcSpace || _size < 1 || !dioSpace || _dioSize < TCQ_DIO_MIN) {
         return -1;
     }
 	tcq->queue = tcSpace;
 	tcq->size = _size;
+    tcq->dio = dioSpace;
+    tcq->dioSize = _dioSize;
     tcqInit(tcq);
 
 	return 0;
 }
 
+/*! tcqDioSize() function
+ *
+ * \brief number of synched IO entries for a queue of _size
+ *
+ * Few moves carry synched IO, so the pool is a quarter of the queue.
+ * A program with M62-M65 on every move gets a shorter look-ahead, as
+ * tcqFull() reports full when the pool runs low.
+ */
+int tcqDioSize(int _size)
+{
+    int n = _size / 4;
+    return n < TCQ_DIO_MIN ? TCQ_DIO_MIN : n;
+}
+
 /*! tcqDelete() function
  *
  * \brief Deletes a queue holding TC elements.
  *
- * This function creates deletes a queue. It doesn't free the space
- * only throws the pointer away.
+ * This function deletes a queue. It doesn't free the space
+ * only throws the pointers away.
  * It gets called by tpDelete()
- * \todo FIXME, it seems tpDelete() is gone, and this function isn't used.
  *
  * @param    tcq       pointer to the TC_QUEUE_STRUCT
  *
@@ -73,6 +98,8 @@ int tcqDelete(TC_QUEUE_STRUCT * const tcq)
     if (!tcqCheck(tcq)) {
         /* free(tcq->queue); */
         tcq->queue = 0;
+        tcq->dio = 0;
+        tcq->dioSize = 0;
     }
 
     return 0;
@@ -99,10 +126,58 @@ int tcqInit(TC_QUEUE_STRUCT * const tcq)
     tcq->rend = 0;
     tcq->_rlen = 0;
     tcq->allFull = 0;
+    tcq->time = 0.0;
+
+    int i;
+    for (i = 0; i < tcq->dioSize; i++) {
+        tcq->dio[i].anychanged = 0;
+    }
+    tcq->dioUsed = 0;
+    tcq->dioNext = 0;
 
     return 0;
 }
 
+/** Take a free entry from the synched IO pool, NULL if there is none */
+static syncdio_t *tcqAllocDio(TC_QUEUE_STRUCT * const tcq)
+{
+    int i;
+    if (tcq->dioUsed >= tcq->dioSize) {
+        return NULL;
+    }
+    for (i = 0; i < tcq->dioSize; i++) {
+        syncdio_t *d = &tcq->dio[tcq->dioNext];
+        tcq->dioNext = (tcq->dioNext + 1) % tcq->dioSize;
+        if (!d->anychanged) {
+            tcq->dioUsed++;
+            return d;
+        }
+    }
+    return NULL;
+}
+
+/*! tcqReleaseDio() function
+ *
+ * \brief gives the synched IO of a tc back to the pool
+ *
+ * Called once the outputs have been written, and for tcs taken off
+ * the queue before that.
+ *
+ * @param    tcq       pointer to the TC_QUEUE_STRUCT
+ * @param	 tc        element owning the entry, may have none
+ */
+void tcqReleaseDio(TC_QUEUE_STRUCT * const tcq, TC_STRUCT * const tc)
+{
+    if (!tc || !tc->syncdio) {
+        return;
+    }
+    tc->syncdio->anychanged = 0;
+    tc->syncdio = NULL;
+    if (tcq && tcq->dioUsed > 0) {
+        tcq->dioUsed--;
+    }
+}
+
 /*! tcqPut() function
  *
  * \brief puts a TC element at the end of the queue
@@ -125,8 +200,20 @@ int tcqPut(TC_QUEUE_STRUCT * const tcq, TC_STRUCT const * const tc)
 	    return -1;
     }
 
+    syncdio_t *dio = NULL;
+    if (tc->syncdio && tc->syncdio->anychanged) {
+        dio = tcqAllocDio(tcq);
+        if (!dio) {
+            return -1;
+        }
+        *dio = *tc->syncdio;
+    }
+
     /* add it */
     tcq->queue[tcq->end] = *tc;
+    tcq->queue[tcq->end].syncdio = dio;
+    tcq->queue[tcq->end].queue_time = tc->reqvel > 0.0 ? tc->target / tc->reqvel : 0.0;
+    tcq->time += tcq->queue[tcq->end].queue_time;
     tcq->_len++;
 
     /* update end ptr, modulo size of queue */
@@ -141,6 +228,16 @@ int tcqPut(TC_QUEUE_STRUCT * const tcq, TC_STRUCT const * const tc)
 }
 
 
+/** The queue time of a tc that leaves the queue.  An empty queue has
+ * none left, whatever rounding piled up meanwhile. */
+static void tcqDropTime(TC_QUEUE_STRUCT * const tcq, TC_STRUCT const * const tc)
+{
+    tcq->time -= tc->queue_time;
+    if (tcq->_len == 0 || tcq->time < 0.0) {
+        tcq->time = 0.0;
+    }
+}
+
 /*! tcqPopBack() function
  *
  * \brief removes the newest TC element (converse of tcqRemove)
@@ -162,6 +259,8 @@ int tcqPopBack(TC_QUEUE_STRUCT * const tcq)
     int n = tcq->end - 1 + tcq->size;
     tcq->end = n % tcq->size;
     tcq->_len--;
+    tcqDropTime(tcq, &tcq->queue[tcq->end]);
+    tcqReleaseDio(tcq, &tcq->queue[tcq->end]);
 
     return 0;
 }
@@ -179,10 +278,14 @@ int tcqPop(TC_QUEUE_STRUCT * const tcq)
         return -1;
     }
 
+    /* the reverse history never writes synched IO again */
+    tcqReleaseDio(tcq, &tcq->queue[tcq->start]);
+
     /* update start ptr and reset allFull flag and len */
+    tcq->_len--;
+    tcqDropTime(tcq, &tcq->queue[tcq->start]);
     tcq->start = (tcq->start + 1) % tcq->size;
     tcq->allFull = 0;
-    tcq->_len--;
 
     if (tcq->_rlen < TCQ_REVERSE_MARGIN) {
         //If we're not overwriting the history yet, then we have another segment added to the reverse history
@@ -222,10 +325,16 @@ int tcqRemove(TC_QUEUE_STRUCT * const tcq, int n)
 	    return -1;
     }
 
-    /* update start ptr and reset allFull flag and len */
-    tcq->start = (tcq->start + n) % tcq->size;
+    int i;
+    for (i = 0; i < n; i++) {
+        tcqReleaseDio(tcq, &tcq->queue[tcq->start]);
+        tcq->_len--;
+        tcqDropTime(tcq, &tcq->queue[tcq->start]);
+        tcq->start = (tcq->start + 1) % tcq->size;
+    }
+
+    /* reset allFull flag */
     tcq->allFull = 0;
-    tcq->_len -= n;
 
     return 0;
 }
@@ -250,6 +359,7 @@ int tcqBackStep(TC_QUEUE_STRUCT * const tcq)
     tcq->start = (tcq->start - 1 + tcq->size) % tcq->size;
     tcq->_len++;
     tcq->_rlen--;
+    tcq->time += tcq->queue[tcq->start].queue_time;
 
     return 0;
 }
@@ -271,6 +381,25 @@ int tcqLen(TC_QUEUE_STRUCT const * const tcq)
     return tcq->_len;
 }
 
+/*! tcqTime() function
+ *
+ * \brief estimates the time it takes to run the queue
+ *
+ * Each tc counts with its length at its requested velocity, as it was
+ * when it was queued, and until it is popped; blends, accelerations and
+ * overrides are left out.
+ *
+ * @param    tcq       pointer to the TC_QUEUE_STRUCT
+ *
+ * @return	 double	   seconds
+ */
+double tcqTime(TC_QUEUE_STRUCT const * const tcq)
+{
+    if (tcqCheck(tcq)) return 0.0;
+
+    return tcq->time;
+}
+
 /*! tcqItem() function
  *
  * \brief gets the n-th TC element in the queue, without removing it
@@ -297,7 +426,8 @@ TC_STRUCT * tcqItem(TC_QUEUE_STRUCT const * const tcq, int n)
 /*! tcqFull() function
  *
  * \brief get the full status of the queue
- * Function returns full if the count is closer to the end of the queue than TC_QUEUE_MARGIN
+ * Function returns full if the count is closer to the end of the queue than TC_QUEUE_MARGIN,
+ * or fewer than TCQ_DIO_MARGIN synched IO entries are left
  *
  * Function called by update_status() in control.c
  *
@@ -311,6 +441,10 @@ int tcqFull(TC_QUEUE_STRUCT const * const tcq)
 	   return 1;		/* null queue is full, for safety */
     }
 
+    if (tcq->dioUsed >= tcq->dioSize - TCQ_DIO_MARGIN) {
+        return 1;
+    }
+
     /* call the queue full if the length is into the margin, so reduce the
        effect of a race condition where the appending process may not see the
        full status immediately and send another motion */
@@ -31,13 +31,22 @@ typedef struct {
     int start, end;		/* indices to next to get, next to put */
     int rend;
     int allFull;		/* flag meaning it's actually full */
+    double time;		/* sum of the queue_time of the queued tcs */
+    syncdio_t *dio;		/* pool for the synched IO of queued tcs */
+    int dioSize;		/* entries in the pool */
+    int dioUsed;		/* entries now taken */
+    int dioNext;		/* where to look for a free one */
 } TC_QUEUE_STRUCT;
 
 /* TC_QUEUE_STRUCT functions */
 
-/* create queue of _size */
+/* create queue of _size, with _dioSize entries for synched IO */
 extern int tcqCreate(TC_QUEUE_STRUCT * const tcq, int _size,
-		     TC_STRUCT * const tcSpace);
+		     TC_STRUCT * const tcSpace,
+		     int _dioSize, syncdio_t * const dioSpace);
+
+/* number of synched IO entries to go with a queue of _size */
+extern int tcqDioSize(int _size);
 
 /* free up queue */
 extern int tcqDelete(TC_QUEUE_STRUCT * const tcq);
@@ -45,7 +54,7 @@ extern int tcqDelete(TC_QUEUE_STRUCT * const tcq);
 /* reset queue to empty */
 extern int tcqInit(TC_QUEUE_STRUCT * const tcq);
 
-/* put tc on end */
+/* put tc on end; its syncdio, if any, is copied into the pool */
 extern int tcqPut(TC_QUEUE_STRUCT * const tcq, TC_STRUCT const * const tc);
 
 /* remove a single tc from the back of the queue */
@@ -61,6 +70,9 @@ extern int tcqBackStep(TC_QUEUE_STRUCT * const tcq);
 /* how many tcs on queue */
 extern int tcqLen(TC_QUEUE_STRUCT const * const tcq);
 
+/* estimated seconds of motion in queue */
+extern double tcqTime(TC_QUEUE_STRUCT const * const tcq);
+
 /* look at nth item, first is 0 */
 extern TC_STRUCT * tcqItem(TC_QUEUE_STRUCT const * const tcq, int n);
 
@@ -72,4 +84,7 @@ extern TC_STRUCT * tcqLast(TC_QUEUE_STRUCT const * const tcq);
 /* get full status */
 extern int tcqFull(TC_QUEUE_STRUCT const * const tcq);
 
+/* give the synched IO of tc back to the pool */
+extern void tcqReleaseDio(TC_QUEUE_STRUCT * const tcq, TC_STRUCT * const tc);
+
 #endif
@@ -217,6 +217,81 @@ STATIC int tpGetMachineActiveLimit(double * const act_limit, PmCartesian const *
     return TP_ERR_OK;
 }
 
+/**
+ * Combine two jerk limits, where 0 means "not limited".
+ */
+STATIC inline double tpMinJerk(double j1, double j2) {
+    if (j1 <= 0.0) {
+        return fmax(j2, 0.0);
+    }
+    if (j2 <= 0.0) {
+        return j1;
+    }
+    return fmin(j1, j2);
+}
+
+/**
+ * Limit the path jerk by one axis.
+ * ratio is how far the axis moves per unit of path length, at most.
+ */
+STATIC inline double tpAxisJerkLimit(double jerk, int axis, double ratio) {
+    double axis_jerk = emcmotConfig->axisJerk[axis];
+    if (axis_jerk <= 0.0 || ratio < TP_POS_EPSILON) {
+        return jerk;
+    }
+    return tpMinJerk(jerk, axis_jerk / fmin(ratio, 1.0));
+}
+
+/**
+ * Find the jerk limit along a line or circle from [TRAJ]MAX_JERK and the
+ * [AXIS_n]MAX_JERK of the axes it moves.
+ * Returns 0 if no jerk limit applies. The normal jerk of circles (from the
+ * changing direction) is not accounted for, only the tangential part.
+ */
+STATIC double tpGetSegmentJerk(TC_STRUCT const * const tc) {
+    double jerk = emcmotConfig->maxJerk;
+    double target = fmax(tc->target, TP_POS_EPSILON);
+    PmCartesian xyz = {0}, abc = {0}, uvw = {0};
+    PmCartLine const *abc_line, *uvw_line;
+
+    switch (tc->motion_type) {
+        case TC_LINEAR:
+            pmCartCartSub(&tc->coords.line.xyz.end, &tc->coords.line.xyz.start, &xyz);
+            abc_line = &tc->coords.line.abc;
+            uvw_line = &tc->coords.line.uvw;
+            break;
+        case TC_CIRCULAR:
+        {
+            // An axis in the plane of the circle sees all of the tangential
+            // jerk somewhere on it, the helix adds the part along the normal
+            PmCartesian const *n = &tc->coords.circle.xyz.normal;
+            PmCartesian const *h = &tc->coords.circle.xyz.rHelix;
+            xyz.x = pmSqrt(fmax(1.0 - pmSq(n->x), 0.0)) + fabs(h->x) / target;
+            xyz.y = pmSqrt(fmax(1.0 - pmSq(n->y), 0.0)) + fabs(h->y) / target;
+            xyz.z = pmSqrt(fmax(1.0 - pmSq(n->z), 0.0)) + fabs(h->z) / target;
+            pmCartScalMultEq(&xyz, target);
+            abc_line = &tc->coords.circle.abc;
+            uvw_line = &tc->coords.circle.uvw;
+            break;
+        }
+        default:
+            return jerk;
+    }
+    pmCartCartSub(&abc_line->end, &abc_line->start, &abc);
+    pmCartCartSub(&uvw_line->end, &uvw_line->start, &uvw);
+
+    jerk = tpAxisJerkLimit(jerk, 0, fabs(xyz.x) / target);
+    jerk = tpAxisJerkLimit(jerk, 1, fabs(xyz.y) / target);
+    jerk = tpAxisJerkLimit(jerk, 2, fabs(xyz.z) / target);
+    jerk = tpAxisJerkLimit(jerk, 3, fabs(abc.x) / target);
+    jerk = tpAxisJerkLimit(jerk, 4, fabs(abc.y) / target);
+    jerk = tpAxisJerkLimit(jerk, 5, fabs(abc.z) / target);
+    jerk = tpAxisJerkLimit(jerk, 6, fabs(uvw.x) / target);
+    jerk = tpAxisJerkLimit(jerk, 7, fabs(uvw.y) / target);
+    jerk = tpAxisJerkLimit(jerk, 8, fabs(uvw.z) / target);
+    return jerk;
+}
+
 
 /**
  * Get a segment's feed scale based on the current planner state and emcmotStatus.
@@ -352,14 +427,6 @@ STATIC inline double tpGetSignedSpindlePosition(spindle_status_t *status) {
  * @section tpaccess tp class-like API
  */
 
-/* space for trajectory planner queues, plus 10 more for safety */
-/*! \todo FIXME-- default is used; dynamic is not honored */
-	TC_STRUCT queueTcSpace[DEFAULT_TC_QUEUE_SIZE + 10];
-
-/**
- * Create the trajectory planner structure with an empty queue.
- */
-
 #ifdef MAKE_TP_HAL_PINS // {
 static struct  tp_haldata {
   // Example pin pointers
@@ -395,6 +462,11 @@ error:
 }
 #endif // }
 
+/**
+ * Create the trajectory planner structure with an empty queue.
+ * The queue space, with the pool for synched IO, is allocated as rtapi
+ * shared memory owned by module id, and freed again by tpDelete().
+ */
 int tpCreate(TP_STRUCT * const tp, int _queueSize,int id)
 {
     if (0 == tp) {
@@ -406,13 +478,39 @@ int tpCreate(TP_STRUCT * const tp, int _queueSize,int id)
     } else {
         tp->queueSize = _queueSize;
     }
-    TC_STRUCT * const tcSpace = queueTcSpace;
 
-    /* create the queue */
-    if (-1 == tcqCreate(&tp->queue, tp->queueSize, tcSpace)) {
+    int dioSize = tcqDioSize(tp->queueSize);
+    unsigned long tcBytes = (unsigned long)tp->queueSize * sizeof(TC_STRUCT);
+    unsigned long dioBytes = (unsigned long)dioSize * sizeof(syncdio_t);
+    void *space;
+
+    tp->queueShmemId = rtapi_shmem_new(TP_SHMEM_KEY, id, tcBytes + dioBytes);
+    if (tp->queueShmemId < 0) {
+        rtapi_print_msg(RTAPI_MSG_ERR,
+                "TP: could not allocate %lu bytes for %d segments\n",
+                tcBytes + dioBytes, tp->queueSize);
+        return TP_ERR_FAIL;
+    }
+    tp->queueModuleId = id;
+    if (rtapi_shmem_getptr(tp->queueShmemId, &space) < 0) {
+        rtapi_shmem_delete(tp->queueShmemId, id);
+        return TP_ERR_FAIL;
+    }
+
+    /* create the queue, TC_STRUCT keeps the pool cache line aligned */
+    if (-1 == tcqCreate(&tp->queue, tp->queueSize, (TC_STRUCT *)space,
+                dioSize, (syncdio_t *)((char *)space + tcBytes))) {
+        rtapi_shmem_delete(tp->queueShmemId, id);
         return TP_ERR_FAIL;
     }
 
+    rtapi_print_msg(RTAPI_MSG_INFO,
+            "TP: queue of %d segments, %lu bytes each plus %lu for synched IO"
+            " (%d entries), %lu bytes per segment, %lu KiB in all\n",
+            tp->queueSize, (unsigned long)sizeof(TC_STRUCT),
+            (unsigned long)sizeof(syncdio_t), dioSize,
+            (tcBytes + dioBytes) / tp->queueSize, (tcBytes + dioBytes) / 1024);
+
 #ifdef MAKE_TP_HAL_PINS // {
     if (-1 == makepins(id)) {
         return TP_ERR_FAIL;
@@ -423,6 +521,21 @@ int tpCreate(TP_STRUCT * const tp, int _queueSize,int id)
     return tpInit(tp);
 }
 
+/**
+ * Free the queue space allocated by tpCreate().
+ */
+int tpDelete(TP_STRUCT * const tp)
+{
+    if (0 == tp || 0 == tp->queue.queue) {
+        return TP_ERR_FAIL;
+    }
+    tcqDelete(&tp->queue);
+    if (rtapi_shmem_delete(tp->queueShmemId, tp->queueModuleId) < 0) {
+        return TP_ERR_FAIL;
+    }
+    return TP_ERR_OK;
+}
+
 /**
  * Clears any potential DIO toggles and anychanged.
  * If any DIOs need to be changed: dios[i] = 1, DIO needs to get turned on, -1
@@ -777,6 +890,11 @@ STATIC double tpCalculateOptimizationInitialVel(TP_STRUCT const * const tp, TC_S
 {
     double acc_scaled = tcGetTangentialMaxAccel(tc);
     double triangle_vel = findVPeak(acc_scaled, tc->target);
+    if (tc->maxjerk > 0.0) {
+        // Stopping at the halfway point takes longer with limited jerk
+        triangle_vel = fmin(triangle_vel,
+                findJerkStopVel(acc_scaled, tc->maxjerk, tc->target / 2.0));
+    }
     double max_vel = tpGetMaxTargetVel(tp, tc);
     tp_debug_json_start(tpCalculateOptimizationInitialVel);
     tp_debug_json_double(triangle_vel);
@@ -821,9 +939,9 @@ STATIC int tpInitBlendArcFromPrev(TP_STRUCT const * const tp,
             ini_maxvel,
             acc);
 
-    // Skip syncdio setup since this blend extends the previous line
-    blend_tc->syncdio =		// enqueue the list of DIOs
-	prev_tc->syncdio;	// that need toggling
+    // Skip syncdio setup since this blend extends the previous line, which
+    // writes its DIOs first (a line with DIOs is never consumed)
+    blend_tc->syncdio = NULL;
 
     // find "helix" length for target
     double length;
@@ -1507,6 +1625,10 @@ STATIC inline int tpAddSegmentToQueue(TP_STRUCT * const tp, TC_STRUCT * const tc
         rtapi_print_msg(RTAPI_MSG_ERR, "tcqPut failed.\n");
         return TP_ERR_FAIL;
     }
+    if (tc->syncdio == &tp->syncdio) {
+        // the queue has its own copy now
+        tpClearDIOs(tp);
+    }
     if (inc_id) {
         tp->nextId++;
     }
@@ -1546,11 +1668,10 @@ STATIC int handleModeChange(TC_STRUCT * const prev_tc, TC_STRUCT * const tc)
 
 STATIC int tpSetupSyncedIO(TP_STRUCT * const tp, TC_STRUCT * const tc) {
     if (tp->syncdio.anychanged != 0) {
-        tc->syncdio = tp->syncdio; //enqueue the list of DIOs that need toggling
-        tpClearDIOs(tp); // clear out the list, in order to prepare for the next time we need to use it
+        tc->syncdio = &tp->syncdio; //enqueue the list of DIOs that need toggling, tcqPut() copies it
         return TP_ERR_OK;
     } else {
-        tc->syncdio.anychanged = 0;
+        tc->syncdio = NULL;
         return TP_ERR_NO_ACTION;
     }
 
@@ -1683,6 +1804,12 @@ STATIC int tpComputeOptimalVelocity(TP_STRUCT const * const tp, TC_STRUCT * cons
 
     // Find the reachable velocity of tc, moving backwards in time
     double vs_back = pmSqrt(pmSq(tc->finalvel) + 2.0 * acc_this * tc->target);
+    if (tc->maxjerk > 0.0 && tc->finalvel < TP_VEL_EPSILON) {
+        // A segment ending in a stop has to ramp its deceleration up and back
+        // down to zero. Segments that pass their velocity on can still hand
+        // over at full deceleration.
+        vs_back = fmin(vs_back, findJerkStopVel(acc_this, tc->maxjerk, tc->target));
+    }
     // Find the reachable velocity of prev1_tc, moving forwards in time
 
     double vf_limit_this = tc->maxvel;
@@ -2025,6 +2152,8 @@ STATIC tc_blend_type_t tpHandleBlendArc(TP_STRUCT * const tp, TC_STRUCT * const
     bool arc_blend_ok = tpCreateBlendIfPossible(tp, prev_tc, tc, &blend_tc);
 
     if (arc_blend_ok) {
+        //Blend arc moves the axes of both segments, so use the tighter limit
+        blend_tc.maxjerk = tpMinJerk(prev_tc->maxjerk, tc->maxjerk);
         //Need to do this here since the length changed
         blend_used = ARC_BLEND;
         tpAddSegmentToQueue(tp, &blend_tc, false);
@@ -2085,6 +2214,7 @@ int tpAddLine(TP_STRUCT * const tp, EmcPose end, int canon_motion_type,
     }
     tc.nominal_length = tc.target;
     tcClampVelocityByLength(&tc);
+    tc.maxjerk = tpGetSegmentJerk(&tc);
 
     // For linear move, set joint corresponding to a locking indexer axis
     tc.indexer_jnum = indexer_jnum;
@@ -2178,6 +2308,7 @@ int tpAddCircle(TP_STRUCT * const tp,
 
     //Reduce max velocity to match sample rate
     tcClampVelocityByLength(&tc);
+    tc.maxjerk = tpGetSegmentJerk(&tc);
 
     TC_STRUCT *prev_tc;
     prev_tc = tcqLast(&tp->queue);
@@ -2323,8 +2454,10 @@ STATIC int tcUpdateDistFromAccel(TC_STRUCT * const tc, double acc, double vel_de
     double v_next = tc->currentvel + acc * tc->cycle_time;
     // update position in this tc using trapezoidal integration
     // Note that progress can be greater than the target after this step.
+    tc->currentacc = acc;
     if (v_next < 0.0) {
         v_next = 0.0;
+        tc->currentacc = 0.0;
         //KLUDGE: the trapezoidal planner undershoots by half a cycle time, so
         //forcing the endpoint here is necessary. However, velocity undershoot
         //also occurs during pausing and stopping, which can happen far from
@@ -2488,21 +2621,23 @@ STATIC int tpCalculateRampAccel(TP_STRUCT const * const tp,
     return TP_ERR_OK;
 }
 
-void tpToggleDIOs(TC_STRUCT * const tc) {
+void tpToggleDIOs(TP_STRUCT * const tp, TC_STRUCT * const tc) {
 
     int i=0;
-    if (tc->syncdio.anychanged != 0) { // we have DIO's to turn on or off
+    syncdio_t const * const dio = tc->syncdio;
+    if (dio && dio->anychanged != 0) { // we have DIO's to turn on or off
         for (i=0; i < emcmotConfig->numDIO; i++) {
-            if (!(tc->syncdio.dio_mask & (1 << i))) continue;
-            if (tc->syncdio.dios[i] > 0) _DioWrite(i, 1); // turn DIO[i] on
-            if (tc->syncdio.dios[i] < 0) _DioWrite(i, 0); // turn DIO[i] off
+            if (!(dio->dio_mask & (1 << i))) continue;
+            if (dio->dios[i] > 0) _DioWrite(i, 1); // turn DIO[i] on
+            if (dio->dios[i] < 0) _DioWrite(i, 0); // turn DIO[i] off
         }
         for (i=0; i < emcmotConfig->numAIO; i++) {
-            if (!(tc->syncdio.aio_mask & (1 << i))) continue;
-            _AioWrite(i, tc->syncdio.aios[i]); // set AIO[i]
+            if (!(dio->aio_mask & (1 << i))) continue;
+            _AioWrite(i, dio->aios[i]); // set AIO[i]
         }
-        tc->syncdio.anychanged = 0; //we have turned them all on/off, nothing else to do for this TC the next time
     }
+    //we have turned them all on/off, nothing else to do for this TC the next time
+    tcqReleaseDio(&tp->queue, tc);
 }
 
 
@@ -2740,6 +2875,7 @@ STATIC int tpCompleteSegment(TP_STRUCT * const tp,
     tc->cycle_time = tp->cycleTime;
     //Velocities are by definition zero for a non-active segment
     tc->currentvel = 0.0;
+    tc->currentacc = 0.0;
     tc->term_vel = 0.0;
     //TODO make progress to match target?
     // done with this move
@@ -3052,7 +3188,7 @@ STATIC int tpDoParabolicBlending(TP_STRUCT * const tp, TC_STRUCT * const tc,
     if(tc->currentvel > nexttc->currentvel) {
         tpUpdateMovementStatus(tp, tc);
     } else {
-        tpToggleDIOs(nexttc);
+        tpToggleDIOs(tp, nexttc);
         tpUpdateMovementStatus(tp, nexttc);
     }
 #ifdef TP_SHOW_BLENDS
@@ -3067,6 +3203,98 @@ STATIC int tpDoParabolicBlending(TP_STRUCT * const tp, TC_STRUCT * const tc,
 }
 
 
+/**
+ * Check if an acceleration for the coming cycle keeps a jerk-limited
+ * profile possible.
+ * After the step, the velocity must settle at or below the target velocity
+ * once the acceleration is ramped back to zero, and there must still be
+ * room to slow down to the final velocity: to a full stop with zero
+ * acceleration, or onto the constant-deceleration envelope that the look-ahead
+ * planned for a segment handing its velocity over to the next one.
+ */
+STATIC bool tpJerkStepOk(TC_STRUCT const * const tc, double acc, double dx,
+        double v_target, double v_final, double a_max)
+{
+    double j_max = tc->maxjerk;
+    double dt = tc->cycle_time;
+    double v_next = fmax(tc->currentvel + acc * dt, 0.0);
+    double dx_next = dx - (tc->currentvel + v_next) * 0.5 * dt;
+
+    if (v_next + acc * fabs(acc) / (2.0 * j_max) > v_target + TP_VEL_EPSILON) {
+        return false;
+    }
+
+    if (v_final < TP_VEL_EPSILON) {
+        // Allow half a cycle for the lag of the sampled jerk ramp
+        double d_stop = findJerkStopDistance(v_next, acc, 0.0, a_max, j_max) + 0.5 * v_next * dt;
+        return d_stop <= dx_next + TP_POS_EPSILON;
+    }
+
+    // Gap to the envelope has to cover the change to its deceleration
+    double v_envelope = pmSqrt(pmSq(v_final) + 2.0 * a_max * fmax(dx_next, 0.0));
+    double acc_rel = acc + a_max;
+    return v_envelope - v_next >= acc_rel * fabs(acc_rel) / (2.0 * j_max);
+}
+
+/**
+ * Calculate jerk-limited (S-curve) acceleration for a cycle.
+ * The acceleration may only change by maxjerk * cycle time from the previous
+ * cycle, and within that range the largest one that passes tpJerkStepOk is
+ * used. If even the hardest braking allowed by the jerk limit cannot stop in
+ * time (e.g. the acceleration limit dropped at a segment boundary), the
+ * trapezoidal acceleration takes over so that the end point is not overrun.
+ */
+STATIC void tpCalculateJerkLimitedAccel(TP_STRUCT const * const tp,
+        TC_STRUCT * const tc,
+        TC_STRUCT const * const nexttc,
+        double * const acc,
+        double * const vel_desired)
+{
+    tc_debug_print("using jerk-limited acceleration\n");
+
+    double v_target = tpGetRealTargetVel(tp, tc);
+    double v_final = tpGetRealFinalVel(tp, tc, nexttc);
+    double dx = tcGetDistanceToGo(tc, tp->reverse_run);
+    double a_max = tcGetTangentialMaxAccel(tc);
+    double da = tc->maxjerk * tc->cycle_time;
+
+    double a_lo = bisaturate(tc->currentacc - da, a_max, -a_max);
+    double a_hi = bisaturate(tc->currentacc + da, a_max, -a_max);
+
+    *vel_desired = fmin(v_target, pmSqrt(pmSq(v_final) + 2.0 * a_max * dx));
+
+    if (v_final < TP_VEL_EPSILON && dx <= da * pmSq(tc->cycle_time)) {
+        // Closer to the end than a single jerk step moves, the search can't
+        // resolve it, so just land on the end point
+        tpCalculateTrapezoidalAccel(tp, tc, nexttc, acc, vel_desired);
+        return;
+    }
+
+    if (tpJerkStepOk(tc, a_hi, dx, v_target, v_final, a_max)) {
+        *acc = a_hi;
+    } else if (!tpJerkStepOk(tc, a_lo, dx, v_target, v_final, a_max)) {
+        *acc = a_lo;
+        double acc_trap, vel_trap;
+        tpCalculateTrapezoidalAccel(tp, tc, nexttc, &acc_trap, &vel_trap);
+        double acc_stop = saturate((vel_trap - tc->currentvel) / fmax(tc->cycle_time, TP_TIME_EPSILON), a_max);
+        if (acc_stop < *acc) {
+            tc_debug_print(" jerk limit can't stop in time, acc = %f\n", acc_stop);
+            *acc = acc_stop;
+        }
+    } else {
+        int i;
+        for (i = 0; i < TP_JERK_SEARCH_STEPS; ++i) {
+            double a_mid = (a_lo + a_hi) / 2.0;
+            if (tpJerkStepOk(tc, a_mid, dx, v_target, v_final, a_max)) {
+                a_lo = a_mid;
+            } else {
+                a_hi = a_mid;
+            }
+        }
+        *acc = a_lo;
+    }
+}
+
 /**
  * Do a complete update on one segment.
  * Handles the majority of updates on a single segment for the current cycle.
@@ -3089,9 +3317,16 @@ STATIC int tpUpdateCycle(TP_STRUCT * const tp,
     int res_accel = 1;
     double acc=0, vel_desired=0;
 
+    if (tc->maxjerk > 0.0 && tc->synchronized == TC_SYNC_NONE) {
+        // Spindle-synced motion has to follow the spindle, so it stays
+        // acceleration-limited
+        tpCalculateJerkLimitedAccel(tp, tc, nexttc, &acc, &vel_desired);
+        res_accel = TP_ERR_OK;
+    }
+
     // If the slowdown is not too great, use velocity ramping instead of trapezoidal velocity
     // Also, don't ramp up for parabolic blends
-    if (tc->accel_mode && tc->term_cond == TC_TERM_COND_TANGENT) {
+    if (res_accel != TP_ERR_OK && tc->accel_mode && tc->term_cond == TC_TERM_COND_TANGENT) {
         res_accel = tpCalculateRampAccel(tp, tc, nexttc, &acc, &vel_desired);
     }
 
@@ -3317,6 +3552,7 @@ STATIC int tpHandleSplitCycle(TP_STRUCT * const tp, TC_STRUCT * const tc,
         case TC_TERM_COND_TANGENT:
             nexttc->cycle_time = tp->cycleTime - tc->cycle_time;
             nexttc->currentvel = tc->term_vel;
+            nexttc->currentacc = tc->currentacc;
             tp_debug_print("Doing tangent split\n");
             break;
         case TC_TERM_COND_PARABOLIC:
@@ -3342,10 +3578,10 @@ STATIC int tpHandleSplitCycle(TP_STRUCT * const tp, TC_STRUCT * const tc,
     // FIXME redundant tangent check, refactor to switch
     if (tc->cycle_time > nexttc->cycle_time && tc->term_cond == TC_TERM_COND_TANGENT) {
         //Majority of time spent in current segment
-        tpToggleDIOs(tc);
+        tpToggleDIOs(tp, tc);
         tpUpdateMovementStatus(tp, tc);
     } else {
-        tpToggleDIOs(nexttc);
+        tpToggleDIOs(tp, nexttc);
         tpUpdateMovementStatus(tp, nexttc);
     }
 
@@ -3383,7 +3619,7 @@ STATIC int tpHandleRegularCycle(TP_STRUCT * const tp,
         tpDoParabolicBlending(tp, tc, nexttc);
     } else {
         //Update status for a normal step
-        tpToggleDIOs(tc);
+        tpToggleDIOs(tp, tc);
         tpUpdateMovementStatus(tp, tc);
     }
     return TP_ERR_OK;
@@ -3596,6 +3832,16 @@ int tpQueueDepth(TP_STRUCT * const tp)
     return tp->depth;
 }
 
+/* estimated seconds of motion queued, see tcqTime() */
+double tpQueueTime(TP_STRUCT * const tp)
+{
+    if (0 == tp) {
+        return 0.0;
+    }
+
+    return tcqTime(&tp->queue);
+}
+
 int tpActiveDepth(TP_STRUCT * const tp)
 {
     if (0 == tp) {
@@ -3671,6 +3917,7 @@ EXPORT_SYMBOL(tpAddLine);
 EXPORT_SYMBOL(tpAddRigidTap);
 EXPORT_SYMBOL(tpClear);
 EXPORT_SYMBOL(tpCreate);
+EXPORT_SYMBOL(tpDelete);
 EXPORT_SYMBOL(tpGetExecId);
 EXPORT_SYMBOL(tpGetExecTag);
 EXPORT_SYMBOL(tpGetMotionType);
@@ -3678,6 +3925,7 @@ EXPORT_SYMBOL(tpGetPos);
 EXPORT_SYMBOL(tpIsDone);
 EXPORT_SYMBOL(tpPause);
 EXPORT_SYMBOL(tpQueueDepth);
+EXPORT_SYMBOL(tpQueueTime);
 EXPORT_SYMBOL(tpResume);
 EXPORT_SYMBOL(tpRunCycle);
 EXPORT_SYMBOL(tpSetAmax);
@@ -22,7 +22,8 @@
 // functions not used by motmod:
 int tpAddCurrentPos(TP_STRUCT * const tp, EmcPose const * const disp);
 int tpSetCurrentPos(TP_STRUCT * const tp, EmcPose const * const pos);
-void tpToggleDIOs(TC_STRUCT * const tc); //gets called when a new tc is
+void tpToggleDIOs(TP_STRUCT * const tp, TC_STRUCT * const tc);
+                                         //gets called when a new tc is
                                          //taken from the queue. it checks
                                          //and toggles all needed DIO's
 int tpIsMoving(TP_STRUCT const * const tp);
@@ -30,6 +31,7 @@ int tpInit(TP_STRUCT * const tp);
 
 // functions used by motmod:
 int tpCreate(TP_STRUCT * const tp, int _queueSize,int id);
+int tpDelete(TP_STRUCT * const tp);
 int tpClear(TP_STRUCT * const tp);
 int tpClearDIOs(TP_STRUCT * const tp);
 int tpSetCycleTime(TP_STRUCT * tp, double secs);
@@ -63,6 +65,7 @@ int tpAddCircle(TP_STRUCT * const tp, EmcPose end, PmCartesian center,
 int tpGetPos(TP_STRUCT const  * const tp, EmcPose * const pos);
 int tpIsDone(TP_STRUCT * const tp);
 int tpQueueDepth(TP_STRUCT * const tp);
+double tpQueueTime(TP_STRUCT * const tp);
 int tpActiveDepth(TP_STRUCT * const tp);
 int tpGetMotionType(TP_STRUCT * const tp);
 int tpSetSpindleSync(TP_STRUCT * const tp, int spindle, double sync, int wait);
@@ -21,6 +21,8 @@
 #include <rtapi_bool.h>
 
 #define TP_DEFAULT_QUEUE_SIZE 32
+/* shared memory key for the queue space allocated by tpCreate() ("TPQ1") */
+#define TP_SHMEM_KEY 0x54505131
 /* Minimum length of a segment in cycles (must be greater than 1 to ensure each
  * segment is hit at least once.) */
 #define TP_MIN_SEGMENT_CYCLES 1.02
@@ -30,6 +32,9 @@
 /* If the queue is shorter than the threshold, assume that we're approaching
  * the end of the program */
 #define TP_QUEUE_THRESHOLD 3
+/* Bisection steps when searching the jerk-limited acceleration for a cycle,
+ * each halves the error in acceleration */
+#define TP_JERK_SEARCH_STEPS 12
 
 /* closeness to zero, for determining if a move is pure rotation */
 #define TP_PURE_ROTATION_EPSILON 1e-6
@@ -98,6 +103,8 @@ typedef struct {
     EmcPose goalPos;
 
     int queueSize;
+    int queueShmemId;		/* rtapi shmem holding the queue and its pools */
+    int queueModuleId;		/* module that allocated it */
     double cycleTime;
 
     double vMax;		/* vel for subsequent moves */
@@ -38,8 +38,10 @@
 #include <unistd.h>
 
 #include "tooldata.hh"
+#include "cmdtrace.h"
 
 #include <cmath>
+#include <vector>
 
 #include <epoxy/gl.h>
 #include <epoxy/glx.h>
@@ -81,10 +83,29 @@ struct pyIniFile {
     IniFile *i;
 };
 
+// Sections of EMC_STAT whose changes are tracked by poll().  Each section
+// gets a sequence number that is bumped whenever any of its bytes differ
+// from the previous poll.
+enum stat_section {
+    STAT_SECTION_TASK,
+    STAT_SECTION_INTERP,
+    STAT_SECTION_MOTION,
+    STAT_SECTION_IO,
+    STAT_SECTION_TOOL,
+    STAT_SECTION_MAX
+};
+
+static const char *stat_section_names[STAT_SECTION_MAX] = {
+    "task", "interp", "motion", "io", "tool"
+};
+
 struct pyStatChannel {
     PyObject_HEAD
     RCS_STAT_CHANNEL *c;
     EMC_STAT status;
+    unsigned long sequence[STAT_SECTION_MAX];
+    unsigned changed;           // bitmask of sections changed by last poll()
+    bool primed;                // status holds a complete copy
 };
 
 struct pyCommandChannel {
@@ -231,10 +252,12 @@ static RCS_STATUS emcWaitCommandComplete(pyCommandChannel *s, double timeout) {
 }
 
 static int emcSendCommand(pyCommandChannel *s, RCS_CMD_MSG & cmd) {
+    long long sent = cmdtrace_now();
     if (s->c->write(&cmd)) {
         return -1;
     }
     s->serial = cmd.serial_number;
+    cmdtrace_user(CMDTRACE_GUI_WRITE, cmd.serial_number, 0, cmd.type, 0, sent);
 
     double start = etime();
     while (etime() - start < EMC_COMMAND_TIMEOUT) {
@@ -242,6 +265,7 @@ static int emcSendCommand(pyCommandChannel *s, RCS_CMD_MSG & cmd) {
         int serial_diff = stat->echo_serial_number - s->serial;
         if(s->s->peek() == EMC_STAT_TYPE &&
            serial_diff >= 0) {
+                cmdtrace_user(CMDTRACE_GUI_ECHO, s->serial, 0, 0, 0, 0);
                 return 0;
            }
         esleep(EMC_COMMAND_DELAY);
@@ -283,6 +307,34 @@ static bool check_stat(RCS_STAT_CHANNEL *emcStatusBuffer) {
     return true;
 }
 
+// Byte ranges of EMC_STAT, in order and covering the whole struct, and the
+// section each one belongs to.  The interpreter state lives inside the task
+// status, so the task section is split around it.  The status message
+// headers of EMC_STAT and of its task, motion and io parts carry serial
+// numbers and heartbeats that move every cycle; they are not compared,
+// STAT_SECTION_MAX marks them.
+struct stat_range {
+    size_t begin, end;
+    stat_section section;
+};
+
+#define SO(x) offsetof(EMC_STAT, x)
+static const stat_range stat_ranges[] = {
+    { 0, SO(task.mode), STAT_SECTION_MAX },
+    { SO(task.mode), SO(task.execState), STAT_SECTION_TASK },
+    { SO(task.execState), SO(task.file), STAT_SECTION_INTERP },
+    { SO(task.file), SO(task.activeGCodes), STAT_SECTION_TASK },
+    { SO(task.activeGCodes), SO(task.task_paused), STAT_SECTION_INTERP },
+    { SO(task.task_paused), SO(motion), STAT_SECTION_TASK },
+    { SO(motion), SO(motion.traj), STAT_SECTION_MAX },
+    { SO(motion.traj), SO(io), STAT_SECTION_MOTION },
+    { SO(io), SO(io.cycleTime), STAT_SECTION_MAX },
+    { SO(io.cycleTime), SO(io.tool), STAT_SECTION_IO },
+    { SO(io.tool), SO(io.coolant), STAT_SECTION_TOOL },
+    { SO(io.coolant), sizeof(EMC_STAT), STAT_SECTION_IO },
+};
+#undef SO
+
 static bool initialized=0;
 
 static PyObject *poll(pyStatChannel *s, PyObject *o) {
@@ -304,14 +356,50 @@ static PyObject *poll(pyStatChannel *s, PyObject *o) {
     }
 #endif //}
     if(!check_stat(s->c)) return NULL;
+    s->changed = 0;
     if(s->c->peek() == EMC_STAT_TYPE) {
         EMC_STAT *emcStatus = static_cast<EMC_STAT*>(s->c->get_address());
+        if(!s->primed) {
+            s->changed = (1u << STAT_SECTION_MAX) - 1;
+            s->primed = true;
+        } else {
+            char *old = (char*)&s->status, *now = (char*)emcStatus;
+            for(size_t i=0; i<sizeof(stat_ranges)/sizeof(stat_ranges[0]); i++) {
+                const stat_range &r = stat_ranges[i];
+                if(r.section != STAT_SECTION_MAX
+                        && memcmp(old + r.begin, now + r.begin, r.end - r.begin))
+                    s->changed |= 1u << r.section;
+            }
+        }
         memcpy((char*)&s->status, emcStatus, sizeof(EMC_STAT));
+        for(int i=0; i<STAT_SECTION_MAX; i++)
+            if(s->changed & (1u << i)) s->sequence[i]++;
     }
     Py_INCREF(Py_None);
     return Py_None;
 }
 
+static PyObject *Stat_changed(pyStatChannel *s, PyObject *o) {
+    PyObject *res = PyTuple_New(__builtin_popcount(s->changed));
+    if(!res) return NULL;
+    for(int i=0, j=0; i<STAT_SECTION_MAX; i++) {
+        if(!(s->changed & (1u << i))) continue;
+        PyTuple_SET_ITEM(res, j++, PyUnicode_FromString(stat_section_names[i]));
+    }
+    return res;
+}
+
+static PyObject *Stat_sequences(pyStatChannel *s, PyObject *o) {
+    PyObject *res = PyDict_New();
+    if(!res) return NULL;
+    for(int i=0; i<STAT_SECTION_MAX; i++) {
+        PyObject *v = PyLong_FromUnsignedLong(s->sequence[i]);
+        PyDict_SetItemString(res, stat_section_names[i], v);
+        Py_XDECREF(v);
+    }
+    return res;
+}
+
 static void dict_add(PyObject *d, const char *name, unsigned char v) {
     PyObject *o;
     PyDict_SetItemString(d, name, o = PyLong_FromLong(v));
@@ -394,6 +482,16 @@ static PyObject *toolinfo(pyStatChannel *s, PyObject *o) {
 
 static PyMethodDef Stat_methods[] = {
     {"poll", (PyCFunction)poll, METH_NOARGS, "Update current machine state"},
+    {"changed", (PyCFunction)Stat_changed, METH_NOARGS,
+         "changed():\n"
+         "   returns a tuple of the status sections (task, interp, motion,\n"
+         "   io, tool) that changed during the last poll()"
+    },
+    {"sequences", (PyCFunction)Stat_sequences, METH_NOARGS,
+         "sequences():\n"
+         "   returns a dict of per-section sequence numbers, bumped by\n"
+         "   poll() whenever that section changes"
+    },
     {"toolinfo", (PyCFunction)toolinfo, METH_VARARGS,
          "toolinfo(toolnumber):\n"
          "   returns dict for toolnumber parameters (pocket,offsets,etc)\n"
@@ -436,6 +534,8 @@ static PyMemberDef Stat_members[] = {
     {(char*)"ini_filename", T_STRING_INPLACE, O(task.ini_filename), READONLY},
     {(char*)"delay_left", T_DOUBLE, O(task.delayLeft), READONLY},
     {(char*)"queued_mdi_commands", T_INT, O(task.queuedMDIcommands), READONLY, (char*)"Number of MDI commands queued waiting to run." },
+    {(char*)"readahead_segments", T_INT, O(task.readaheadSegments), READONLY, (char*)"Motions read by the interpreter that did not run yet." },
+    {(char*)"readahead_time", T_DOUBLE, O(task.readaheadTime), READONLY, (char*)"Estimated seconds of motion read by the interpreter that did not run yet." },
 
 //   EMC_TRAJ_STAT traj
     {(char*)"linear_units", T_DOUBLE, O(motion.traj.linearUnits), READONLY},
@@ -451,6 +551,7 @@ static PyMemberDef Stat_members[] = {
     {(char*)"queue", T_INT, O(motion.traj.queue), READONLY},
     {(char*)"active_queue", T_INT, O(motion.traj.activeQueue), READONLY},
     {(char*)"queue_full", T_BOOL, O(motion.traj.queueFull), READONLY},
+    {(char*)"queue_time", T_DOUBLE, O(motion.traj.queueTime), READONLY, (char*)"Estimated seconds of motion in the trajectory planner queue." },
     {(char*)"motion_id", T_INT, O(motion.traj.id), READONLY},
     {(char*)"paused", T_BOOL, O(motion.traj.paused), READONLY},
     {(char*)"feedrate", T_DOUBLE, O(motion.traj.scale), READONLY},
@@ -601,6 +702,14 @@ static PyObject *Stat_activesettings(pyStatChannel *s) {
    return double_array(s->status.task.activeSettings, ACTIVE_SETTINGS);
 }
 
+static PyObject *Stat_memcurrent(pyStatChannel *s) {
+    return double_array(s->status.task.memCurrent, ALLOC_TAGS);
+}
+
+static PyObject *Stat_mempeak(pyStatChannel *s) {
+    return double_array(s->status.task.memPeak, ALLOC_TAGS);
+}
+
 static PyObject *Stat_din(pyStatChannel *s) {
     return int_array(s->status.motion.synch_di, EMCMOT_MAX_AIO);
 }
@@ -810,6 +919,13 @@ static PyGetSetDef Stat_getsetlist[] = {
     },
     {(char*)"limit", (getter)Stat_limit},
     {(char*)"mcodes", (getter)Stat_activemcodes},
+    {(char*)"mem_current", (getter)Stat_memcurrent, (setter)NULL,
+        (char*)"Bytes task has allocated per subsystem: other, interp, interp_list,\n"
+        "canon_queue, python and nml.  Only counted with [TASK]ALLOC_ACCOUNTING."
+    },
+    {(char*)"mem_peak", (getter)Stat_mempeak, (setter)NULL,
+        (char*)"The highest value each entry of mem_current has had."
+    },
     {(char*)"misc_error", (getter)Stat_misc_error},
     {(char*)"g5x_offset", (getter)Stat_g5x_offset},
     {(char*)"g5x_index", (getter)Stat_g5x_index},
@@ -895,6 +1011,7 @@ static int Command_init(pyCommandChannel *self, PyObject *a, PyObject *k) {
 
     self->s = s;
     self->c = c;
+    cmdtrace_attach();
     return 0;
 }
 
@@ -1815,10 +1932,62 @@ static void glvertex9(const double pt[9], const char *geometry) {
     glVertex3dv(p);
 }
 
+static const double epsilon = 1e-4; // 1-cos(1 deg) ~= 1e-4
+static const double tiny = 1e-10;
+
+static inline bool colinear(double xa, double ya, double za, double xb, double yb, double zb, double xc, double yc, double zc) {
+    double dx1 = xa-xb, dx2 = xb-xc;
+    double dy1 = ya-yb, dy2 = yb-yc;
+    double dz1 = za-zb, dz2 = zb-zc;
+    double dp = sqrt(dx1*dx1 + dy1*dy1 + dz1*dz1);
+    double dq = sqrt(dx2*dx2 + dy2*dy2 + dz2*dz2);
+    if( fabs(dp) < tiny || fabs(dq) < tiny ) return true;
+    double dot = (dx1*dx2 + dy1*dy2 + dz1*dz2) / dp / dq;
+    if( fabs(1-dot) < epsilon) return true;
+    return false;
+}
+
+// Vertices of one GL_LINE_STRIP, collected so that the whole strip is
+// submitted with a single glDrawArrays instead of one call per vertex.
+// With decimate set, a vertex that is colinear with the two before it
+// replaces the previous one instead of being appended.
+struct vertex_strip {
+    std::vector<double> v;
+    bool decimate;
+
+    explicit vertex_strip(bool d) : decimate(d) { }
+
+    size_t size() const { return v.size() / 3; }
+
+    void add(const double p[3]) {
+        size_t n = v.size();
+        if(decimate && n >= 6 && colinear(p[0], p[1], p[2],
+                    v[n-3], v[n-2], v[n-1], v[n-6], v[n-5], v[n-4])) {
+            v[n-3] = p[0]; v[n-2] = p[1]; v[n-1] = p[2];
+            return;
+        }
+        v.insert(v.end(), p, p+3);
+    }
+
+    void add9(const double pt[9], const char *geometry) {
+        double p[3];
+        vertex9(pt, p, geometry);
+        add(p);
+    }
+
+    void draw() {
+        if(size() >= 2) {
+            glVertexPointer(3, GL_DOUBLE, 0, v.data());
+            glDrawArrays(GL_LINE_STRIP, 0, size());
+        }
+        v.clear();
+    }
+};
+
 #define max(a,b) ((a) < (b) ? (b) : (a))
 #define max3(a,b,c) (max((a),max((b),(c))))
 
-static void line9(const double p1[9], const double p2[9], const char *geometry) {
+static void line9(vertex_strip &strip, const double p1[9], const double p2[9], const char *geometry) {
     if(p1[3] != p2[3] || p1[4] != p2[4] || p1[5] != p2[5]) {
         double dc = max3(
             fabs(p2[3] - p1[3]),
@@ -1832,10 +2001,10 @@ static void line9(const double p1[9], const double p2[9], const char *geometry)
             double v = 1.0 - t;
             double pt[9];
             for(int j=0; j<9; j++) { pt[j] = t * p2[j] + v * p1[j]; }
-            glvertex9(pt, geometry);
+            strip.add9(pt, geometry);
         }
     } else {
-        glvertex9(p2, geometry);
+        strip.add9(p2, geometry);
     }
 }
 
@@ -1924,16 +2093,22 @@ static PyObject *pygui_rot_offsets(PyObject *s, PyObject *o) {
 static PyObject *pydraw_lines(PyObject *s, PyObject *o) {
     PyListObject *li;
     int for_selection = 0;
+    int decimate = 0;
     int i;
     int first = 1;
     int nl = -1, n;
     double p1[9], p2[9], pl[9];
     char *geometry;
 
-    if(!PyArg_ParseTuple(o, "sO!|i:draw_lines",
-			    &geometry, &PyList_Type, &li, &for_selection))
+    if(!PyArg_ParseTuple(o, "sO!|ii:draw_lines",
+			    &geometry, &PyList_Type, &li, &for_selection, &decimate))
         return NULL;
 
+    vertex_strip strip(decimate);
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glEnableClientState(GL_VERTEX_ARRAY);
+
     for(i=0; i<PyList_GET_SIZE(li); i++) {
         PyObject *it = PyList_GET_ITEM(li, i);
         PyObject *dummy1, *dummy2, *dummy3;
@@ -1945,25 +2120,26 @@ static PyObject *pydraw_lines(PyObject *s, PyObject *o) {
                     p2+3, p2+4, p2+5,
                     p2+6, p2+7, p2+8,
                     &dummy1, &dummy2, &dummy3)) {
-            if(!first) glEnd();
+            strip.draw();
+            glPopClientAttrib();
             return NULL;
         }
         if(first || memcmp(p1, pl, sizeof(p1))
                 || (for_selection && n != nl)) {
-            if(!first) glEnd();
+            strip.draw();
             if(for_selection && n != nl) {
                 glLoadName(n);
                 nl = n;
             }
-            glBegin(GL_LINE_STRIP);
-            glvertex9(p1, geometry);
+            strip.add9(p1, geometry);
             first = 0;
         }
-        line9(p1, p2, geometry);
+        line9(strip, p1, p2, geometry);
         memcpy(pl, p2, sizeof(p1));
     }
 
-    if(!first) glEnd();
+    strip.draw();
+    glPopClientAttrib();
 
     Py_INCREF(Py_None);
     return Py_None;
@@ -2065,27 +2241,14 @@ typedef struct {
     struct logger_point *p;
     struct color colors[NUMCOLORS];
     bool exit, clear, changed;
+    GLuint vbo;                 // buffer object holding the uploaded points
+    int vbo_pts, vbo_cap;       // points uploaded, buffer capacity in points
     char *geometry;
     int is_xyuv;
     double foam_z, foam_w;
     pyStatChannel *st;
 } pyPositionLogger;
 
-static const double epsilon = 1e-4; // 1-cos(1 deg) ~= 1e-4
-static const double tiny = 1e-10;
-
-static inline bool colinear(float xa, float ya, float za, float xb, float yb, float zb, float xc, float yc, float zc) {
-    double dx1 = xa-xb, dx2 = xb-xc;
-    double dy1 = ya-yb, dy2 = yb-yc;
-    double dz1 = za-zb, dz2 = zb-zc;
-    double dp = sqrt(dx1*dx1 + dy1*dy1 + dz1*dz1);
-    double dq = sqrt(dx2*dx2 + dy2*dy2 + dz2*dz2);
-    if( fabs(dp) < tiny || fabs(dq) < tiny ) return true;
-    double dot = (dx1*dx2 + dy1*dy2 + dz1*dz2) / dp / dq;
-    if( fabs(1-dot) < epsilon) return true;
-    return false;
-}
-
 static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static void LOCK() { pthread_mutex_lock(&mutex); }
@@ -2098,6 +2261,8 @@ static int Logger_init(pyPositionLogger *self, PyObject *a, PyObject *k) {
     self->npts = self->mpts = 0;
     self->exit = self->clear = 0;
     self->changed = 1;
+    self->vbo = 0;
+    self->vbo_pts = self->vbo_cap = 0;
     self->st = 0;
     self->is_xyuv = 0;
     self->foam_z = 0;
@@ -2118,7 +2283,13 @@ static int Logger_init(pyPositionLogger *self, PyObject *a, PyObject *k) {
     return 0;
 }
 
+// Buffer objects of loggers that went away.  There need not be a current
+// GL context when a logger is freed, so they are deleted by the next draw.
+static std::vector<GLuint> orphaned_vbos;
+
 static void Logger_dealloc(pyPositionLogger *s) {
+    if(s->vbo)
+        orphaned_vbos.push_back(s->vbo);
     free(s->p);
     Py_XDECREF(s->st);
     free(s->geometry);
@@ -2181,13 +2352,19 @@ static PyObject *Logger_start(pyPositionLogger *s, PyObject *o) {
 
     s->exit = 0;
     s->clear = 0;
+    LOCK();
     s->npts = 0;
+    s->changed = 1;
+    UNLOCK();
 
     Py_BEGIN_ALLOW_THREADS
     while(!s->exit) {
         if(s->clear) {
+            LOCK();
             s->npts = 0;
             s->lpts = 0;
+            s->changed = 1;
+            UNLOCK();
             s->clear = 0;
         }
         if(s->st->c->valid() && s->st->c->peek() == EMC_STAT_TYPE) {
@@ -2252,6 +2429,7 @@ static PyObject *Logger_start(pyPositionLogger *s, PyObject *o) {
                         s->npts -= adjust;
                         memmove(s->p, s->p + adjust,
                                 sizeof(struct logger_point) * s->npts);
+                        s->changed = 1;
                     } else {
                         s->mpts = 2 * s->mpts + 2;
                         s->changed = 1;
@@ -2309,8 +2487,58 @@ static PyObject* Logger_stop(pyPositionLogger *s, PyObject *o) {
     return Py_None;
 }
 
+// Bring the buffer object up to date with the logged points.  Points are
+// only ever appended, except that the last point is moved while the tool
+// travels in a straight line, so normally only the tail since the previous
+// upload is sent.  A trim or reallocation of the point array, or a clear,
+// uploads everything again.
+static void Logger_upload(pyPositionLogger *s) {
+    const size_t sz = sizeof(struct logger_point);
+    if(!s->vbo || !glIsBuffer(s->vbo)) {
+        glGenBuffers(1, &s->vbo);
+        s->changed = 1;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, s->vbo);
+    if(s->changed || s->npts < s->vbo_pts || s->mpts > s->vbo_cap) {
+        glBufferData(GL_ARRAY_BUFFER, sz * s->mpts, NULL, GL_DYNAMIC_DRAW);
+        if(s->npts)
+            glBufferSubData(GL_ARRAY_BUFFER, 0, sz * s->npts, s->p);
+        s->vbo_cap = s->mpts;
+        s->changed = 0;
+    } else if(s->npts) {
+        int first = s->vbo_pts ? s->vbo_pts - 1 : 0;
+        glBufferSubData(GL_ARRAY_BUFFER, sz * first,
+                sz * (s->npts - first), s->p + first);
+    }
+    s->vbo_pts = s->npts;
+}
+
 static PyObject* Logger_call(pyPositionLogger *s, PyObject *o) {
-    if(!s->clear) {
+    if(!orphaned_vbos.empty()) {
+        glDeleteBuffers(orphaned_vbos.size(), orphaned_vbos.data());
+        orphaned_vbos.clear();
+    }
+    if(!s->clear && epoxy_gl_version() >= 15) {
+        LOCK();
+        Logger_upload(s);
+        glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+        GLsizei stride = sizeof(struct logger_point);
+        if(s->is_xyuv) stride /= 2;
+        glVertexPointer(3, GL_FLOAT, stride,
+                (GLvoid*)offsetof(struct logger_point, x));
+        glColorPointer(4, GL_UNSIGNED_BYTE, stride,
+                (GLvoid*)offsetof(struct logger_point, c));
+        glEnableClientState(GL_COLOR_ARRAY);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        s->lpts = s->npts;
+        if(s->is_xyuv)
+            glDrawArrays(GL_LINES, 0, 2*s->npts);
+        else
+            glDrawArrays(GL_LINE_STRIP, 0, s->npts);
+        glPopClientAttrib();
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        UNLOCK();
+    } else if(!s->clear) {
         LOCK();
         if(s->is_xyuv) {
             if(s->changed) {
@@ -2437,7 +2665,7 @@ static PyTypeObject PositionLoggerType = {
 
 static PyMethodDef emc_methods[] = {
 #define METH(name, doc) { #name, (PyCFunction) py##name, METH_VARARGS, doc }
-METH(draw_lines, "Draw a bunch of lines in the 'rs274.glcanon' format"),
+METH(draw_lines, "Draw a bunch of lines in the 'rs274.glcanon' format; with decimate set, colinear vertices are merged"),
 METH(draw_dwells, "Draw a bunch of dwell positions in the 'rs274.glcanon' format"),
 METH(line9, "Draw a single line in the 'rs274.glcanon' format; assumes glBegin(GL_LINES)"),
 METH(vertex9, "Get the 3d location for a 9d point"),
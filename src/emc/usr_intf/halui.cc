@@ -38,6 +38,7 @@
 #include "timer.hh"
 #include <rtapi_string.h>
 #include "tooldata.hh"
+#include "cmdtrace.h"
 
 /* Using halui: see the man page */
 
@@ -287,6 +288,8 @@ static int emcTaskNmlGet()
 	    delete emcCommandBuffer;
 	    emcCommandBuffer = 0;
 	    retval = -1;
+	} else {
+	    cmdtrace_attach();
 	}
     }
     // try to connect to EMC status
@@ -449,12 +452,15 @@ static int emcCommandWaitDone()
 
 static int emcCommandSend(RCS_CMD_MSG & cmd)
 {
+    long long sent = cmdtrace_now();
+
     // write command
     if (emcCommandBuffer->write(&cmd)) {
         rtapi_print("halui: %s: error writing to Task\n", __func__);
         return -1;
     }
     emcCommandSerialNumber = cmd.serial_number;
+    cmdtrace_user(CMDTRACE_GUI_WRITE, cmd.serial_number, 0, cmd.type, 0, sent);
 
     // wait for receive
     double end;
@@ -463,6 +469,7 @@ static int emcCommandSend(RCS_CMD_MSG & cmd)
 	int serial_diff = emcStatus->echo_serial_number - emcCommandSerialNumber;
 
 	if (serial_diff >= 0) {
+	    cmdtrace_user(CMDTRACE_GUI_ECHO, emcCommandSerialNumber, 0, 0, 0, 0);
 	    return 0;
 	}
 
@@ -481,6 +488,7 @@ static void thisQuit()
     if(emcCommandBuffer) { delete emcCommandBuffer;  emcCommandBuffer = 0; }
     if(emcStatusBuffer) { delete emcStatusBuffer;  emcStatusBuffer = 0; }
     if(emcErrorBuffer) { delete emcErrorBuffer;  emcErrorBuffer = 0; }
+    cmdtrace_detach();
     exit(0);
 }
 
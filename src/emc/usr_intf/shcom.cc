@@ -39,6 +39,7 @@
 #include "rcs_print.hh"
 #include "timer.hh"             // esleep
 #include "shcom.hh"             // Common NML communications functions
+#include "cmdtrace.h"		// cmdtrace_user()
 #include <rtapi_string.h>
 
 LINEAR_UNIT_CONVERSION linearUnitConversion;
@@ -88,6 +89,8 @@ int emcTaskNmlGet()
 	    delete emcCommandBuffer;
 	    emcCommandBuffer = 0;
 	    retval = -1;
+	} else {
+	    cmdtrace_attach();
 	}
     }
     // try to connect to EMC status
@@ -319,6 +322,7 @@ int emcCommandWaitReceived()
 
 	int serial_diff = emcStatus->echo_serial_number - emcCommandSerialNumber;
 	if (serial_diff >= 0) {
+	    cmdtrace_user(CMDTRACE_GUI_ECHO, emcCommandSerialNumber, 0, 0, 0, 0);
 	    return 0;
 	}
 
@@ -330,11 +334,14 @@ int emcCommandWaitReceived()
 
 int emcCommandSend(RCS_CMD_MSG & cmd)
 {
+    long long sent = cmdtrace_now();
+
     // write command
     if (emcCommandBuffer->write(&cmd)) {
         return -1;
     }
     emcCommandSerialNumber = cmd.serial_number;
+    cmdtrace_user(CMDTRACE_GUI_WRITE, cmd.serial_number, 0, cmd.type, 0, sent);
     return 0;
 }
 
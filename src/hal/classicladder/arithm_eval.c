@@ -224,6 +224,69 @@ int IdentifyVarIndexedOrNot(char *StartExpr,int * ResType,int * ResOffset, int *
 	return FALSE;
 }
 
+/* Expressions are compiled once to a small stack code (see CompileCompare()
+   and CompileCalc()), that is then run at each scan by ExecArithmCode()
+   without parsing again the text of the expression. */
+enum
+{
+	ARITHM_OP_END = 0,
+	ARITHM_OP_CONST,		/* value */
+	ARITHM_OP_VAR,			/* type, offset */
+	ARITHM_OP_VAR_INDEXED,	/* type, offset, index type, index offset */
+	ARITHM_OP_ABS,
+	ARITHM_OP_MINI,			/* nbr of values */
+	ARITHM_OP_MAXI,			/* nbr of values */
+	ARITHM_OP_AVG,			/* nbr of values */
+	ARITHM_OP_NOT,
+	ARITHM_OP_POW,
+	ARITHM_OP_MUL,
+	ARITHM_OP_DIV,
+	ARITHM_OP_MOD,
+	ARITHM_OP_ADD,
+	ARITHM_OP_SUB,
+	ARITHM_OP_AND,
+	ARITHM_OP_XOR,
+	ARITHM_OP_OR,
+	ARITHM_OP_COMPARE,		/* COMPARE_xx flags */
+	ARITHM_OP_STORE,		/* type, offset */
+	ARITHM_OP_STORE_INDEXED	/* type, offset, index type, index offset */
+};
+#define COMPARE_GREATER 1
+#define COMPARE_LESS 2
+#define COMPARE_EQUAL 4
+#define COMPARE_DIFFERENT 8
+
+#define ARITHM_STACK_SIZE 32
+
+int * CompiledCode;
+int CompiledCodeLgt;
+int CompiledStackDepth;
+
+void EmitCode(int Value)
+{
+	if ( CompiledCodeLgt>=ARITHM_CODE_SIZE-1 )
+	{
+		if ( ErrorDesc==NULL )
+		{
+			ErrorDesc = "Expression too complex";
+			SyntaxError();
+		}
+		return;
+	}
+	CompiledCode[ CompiledCodeLgt++ ] = Value;
+}
+/* NbrPop values taken from the stack, NbrPush values put on it */
+void EmitOp(int Op, int NbrPop, int NbrPush)
+{
+	EmitCode( Op );
+	CompiledStackDepth = CompiledStackDepth-NbrPop+NbrPush;
+	if ( CompiledStackDepth>ARITHM_STACK_SIZE && ErrorDesc==NULL )
+	{
+		ErrorDesc = "Expression too complex";
+		SyntaxError();
+	}
+}
+
 /* Give final variable (taking into account the value of an index if present) */
 int IdentifyFinalVar( char *StartExpr, int * ResType,int * ResOffset )
 {
@@ -242,33 +305,47 @@ int IdentifyFinalVar( char *StartExpr, int * ResType,int * ResOffset )
 	return SyntaxOk;
 }
 
-arithmtype Variable(void)
+/* flush var found "@xxx/yyy@" or "@xxx/yyy[xxx/yyy]@" */
+void SkipVariable(void)
 {
-	int VarType,VarOffset;
-	if (IdentifyFinalVar(Expr, &VarType,&VarOffset))
+	Expr++;
+	do
 	{
-//printf("Variable:%d/%d\n", VarType, VarOffset);
-		/* flush var found */
-		Expr++;
-		do
-		{
-			Expr++;
-		}
-		while( (*Expr!='@') && (*Expr!='\0') );
 		Expr++;
-		/* return var value */
-		return (arithmtype)ReadVar(VarType,VarOffset);
 	}
-	else
+	while( (*Expr!='@') && (*Expr!='\0') );
+	if ( *Expr=='@' )
+		Expr++;
+}
+
+void Variable(void)
+{
+	int VarType,VarOffset,IndexVarType,IndexVarOffset;
+	if (IdentifyVarIndexedOrNot(Expr, &VarType,&VarOffset,&IndexVarType,&IndexVarOffset))
 	{
-		return 0;
+//printf("Variable:%d/%d\n", VarType, VarOffset);
+		SkipVariable( );
+		if ( IndexVarType!=-1 && IndexVarOffset!=-1 )
+		{
+			EmitOp( ARITHM_OP_VAR_INDEXED, 0, 1 );
+			EmitCode( VarType );
+			EmitCode( VarOffset );
+			EmitCode( IndexVarType );
+			EmitCode( IndexVarOffset );
+		}
+		else
+		{
+			EmitOp( ARITHM_OP_VAR, 0, 1 );
+			EmitCode( VarType );
+			EmitCode( VarOffset );
+		}
 	}
 }
 
-arithmtype Function(void)
+void Function(void)
 {
 	char tcFonc[ 20 ], *pFonc;
-	int Res = 0;
+	int Op = -1;
 
 	/* which function ? */
 	pFonc = tcFonc;
@@ -283,65 +360,47 @@ arithmtype Function(void)
 	if ( !strcmp(tcFonc, "ABS") )
 	{
 		Expr++; /* ( */
-		Res = Variable( );
-		if ( Res<0 )
-			Res = Res * -1;
+		Variable( );
 		if ( *Expr!=')' )
 		{
 			ErrorDesc = "Missing end ) after the only variable in ABS() function";
 			SyntaxError();
-			return 0;
+			return;
 		}
 		Expr++; /* ) */
-		return Res;
+		EmitOp( ARITHM_OP_ABS, 1, 1 );
+		return;
 	}
 
 	/* functions with many parameters = many variables separated per ',' */
 	if ( !strcmp(tcFonc, "MINI") )
-	{
-		Res = 0x7FFFFFFF;
-		do
-		{
-			int iValVar;
-			Expr++; /* ( -ou- , */
-			iValVar = Variable( );
-			if ( iValVar<Res )
-				Res = iValVar;
-		}
-		while( *Expr!=')' );
-		Expr++; /* ) */
-		return Res;
-	}
+		Op = ARITHM_OP_MINI;
 	if ( !strcmp(tcFonc, "MAXI") )
-	{
-		Res = 0x80000000;
-		do
-		{
-			int iValVar;
-			Expr++; /* ( -or- , */
-			iValVar = Variable( );
-			if ( iValVar>Res )
-				Res = iValVar;
-		}
-		while( *Expr!=')' );
-		Expr++; /* ) */
-		return Res;
-	}
+		Op = ARITHM_OP_MAXI;
 	if ( !strcmp(tcFonc, "MOY") /*original french term!*/ || !strcmp(tcFonc, "AVG") /*added latter!!!*/ )
+		Op = ARITHM_OP_AVG;
+	if ( Op!=-1 )
 	{
 		int NbrVars = 0;
 		do
 		{
-			int ValVar;
 			Expr++; /* ( -or- , */
-			ValVar = Variable( );
+			Variable( );
 			NbrVars++;
-			Res = Res + ValVar;
+			if ( ErrorDesc )
+				return;
+			if ( *Expr=='\0' )
+			{
+				ErrorDesc = "Missing end ) after the variables of the function";
+				SyntaxError();
+				return;
+			}
 		}
 		while( *Expr!=')' );
 		Expr++; /* ) */
-		Res = Res/NbrVars;
-		return Res;
+		EmitOp( Op, NbrVars, 1 );
+		EmitCode( NbrVars );
+		return;
 	}
 
 	/* functions with parameter = term */
@@ -353,40 +412,42 @@ arithmtype Function(void)
 
 	ErrorDesc = "Unknown function";
 	SyntaxError();
-
-	return 0;
 }
 
-arithmtype Term(void)
+void Term(void)
 {
 //if (UnderVerify)
 //printf("Term_Expr=%s (%c)\n",Expr, *Expr);
 	if (*Expr=='(')
 	{
-		arithmtype Res;
 		Expr++;
-//		Res = AddSub();
-		Res = Or();
+//		AddSub();
+		Or();
 		if (*Expr!=')')
 		{
 			ErrorDesc = "Missing parenthesis";
 			SyntaxError();
+			return;
 		}
 		Expr++;
-		return Res;
 	}
 	else if ( (*Expr>='0' && *Expr<='9') || (*Expr=='$') || (*Expr=='-') || (*Expr=='\'') )
-		return Constant();
+	{
+		arithmtype Value = Constant();
+		EmitOp( ARITHM_OP_CONST, 0, 1 );
+		EmitCode( Value );
+	}
 	else if (*Expr>='A' && *Expr<='Z')
-		return Function();
+		Function();
 	else if (*Expr=='@')
 	{
-		return Variable();
+		Variable();
 	}
 	else if (*Expr=='!')
 	{
 		Expr++;
-		return Term()?0:1;
+		Term();
+		EmitOp( ARITHM_OP_NOT, 1, 1 );
 	}
 	else
 	{
@@ -394,29 +455,25 @@ if (UnderVerify)
 rtapi_print("TermERROR!_ExprHere=%s\n",Expr);
 		ErrorDesc = "Unknown term";
 		SyntaxError();
-		return 0;
 	}
-//	return 0;
 }
 
-arithmtype Pow(void)
+void Pow(void)
 {
-	arithmtype Q,Res = Term();
+	Term();
 	while(*Expr=='^')
 	{
 		if ( ErrorDesc )
 			break;
 		Expr++;
-		Q = Pow();
-		Res = pow_int(Res,Q);
+		Pow();
+		EmitOp( ARITHM_OP_POW, 2, 1 );
 	}
-	return Res;
 }
 
-arithmtype MulDivMod(void)
+void MulDivMod(void)
 {
-	int Val=0;
-	arithmtype Res = Pow();
+	Pow();
 	while(1)
 	{
 		if ( ErrorDesc )
@@ -426,35 +483,33 @@ arithmtype MulDivMod(void)
 		if (*Expr=='*')
 		{
 			Expr++;
-			Res = Res * Pow();
+			Pow();
+			EmitOp( ARITHM_OP_MUL, 2, 1 );
 		}
 		else
 		if (*Expr=='/')
 		{
 			Expr++;
-			Val = Pow();
-			if ( ErrorDesc==NULL )
-				Res = Res / Val;
+			Pow();
+			EmitOp( ARITHM_OP_DIV, 2, 1 );
 		}
 		else
 		if (*Expr=='%')
 		{
 			Expr++;
-			Val = Pow();
-			if ( ErrorDesc==NULL )
-				Res = Res % Val;
+			Pow();
+			EmitOp( ARITHM_OP_MOD, 2, 1 );
 		}
 		else
 		{
 			break;
 		}
 	}
-	return Res;
 }
 
-arithmtype AddSub(void)
+void AddSub(void)
 {
-	arithmtype Res = MulDivMod();
+	MulDivMod();
 	while(1)
 	{
 		if ( ErrorDesc )
@@ -464,25 +519,26 @@ arithmtype AddSub(void)
 		if (*Expr=='+')
 		{
 			Expr++;
-			Res = Res + MulDivMod();
+			MulDivMod();
+			EmitOp( ARITHM_OP_ADD, 2, 1 );
 		}
 		else
 		if (*Expr=='-')
 		{
 			Expr++;
-			Res = Res - MulDivMod();
+			MulDivMod();
+			EmitOp( ARITHM_OP_SUB, 2, 1 );
 		}
 		else
 		{
 			break;
 		}
 	}
-	return Res;
 }
 
-arithmtype And(void)
+void And(void)
 {
-	arithmtype Res = AddSub();
+	AddSub();
 	while(1)
 	{
 		if ( ErrorDesc )
@@ -490,18 +546,18 @@ arithmtype And(void)
 		if (*Expr=='&')
 		{
 			Expr++;
-			Res = Res & AddSub();
+			AddSub();
+			EmitOp( ARITHM_OP_AND, 2, 1 );
 		}
 		else
 		{
 			break;
 		}
 	}
-	return Res;
 }
-arithmtype Xor(void)
+void Xor(void)
 {
-	arithmtype Res = And();
+	And();
 	while(1)
 	{
 		if ( ErrorDesc )
@@ -509,18 +565,18 @@ arithmtype Xor(void)
 		if (*Expr=='^')
 		{
 			Expr++;
-			Res = Res ^ And();
+			And();
+			EmitOp( ARITHM_OP_XOR, 2, 1 );
 		}
 		else
 		{
 			break;
 		}
 	}
-	return Res;
 }
-arithmtype Or(void)
+void Or(void)
 {
-	arithmtype Res = Xor();
+	Xor();
 	while(1)
 	{
 		if ( ErrorDesc )
@@ -528,43 +584,175 @@ arithmtype Or(void)
 		if (*Expr=='|')
 		{
 			Expr++;
-			Res = Res | Xor();
+			Xor();
+			EmitOp( ARITHM_OP_OR, 2, 1 );
 		}
 		else
 		{
 			break;
 		}
 	}
-	return Res;
 }
 
-arithmtype EvalExpression(char * ExprString)
+void CompileExpression(char * ExprString)
 {
-	arithmtype Res;
 	Expr = ExprString;
-//    Res = AddSub();
+//    AddSub();
 	ErrorDesc = NULL;
-	Res = Or();
+	Or();
+}
 
-	return Res;
+/* Run a code compiled, returns the value left on the stack */
+arithmtype ExecArithmCode(int * Pc)
+{
+	arithmtype Stack[ ARITHM_STACK_SIZE ];
+	arithmtype * Sp = Stack;
+	arithmtype Res;
+	int Nbr, Scan;
+	while(1)
+	{
+		switch( *Pc++ )
+		{
+			case ARITHM_OP_END:
+				return ( Sp>Stack )?Sp[-1]:0;
+			case ARITHM_OP_CONST:
+				*Sp++ = *Pc++;
+				break;
+			case ARITHM_OP_VAR:
+				*Sp++ = (arithmtype)ReadVar( Pc[0], Pc[1] );
+				Pc += 2;
+				break;
+			case ARITHM_OP_VAR_INDEXED:
+				*Sp++ = (arithmtype)ReadVar( Pc[0], Pc[1]+ReadVar( Pc[2], Pc[3] ) );
+				Pc += 4;
+				break;
+			case ARITHM_OP_ABS:
+				if ( Sp[-1]<0 )
+					Sp[-1] = Sp[-1] * -1;
+				break;
+			case ARITHM_OP_MINI:
+				Nbr = *Pc++;
+				Sp -= Nbr;
+				Res = 0x7FFFFFFF;
+				for ( Scan=0; Scan<Nbr; Scan++ )
+				{
+					if ( Sp[Scan]<Res )
+						Res = Sp[Scan];
+				}
+				*Sp++ = Res;
+				break;
+			case ARITHM_OP_MAXI:
+				Nbr = *Pc++;
+				Sp -= Nbr;
+				Res = 0x80000000;
+				for ( Scan=0; Scan<Nbr; Scan++ )
+				{
+					if ( Sp[Scan]>Res )
+						Res = Sp[Scan];
+				}
+				*Sp++ = Res;
+				break;
+			case ARITHM_OP_AVG:
+				Nbr = *Pc++;
+				Sp -= Nbr;
+				Res = 0;
+				for ( Scan=0; Scan<Nbr; Scan++ )
+					Res = Res + Sp[Scan];
+				*Sp++ = Res/Nbr;
+				break;
+			case ARITHM_OP_NOT:
+				Sp[-1] = Sp[-1]?0:1;
+				break;
+			case ARITHM_OP_POW:
+				Sp--;
+				Sp[-1] = pow_int( Sp[-1], Sp[0] );
+				break;
+			case ARITHM_OP_MUL:
+				Sp--;
+				Sp[-1] = Sp[-1] * Sp[0];
+				break;
+			case ARITHM_OP_DIV:
+				Sp--;
+				Sp[-1] = Sp[-1] / Sp[0];
+				break;
+			case ARITHM_OP_MOD:
+				Sp--;
+				Sp[-1] = Sp[-1] % Sp[0];
+				break;
+			case ARITHM_OP_ADD:
+				Sp--;
+				Sp[-1] = Sp[-1] + Sp[0];
+				break;
+			case ARITHM_OP_SUB:
+				Sp--;
+				Sp[-1] = Sp[-1] - Sp[0];
+				break;
+			case ARITHM_OP_AND:
+				Sp--;
+				Sp[-1] = Sp[-1] & Sp[0];
+				break;
+			case ARITHM_OP_XOR:
+				Sp--;
+				Sp[-1] = Sp[-1] ^ Sp[0];
+				break;
+			case ARITHM_OP_OR:
+				Sp--;
+				Sp[-1] = Sp[-1] | Sp[0];
+				break;
+			case ARITHM_OP_COMPARE:
+				Nbr = *Pc++;
+				Sp--;
+				Res = 0;
+				if ( (Nbr & COMPARE_GREATER) && Sp[-1]>Sp[0] )
+					Res = 1;
+				if ( (Nbr & COMPARE_LESS) && Sp[-1]<Sp[0] )
+					Res = 1;
+				if ( (Nbr & COMPARE_DIFFERENT) && Sp[-1]!=Sp[0] )
+					Res = 1;
+				if ( (Nbr & COMPARE_EQUAL) && Sp[-1]==Sp[0] )
+					Res = 1;
+				Sp[-1] = Res;
+				break;
+			case ARITHM_OP_STORE:
+				WriteVar( Pc[0], Pc[1], (int)*--Sp );
+				Pc += 2;
+				break;
+			case ARITHM_OP_STORE_INDEXED:
+				WriteVar( Pc[0], Pc[1]+ReadVar( Pc[2], Pc[3] ), (int)*--Sp );
+				Pc += 4;
+				break;
+			default:
+				return 0;
+		}
+	}
 }
 
 
 
-/* Result of the comparison of 2 arithmetics expressions : */
+/* Compile the comparison of 2 arithmetics expressions : */
 /* Expr1 ... Expr2 where ... can be : < , > , = , <= , >= , <> */
-int EvalCompare(char * CompareString)
+/* return TRUE if okay */
+int CompileCompare(char * CompareString, int * CodeBuff)
 {
 	char * FirstExpr,* SecondExpr = NULL;
 	char StrCopy[ARITHM_EXPR_SIZE+1]; /* used for putting null char after first expr */
 	char * SearchSep;
 	char * CutFirst;
 	int Found = FALSE;
-	int BoolRes = 0;
+
+	CompiledCode = CodeBuff;
+	CompiledCodeLgt = 0;
+	CompiledStackDepth = 0;
+	ErrorDesc = NULL;
 
 	/* null expression ? */
 	if (*CompareString=='\0' || *CompareString=='#')
-		return BoolRes;
+	{
+		EmitOp( ARITHM_OP_CONST, 0, 1 );
+		EmitCode( 0 );
+		CompiledCode[ CompiledCodeLgt ] = ARITHM_OP_END;
+		return TRUE;
+	}
 
 	rtapi_strxcpy(StrCopy,CompareString);
 
@@ -595,58 +783,64 @@ int EvalCompare(char * CompareString)
 	while (*SearchSep!='\0' && !Found);
 	if (Found)
 	{
-		arithmtype EvalFirst,EvalSecond;
-//printf("EvalCompare FirstString=%s , SecondString=%s\n",FirstExpr,SecondExpr);
-		EvalFirst = EvalExpression(FirstExpr);
-		EvalSecond = EvalExpression(SecondExpr);
-//printf("EvalCompare ResultFirst=%d , ResultSecond=%d\n",EvalFirst,EvalSecond);
-		/* verify if compare is true */
-		if ( *SearchSep=='>' && EvalFirst>EvalSecond )
-			BoolRes = 1;
-		if ( *SearchSep=='<' && *(SearchSep+1)!='>' && EvalFirst<EvalSecond )
-			BoolRes = 1;
-		if ( *SearchSep=='<' && *(SearchSep+1)=='>' && EvalFirst!=EvalSecond )
-			BoolRes = 1;
-		if ( (*SearchSep=='=' || *(SearchSep+1)=='=') && EvalFirst==EvalSecond )
-			BoolRes = 1;
+		int Flags = 0;
+		char * ErrorFirst;
+//printf("CompileCompare FirstString=%s , SecondString=%s\n",FirstExpr,SecondExpr);
+		CompileExpression(FirstExpr);
+		ErrorFirst = ErrorDesc;
+		CompileExpression(SecondExpr);
+		if ( ErrorDesc==NULL )
+			ErrorDesc = ErrorFirst;
+		/* which compare is it ? */
+		if ( *SearchSep=='>' )
+			Flags |= COMPARE_GREATER;
+		if ( *SearchSep=='<' && *(SearchSep+1)!='>' )
+			Flags |= COMPARE_LESS;
+		if ( *SearchSep=='<' && *(SearchSep+1)=='>' )
+			Flags |= COMPARE_DIFFERENT;
+		if ( *SearchSep=='=' || *(SearchSep+1)=='=' )
+			Flags |= COMPARE_EQUAL;
+		EmitOp( ARITHM_OP_COMPARE, 2, 1 );
+		EmitCode( Flags );
 	}
 	else
 	{
 		ErrorDesc = "Missing < or > or = or ... to make compare";
 		SyntaxError();
 	}
-//printf("Eval FinalBoolResult = %d\n",BoolRes);
-	return BoolRes;
+	CompiledCode[ CompiledCodeLgt ] = ARITHM_OP_END;
+	return ErrorDesc==NULL;
 }
 
-/* Calc the new value of a variable from an arithmetic expression : */
+/* Compile the new value of a variable from an arithmetic expression : */
 /* VarDest := ArithmExpr */
-void MakeCalc(char * CalcString,int VerifyMode)
+/* return TRUE if okay */
+int CompileCalc(char * CalcString, int * CodeBuff, int VerifyMode)
 {
 	char StrCopy[ARITHM_EXPR_SIZE+1]; /* used for putting null char after first expr */
-	int TargetVarType,TargetVarOffset;
+	int TargetVarType,TargetVarOffset,TargetIndexVarType,TargetIndexVarOffset;
 	int  Found = FALSE;
 
+	CompiledCode = CodeBuff;
+	CompiledCodeLgt = 0;
+	CompiledStackDepth = 0;
+	ErrorDesc = NULL;
+	CompiledCode[ 0 ] = ARITHM_OP_END;
+
 	/* null expression ? */
 	if (*CalcString=='\0' || *CalcString=='#')
-		return;
+		return TRUE;
 
 	rtapi_strxcpy(StrCopy,CalcString);
 
 	Expr = StrCopy;
-	if (IdentifyFinalVar(Expr,&TargetVarType,&TargetVarOffset))
+	if (IdentifyVarIndexedOrNot(Expr,&TargetVarType,&TargetVarOffset,&TargetIndexVarType,&TargetIndexVarOffset))
 	{
-		/* flush var found */
-		Expr++;
-		do
-		{
-			Expr++;
-		}
-		while( (*Expr!='@') && (*Expr!='\0') );
-		Expr++;
+		SkipVariable( );
 		/* verify if there is the '=' or ':=' */
 		do
 		{
+			char * Before = Expr;
 			if (*Expr==':')
 				Expr++;
 			if (*Expr=='=')
@@ -656,23 +850,35 @@ void MakeCalc(char * CalcString,int VerifyMode)
 			}
 			if (*Expr==' ')
 				Expr++;
+			if ( Expr==Before )
+				break;
 		}
 		while( !Found && *Expr!='\0' );
 		while( *Expr==' ')
 			Expr++;
 		if (Found)
 		{
-			arithmtype EvalExpr;
-//printf("Calc - Eval String=%s\n",Expr);
-			EvalExpr = EvalExpression(Expr);
-//printf("Calc - Result=%d\n",EvalExpr);
-			if (!VerifyMode)
+//printf("Calc - Compile String=%s\n",Expr);
+			CompileExpression(Expr);
+			if ( TargetIndexVarType!=-1 && TargetIndexVarOffset!=-1 )
 			{
-				WriteVar(TargetVarType,TargetVarOffset,(int)EvalExpr);
+				EmitOp( ARITHM_OP_STORE_INDEXED, 1, 0 );
+				EmitCode( TargetVarType );
+				EmitCode( TargetVarOffset );
+				EmitCode( TargetIndexVarType );
+				EmitCode( TargetIndexVarOffset );
 			}
-#ifdef GTK_INTERFACE
 			else
 			{
+				EmitOp( ARITHM_OP_STORE, 1, 0 );
+				EmitCode( TargetVarType );
+				EmitCode( TargetVarOffset );
+			}
+#ifdef GTK_INTERFACE
+			if ( VerifyMode )
+			{
+				if ( TargetIndexVarType!=-1 && TargetIndexVarOffset!=-1 )
+					TargetVarOffset = TargetVarOffset + ReadVar( TargetIndexVarType, TargetIndexVarOffset );
 				if ( !TestVarIsReadWrite( TargetVarType, TargetVarOffset ) )
 				{
 					ErrorDesc = "Target variable must be read/write !";
@@ -687,15 +893,67 @@ void MakeCalc(char * CalcString,int VerifyMode)
 			SyntaxError();
 		}
 	}
+	else if ( ErrorDesc==NULL )
+	{
+		ErrorDesc = "Bad var coding (unknown variable)";
+	}
+	CompiledCode[ CompiledCodeLgt ] = ARITHM_OP_END;
+	return ErrorDesc==NULL;
+}
+
+/* Result of the comparison of 2 arithmetics expressions : */
+/* Expr1 ... Expr2 where ... can be : < , > , = , <= , >= , <> */
+int EvalCompare(char * CompareString)
+{
+	int CodeBuff[ ARITHM_CODE_SIZE ];
+	if ( !CompileCompare( CompareString, CodeBuff ) )
+		return 0;
+	return ExecArithmCode( CodeBuff );
+}
+
+/* Calc the new value of a variable from an arithmetic expression : */
+/* VarDest := ArithmExpr */
+void MakeCalc(char * CalcString,int VerifyMode)
+{
+	int CodeBuff[ ARITHM_CODE_SIZE ];
+	if ( CompileCalc( CalcString, CodeBuff, VerifyMode ) && !VerifyMode )
+		ExecArithmCode( CodeBuff );
+}
+
+/* Compiled again only when the text of the expression has been modified
+   (ExprVersion incremented after each modification). */
+int EvalCompareExpr(StrArithmExpr * pArithmExpr)
+{
+	int Version = pArithmExpr->ExprVersion;
+	if ( pArithmExpr->CodeVersion!=Version )
+	{
+		pArithmExpr->CodeOk = CompileCompare( pArithmExpr->Expr, pArithmExpr->Code );
+		pArithmExpr->CodeVersion = Version;
+	}
+	if ( !pArithmExpr->CodeOk )
+		return 0;
+	return ExecArithmCode( pArithmExpr->Code );
+}
+void MakeCalcExpr(StrArithmExpr * pArithmExpr)
+{
+	int Version = pArithmExpr->ExprVersion;
+	if ( pArithmExpr->CodeVersion!=Version )
+	{
+		pArithmExpr->CodeOk = CompileCalc( pArithmExpr->Expr, pArithmExpr->Code, FALSE );
+		pArithmExpr->CodeVersion = Version;
+	}
+	if ( pArithmExpr->CodeOk )
+		ExecArithmCode( pArithmExpr->Code );
 }
 
 /* Used one time after user input to verify syntax only */
 /* return NULL if ok, else pointer on error description */
 char * VerifySyntaxForEvalCompare(char * StringToVerify)
 {
+	int CodeBuff[ ARITHM_CODE_SIZE ];
 	UnderVerify = TRUE;
 	VerifyErrorDesc = NULL;
-	EvalCompare(StringToVerify);
+	CompileCompare(StringToVerify, CodeBuff);
 	UnderVerify = FALSE;
 	return VerifyErrorDesc;
 }
@@ -703,10 +961,10 @@ char * VerifySyntaxForEvalCompare(char * StringToVerify)
 /* return NULL if ok, else pointer on error description */
 char * VerifySyntaxForMakeCalc(char * StringToVerify)
 {
+	int CodeBuff[ ARITHM_CODE_SIZE ];
 	UnderVerify = TRUE;
 	VerifyErrorDesc = NULL;
-	MakeCalc(StringToVerify,TRUE /* verify mode */);
+	CompileCalc(StringToVerify, CodeBuff, TRUE /* verify mode */);
 	UnderVerify = FALSE;
 	return VerifyErrorDesc;
 }
-
@@ -20,8 +20,10 @@
 int IdentifyVarIndexedOrNot(char * StartExpr,int * ResType,int * ResOffset, int * ResIndexType,int * ResIndexOffset);
 int EvalCompare(char * CompareString);
 void MakeCalc(char * CalcString,int VerifyMode);
-arithmtype AddSub(void);
-arithmtype Or(void);
+int EvalCompareExpr(StrArithmExpr * pArithmExpr);
+void MakeCalcExpr(StrArithmExpr * pArithmExpr);
+void AddSub(void);
+void Or(void);
 char * VerifySyntaxForEvalCompare(char * StringToVerify);
 char * VerifySyntaxForMakeCalc(char * StringToVerify);
 
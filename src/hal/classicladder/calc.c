@@ -213,7 +213,11 @@ void InitArithmExpr()
 {
     int NumExpr;
     for (NumExpr=0; NumExpr<NBR_ARITHM_EXPR; NumExpr++)
+    {
         rtapi_strxcpy(ArithmExpr[NumExpr].Expr,"");
+        ArithmExpr[NumExpr].ExprVersion = 0;
+        ArithmExpr[NumExpr].CodeVersion = -1;
+    }
 }
 void InitIOConf( )
 {
@@ -665,7 +669,7 @@ char CalcTypeCompar(int x,int y,StrRung * UpdateRung)
     char State;
     char StateElement;
 
-    StateElement = EvalCompare(ArithmExpr[UpdateRung->Element[x][y].VarNum].Expr);
+    StateElement = EvalCompareExpr(&ArithmExpr[UpdateRung->Element[x][y].VarNum]);
     UpdateRung->Element[x][y].DynamicState = StateElement;
     if (x==2)
     {
@@ -686,7 +690,7 @@ char CalcTypeOutputOperate(int x,int y,StrRung * UpdateRung)
     char State;
     State = StateOnLeft(x-2,y,UpdateRung);
     if (State)
-        MakeCalc(ArithmExpr[UpdateRung->Element[x][y].VarNum].Expr,FALSE /* verify mode */);
+        MakeCalcExpr(&ArithmExpr[UpdateRung->Element[x][y].VarNum]);
     UpdateRung->Element[x][y].DynamicInput = State;
     UpdateRung->Element[x][y].DynamicState = State;
     return State;
@@ -829,6 +833,25 @@ void RefreshASection( StrSection * pSection )
 	while(!Done);
 }
 
+// Time taken by each section (sub-routines called are counted in the
+// section calling them), displayed in the main window for the current one.
+#ifdef HAL_SUPPORT
+static long long int SectionScanStartTime;
+static void SectionScanStart( void )
+{
+	SectionScanStartTime = rtapi_get_time( );
+}
+static void SectionScanEnd( StrSection * pSection )
+{
+	pSection->DurationOfLastScan = rtapi_get_time( )-SectionScanStartTime;
+	if ( pSection->DurationOfLastScan>pSection->MaxDurationOfScan )
+		pSection->MaxDurationOfScan = pSection->DurationOfLastScan;
+}
+#else
+#define SectionScanStart( )
+#define SectionScanEnd( pSection )
+#endif
+
 // All the sections 'main' are refreshed in the order defined.
 #define SR_STACK 25
 void ClassicLadder_RefreshAllSections()
@@ -847,14 +870,18 @@ void ClassicLadder_RefreshAllSections()
 		// and in Ladder language ?
 		if ( pScanSection->Used && pScanSection->SubRoutineNumber==-1 && pScanSection->Language==SECTION_IN_LADDER )
 		{
+			SectionScanStart( );
 			RefreshASection( pScanSection );
+			SectionScanEnd( pScanSection );
 		}
 
 #ifdef SEQUENTIAL_SUPPORT
 		// current section defined and is in sequential language
 		if ( pScanSection->Used && pScanSection->Language==SECTION_IN_SEQUENTIAL )
 		{
+			SectionScanStart( );
 			RefreshSequentialPage( pScanSection->SequentialPage );
+			SectionScanEnd( pScanSection );
 		}
 #endif
 
@@ -299,9 +299,16 @@ typedef struct StrTimerIEC
 	int ValueToReachOneBaseUnit;
 }StrTimerIEC;
 
+#define ARITHM_CODE_SIZE 80
 typedef struct StrArithmExpr
 {
 	char Expr[ARITHM_EXPR_SIZE];
+	/* to increment after each modification of Expr */
+	int ExprVersion;
+	/* Expr compiled at the version CodeVersion (see arithm_eval.c) */
+	int CodeVersion;
+	char CodeOk;
+	int Code[ARITHM_CODE_SIZE];
 }StrArithmExpr;
 
 #define DEVICE_TYPE_NONE -1 //added in 0.9.4 because now we can have DEVICE_TYPE_DIRECT_CONFIG and FirstClassicLadderIO at -1 !!!
@@ -420,6 +427,9 @@ typedef struct StrSection
 	int LastRung;
 	/* if section is in Sequential */
 	int SequentialPage;
+	/* time for the last scan of this section and the longest one, in ns */
+	int DurationOfLastScan;
+	int MaxDurationOfScan;
 }StrSection;
 
 #define LGT_VAR_NAME 10
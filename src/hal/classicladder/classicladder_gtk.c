@@ -990,7 +990,7 @@ void MainSectionWindowInitGtk()
 #if defined( RT_SUPPORT ) || defined( __XENO__ )
 	DurationOfLastScan = gtk_entry_new();
 //GTK3	gtk_widget_set_usize(DurationOfLastScan,150,0);
-	gtk_widget_set_size_request( DurationOfLastScan, 150, -1 );
+	gtk_widget_set_size_request( DurationOfLastScan, 220, -1 );
 //    gtk_entry_set_max_length((GtkEntry *)DurationOfLastScan,LGT_COMMENT-1);
 //    gtk_entry_set_max_length((GtkEntry *)DurationOfLastScan,20);
 //ForGTK3	gtk_entry_prepend_text((GtkEntry *)DurationOfLastScan,"---");
@@ -1209,8 +1209,10 @@ static gint PeriodicUpdateDisplay(gpointer data)
 	if (InfosGene->LadderState==STATE_RUN)
 	{
 #if defined( RT_SUPPORT ) || defined( __XENO__ )
-		char TextBuffer[ 20 ];
-		snprintf(TextBuffer, sizeof(TextBuffer) , _("%d µs"), InfosGene->DurationOfLastScan/1000);
+		char TextBuffer[ 50 ];
+		StrSection * pSection = &SectionArray[ InfosGene->CurrentSection ];
+		snprintf(TextBuffer, sizeof(TextBuffer) , _("%d µs (section %d/%d µs)"), InfosGene->DurationOfLastScan/1000,
+			pSection->DurationOfLastScan/1000, pSection->MaxDurationOfScan/1000);
 		gtk_entry_set_text(GTK_ENTRY(DurationOfLastScan),TextBuffer);
 #endif
 		if (InfosGene->CmdRefreshVarsBits)
@@ -598,7 +598,13 @@ void ApplyNewArithmExpr()
 {
 	int NumExpr;
 	for (NumExpr=0; NumExpr<NBR_ARITHM_EXPR; NumExpr++)
-		rtapi_strxcpy(ArithmExpr[NumExpr].Expr,EditArithmExpr[NumExpr].Expr);
+	{
+		if ( strcmp( ArithmExpr[NumExpr].Expr, EditArithmExpr[NumExpr].Expr )!=0 )
+		{
+			rtapi_strxcpy(ArithmExpr[NumExpr].Expr,EditArithmExpr[NumExpr].Expr);
+			ArithmExpr[NumExpr].ExprVersion++;
+		}
+	}
 }
 void CheckForFreeingArithmExpr(int PosiX,int PosiY)
 {
@@ -876,6 +882,7 @@ RedrawSignalDrawingArea( );
 				|| (RungArray[OldCurrent].Element[x][y].Type == ELE_OUTPUT_OPERATE) )
 				{
 					rtapi_strxcpy(ArithmExpr[ RungArray[OldCurrent].Element[x][y].VarNum ].Expr,"");
+					ArithmExpr[ RungArray[OldCurrent].Element[x][y].VarNum ].ExprVersion++;
 				}
 			}
 		}
@@ -761,10 +761,12 @@ char LoadArithmeticExpr(char * FileName)
 					{
 						NumExpr = atoi(Line);
 						rtapi_strxcpy(ArithmExpr[NumExpr].Expr,Line+strlen("xxxx,"));
+						ArithmExpr[NumExpr].ExprVersion++;
 					}
 					else
 					{
 						rtapi_strxcpy(ArithmExpr[NumExpr].Expr,Line);
+						ArithmExpr[NumExpr].ExprVersion++;
 						NumExpr++;
 					}
 				}
@@ -48,6 +48,8 @@ void InitSections( void )
 		pSection->FirstRung = 0;
 		pSection->LastRung = 0;
 		pSection->SequentialPage = 0;
+		pSection->DurationOfLastScan = 0;
+		pSection->MaxDurationOfScan = 0;
 	}
 
 	// We directly create one section in ladder...
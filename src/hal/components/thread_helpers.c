@@ -0,0 +1,111 @@
+/********************************************************************
+* Description:  thread_helpers.c
+*               This file, 'thread_helpers.c', is a HAL component
+*               that gives an existing realtime thread helper tasks
+*               on other CPUs, so independent functions of the
+*               thread can run at the same time.
+*
+* License: GPL Version 2
+*
+********************************************************************/
+/** This file, 'thread_helpers.c', is a HAL component that gives an
+    existing thread helper tasks but contains no other functionality.
+
+    The module has two parameters: "thread" names the thread, and
+    "cpus" lists the CPU of each helper, one helper per entry.  The
+    helpers stay until the module is unloaded.  halcmd 'start'
+    computes which functions of the thread may run side by side; see
+    'halcmd show depends'.
+*/
+
+/** This program is free software; you can redistribute it and/or
+    modify it under the terms of version 2 of the GNU General
+    Public License as published by the Free Software Foundation.
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    THE AUTHORS OF THIS LIBRARY ACCEPT ABSOLUTELY NO LIABILITY FOR
+    ANY HARM OR LOSS RESULTING FROM ITS USE.  IT IS _EXTREMELY_ UNWISE
+    TO RELY ON SOFTWARE ALONE FOR SAFETY.  Any machinery capable of
+    harming persons must have provisions for completely removing power
+    from all motors, etc, before persons enter any danger area.  All
+    machinery must be designed to comply with local and national safety
+    codes, and the authors of this software can not, and do not, take
+    any responsibility for such compliance.
+
+    This code was written as part of the EMC HAL project.  For more
+    information, go to www.linuxcnc.org.
+*/
+
+#include "rtapi.h"		/* RTAPI realtime OS API */
+#include "rtapi_app.h"		/* RTAPI realtime module decls */
+#include "hal.h"		/* HAL public API decls */
+#include "rtapi_string.h"
+
+#define MAX_HELPERS 8		/* same as HAL_MAX_HELPERS */
+
+MODULE_DESCRIPTION("Helper tasks for HAL threads");
+MODULE_LICENSE("GPL");
+static char *thread = "servo-thread";	/* name of thread */
+RTAPI_MP_STRING(thread, "name of the thread to help");
+static int cpus[MAX_HELPERS] = {-1, -1, -1, -1, -1, -1, -1, -1};
+RTAPI_MP_ARRAY_INT(cpus, MAX_HELPERS, "cpu of each helper task");
+
+/***********************************************************************
+*                STRUCTURES AND GLOBAL VARIABLES                       *
+************************************************************************/
+
+static int comp_id;		/* component ID */
+static int helpers;		/* number of helpers started */
+
+/***********************************************************************
+*                       INIT AND EXIT CODE                             *
+************************************************************************/
+
+int rtapi_app_main(void)
+{
+    int n, retval;
+
+    comp_id = hal_init("thread_helpers");
+    if (comp_id < 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "THREAD_HELPERS: ERROR: hal_init() failed\n");
+	return -1;
+    }
+    n = 0;
+    while (n < MAX_HELPERS && cpus[n] >= 0) {
+	n++;
+    }
+    if (n == 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "THREAD_HELPERS: ERROR: no cpus given\n");
+	hal_exit(comp_id);
+	return -1;
+    }
+    retval = hal_thread_helpers(thread, n, cpus);
+    if (retval < 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "THREAD_HELPERS: ERROR: could not add helpers to thread '%s'\n",
+	    thread);
+	hal_exit(comp_id);
+	return -1;
+    }
+    helpers = n;
+    rtapi_print_msg(RTAPI_MSG_INFO,
+	"THREAD_HELPERS: thread '%s' has %d helpers\n", thread, helpers);
+    hal_ready(comp_id);
+    return 0;
+}
+
+void rtapi_app_exit(void)
+{
+    /* the thread may already be gone, taking its helpers along */
+    if (helpers) hal_thread_helpers(thread, 0, NULL);
+    hal_exit(comp_id);
+}
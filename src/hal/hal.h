@@ -773,6 +773,20 @@ extern int hal_create_thread(const char *name, unsigned long period_nsec,
 */
 extern int hal_thread_delete(const char *name);
 
+/** hal_thread_helpers() gives thread 'name' 'count' helper tasks, the
+    n-th one running on CPU 'cpus[n]'.  While the stages computed by
+    halcmd 'start' are current, the thread hands out independent
+    functions to its helpers and its runtime shrinks to that of the
+    longest chain of dependent functions.  Helpers busy-wait for work
+    during each cycle, so their CPUs should be isolated for realtime.
+    A 'count' of zero removes the helpers again.
+    On success, hal_thread_helpers() returns 0, on failure it returns
+    a negative error code; -ENOSYS means tasks cannot run on separate
+    CPUs.  Call only from realtime init code, not from user space or
+    realtime code.
+*/
+extern int hal_thread_helpers(const char *name, int count, const int *cpus);
+
 #endif /* RTAPI */
 
 /** hal_add_funct_to_thread() adds a function exported by a
@@ -157,6 +157,16 @@ static void free_thread_struct(hal_thread_t * thread);
     and calling each function in turn.
 */
 static void thread_task(void *arg);
+
+/** 'helper_task()' is the realtime task of a thread helper.  Each
+    period it waits for the owning thread to start a cycle and then
+    runs unclaimed functions of the current stage until the cycle ends.
+*/
+static void helper_task(void *arg);
+
+static void clear_thread_claims(hal_thread_t * thread);
+static int stop_thread_helpers(hal_thread_t * thread);
+static void delete_thread_helpers(hal_thread_t * thread, int count);
 #endif /* RTAPI */
 
 /***********************************************************************
@@ -1303,6 +1313,7 @@ int hal_link(const char *pin_name, const char *sig_name)
     }
     /* and update the pin */
     pin->signal = SHMOFF(sig);
+    hal_data->graph_serial++;
     /* done, release the mutex and return */
     rtapi_mutex_give(&(hal_data->mutex));
     return 0;
@@ -2193,6 +2204,113 @@ extern int hal_thread_delete(const char *name)
     return -EINVAL;
 }
 
+int hal_thread_helpers(const char *name, int count, const int *cpus)
+{
+    hal_thread_t *thread;
+    int n, retval, task_id;
+
+    if (hal_data == 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: thread_helpers called before init\n");
+	return -EINVAL;
+    }
+
+    if (hal_data->lock & HAL_LOCK_CONFIG) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: thread_helpers called while HAL is locked\n");
+	return -EPERM;
+    }
+    if ((count < 0) || (count > HAL_MAX_HELPERS) || (count > 0 && cpus == 0)) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: thread_helpers: bad helper count %d\n", count);
+	return -EINVAL;
+    }
+    /* get mutex before accessing shared data */
+    rtapi_mutex_get(&(hal_data->mutex));
+    thread = halpr_find_thread_by_name(name);
+    if (thread == 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR, "HAL: ERROR: thread '%s' not found\n",
+	    name);
+	return -EINVAL;
+    }
+    if (count == 0) {
+	n = thread->helpers;
+	if (n <= 0) {
+	    /* none, or somebody else is removing them */
+	    rtapi_mutex_give(&(hal_data->mutex));
+	    return n == 0 ? 0 : -EBUSY;
+	}
+	/* out of the next cycles; negative also keeps anyone from adding
+	   helpers while we wait for them without the mutex */
+	thread->helpers = -n;
+	__sync_synchronize();
+	rtapi_mutex_give(&(hal_data->mutex));
+	retval = stop_thread_helpers(thread);
+	rtapi_mutex_get(&(hal_data->mutex));
+	if (halpr_find_thread_by_name(name) != thread || thread->helpers != -n) {
+	    /* the thread was deleted meanwhile, and its helpers with it */
+	    rtapi_mutex_give(&(hal_data->mutex));
+	    return 0;
+	}
+	if (retval == 0) {
+	    delete_thread_helpers(thread, n);
+	} else {
+	    /* a helper is stuck in a function, leave them all running */
+	    thread->helpers = n;
+	}
+	rtapi_mutex_give(&(hal_data->mutex));
+	if (retval != 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"HAL: ERROR: helpers of thread '%s' did not leave their stage\n",
+		name);
+	}
+	return retval;
+    }
+    if (thread->helpers != 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: thread '%s' already has helpers\n", name);
+	return -EBUSY;
+    }
+    retval = 0;
+    for (n = 0; n < count; n++) {
+	task_id = rtapi_task_new(helper_task, thread, thread->priority,
+	    lib_module_id, HAL_STACKSIZE, thread->uses_fp);
+	if (task_id < 0) {
+	    retval = task_id;
+	    break;
+	}
+	retval = rtapi_task_set_cpu(task_id, cpus[n]);
+	if (retval == 0) {
+	    retval = rtapi_task_start(task_id, thread->period);
+	}
+	if (retval != 0) {
+	    rtapi_task_delete(task_id);
+	    break;
+	}
+	thread->helper_task_id[n] = task_id;
+    }
+    if (n < count) {
+	/* 'helpers' is still 0, so none of them ever joined a cycle */
+	delete_thread_helpers(thread, n);
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: could not start helper %d (cpu %d) of thread '%s': %d\n",
+	    n, cpus[n], name, retval);
+	return retval;
+    }
+    /* claims from the last time the thread had helpers may be so old
+       that they compare as new */
+    clear_thread_claims(thread);
+    __sync_synchronize();
+    thread->helpers = count;
+    rtapi_mutex_give(&(hal_data->mutex));
+    rtapi_print_msg(RTAPI_MSG_DBG, "HAL: thread '%s' has %d helpers\n",
+	name, count);
+    return 0;
+}
+
 #endif /* RTAPI */
 
 int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int position)
@@ -2319,6 +2437,9 @@ int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int
     funct_entry->funct_ptr = SHMOFF(funct);
     funct_entry->arg = funct->arg;
     funct_entry->funct = funct->funct;
+    /* void the stages before a running thread can see the entry */
+    hal_data->graph_serial++;
+    __sync_synchronize();
     /* add the entry to the list */
     list_add_after((hal_list_t *) funct_entry, list_entry);
     /* update the function usage count */
@@ -2404,7 +2525,10 @@ int hal_del_funct_from_thread(const char *funct_name, const char *thread_name)
 	}
 	funct_entry = (hal_funct_entry_t *) list_entry;
 	if (SHMPTR(funct_entry->funct_ptr) == funct) {
-	    /* this funct entry points to our funct, unlink */
+	    /* this funct entry points to our funct, void the stages and
+	       unlink */
+	    hal_data->graph_serial++;
+	    __sync_synchronize();
 	    list_remove_entry(list_entry);
 	    /* and delete it */
 	    free_funct_entry_struct(funct_entry);
@@ -2936,6 +3060,225 @@ void rtapi_app_exit(void)
 	"HAL_LIB: kernel lib removed successfully\n");
 }
 
+/* non-zero if 'thread' should run its function list by stages */
+static int thread_runs_stages(hal_thread_t * thread)
+{
+    return thread->helpers > 0 && thread->stages > 1
+	&& thread->sched_serial == hal_data->graph_serial;
+}
+
+/* stage words grow by one stage at a time and wrap, so compare them by
+   their difference */
+static inline int word_before(unsigned int a, unsigned int b)
+{
+    return (int) (a - b) < 0;
+}
+
+/* marks every function of 'thread' as claimed and run in the current
+   cycle, before it runs by stages again */
+static void clear_thread_claims(hal_thread_t * thread)
+{
+    hal_funct_entry_t *funct_root, *funct_entry;
+
+    funct_root = (hal_funct_entry_t *) & (thread->funct_list);
+    funct_entry = SHMPTR(funct_root->links.next);
+    while (funct_entry != funct_root) {
+	funct_entry->claimed = funct_entry->done = thread->par_word;
+	funct_entry = SHMPTR(funct_entry->links.next);
+    }
+}
+
+/* runs 'funct_entry' once, timing it; the caller claimed it with 'word' */
+static void run_claimed_funct(hal_thread_t * thread,
+    hal_funct_entry_t * funct_entry, unsigned int word)
+{
+    hal_funct_t *funct;
+    long long int start_time, end_time;
+
+    start_time = rtapi_get_clocks();
+    funct_entry->funct(funct_entry->arg, thread->period);
+    end_time = rtapi_get_clocks();
+    funct = SHMPTR(funct_entry->funct_ptr);
+    *(funct->runtime) = (hal_s32_t)(end_time - start_time);
+    if ( *(funct->runtime) > funct->maxtime) {
+	funct->maxtime = *(funct->runtime);
+	funct->maxtime_increased = 1;
+    } else {
+	funct->maxtime_increased = 0;
+    }
+    __sync_synchronize();
+    funct_entry->done = word;
+}
+
+/* walks the function list of 'thread' and runs every function of the
+   stage in 'word' that nobody has claimed yet.  A claim only replaces
+   an older word, so a helper still holding the word of a stage that
+   has ended can no longer claim anything.  Returns -1 as soon as the
+   list or the signals changed, which makes the stages void. */
+static int run_stage_functs(hal_thread_t * thread, unsigned int word)
+{
+    hal_funct_entry_t *funct_root, *funct_entry;
+    unsigned int old;
+    int stage;
+
+    stage = word & 0xff;
+    funct_root = (hal_funct_entry_t *) & (thread->funct_list);
+    funct_entry = SHMPTR(funct_root->links.next);
+    while (funct_entry != funct_root) {
+	if (thread->sched_serial != hal_data->graph_serial) {
+	    return -1;
+	}
+	if (funct_entry->stage == stage) {
+	    old = funct_entry->claimed;
+	    if (word_before(old, word) && thread->par_word == word
+		&& __sync_bool_compare_and_swap(&funct_entry->claimed, old, word)) {
+		run_claimed_funct(thread, funct_entry, word);
+	    }
+	}
+	funct_entry = SHMPTR(funct_entry->links.next);
+    }
+    return 0;
+}
+
+/* waits until every function of the stage in 'word' has finished,
+   whoever ran it.  Returns -1 if the stages became void or 'deadline'
+   passed first. */
+static int wait_stage_functs(hal_thread_t * thread, unsigned int word,
+    long long int deadline)
+{
+    hal_funct_entry_t *funct_root, *funct_entry;
+    int stage;
+
+    stage = word & 0xff;
+    funct_root = (hal_funct_entry_t *) & (thread->funct_list);
+    funct_entry = SHMPTR(funct_root->links.next);
+    while (funct_entry != funct_root) {
+	if (thread->sched_serial != hal_data->graph_serial
+	    || rtapi_get_time() > deadline) {
+	    return -1;
+	}
+	if (funct_entry->stage == stage && funct_entry->done != word) {
+	    /* a helper is still running it, look again */
+	    continue;
+	}
+	funct_entry = SHMPTR(funct_entry->links.next);
+    }
+    __sync_synchronize();
+    return 0;
+}
+
+/* runs what is left of cycle 'cycle' in list order, after the stages
+   became void or a helper took too long: every function not claimed in
+   this cycle yet.  One a helper is still running is left to it. */
+static void finish_cycle_serially(hal_thread_t * thread, unsigned int cycle)
+{
+    hal_funct_entry_t *funct_root, *funct_entry;
+    unsigned int old, word;
+
+    word = (cycle << 8) | HAL_PAR_SERIAL;
+    funct_root = (hal_funct_entry_t *) & (thread->funct_list);
+    funct_entry = SHMPTR(funct_root->links.next);
+    while (funct_entry != funct_root) {
+	old = funct_entry->claimed;
+	if (word_before(old, cycle << 8)
+	    && __sync_bool_compare_and_swap(&funct_entry->claimed, old, word)) {
+	    run_claimed_funct(thread, funct_entry, word);
+	}
+	funct_entry = SHMPTR(funct_entry->links.next);
+    }
+}
+
+/* runs one cycle of 'thread' stage by stage; the helpers join in
+   through 'par_word' and each stage ends when all of its functions
+   have finished, whoever ran them.  The cycle may take at most one
+   period, after that the thread finishes it alone. */
+static void run_thread_stages(hal_thread_t * thread)
+{
+    unsigned int cycle, word;
+    long long int deadline;
+    int stage;
+
+    deadline = rtapi_get_time() + thread->period;
+    cycle = (thread->par_word >> 8) + 1;
+    for (stage = 0; stage < thread->stages; stage++) {
+	word = (cycle << 8) | stage;
+	__sync_synchronize();
+	thread->par_word = word;
+	if (run_stage_functs(thread, word) < 0
+	    || wait_stage_functs(thread, word, deadline) < 0) {
+	    finish_cycle_serially(thread, cycle);
+	    break;
+	}
+    }
+    thread->par_word = (cycle << 8) | HAL_PAR_IDLE;
+}
+
+static void helper_task(void *arg)
+{
+    hal_thread_t *thread;
+    unsigned int word, last;
+    long long int deadline;
+
+    thread = arg;
+    last = thread->par_word;
+    while (1) {
+	/* wait until next period */
+	rtapi_wait();
+	/* count ourselves busy before looking at 'helpers', so that
+	   stop_thread_helpers() either sees us or we see it */
+	__sync_fetch_and_add(&thread->par_busy, 1);
+	if (hal_data->threads_running == 0 || !thread_runs_stages(thread)) {
+	    __sync_fetch_and_sub(&thread->par_busy, 1);
+	    continue;
+	}
+	/* the thread task may start its cycle a little later than us;
+	   give up in time to be back for our next period */
+	deadline = rtapi_get_time() + thread->period - thread->period / 8;
+	while (rtapi_get_time() < deadline) {
+	    word = thread->par_word;
+	    if (word == last) {
+		continue;
+	    }
+	    last = word;
+	    if ((word & 0xff) == HAL_PAR_IDLE
+		|| run_stage_functs(thread, word) < 0) {
+		/* this cycle is done, or the stages became void */
+		break;
+	    }
+	}
+	__sync_fetch_and_sub(&thread->par_busy, 1);
+    }
+}
+
+/* once 'helpers' no longer lets them join a cycle, waits for at most
+   ten periods until no helper of 'thread' is inside a stage any more;
+   one deleted in the middle of a function would never finish it.
+   Returns 0, or -EBUSY if a helper is still busy. */
+static int stop_thread_helpers(hal_thread_t * thread)
+{
+    long long int deadline;
+
+    deadline = rtapi_get_time() + 10 * (long long int) thread->period;
+    while (thread->par_busy != 0) {
+	if (rtapi_get_time() > deadline) {
+	    return -EBUSY;
+	}
+    }
+    return 0;
+}
+
+static void delete_thread_helpers(hal_thread_t * thread, int count)
+{
+    int n;
+
+    for (n = 0; n < count; n++) {
+	rtapi_task_pause(thread->helper_task_id[n]);
+	rtapi_task_delete(thread->helper_task_id[n]);
+	thread->helper_task_id[n] = 0;
+    }
+    thread->helpers = 0;
+}
+
 /* this is the task function that implements threads in realtime */
 
 static void thread_task(void *arg)
@@ -2948,7 +3291,16 @@ static void thread_task(void *arg)
 
     thread = arg;
     while (1) {
-	if (hal_data->threads_running > 0) {
+	if (hal_data->threads_running > 0 && thread_runs_stages(thread)) {
+	    /* let the helpers work through the stages with us */
+	    thread_start_time = rtapi_get_clocks();
+	    run_thread_stages(thread);
+	    end_time = rtapi_get_clocks();
+	    *(thread->runtime) = (hal_s32_t)(end_time - thread_start_time);
+	    if ( *(thread->runtime) > thread->maxtime) {
+	        thread->maxtime = *(thread->runtime);
+	    }
+	} else if (hal_data->threads_running > 0) {
 	    /* point at first function on function list */
 	    funct_root = (hal_funct_entry_t *) & (thread->funct_list);
 	    funct_entry = SHMPTR(funct_root->links.next);
@@ -3041,6 +3393,7 @@ static int init_hal_data(void)
     list_init_entry(&(hal_data->funct_entry_free));
     hal_data->thread_free_ptr = 0;
     hal_data->exact_base_period = 0;
+    hal_data->graph_serial = 0;
     /* set up for shmalloc_xx() */
     hal_data->shmem_bot = sizeof(hal_data_t);
     hal_data->shmem_top = HAL_SIZE;
@@ -3304,6 +3657,9 @@ static hal_funct_entry_t *alloc_funct_entry_struct(void)
 	p->funct_ptr = 0;
 	p->arg = 0;
 	p->funct = 0;
+	p->stage = 0;
+	p->claimed = 0;
+	p->done = 0;
     }
     return p;
 }
@@ -3333,6 +3689,11 @@ static hal_thread_t *alloc_thread_struct(void)
 	p->task_id = 0;
 	list_init_entry(&(p->funct_list));
 	p->name[0] = '\0';
+	p->helpers = 0;
+	p->sched_serial = -1;
+	p->stages = 0;
+	p->par_word = HAL_PAR_IDLE;
+	p->par_busy = 0;
     }
     return p;
 }
@@ -3421,6 +3782,7 @@ static void unlink_pin(hal_pin_t * pin)
     /* is this pin linked to a signal? */
     if (pin->signal != 0) {
     /* yes, need to unlink it */
+    hal_data->graph_serial++;
     sig = SHMPTR(pin->signal);
     /* make pin's 'data_ptr' point to its dummy signal */
     data_ptr_addr = SHMPTR(pin->data_ptr_addr);
@@ -3610,6 +3972,7 @@ static void free_funct_entry_struct(hal_funct_entry_t * funct_entry)
     funct_entry->funct_ptr = 0;
     funct_entry->arg = 0;
     funct_entry->funct = 0;
+    hal_data->graph_serial++;
     /* add it to free list */
     list_add_after((hal_list_t *) funct_entry, &(hal_data->funct_entry_free));
 }
@@ -3619,6 +3982,7 @@ static void free_thread_struct(hal_thread_t * thread)
 {
     hal_funct_entry_t *funct_entry;
     hal_list_t *list_root, *list_entry;
+    int n;
 /*! \todo Another #if 0 */
 #if 0
     rtapi_intptr_t *prev, next;
@@ -3628,9 +3992,19 @@ static void free_thread_struct(hal_thread_t * thread)
 
     /* if we're deleting a thread, we need to stop all threads */
     hal_data->threads_running = 0;
-    /* and stop the task associated with this thread */
+    /* and stop the tasks associated with this thread, the thread task
+       first so that nothing waits for a helper any more */
     rtapi_task_pause(thread->task_id);
     rtapi_task_delete(thread->task_id);
+    n = thread->helpers < 0 ? -thread->helpers : thread->helpers;
+    thread->helpers = 0;
+    __sync_synchronize();
+    if (stop_thread_helpers(thread) != 0) {
+	rtapi_print_msg(RTAPI_MSG_WARN,
+	    "HAL: WARNING: deleting busy helpers of thread '%s'\n",
+	    thread->name);
+    }
+    delete_thread_helpers(thread, n);
     /* clear contents of struct */
     thread->uses_fp = 0;
     thread->period = 0;
@@ -4331,6 +4705,7 @@ EXPORT_SYMBOL(hal_set_constructor);
 EXPORT_SYMBOL(hal_export_funct);
 
 EXPORT_SYMBOL(hal_create_thread);
+EXPORT_SYMBOL(hal_thread_helpers);
 
 EXPORT_SYMBOL(hal_add_funct_to_thread);
 EXPORT_SYMBOL(hal_del_funct_from_thread);
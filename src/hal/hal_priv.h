@@ -118,7 +118,7 @@
 */
 
 #define HAL_KEY   0x48414C32	/* key used to open HAL shared memory */
-#define HAL_VER   0x00000010	/* version code */
+#define HAL_VER   0x00000011	/* version code */
 #define HAL_SIZE  (256*4096)
 #define HAL_PSEUDO_COMP_PREFIX "__" /* prefix to identify a pseudo component */
 
@@ -274,6 +274,7 @@ typedef struct hal_data_t {
     int exact_base_period;      /* if set, pretend that rtapi satisfied our
 				   period request exactly */
     unsigned char lock;         /* hal locking, can be one of the HAL_LOCK_* types */
+    int graph_serial;		/* bumped whenever a link or thread changes */
 } hal_data_t;
 
 /** HAL 'component' type.
@@ -380,9 +381,32 @@ struct hal_funct_entry_t {
     void *arg;			/* argument for function */
     void (*funct) (void *, long);	/* ptr to function code */
     SHMFIELD(hal_funct_t) funct_ptr;		/* pointer to function */
+    int stage;			/* parallel stage, see hal_thread_t */
+    volatile unsigned int claimed;	/* stage word of the last run */
+    volatile unsigned int done;	/* stage word of the last finished run */
 };
 
 #define HAL_STACKSIZE 16384	/* realtime task stacksize */
+#define HAL_MAX_HELPERS 8	/* helper tasks per thread */
+#define HAL_PAR_IDLE 0xff	/* stage part of 'par_word' between cycles */
+#define HAL_PAR_SERIAL 0xfe	/* stage part of claims when a cycle is
+				   finished without the stages */
+
+/* A thread with helper tasks runs its function list in 'stages':
+   functions in one stage do not share signals or a component instance,
+   so they may run in any order or at the same time; each stage only
+   starts after the previous one finished.  The stages are computed by
+   halcmd and only used while 'sched_serial' matches the current
+   'graph_serial', otherwise the thread runs serially as usual.
+   'par_word' holds (cycle << 8) | stage so helpers read both at once;
+   a function entry is claimed and marked done with that word.  Any
+   change of the function list or the signals bumps 'graph_serial'
+   before it is made, and a cycle that sees it change or runs longer
+   than a period is finished serially by the thread task.
+   A helper counts itself in 'par_busy' while it may run functions, so
+   helpers are only deleted once none of them is inside a stage.
+   'helpers' is negated while hal_thread_helpers() waits for that.
+*/
 
 struct hal_thread_t {
     SHMFIELD(hal_thread_t) next_ptr;		/* next thread in linked list */
@@ -395,6 +419,12 @@ struct hal_thread_t {
     hal_list_t funct_list;	/* list of functions to run */
     char name[HAL_NAME_LEN + 1];	/* thread name */
     int comp_id;
+    int helpers;		/* number of helper tasks */
+    int helper_task_id[HAL_MAX_HELPERS];	/* IDs of the helper tasks */
+    int sched_serial;		/* graph_serial the stages were computed for */
+    int stages;			/* number of stages in the schedule */
+    volatile unsigned int par_word;	/* current cycle and stage */
+    volatile int par_busy;	/* helpers between rtapi_wait() calls */
 };
 
 /***********************************************************************
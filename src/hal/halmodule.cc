@@ -20,6 +20,7 @@
 #include <structmember.h>
 #include <string>
 #include <map>
+#include <vector>
 using namespace std;
 
 #include "config.h"
@@ -1821,6 +1822,361 @@ PyTypeObject stream_type = {
 };
 
 
+/* A watch set resolves a list of pin, param and signal names once, and
+   then reads all of their values with a single acquisition of the HAL
+   mutex and without any further name lookups.  The values of the last
+   snapshot are exported through the buffer protocol as an array of C
+   doubles, and snapshot() reports which entries changed. */
+struct watchentry {
+    char kind;                  /* 'p' pin, 's' signal, 'a' param */
+    hal_type_t type;
+    void *obj;                  /* hal_pin_t, hal_sig_t or hal_param_t */
+    std::string name;
+    hal_data_u raw;             /* raw value from the last snapshot */
+};
+
+struct watchobj {
+    PyObject_HEAD
+    std::vector<watchentry> *entries;
+    double *values;
+    Py_ssize_t shape;
+    bool primed;
+    unsigned long snapshots;
+    int exports;
+};
+
+/* must be called with the HAL mutex held */
+static bool watch_resolve(watchentry &e) {
+    const char *name = e.name.c_str();
+    hal_pin_t *pin = halpr_find_pin_by_name(name);
+    if(pin) { e.kind = 'p'; e.type = pin->type; e.obj = pin; return true; }
+    hal_sig_t *sig = halpr_find_sig_by_name(name);
+    if(sig) { e.kind = 's'; e.type = sig->type; e.obj = sig; return true; }
+    hal_param_t *param = halpr_find_param_by_name(name);
+    if(param) { e.kind = 'a'; e.type = param->type; e.obj = param; return true; }
+    return false;
+}
+
+/* must be called with the HAL mutex held.  The cached object is checked
+   against its name so that a pin or signal deleted (and its struct
+   reused) after the watch set was built is looked up again. */
+static void *watch_data_ptr(watchentry &e) {
+    const char *objname;
+    switch(e.kind) {
+        case 'p': objname = ((hal_pin_t *)e.obj)->name; break;
+        case 's': objname = ((hal_sig_t *)e.obj)->name; break;
+        default: objname = ((hal_param_t *)e.obj)->name; break;
+    }
+    if(strcmp(objname, e.name.c_str()) != 0 && !watch_resolve(e))
+        return NULL;
+    switch(e.kind) {
+        case 'p': {
+            hal_pin_t *pin = (hal_pin_t *)e.obj;
+            if(pin->signal != 0) {
+                hal_sig_t *sig = (hal_sig_t*)SHMPTR(pin->signal);
+                return SHMPTR(sig->data_ptr);
+            }
+            return &(pin->dummysig);
+        }
+        case 's': return SHMPTR(((hal_sig_t *)e.obj)->data_ptr);
+        default: return SHMPTR(((hal_param_t *)e.obj)->data_ptr);
+    }
+}
+
+static double watch_as_double(const watchentry &e) {
+    switch(e.type) {
+        case HAL_BIT: return e.raw.b;
+        case HAL_U32: return e.raw.u;
+        case HAL_S32: return e.raw.s;
+        case HAL_U64: return e.raw.lu;
+        case HAL_S64: return e.raw.ls;
+        case HAL_FLOAT: return e.raw.f;
+        default: return 0;
+    }
+}
+
+static PyObject *watch_to_python(const watchentry &e) {
+    switch(e.type) {
+        case HAL_BIT: return to_python((bool)e.raw.b);
+        case HAL_U32: return to_python((hal_u32_t)e.raw.u);
+        case HAL_S32: return to_python((hal_s32_t)e.raw.s);
+        case HAL_U64: return to_python((hal_u64_t)e.raw.lu);
+        case HAL_S64: return to_python((hal_s64_t)e.raw.ls);
+        case HAL_FLOAT: return to_python((double)e.raw.f);
+        default: Py_RETURN_NONE;
+    }
+}
+
+static int pywatch_init(PyObject *_self, PyObject *args, PyObject *kw) {
+    watchobj *self = (watchobj *)_self;
+    PyObject *names;
+
+    if(!PyArg_ParseTuple(args, "O:hal.watch", &names)) return -1;
+    if(!hal_shmem_base) {
+        PyErr_Format(PyExc_RuntimeError,
+                "Cannot call before creating component");
+        return -1;
+    }
+
+    PyObject *seq = PySequence_Fast(names, "hal.watch: expected a sequence of names");
+    if(!seq) return -1;
+
+    std::vector<watchentry> *entries = new std::vector<watchentry>();
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+    entries->resize(n);
+    for(Py_ssize_t i=0; i<n; i++) {
+        const char *name = PyUnicode_AsUTF8(PySequence_Fast_GET_ITEM(seq, i));
+        if(!name) {
+            delete entries;
+            Py_DECREF(seq);
+            return -1;
+        }
+        (*entries)[i].name = name;
+        memset(&(*entries)[i].raw, 0, sizeof(hal_data_u));
+    }
+    Py_DECREF(seq);
+
+    rtapi_mutex_get(&(hal_data->mutex));
+    for(Py_ssize_t i=0; i<n; i++) {
+        if(!watch_resolve((*entries)[i])) {
+            rtapi_mutex_give(&(hal_data->mutex));
+            PyErr_Format(PyExc_RuntimeError,
+                "pin / param / signal %s not found", (*entries)[i].name.c_str());
+            delete entries;
+            return -1;
+        }
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+
+    if(self->exports) {
+        delete entries;
+        PyErr_SetString(PyExc_BufferError, "watch set is exported as a buffer");
+        return -1;
+    }
+    delete self->entries;
+    delete[] self->values;
+    self->entries = entries;
+    self->values = new double[n ? n : 1]();
+    self->shape = n;
+    self->primed = false;
+    self->snapshots = 0;
+    return 0;
+}
+
+static void pywatch_delete(PyObject *_self) {
+    watchobj *self = (watchobj *)_self;
+    delete self->entries;
+    delete[] self->values;
+    Py_TYPE(self)->tp_free(self);
+}
+
+static PyObject *watch_snapshot(PyObject *_self, PyObject *unused) {
+    watchobj *self = (watchobj *)_self;
+    if(!self->entries) {
+        PyErr_SetString(PyExc_RuntimeError, "Invalid operation on uninitialized watch set");
+        return NULL;
+    }
+    std::vector<watchentry> &entries = *self->entries;
+    size_t n = entries.size();
+    std::vector<Py_ssize_t> changed;
+    const char *missing = NULL;
+
+    rtapi_mutex_get(&(hal_data->mutex));
+    for(size_t i=0; i<n; i++) {
+        watchentry &e = entries[i];
+        void *d_ptr = watch_data_ptr(e);
+        if(!d_ptr) { missing = e.name.c_str(); break; }
+        bool differs;
+        switch(e.type) {
+            case HAL_BIT: {
+                hal_bit_t v = *(hal_bit_t *)d_ptr;
+                differs = v != e.raw.b; e.raw.b = v; break;
+            }
+            case HAL_U32: {
+                hal_u32_t v = *(hal_u32_t *)d_ptr;
+                differs = v != e.raw.u; e.raw.u = v; break;
+            }
+            case HAL_S32: {
+                hal_s32_t v = *(hal_s32_t *)d_ptr;
+                differs = v != e.raw.s; e.raw.s = v; break;
+            }
+            case HAL_U64: {
+                hal_u64_t v = *(hal_u64_t *)d_ptr;
+                differs = v != e.raw.lu; e.raw.lu = v; break;
+            }
+            case HAL_S64: {
+                hal_s64_t v = *(hal_s64_t *)d_ptr;
+                differs = v != e.raw.ls; e.raw.ls = v; break;
+            }
+            case HAL_FLOAT: {
+                real_t v = *(hal_float_t *)d_ptr;
+                /* compare bit patterns so that NaN reports once, not forever */
+                differs = memcmp(&v, (const void *)&e.raw.f, sizeof(v)) != 0;
+                e.raw.f = v; break;
+            }
+            default: differs = false; break;
+        }
+        if(differs || !self->primed) changed.push_back(i);
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+
+    if(missing) {
+        PyErr_Format(PyExc_RuntimeError,
+            "pin / param / signal %s no longer exists", missing);
+        return NULL;
+    }
+
+    self->primed = true;
+    self->snapshots++;
+
+    PyObject *r = PyTuple_New(changed.size());
+    if(!r) return NULL;
+    for(size_t i=0; i<changed.size(); i++) {
+        self->values[changed[i]] = watch_as_double(entries[changed[i]]);
+        PyObject *o = PyLong_FromSsize_t(changed[i]);
+        if(!o) { Py_DECREF(r); return NULL; }
+        PyTuple_SET_ITEM(r, i, o);
+    }
+    return r;
+}
+
+static PyObject *watch_values(PyObject *_self, PyObject *unused) {
+    watchobj *self = (watchobj *)_self;
+    if(!self->entries) {
+        PyErr_SetString(PyExc_RuntimeError, "Invalid operation on uninitialized watch set");
+        return NULL;
+    }
+    std::vector<watchentry> &entries = *self->entries;
+    PyObject *r = PyTuple_New(entries.size());
+    if(!r) return NULL;
+    for(size_t i=0; i<entries.size(); i++) {
+        PyObject *o = watch_to_python(entries[i]);
+        if(!o) { Py_DECREF(r); return NULL; }
+        PyTuple_SET_ITEM(r, i, o);
+    }
+    return r;
+}
+
+static PyObject *watch_names(PyObject *_self, PyObject *unused) {
+    watchobj *self = (watchobj *)_self;
+    if(!self->entries) return PyTuple_New(0);
+    std::vector<watchentry> &entries = *self->entries;
+    PyObject *r = PyTuple_New(entries.size());
+    if(!r) return NULL;
+    for(size_t i=0; i<entries.size(); i++) {
+        PyObject *o = PyUnicode_FromString(entries[i].name.c_str());
+        if(!o) { Py_DECREF(r); return NULL; }
+        PyTuple_SET_ITEM(r, i, o);
+    }
+    return r;
+}
+
+static Py_ssize_t pywatch_len(PyObject *_self) {
+    watchobj *self = (watchobj *)_self;
+    return self->entries ? self->entries->size() : 0;
+}
+
+static int watch_buffer_getbuffer(PyObject *obj, Py_buffer *view, int flags) {
+    watchobj *self = (watchobj *)obj;
+    if(!self->entries) {
+        PyErr_SetString(PyExc_BufferError, "uninitialized watch set");
+        return -1;
+    }
+    if((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "watch set buffer is read-only");
+        return -1;
+    }
+    view->obj = obj;
+    view->buf = (void*)self->values;
+    view->len = self->shape * sizeof(double);
+    view->readonly = 1;
+    view->itemsize = sizeof(double);
+    view->format = (flags & PyBUF_FORMAT) ? (char*)"d" : NULL;
+    view->ndim = 1;
+    view->shape = (flags & PyBUF_ND) ? &self->shape : NULL;
+    view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? &view->itemsize : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    self->exports++;
+    Py_INCREF(obj);
+    return 0;
+}
+
+static void watch_buffer_releasebuffer(PyObject *obj, Py_buffer *view) {
+    watchobj *self = (watchobj *)obj;
+    self->exports--;
+}
+
+static PyObject *pywatch_repr(PyObject *_self) {
+    watchobj *self = (watchobj *)_self;
+    return PyUnicode_FromFormat("<hal watch set of %zd items, %lu snapshots>",
+            pywatch_len(_self), self->snapshots);
+}
+
+static PyBufferProcs watchbuffer_procs = {
+    (getbufferproc)watch_buffer_getbuffer,         /* bf_getbuffer */
+    (releasebufferproc)watch_buffer_releasebuffer, /* bf_releasebuffer */
+};
+
+static PySequenceMethods watch_sequence = {
+    pywatch_len,               /* sq_length */
+};
+
+static PyMethodDef watch_methods[] = {
+    {"snapshot", watch_snapshot, METH_NOARGS,
+        "Read all values; return a tuple of the indices that changed since the last snapshot"},
+    {"values", watch_values, METH_NOARGS,
+        "Return the values of the last snapshot as a tuple of Python values"},
+    {"names", watch_names, METH_NOARGS,
+        "Return the watched names as a tuple"},
+    {NULL},
+};
+
+static
+PyTypeObject watch_type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "hal.watch",               /*tp_name*/
+    sizeof(watchobj),          /*tp_basicsize*/
+    0,                         /*tp_itemsize*/
+    pywatch_delete,            /*tp_dealloc*/
+    0,                         /*tp_print*/
+    0,                         /*tp_getattr*/
+    0,                         /*tp_setattr*/
+    0,                         /*tp_compare*/
+    pywatch_repr,              /*tp_repr*/
+    0,                         /*tp_as_number*/
+    &watch_sequence,           /*tp_as_sequence*/
+    0,                         /*tp_as_mapping*/
+    0,                         /*tp_hash */
+    0,                         /*tp_call*/
+    0,                         /*tp_str*/
+    0,                         /*tp_getattro*/
+    0,                         /*tp_setattro*/
+    &watchbuffer_procs,        /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT,        /*tp_flags*/
+    "HAL Watch Set",           /*tp_doc*/
+    0,                         /*tp_traverse*/
+    0,                         /*tp_clear*/
+    0,                         /*tp_richcompare*/
+    0,                         /*tp_weaklistoffset*/
+    0,                         /*tp_iter*/
+    0,                         /*tp_iternext*/
+    watch_methods,             /*tp_methods*/
+    0,                         /*tp_members*/
+    0,                         /*tp_getset*/
+    0,                         /*tp_base*/
+    0,                         /*tp_dict*/
+    0,                         /*tp_descr_get*/
+    0,                         /*tp_descr_set*/
+    0,                         /*tp_dictoffset*/
+    pywatch_init,              /*tp_init*/
+    0,                         /*tp_alloc*/
+    PyType_GenericNew,         /*tp_new*/
+    0,                         /*tp_free*/
+    0,                         /*tp_is_gc*/
+};
+
+
 PyMethodDef module_methods[] = {
     {"pin_has_writer", pin_has_writer, METH_VARARGS,
 	".pin_has_writer('pin_name'): Return a FALSE value if a pin has no writers and TRUE if it does"},
@@ -1898,10 +2254,12 @@ PyMODINIT_FUNC PyInit__hal(void)
     PyType_Ready(&shm_type);
     PyType_Ready(&halpin_type);
     PyType_Ready(&stream_type);
+    PyType_Ready(&watch_type);
     PyModule_AddObject(m, "component", (PyObject*)&halobject_type);
     PyModule_AddObject(m, "shm", (PyObject*)&shm_type);
     PyModule_AddObject(m, "item", (PyObject*)&halpin_type);
     PyModule_AddObject(m, "stream", (PyObject*)&stream_type);
+    PyModule_AddObject(m, "watch", (PyObject*)&watch_type);
 
     PyModule_AddIntConstant(m, "MSG_NONE", RTAPI_MSG_NONE);
     PyModule_AddIntConstant(m, "MSG_ERR", RTAPI_MSG_ERR);
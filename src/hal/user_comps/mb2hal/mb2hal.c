@@ -127,12 +127,14 @@ QUIT_CLEANUP:
 void *link_loop_and_logic(void *thrd_link_num)
 {
     char *fnct_name = "link_loop_and_logic";
-    int ret, ret_available, ret_connected;
+    int ret, ret_connected;
     int tx_counter;
     mb_tx_t   *this_mb_tx = NULL;
     int        this_mb_tx_num;
     mb_link_t *this_mb_link = NULL;
     int        this_mb_link_num;
+    mb_tx_t   *co_mb_tx;
+    double     wait_time, start_time, end_time;
 
     if (thrd_link_num == NULL) {
         ERR(gbl.init_dbg, "NULL pointer");
@@ -147,127 +149,153 @@ void *link_loop_and_logic(void *thrd_link_num)
 
     while (1) {
 
-        for (tx_counter = 0; tx_counter < gbl.tot_mb_tx; tx_counter++) {
+        if (gbl.quit_flag != 0) { //tell the threads to quit (SIGTERM o SGIQUIT) (unloadusr mb2hal).
+            return NULL;
+        }
 
-            if (gbl.quit_flag != 0) { //tell the threads to quit (SIGTERM o SGIQUIT) (unloadusr mb2hal).
-                return NULL;
+        //the most overdue tx of this link (update_rate), or sleep until the next one is due
+        if (get_next_tx(this_mb_link_num, &this_mb_tx_num, &wait_time) != retOK) {
+            ERR(gbl.init_dbg, "mb_links[%d] thread[%d] fd[%d] get_next_tx ERR",
+                this_mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
+            return NULL;
+        }
+        if (this_mb_tx_num < 0) {
+            if (wait_time > MB2HAL_MAX_IDLE_WAIT_S) {
+                wait_time = MB2HAL_MAX_IDLE_WAIT_S;
             }
+            usleep(wait_time * 1000 * 1000);
+            continue;
+        }
+        this_mb_tx = &gbl.mb_tx[this_mb_tx_num];
 
-            this_mb_tx_num = tx_counter;
-            this_mb_tx = &gbl.mb_tx[this_mb_tx_num];
+        DBGMAX(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] going to TEST connection",
+            this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
 
-            DBGMAX(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] going to TEST availability",
+        //first time connection or reconnection, run time parameters setting
+        if (get_tx_connection(this_mb_tx_num, &ret_connected) != retOK) {
+            ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] get_tx_connection ERR",
                 this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
-
-            //corresponding link and time (update_rate)
-            if (is_this_tx_ready(this_mb_link_num, this_mb_tx_num, &ret_available) != retOK) {
-                ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] is_this_tx_ready ERR",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
-                return NULL;
-            }
-            if (ret_available == 0) {
-                DBGMAX(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] NOT available",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
-                usleep(1000);
-                continue;
-            }
-
-            DBGMAX(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] going to TEST connection",
+            return NULL;
+        }
+        if (ret_connected == 0) {
+            DBGMAX(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] NOT connected",
                 this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
+            //let the other tx of this link try (and count) the connection too
+            this_mb_tx->next_time = get_time() + this_mb_tx->time_increment;
+            usleep(1000);
+            continue;
+        }
 
-            //first time connection or reconnection, run time parameters setting
-            if (get_tx_connection(this_mb_tx_num, &ret_connected) != retOK) {
-                ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] get_tx_connection ERR",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
-                return NULL;
-            }
-            if (ret_connected == 0) {
-                DBGMAX(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] NOT connected",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
-                usleep(1000);
-                continue;
-            }
+        DBGMAX(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] lk_dbg[%d] going to EXECUTE transaction",
+            this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus),
+            this_mb_tx->protocol_debug);
+
+        start_time = get_time();
+
+        switch (this_mb_tx->mb_tx_fnct) {
+
+        case mbtx_01_READ_COILS:
+            ret = fnct_01_read_coils(this_mb_tx, this_mb_link);
+            break;
+        case mbtx_02_READ_DISCRETE_INPUTS:
+            ret = fnct_02_read_discrete_inputs(this_mb_tx, this_mb_link);
+            break;
+        case mbtx_03_READ_HOLDING_REGISTERS:
+            ret = fnct_03_read_holding_registers(this_mb_tx, this_mb_link);
+            break;
+        case mbtx_04_READ_INPUT_REGISTERS:
+            ret = fnct_04_read_input_registers(this_mb_tx, this_mb_link);
+            break;
+        case mbtx_05_WRITE_SINGLE_COIL:
+            ret = fnct_05_write_single_coil(this_mb_tx, this_mb_link);
+            break;
+        case mbtx_06_WRITE_SINGLE_REGISTER:
+            ret = fnct_06_write_single_register(this_mb_tx, this_mb_link);
+            break;
+        case mbtx_15_WRITE_MULTIPLE_COILS:
+            ret = fnct_15_write_multiple_coils(this_mb_tx, this_mb_link);
+            break;
+        case mbtx_16_WRITE_MULTIPLE_REGISTERS:
+            ret = fnct_16_write_multiple_registers(this_mb_tx, this_mb_link);
+            break;
+        default:
+            ret = -1;
+            ERR(this_mb_tx->cfg_debug, "case error with mb_tx_fnct %d [%s] in mb_tx_num[%d]",
+                this_mb_tx->mb_tx_fnct, this_mb_tx->mb_tx_fnct_name, this_mb_tx_num);
+            break;
+        }
 
-            DBGMAX(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] lk_dbg[%d] going to EXECUTE transaction",
-                this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus),
-                this_mb_tx->protocol_debug);
-
-            switch (this_mb_tx->mb_tx_fnct) {
-
-            case mbtx_01_READ_COILS:
-                ret = fnct_01_read_coils(this_mb_tx, this_mb_link);
-                break;
-            case mbtx_02_READ_DISCRETE_INPUTS:
-                ret = fnct_02_read_discrete_inputs(this_mb_tx, this_mb_link);
-                break;
-            case mbtx_03_READ_HOLDING_REGISTERS:
-                ret = fnct_03_read_holding_registers(this_mb_tx, this_mb_link);
-                break;
-            case mbtx_04_READ_INPUT_REGISTERS:
-                ret = fnct_04_read_input_registers(this_mb_tx, this_mb_link);
-                break;
-            case mbtx_05_WRITE_SINGLE_COIL:
-                ret = fnct_05_write_single_coil(this_mb_tx, this_mb_link);
-                break;
-            case mbtx_06_WRITE_SINGLE_REGISTER:
-                ret = fnct_06_write_single_register(this_mb_tx, this_mb_link);
-                break;
-            case mbtx_15_WRITE_MULTIPLE_COILS:
-                ret = fnct_15_write_multiple_coils(this_mb_tx, this_mb_link);
-                break;
-            case mbtx_16_WRITE_MULTIPLE_REGISTERS:
-                ret = fnct_16_write_multiple_registers(this_mb_tx, this_mb_link);
-                break;
-            default:
-                ret = -1;
-                ERR(this_mb_tx->cfg_debug, "case error with mb_tx_fnct %d [%s] in mb_tx_num[%d]",
-                    this_mb_tx->mb_tx_fnct, this_mb_tx->mb_tx_fnct_name, this_mb_tx_num);
-                break;
-            }
+        end_time = get_time();
 
-            if (gbl.quit_flag != 0) { //tell the threads to quit (SIGTERM o SGIQUIT) (unloadusr mb2hal).
-                return NULL;
-            }
+        if (gbl.quit_flag != 0) { //tell the threads to quit (SIGTERM o SGIQUIT) (unloadusr mb2hal).
+            return NULL;
+        }
 
-            if (ret != retOK && modbus_get_socket(this_mb_link->modbus) < 0) { //link failure
-                (**this_mb_tx->num_errors)++;
-                ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] link failure, going to close link",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
-                modbus_close(this_mb_link->modbus);
+        if (ret == retOKwithWarning) { //WRITE_ON_CHANGE and unchanged HAL values, nothing was sent
+            DBGMAX(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] unchanged, write skipped",
+                this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
+            this_mb_tx->next_time = end_time + (this_mb_tx->time_increment > MB2HAL_MIN_POLL_TIME_S ?
+                                                this_mb_tx->time_increment : MB2HAL_MIN_POLL_TIME_S);
+            continue;
+        }
+
+        if (ret != retOK && modbus_get_socket(this_mb_link->modbus) < 0) { //link failure
+            (**this_mb_tx->num_errors)++;
+            ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] link failure, going to close link",
+                this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
+            modbus_close(this_mb_link->modbus);
+        }
+        else if (ret != retOK) {  //transaction failure but link OK
+            (**this_mb_tx->num_errors)++;
+            ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] transaction failure, num_errors[%d]",
+                this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus), **this_mb_tx->num_errors);
+            // Clear any unread data. Otherwise the link might get out of sync
+            modbus_flush(this_mb_link->modbus);
+        }
+        else { //transaction and link OK
+            OK(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] transaction OK, update_HZ[%0.03f]",
+               this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus),
+               1.0/(end_time-this_mb_tx->last_time_ok));
+            if (this_mb_tx->last_time_ok > 0) {
+                **this_mb_tx->rate_hz = 1.0 / (end_time - this_mb_tx->last_time_ok);
             }
-            else if (ret != retOK) {  //transaction failure but link OK
-                (**this_mb_tx->num_errors)++;
-                ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] transaction failure, num_errors[%d]",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus), **this_mb_tx->num_errors);
-                // Clear any unread data. Otherwise the link might get out of sync
-                modbus_flush(this_mb_link->modbus);
+            **this_mb_tx->latency_ms = (end_time - start_time) * 1000.0;
+            if (**this_mb_tx->latency_ms > **this_mb_tx->max_latency_ms) {
+                **this_mb_tx->max_latency_ms = **this_mb_tx->latency_ms;
             }
-            else { //transaction and link OK
-                OK(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] transaction OK, update_HZ[%0.03f]",
-                   this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus),
-                   1.0/(get_time()-this_mb_tx->last_time_ok));
-                this_mb_tx->last_time_ok = get_time();
-                (**this_mb_tx->num_errors) = 0;
+            this_mb_tx->last_time_ok = end_time;
+            (**this_mb_tx->num_errors) = 0;
+        }
+
+        //coalesced tx were read by this one, same result
+        for (tx_counter = this_mb_tx_num + 1; tx_counter < gbl.tot_mb_tx; tx_counter++) {
+            co_mb_tx = &gbl.mb_tx[tx_counter];
+            if (co_mb_tx->coalesce_leader != this_mb_tx_num) {
+                continue;
             }
+            **co_mb_tx->num_errors     = **this_mb_tx->num_errors;
+            **co_mb_tx->latency_ms     = **this_mb_tx->latency_ms;
+            **co_mb_tx->max_latency_ms = **this_mb_tx->max_latency_ms;
+            **co_mb_tx->rate_hz        = **this_mb_tx->rate_hz;
+        }
 
-            //set the next (waiting) time for update rate
-            this_mb_tx->next_time = get_time() + this_mb_tx->time_increment;
+        //set the next (waiting) time for update rate
+        this_mb_tx->next_time = get_time() + this_mb_tx->time_increment;
 
-            //wait time for serial lines
-            if (this_mb_tx->cfg_link_type == linkRTU) {
-                DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] SERIAL_DELAY_MS activated [%d]",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus),
-                    this_mb_tx->cfg_serial_delay_ms);
-                usleep(this_mb_tx->cfg_serial_delay_ms * 1000);
-            }
+        //wait time for serial lines
+        if (this_mb_tx->cfg_link_type == linkRTU) {
+            DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] SERIAL_DELAY_MS activated [%d]",
+                this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus),
+                this_mb_tx->cfg_serial_delay_ms);
+            usleep(this_mb_tx->cfg_serial_delay_ms * 1000);
+        }
 
-            //wait time to gbl.slowdown activity (debugging)
-            if (gbl.slowdown > 0) {
-                DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] gbl.slowdown activated [%0.3f]",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus), gbl.slowdown);
-                usleep(gbl.slowdown * 1000 * 1000);
-            }
-        }  //end for
+        //wait time to gbl.slowdown activity (debugging)
+        if (gbl.slowdown > 0) {
+            DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] gbl.slowdown activated [%0.3f]",
+                this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus), gbl.slowdown);
+            usleep(gbl.slowdown * 1000 * 1000);
+        }
 
     } //end while
 
@@ -275,45 +303,53 @@ void *link_loop_and_logic(void *thrd_link_num)
 }
 
 /*
- * Check if the transaction is available for this link
+ * Get the transaction of this link to run now: the one waiting for the
+ * longest time, so each tx gets its own update rate and the others are
+ * served round robin. If none is due, ret_wait is the time to wait.
+ * Coalesced tx are read by another tx and never run by themselves.
  */
 
-retCode is_this_tx_ready(const int this_mb_link_num, const int this_mb_tx_num, int *ret_available)
+retCode get_next_tx(const int this_mb_link_num, int *ret_mb_tx_num, double *ret_wait)
 {
-    char *fnct_name = "is_this_tx_available";
+    char *fnct_name = "get_next_tx";
     mb_tx_t *this_mb_tx;
-    int this_mb_tx_link_num;
+    int tx_counter;
+    double now, next_time = 0;
 
-    if (this_mb_tx_num < 0 || this_mb_tx_num > gbl.tot_mb_tx) {
-        ERR(gbl.init_dbg, "parameter out of range this_mb_tx_num[%d]", this_mb_tx_num);
+    if (ret_mb_tx_num == NULL || ret_wait == NULL) {
+        ERR(gbl.init_dbg, "NULL pointer");
         return retERR;
     }
-    this_mb_tx = &gbl.mb_tx[this_mb_tx_num];
 
-    if (ret_available == NULL) {
-        ERR(this_mb_tx->cfg_debug, "NULL pointer");
-        return retERR;
-    }
+    *ret_mb_tx_num = -1; //defaults to not available
+    *ret_wait = MB2HAL_MAX_IDLE_WAIT_S;
 
-    this_mb_tx_link_num = this_mb_tx->mb_link_num;
-    if (this_mb_tx_link_num < 0 || this_mb_tx_link_num >= gbl.tot_mb_links) {
-        ERR(this_mb_tx->cfg_debug, "parameter out of range this_mb_tx_link_num[%d]", this_mb_tx_link_num);
-        return retERR;
-    }
+    for (tx_counter = 0; tx_counter < gbl.tot_mb_tx; tx_counter++) {
+        this_mb_tx = &gbl.mb_tx[tx_counter];
 
-    *ret_available = 0; //defaults to not available
+        //the tx is not of this link or it is coalesced
+        if (this_mb_tx->mb_link_num != this_mb_link_num || this_mb_tx->coalesce_leader >= 0) {
+            continue;
+        }
+        if (*ret_mb_tx_num < 0 || this_mb_tx->next_time < next_time) {
+            *ret_mb_tx_num = tx_counter;
+            next_time = this_mb_tx->next_time;
+        }
+    }
 
-    //the tx is not of this link
-    if (this_mb_link_num != this_mb_tx_link_num) {
+    if (*ret_mb_tx_num < 0) {
         return retOK;
     }
 
     //not now
-    if (get_time() < this_mb_tx->next_time) {
+    now = get_time();
+    if (now < next_time) {
+        *ret_mb_tx_num = -1;
+        *ret_wait = next_time - now;
         return retOK;
     }
 
-    *ret_available = 1; //is available
+    *ret_wait = 0;
     return retOK;
 }
 
@@ -359,6 +395,7 @@ retCode get_tx_connection(const int this_mb_tx_num, int *ret_connected)
                 this_mb_tx_num, this_mb_tx->mb_link_num, ret, modbus_get_socket(this_mb_link->modbus));
             return retOK; //not connected
         }
+        this_mb_link->connect_num++; //WRITE_ON_CHANGE tx have to be written again
         DBGMAX(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] new connection -> fd[%d]",
             this_mb_tx_num, this_mb_tx->mb_link_num, modbus_get_socket(this_mb_link->modbus));
     }
@@ -30,6 +30,8 @@
 #define MB2HAL_MAX_FNCT06_ELEMENTS 1
 #define MB2HAL_MAX_FNCT15_ELEMENTS 100
 #define MB2HAL_MAX_FNCT16_ELEMENTS 100
+#define MB2HAL_MAX_IDLE_WAIT_S    0.1   //max sleep of a link thread (quit_flag response)
+#define MB2HAL_MIN_POLL_TIME_S    0.001 //poll time of unchanged WRITE_ON_CHANGE transactions
 
 #ifdef MODULE_VERBOSE
 MODULE_VERBOSE(emc2, "component:mb2hal:Userspace HAL component to communicate with one or more Modbus devices");
@@ -89,6 +91,7 @@ typedef struct {
     int        mb_byte_timeout_ms;     //MB byte timeout
     //cfg_* are others INI config params
     double cfg_update_rate;    //tx update rate
+    int    cfg_write_on_change; //write tx only sent when the HAL values changed
     int    cfg_debug;          //tx debug level (program, may be also protocol)
     //Modbus protocol debug
     int  protocol_debug;       //Flag debug Modbus protocol
@@ -99,6 +102,14 @@ typedef struct {
     double time_increment; //wait time between tx
     double next_time;      //next time for this tx
     double last_time_ok;   //last OK tx time
+    //coalesced read transactions (COALESCE=1)
+    int coalesce_leader;   //tx that reads this one as part of its own request, -1 = none
+    int co_1st_addr;       //MB first register read, including the coalesced tx
+    int co_nelem;          //MB n registers read, including the coalesced tx
+    //write on change (WRITE_ON_CHANGE=1)
+    uint8_t last_data[MB2HAL_MAX_FNCT16_ELEMENTS * sizeof(uint16_t)]; //last written data
+    int last_data_valid;   //last_data is known to be in the device
+    int last_connect_num;  //link connection when last_data was written
     //HAL related params
     char hal_tx_name[HAL_NAME_LEN + 1];
     hal_float_t **float_value;
@@ -108,6 +119,9 @@ typedef struct {
     hal_bit_t **bit;
     hal_bit_t **bit_inv;
     hal_u32_t **num_errors;     //num of acummulated errors (0=last tx OK)
+    hal_float_t **latency_ms;     //last OK tx round trip time
+    hal_float_t **max_latency_ms; //worst OK tx round trip time
+    hal_float_t **rate_hz;        //actual update rate
 } mb_tx_t;
 
 //Modbus link structure (mb_link_t)
@@ -128,6 +142,7 @@ typedef struct {
     int  lp_tcp_port;         //tcp port number
     //run time processing values
     int mb_link_num;       //corresponding number of this link/thread
+    int connect_num;       //incremented on each (re)connection
     modbus_t *modbus;
     pthread_t thrd;
 } mb_link_t;
@@ -142,6 +157,7 @@ typedef struct {
     int   init_dbg;
     int   version;
     double slowdown;
+    int   coalesce;
     //HAL related
     int   hal_mod_id;
     char *hal_mod_name;
@@ -160,7 +176,7 @@ extern gbl_t gbl;
 
 //mb2hal.c
 void *link_loop_and_logic(void *thrd_link_num);
-retCode is_this_tx_ready(const int this_mb_link_num, const int this_mb_tx_num, int *ret_available);
+retCode get_next_tx(const int this_mb_link_num, int *ret_mb_tx_num, double *ret_wait);
 retCode get_tx_connection(const int mb_tx_num, int *ret_connected);
 void set_init_gbl_params();
 double get_time();
@@ -178,6 +194,7 @@ retCode check_int_in(int n_args, const int int_value, ...);
 retCode check_str_in(int n_args, const char *str_value, ...);
 retCode init_mb_links();
 retCode init_mb_tx();
+retCode coalesce_mb_tx();
 
 //mb2hal_hal.c
 retCode create_HAL_pins();
@@ -1,5 +1,29 @@
 #include "mb2hal.h"
 
+static retCode create_tx_float_out_pin(mb_tx_t *mb_tx, hal_float_t ***pin, const char *pin_suffix)
+{
+    char *fnct_name = "create_tx_float_out_pin";
+    char hal_pin_name[HAL_NAME_LEN + 1];
+    int ret;
+
+    *pin = hal_malloc(sizeof(hal_float_t *));
+    if (*pin == NULL) {
+        ERR(gbl.init_dbg, "[%d] [%s] NULL hal_malloc %s",
+            mb_tx->mb_tx_fnct, mb_tx->mb_tx_fnct_name, pin_suffix);
+        return retERR;
+    }
+    memset(*pin, 0, sizeof(hal_float_t *));
+    ret = snprintf(hal_pin_name, HAL_NAME_LEN, "%s.%s.%s", gbl.hal_mod_name, mb_tx->hal_tx_name, pin_suffix);
+    if (ret >= HAL_NAME_LEN || ret < 0 || 0 != hal_pin_float_newf(HAL_OUT, *pin, gbl.hal_mod_id, "%s", hal_pin_name)) {
+        ERR(gbl.init_dbg, "[%d] [%s] [%s] hal_pin_float_newf failed", mb_tx->mb_tx_fnct, mb_tx->mb_tx_fnct_name, hal_pin_name);
+        return retERR;
+    }
+    **pin = 0;
+    DBG(gbl.init_dbg, "mb_tx_num [%d] pin_name [%s]", mb_tx->mb_tx_num, hal_pin_name);
+
+    return retOK;
+}
+
 retCode create_HAL_pins()
 {
     char *fnct_name = "create_HAL_pins";
@@ -44,6 +68,13 @@ retCode create_each_mb_tx_hal_pins(mb_tx_t *mb_tx)
     **(mb_tx->num_errors) = 0;
     DBG(gbl.init_dbg, "mb_tx_num [%d] pin_name [%s]", mb_tx->mb_tx_num, hal_pin_name);
 
+    //statistics hal pins
+    if (create_tx_float_out_pin(mb_tx, &mb_tx->latency_ms, "latency_ms") != retOK
+            || create_tx_float_out_pin(mb_tx, &mb_tx->max_latency_ms, "max_latency_ms") != retOK
+            || create_tx_float_out_pin(mb_tx, &mb_tx->rate_hz, "rate_hz") != retOK) {
+        return retERR;
+    }
+
     switch (mb_tx->mb_tx_fnct) {
 
     case mbtx_01_READ_COILS:
@@ -110,6 +110,10 @@ retCode parse_common_section()
     iniFindDouble(gbl.ini_file_ptr, tag, section, &gbl.slowdown);
     DBG(gbl.init_dbg, "[%s] [%s] [%0.3f]", section, tag, gbl.slowdown);
 
+    tag     = "COALESCE"; //optional
+    iniFindInt(gbl.ini_file_ptr, tag, section, &gbl.coalesce);
+    DBG(gbl.init_dbg, "[%s] [%s] [%d]", section, tag, gbl.coalesce);
+
     tag     = "TOTAL_TRANSACTIONS"; //required
     if (iniFindInt(gbl.ini_file_ptr, tag, section, &gbl.tot_mb_tx) != 0) {
         ERR(gbl.init_dbg, "required [%s] [%s] not found", section, tag);
@@ -331,6 +335,17 @@ retCode parse_transaction_section(const int mb_tx_num)
     }
     DBG(gbl.init_dbg, "[%s] [%s] [%d]", section, tag, this_mb_tx->mb_byte_timeout_ms);
 
+    tag = "WRITE_ON_CHANGE"; //optional
+    this_mb_tx->cfg_write_on_change = 0; //default: write every time
+    if (iniFindInt(gbl.ini_file_ptr, tag, section, &this_mb_tx->cfg_write_on_change) != 0) { //not found
+        if (mb_tx_num > 0) { //previous value?
+            if (strcasecmp(this_mb_tx->cfg_link_type_str, gbl.mb_tx[mb_tx_num-1].cfg_link_type_str) == 0) {
+                this_mb_tx->cfg_write_on_change = gbl.mb_tx[mb_tx_num-1].cfg_write_on_change;
+            }
+        }
+    }
+    DBG(gbl.init_dbg, "[%s] [%s] [%d]", section, tag, this_mb_tx->cfg_write_on_change);
+
     tag = "DEBUG"; //optional
     this_mb_tx->cfg_debug = debugERR; //default
     if (iniFindInt(gbl.ini_file_ptr, tag, section, &this_mb_tx->cfg_debug) != 0) { //not found
@@ -787,10 +802,99 @@ retCode init_mb_tx()
         }
         this_mb_tx->next_time = 0; //next time for this tx
 
+        this_mb_tx->coalesce_leader = -1; //reads its own registers
+        this_mb_tx->co_1st_addr = this_mb_tx->mb_tx_1st_addr;
+        this_mb_tx->co_nelem    = this_mb_tx->mb_tx_nelem;
+
         DBG(gbl.init_dbg, "MB_TX %d lk_n[%d] tx_n[%d] cfg_dbg[%d] lk_dbg[%d] t_inc[%0.3f] nxt_t[%0.3f]",
             tx_counter, this_mb_tx->mb_link_num, this_mb_tx->mb_tx_num, this_mb_tx->cfg_debug,
             this_mb_tx->protocol_debug, this_mb_tx->time_increment, this_mb_tx->next_time);
     }
 
+    if (gbl.coalesce != 0) {
+        return coalesce_mb_tx();
+    }
+
+    return retOK;
+}
+
+/*
+ * COALESCE=1: read transactions of the same link, slave, function code,
+ * update rate and timeouts whose registers are adjacent or overlapped are
+ * read by only one Modbus request (the lowest tx number of the group).
+ */
+retCode coalesce_mb_tx()
+{
+    char *fnct_name="coalesce_mb_tx";
+    int tx_counter, co_counter, merged;
+    int co_end, max_nelem;
+    mb_tx_t   *this_mb_tx, *co_mb_tx;
+
+    for (tx_counter = 0; tx_counter < gbl.tot_mb_tx; tx_counter++) {
+        this_mb_tx = &gbl.mb_tx[tx_counter];
+
+        if (this_mb_tx->coalesce_leader >= 0) { //already read by another tx
+            continue;
+        }
+        switch (this_mb_tx->mb_tx_fnct) {
+        case mbtx_01_READ_COILS:
+            max_nelem = MB2HAL_MAX_FNCT01_ELEMENTS;
+            break;
+        case mbtx_02_READ_DISCRETE_INPUTS:
+            max_nelem = MB2HAL_MAX_FNCT02_ELEMENTS;
+            break;
+        case mbtx_03_READ_HOLDING_REGISTERS:
+            max_nelem = MB2HAL_MAX_FNCT03_ELEMENTS;
+            break;
+        case mbtx_04_READ_INPUT_REGISTERS:
+            max_nelem = MB2HAL_MAX_FNCT04_ELEMENTS;
+            break;
+        default: //write transactions are never coalesced
+            continue;
+        }
+
+        //repeat until no more tx can be added, every merge grows the range
+        do {
+            merged = 0;
+            for (co_counter = tx_counter + 1; co_counter < gbl.tot_mb_tx; co_counter++) {
+                co_mb_tx = &gbl.mb_tx[co_counter];
+
+                if (co_mb_tx->coalesce_leader >= 0
+                        || co_mb_tx->mb_link_num != this_mb_tx->mb_link_num
+                        || co_mb_tx->mb_tx_slave_id != this_mb_tx->mb_tx_slave_id
+                        || co_mb_tx->mb_tx_fnct != this_mb_tx->mb_tx_fnct
+                        || co_mb_tx->cfg_update_rate != this_mb_tx->cfg_update_rate
+                        || co_mb_tx->mb_response_timeout_ms != this_mb_tx->mb_response_timeout_ms
+                        || co_mb_tx->mb_byte_timeout_ms != this_mb_tx->mb_byte_timeout_ms) {
+                    continue;
+                }
+                //adjacent or overlapped registers only, no gaps
+                co_end = this_mb_tx->co_1st_addr + this_mb_tx->co_nelem;
+                if (co_mb_tx->mb_tx_1st_addr > co_end
+                        || co_mb_tx->mb_tx_1st_addr + co_mb_tx->mb_tx_nelem < this_mb_tx->co_1st_addr) {
+                    continue;
+                }
+                if (co_mb_tx->mb_tx_1st_addr + co_mb_tx->mb_tx_nelem > co_end) {
+                    co_end = co_mb_tx->mb_tx_1st_addr + co_mb_tx->mb_tx_nelem;
+                }
+                if (co_mb_tx->mb_tx_1st_addr < this_mb_tx->co_1st_addr) {
+                    if (co_end - co_mb_tx->mb_tx_1st_addr > max_nelem) {
+                        continue;
+                    }
+                    this_mb_tx->co_1st_addr = co_mb_tx->mb_tx_1st_addr;
+                }
+                else if (co_end - this_mb_tx->co_1st_addr > max_nelem) {
+                    continue;
+                }
+                this_mb_tx->co_nelem = co_end - this_mb_tx->co_1st_addr;
+                co_mb_tx->coalesce_leader = tx_counter;
+                merged = 1;
+
+                DBG(gbl.init_dbg, "MB_TX %d coalesced into MB_TX %d 1st_addr[%d] nelem[%d]",
+                    co_counter, tx_counter, this_mb_tx->co_1st_addr, this_mb_tx->co_nelem);
+            }
+        } while (merged != 0);
+    }
+
     return retOK;
 }
@@ -1,24 +1,67 @@
 #include <sys/time.h>
 #include "mb2hal.h"
 
+/*
+ * Next tx coalesced into this_mb_tx (COALESCE=1) after prev_mb_tx,
+ * NULL if no more.
+ */
+
+static mb_tx_t *next_coalesced_tx(mb_tx_t *this_mb_tx, mb_tx_t *prev_mb_tx)
+{
+    int tx_counter;
+
+    for (tx_counter = prev_mb_tx->mb_tx_num + 1; tx_counter < gbl.tot_mb_tx; tx_counter++) {
+        if (gbl.mb_tx[tx_counter].coalesce_leader == this_mb_tx->mb_tx_num) {
+            return &gbl.mb_tx[tx_counter];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * WRITE_ON_CHANGE=1: true if data was already written to the device
+ * in this connection and the last write was OK.
+ */
+
+static int is_write_unchanged(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link, const void *data, size_t size)
+{
+    return this_mb_tx->cfg_write_on_change != 0
+           && this_mb_tx->last_data_valid != 0
+           && this_mb_tx->last_connect_num == this_mb_link->connect_num
+           && memcmp(this_mb_tx->last_data, data, size) == 0;
+}
+
+static void set_write_done(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link, const void *data, size_t size, int ok)
+{
+    if (ok && size <= sizeof(this_mb_tx->last_data)) {
+        memcpy(this_mb_tx->last_data, data, size);
+        this_mb_tx->last_connect_num = this_mb_link->connect_num;
+        this_mb_tx->last_data_valid = 1;
+    }
+    else {
+        this_mb_tx->last_data_valid = 0; //unknown, write again
+    }
+}
+
 retCode fnct_01_read_coils(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link)
 {
     char *fnct_name = "fnct_01_read_coils";
-    int counter, ret;
+    int counter, offset, ret;
+    mb_tx_t *co_mb_tx;
     uint8_t bits[MB2HAL_MAX_FNCT01_ELEMENTS];
 
     if (this_mb_tx == NULL || this_mb_link == NULL) {
         return retERR;
     }
-    if (this_mb_tx->mb_tx_nelem > MB2HAL_MAX_FNCT01_ELEMENTS) {
+    if (this_mb_tx->co_nelem > MB2HAL_MAX_FNCT01_ELEMENTS) {
         return retERR;
     }
 
     DBG(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] fd[%d] 1st_addr[%d] nelem[%d]",
         this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_tx->mb_tx_slave_id, modbus_get_socket(this_mb_link->modbus),
-        this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem);
+        this_mb_tx->co_1st_addr, this_mb_tx->co_nelem);
 
-    ret = modbus_read_bits(this_mb_link->modbus, this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem, bits);
+    ret = modbus_read_bits(this_mb_link->modbus, this_mb_tx->co_1st_addr, this_mb_tx->co_nelem, bits);
     if (ret < 0) {
         if (modbus_get_socket(this_mb_link->modbus) < 0) {
             modbus_close(this_mb_link->modbus);
@@ -29,9 +72,13 @@ retCode fnct_01_read_coils(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link)
         return retERR;
     }
 
-    for (counter = 0; counter < this_mb_tx->mb_tx_nelem; counter++) {
-        *(this_mb_tx->bit[counter]) = bits[counter];
-        *(this_mb_tx->bit_inv[counter]) = !bits[counter];
+    //this tx and the ones coalesced into it
+    for (co_mb_tx = this_mb_tx; co_mb_tx != NULL; co_mb_tx = next_coalesced_tx(this_mb_tx, co_mb_tx)) {
+        offset = co_mb_tx->mb_tx_1st_addr - this_mb_tx->co_1st_addr;
+        for (counter = 0; counter < co_mb_tx->mb_tx_nelem; counter++) {
+            *(co_mb_tx->bit[counter]) = bits[offset + counter];
+            *(co_mb_tx->bit_inv[counter]) = !bits[offset + counter];
+        }
     }
 
     return retOK;
@@ -40,21 +87,22 @@ retCode fnct_01_read_coils(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link)
 retCode fnct_02_read_discrete_inputs(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link)
 {
     char *fnct_name = "fnct_02_read_discrete_inputs";
-    int counter, ret;
+    int counter, offset, ret;
+    mb_tx_t *co_mb_tx;
     uint8_t bits[MB2HAL_MAX_FNCT02_ELEMENTS];
 
     if (this_mb_tx == NULL || this_mb_link == NULL) {
         return retERR;
     }
-    if (this_mb_tx->mb_tx_nelem > MB2HAL_MAX_FNCT02_ELEMENTS) {
+    if (this_mb_tx->co_nelem > MB2HAL_MAX_FNCT02_ELEMENTS) {
         return retERR;
     }
 
     DBG(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] fd[%d] 1st_addr[%d] nelem[%d]",
         this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_tx->mb_tx_slave_id, modbus_get_socket(this_mb_link->modbus),
-        this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem);
+        this_mb_tx->co_1st_addr, this_mb_tx->co_nelem);
 
-    ret = modbus_read_input_bits(this_mb_link->modbus, this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem, bits);
+    ret = modbus_read_input_bits(this_mb_link->modbus, this_mb_tx->co_1st_addr, this_mb_tx->co_nelem, bits);
     if (ret < 0) {
         if (modbus_get_socket(this_mb_link->modbus) < 0) {
             modbus_close(this_mb_link->modbus);
@@ -65,10 +113,14 @@ retCode fnct_02_read_discrete_inputs(mb_tx_t *this_mb_tx, mb_link_t *this_mb_lin
         return retERR;
     }
 
-    for (counter = 0; counter < this_mb_tx->mb_tx_nelem; counter++) {
-        *(this_mb_tx->bit[counter]) = bits[counter];
-        if (gbl.version > 1000)
-            *(this_mb_tx->bit_inv[counter]) = !bits[counter];
+    //this tx and the ones coalesced into it
+    for (co_mb_tx = this_mb_tx; co_mb_tx != NULL; co_mb_tx = next_coalesced_tx(this_mb_tx, co_mb_tx)) {
+        offset = co_mb_tx->mb_tx_1st_addr - this_mb_tx->co_1st_addr;
+        for (counter = 0; counter < co_mb_tx->mb_tx_nelem; counter++) {
+            *(co_mb_tx->bit[counter]) = bits[offset + counter];
+            if (gbl.version > 1000)
+                *(co_mb_tx->bit_inv[counter]) = !bits[offset + counter];
+        }
     }
 
     return retOK;
@@ -77,21 +129,22 @@ retCode fnct_02_read_discrete_inputs(mb_tx_t *this_mb_tx, mb_link_t *this_mb_lin
 retCode fnct_03_read_holding_registers(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link)
 {
     char *fnct_name = "fnct_03_read_holding_registers";
-    int counter, ret;
+    int counter, offset, ret;
+    mb_tx_t *co_mb_tx;
     uint16_t data[MB2HAL_MAX_FNCT03_ELEMENTS];
 
     if (this_mb_tx == NULL || this_mb_link == NULL) {
         return retERR;
     }
-    if (this_mb_tx->mb_tx_nelem > MB2HAL_MAX_FNCT03_ELEMENTS) {
+    if (this_mb_tx->co_nelem > MB2HAL_MAX_FNCT03_ELEMENTS) {
         return retERR;
     }
 
     DBG(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] fd[%d] 1st_addr[%d] nelem[%d]",
         this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_tx->mb_tx_slave_id,
-        modbus_get_socket(this_mb_link->modbus), this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem);
+        modbus_get_socket(this_mb_link->modbus), this_mb_tx->co_1st_addr, this_mb_tx->co_nelem);
 
-    ret = modbus_read_registers(this_mb_link->modbus, this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem, data);
+    ret = modbus_read_registers(this_mb_link->modbus, this_mb_tx->co_1st_addr, this_mb_tx->co_nelem, data);
     if (ret < 0) {
         if (modbus_get_socket(this_mb_link->modbus) < 0) {
             modbus_close(this_mb_link->modbus);
@@ -102,12 +155,16 @@ retCode fnct_03_read_holding_registers(mb_tx_t *this_mb_tx, mb_link_t *this_mb_l
         return retERR;
     }
 
-    for (counter = 0; counter < this_mb_tx->mb_tx_nelem; counter++) {
-        float val = data[counter];
-        //val *= this_mb_tx->scale[counter];
-        //val += this_mb_tx->offset[counter];
-        *(this_mb_tx->float_value[counter]) = val;
-        *(this_mb_tx->int_value[counter]) = data[counter];
+    //this tx and the ones coalesced into it
+    for (co_mb_tx = this_mb_tx; co_mb_tx != NULL; co_mb_tx = next_coalesced_tx(this_mb_tx, co_mb_tx)) {
+        offset = co_mb_tx->mb_tx_1st_addr - this_mb_tx->co_1st_addr;
+        for (counter = 0; counter < co_mb_tx->mb_tx_nelem; counter++) {
+            float val = data[offset + counter];
+            //val *= co_mb_tx->scale[counter];
+            //val += co_mb_tx->offset[counter];
+            *(co_mb_tx->float_value[counter]) = val;
+            *(co_mb_tx->int_value[counter]) = data[offset + counter];
+        }
     }
 
     return retOK;
@@ -116,21 +173,22 @@ retCode fnct_03_read_holding_registers(mb_tx_t *this_mb_tx, mb_link_t *this_mb_l
 retCode fnct_04_read_input_registers(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link)
 {
     char *fnct_name = "fnct_04_read_input_registers";
-    int counter, ret;
+    int counter, offset, ret;
+    mb_tx_t *co_mb_tx;
     uint16_t data[MB2HAL_MAX_FNCT04_ELEMENTS];
 
     if (this_mb_tx == NULL || this_mb_link == NULL) {
         return retERR;
     }
-    if (this_mb_tx->mb_tx_nelem > MB2HAL_MAX_FNCT04_ELEMENTS) {
+    if (this_mb_tx->co_nelem > MB2HAL_MAX_FNCT04_ELEMENTS) {
         return retERR;
     }
 
     DBG(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] fd[%d] 1st_addr[%d] nelem[%d]",
         this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_tx->mb_tx_slave_id,
-        modbus_get_socket(this_mb_link->modbus), this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem);
+        modbus_get_socket(this_mb_link->modbus), this_mb_tx->co_1st_addr, this_mb_tx->co_nelem);
 
-    ret = modbus_read_input_registers(this_mb_link->modbus, this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem, data);
+    ret = modbus_read_input_registers(this_mb_link->modbus, this_mb_tx->co_1st_addr, this_mb_tx->co_nelem, data);
     if (ret < 0) {
         if (modbus_get_socket(this_mb_link->modbus) < 0) {
             modbus_close(this_mb_link->modbus);
@@ -141,12 +199,16 @@ retCode fnct_04_read_input_registers(mb_tx_t *this_mb_tx, mb_link_t *this_mb_lin
         return retERR;
     }
 
-    for (counter = 0; counter < this_mb_tx->mb_tx_nelem; counter++) {
-        float val = data[counter];
-        //val += this_mb_tx->offset[counter];
-        //val *= this_mb_tx->scale[counter];
-        *(this_mb_tx->float_value[counter]) = val;
-        *(this_mb_tx->int_value[counter]) = data[counter];
+    //this tx and the ones coalesced into it
+    for (co_mb_tx = this_mb_tx; co_mb_tx != NULL; co_mb_tx = next_coalesced_tx(this_mb_tx, co_mb_tx)) {
+        offset = co_mb_tx->mb_tx_1st_addr - this_mb_tx->co_1st_addr;
+        for (counter = 0; counter < co_mb_tx->mb_tx_nelem; counter++) {
+            float val = data[offset + counter];
+            //val += co_mb_tx->offset[counter];
+            //val *= co_mb_tx->scale[counter];
+            *(co_mb_tx->float_value[counter]) = val;
+            *(co_mb_tx->int_value[counter]) = data[offset + counter];
+        }
     }
 
     return retOK;
@@ -155,7 +217,8 @@ retCode fnct_04_read_input_registers(mb_tx_t *this_mb_tx, mb_link_t *this_mb_lin
 retCode fnct_05_write_single_coil(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link)
 {
     char *fnct_name = "fnct_05_write_single_coil";
-    int ret, bit;
+    int ret;
+    uint8_t bit;
 
     if (this_mb_tx == NULL || this_mb_link == NULL) {
         return retERR;
@@ -166,11 +229,16 @@ retCode fnct_05_write_single_coil(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link)
 
     bit = *(this_mb_tx->bit[0]);
 
+    if (is_write_unchanged(this_mb_tx, this_mb_link, &bit, sizeof(bit))) {
+        return retOKwithWarning; //nothing to write
+    }
+
     DBG(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] fd[%d] 1st_addr[%d] nelem[%d]",
         this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_tx->mb_tx_slave_id,
         modbus_get_socket(this_mb_link->modbus), this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem);
 
     ret = modbus_write_bit(this_mb_link->modbus, this_mb_tx->mb_tx_1st_addr, bit);
+    set_write_done(this_mb_tx, this_mb_link, &bit, sizeof(bit), ret >= 0);
     if (ret < 0) {
         if (modbus_get_socket(this_mb_link->modbus) < 0) {
             modbus_close(this_mb_link->modbus);
@@ -188,6 +256,7 @@ retCode fnct_06_write_single_register(mb_tx_t *this_mb_tx, mb_link_t *this_mb_li
 {
     char *fnct_name = "fnct_06_write_single_register";
     int ret, data;
+    uint16_t value;
 
     if (this_mb_tx == NULL || this_mb_link == NULL) {
         return retERR;
@@ -202,12 +271,18 @@ retCode fnct_06_write_single_register(mb_tx_t *this_mb_tx, mb_link_t *this_mb_li
     if(data > UINT16_MAX) { // prevent wrap on overflow
         data = UINT16_MAX;
     }
-    
+    value = data;
+
+    if (is_write_unchanged(this_mb_tx, this_mb_link, &value, sizeof(value))) {
+        return retOKwithWarning; //nothing to write
+    }
+
     DBG(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] fd[%d] 1st_addr[%d] nelem[%d]",
         this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_tx->mb_tx_slave_id,
         modbus_get_socket(this_mb_link->modbus), this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem);
 
-    ret = modbus_write_register(this_mb_link->modbus, this_mb_tx->mb_tx_1st_addr, data);
+    ret = modbus_write_register(this_mb_link->modbus, this_mb_tx->mb_tx_1st_addr, value);
+    set_write_done(this_mb_tx, this_mb_link, &value, sizeof(value), ret >= 0);
     if (ret < 0) {
         if (modbus_get_socket(this_mb_link->modbus) < 0) {
             modbus_close(this_mb_link->modbus);
@@ -238,11 +313,16 @@ retCode fnct_15_write_multiple_coils(mb_tx_t *this_mb_tx, mb_link_t *this_mb_lin
         bits[counter] = *(this_mb_tx->bit[counter]);
     }
 
+    if (is_write_unchanged(this_mb_tx, this_mb_link, bits, sizeof(bits[0]) * this_mb_tx->mb_tx_nelem)) {
+        return retOKwithWarning; //nothing to write
+    }
+
     DBG(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] fd[%d] 1st_addr[%d] nelem[%d]",
         this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_tx->mb_tx_slave_id,
         modbus_get_socket(this_mb_link->modbus), this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem);
 
     ret = modbus_write_bits(this_mb_link->modbus, this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem, bits);
+    set_write_done(this_mb_tx, this_mb_link, bits, sizeof(bits[0]) * this_mb_tx->mb_tx_nelem, ret >= 0);
     if (ret < 0) {
         if (modbus_get_socket(this_mb_link->modbus) < 0) {
             modbus_close(this_mb_link->modbus);
@@ -283,11 +363,16 @@ retCode fnct_16_write_multiple_registers(mb_tx_t *this_mb_tx, mb_link_t *this_mb
         }
     }
 
+    if (is_write_unchanged(this_mb_tx, this_mb_link, data, sizeof(data[0]) * this_mb_tx->mb_tx_nelem)) {
+        return retOKwithWarning; //nothing to write
+    }
+
     DBG(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] fd[%d] 1st_addr[%d] nelem[%d]",
         this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_tx->mb_tx_slave_id,
         modbus_get_socket(this_mb_link->modbus), this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem);
 
     ret = modbus_write_registers(this_mb_link->modbus, this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem, data);
+    set_write_done(this_mb_tx, this_mb_link, data, sizeof(data[0]) * this_mb_tx->mb_tx_nelem, ret >= 0);
     if (ret < 0) {
         if (modbus_get_socket(this_mb_link->modbus) < 0) {
             modbus_close(this_mb_link->modbus);
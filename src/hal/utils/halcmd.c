@@ -137,6 +137,7 @@ void halcmd_shutdown(void) {
 struct halcmd_command halcmd_commands[] = {
     {"addf",    FUNCT(do_addf_cmd),    A_TWO | A_PLUS },
     {"alias",   FUNCT(do_alias_cmd),   A_THREE },
+    {"compact", FUNCT(do_compact_cmd), A_ONE | A_OPTIONAL },
     {"delf",    FUNCT(do_delf_cmd),    A_TWO | A_OPTIONAL },
     {"delsig",  FUNCT(do_delsig_cmd),  A_ONE },
     {"debug",   FUNCT(do_set_debug_cmd),A_ONE },
@@ -162,7 +163,7 @@ struct halcmd_command halcmd_commands[] = {
     {"sets",    FUNCT(do_sets_cmd),    A_TWO },
     {"show",    FUNCT(do_show_cmd),    A_ONE | A_OPTIONAL | A_PLUS},
     {"source",  FUNCT(do_source_cmd),  A_ONE | A_TILDE },
-    {"start",   FUNCT(do_start_cmd),   A_ZERO},
+    {"start",   FUNCT(do_start_cmd),   A_ONE | A_OPTIONAL },
     {"status",  FUNCT(do_status_cmd),  A_ONE | A_OPTIONAL },
     {"stop",    FUNCT(do_stop_cmd),    A_ZERO},
     {"unalias", FUNCT(do_unalias_cmd), A_TWO },
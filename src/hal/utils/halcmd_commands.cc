@@ -56,6 +56,11 @@
 #include <errno.h>
 #include <time.h>
 #include <fnmatch.h>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 
 static int unloadrt_comp(char *mod_name);
@@ -68,6 +73,8 @@ static void print_script_sig_info(int type, char **patterns);
 static void print_param_info(int type, char **patterns);
 static void print_funct_info(char **patterns);
 static void print_thread_info(char **patterns);
+static void print_thread_depends(char **patterns);
+static void schedule_threads(void);
 static void print_comp_names(char **patterns);
 static void print_pin_names(char **patterns);
 static void print_sig_names(char **patterns);
@@ -289,8 +296,20 @@ int do_source_cmd(char *hal_filename) {
     return result;
 }
 
-int do_start_cmd(void) {
-    int retval = hal_start_threads();
+int do_start_cmd(char *how) {
+    int retval;
+    if (how != NULL && strcmp(how, "compact") == 0) {
+	retval = do_compact_cmd(NULL);
+	if (retval != 0) {
+	    return retval;
+	}
+    } else if (how != NULL && *how) {
+	halcmd_error("Unknown 'start' option '%s'\n", how);
+	return -EINVAL;
+    }
+    /* let threads with helpers run independent functions side by side */
+    schedule_threads();
+    retval = hal_start_threads();
     if (retval == 0) {
         /* print success message */
         halcmd_info("Realtime threads started\n");
@@ -307,6 +326,480 @@ int do_stop_cmd(void) {
     return retval;
 }
 
+/* Signal values are allocated from the bottom of HAL shared memory
+   in the order the signals were created, in between component data,
+   so the signals one thread uses are spread over many cache lines.
+   'compact' moves the values of the signals each thread touches into
+   one cache line aligned block per thread, in the order the thread's
+   functions run, and repoints all pins linked to them.  A function is
+   taken to touch the linked pins of its component that are named like
+   the function's instance ('pid.0.' for 'pid.0.do-pid-calcs'), or all
+   of the component's linked pins if none are.  A signal used by more
+   than one thread is placed with the first (fastest) thread. */
+
+#define HAL_CACHE_LINE 64
+
+struct compact_thread {
+    hal_thread_t *thread;
+    std::vector<hal_sig_t *> sigs;
+};
+
+static void funct_pins(hal_funct_t *funct,
+    const std::vector<hal_pin_t *> &comp_pins, std::vector<hal_pin_t *> &pins)
+{
+    std::string prefix = std::string(funct->name) + ".";
+
+    pins.clear();
+    for (hal_pin_t *pin : comp_pins) {
+	if (strncmp(pin->name, prefix.c_str(), prefix.size()) == 0) {
+	    pins.push_back(pin);
+	}
+    }
+    if (pins.empty()) {
+	size_t dot = prefix.rfind('.', prefix.size() - 2);
+	if (dot != std::string::npos) {
+	    prefix.resize(dot + 1);
+	    for (hal_pin_t *pin : comp_pins) {
+		if (strncmp(pin->name, prefix.c_str(), prefix.size()) == 0) {
+		    pins.push_back(pin);
+		}
+	    }
+	}
+    }
+    if (pins.empty()) {
+	pins = comp_pins;
+    }
+}
+
+/* build the per-thread signal working sets; call with mutex held */
+static void compact_plan(std::vector<compact_thread> &threads, long *max_period)
+{
+    std::unordered_map<hal_comp_t *, std::vector<hal_pin_t *> > comp_pins;
+    std::unordered_set<hal_sig_t *> seen;
+    std::vector<hal_pin_t *> pins;
+    SHMFIELD(hal_pin_t) next_pin;
+    SHMFIELD(hal_thread_t) next_thread;
+    hal_list_t *list_root, *list_entry;
+
+    threads.clear();
+    *max_period = 0;
+    next_pin = hal_data->pin_list_ptr;
+    while (next_pin != 0) {
+	hal_pin_t *pin = SHMPTR(next_pin);
+	if (pin->signal != 0) {
+	    comp_pins[SHMPTR(pin->owner_ptr)].push_back(pin);
+	}
+	next_pin = pin->next_ptr;
+    }
+    next_thread = hal_data->thread_list_ptr;
+    while (next_thread != 0) {
+	hal_thread_t *tptr = SHMPTR(next_thread);
+	compact_thread ct;
+	ct.thread = tptr;
+	if (tptr->period > *max_period) {
+	    *max_period = tptr->period;
+	}
+	list_root = &(tptr->funct_list);
+	list_entry = list_next(list_root);
+	while (list_entry != list_root) {
+	    hal_funct_entry_t *fentry = (hal_funct_entry_t *) list_entry;
+	    hal_funct_t *funct = SHMPTR(fentry->funct_ptr);
+	    funct_pins(funct, comp_pins[SHMPTR(funct->owner_ptr)], pins);
+	    for (hal_pin_t *pin : pins) {
+		hal_sig_t *sig = SHMPTR(pin->signal);
+		if (seen.insert(sig).second) {
+		    ct.sigs.push_back(sig);
+		}
+	    }
+	    list_entry = list_next(list_entry);
+	}
+	threads.push_back(ct);
+	next_thread = tptr->next_ptr;
+    }
+}
+
+static long compact_size(const std::vector<compact_thread> &threads)
+{
+    long size = HAL_CACHE_LINE;
+    for (const compact_thread &ct : threads) {
+	long n = ct.sigs.size() * sizeof(hal_data_u);
+	size += (n + HAL_CACHE_LINE - 1) & ~(HAL_CACHE_LINE - 1);
+    }
+    return size;
+}
+
+static int sig_cache_lines(const std::vector<hal_sig_t *> &sigs)
+{
+    std::set<uintptr_t> lines;
+    for (hal_sig_t *sig : sigs) {
+	lines.insert((uintptr_t) SHMPTR(sig->data_ptr) / HAL_CACHE_LINE);
+    }
+    return lines.size();
+}
+
+int do_compact_cmd(char *how)
+{
+    std::vector<compact_thread> threads;
+    std::vector<int> before;
+    std::unordered_set<hal_sig_t *> moved;
+    SHMFIELD(hal_pin_t) next_pin;
+    long size, max_period;
+    char *block, *p;
+    int report_only = 0;
+
+    if (how != NULL && strcmp(how, "report") == 0) {
+	report_only = 1;
+    } else if (how != NULL && *how) {
+	halcmd_error("Unknown 'compact' option '%s'\n", how);
+	return -EINVAL;
+    }
+    if (!report_only && (hal_data->lock & HAL_LOCK_CONFIG)) {
+	halcmd_error("HAL is locked, cannot move signals\n");
+	return -EPERM;
+    }
+    rtapi_mutex_get(&(hal_data->mutex));
+    if (!report_only && hal_data->threads_running > 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	halcmd_error("realtime threads must be stopped to move signals\n");
+	return -EBUSY;
+    }
+    compact_plan(threads, &max_period);
+    size = compact_size(threads);
+    for (const compact_thread &ct : threads) {
+	before.push_back(sig_cache_lines(ct.sigs));
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+
+    if (report_only) {
+	halcmd_output("Thread                Signals  Cache lines\n");
+	for (size_t i = 0; i < threads.size(); i++) {
+	    halcmd_output("%-20s  %7zu  %11d\n", threads[i].thread->name,
+		threads[i].sigs.size(), before[i]);
+	}
+	return 0;
+    }
+
+    /* a thread may still be in the middle of the cycle during which
+       it was stopped; give it time to finish */
+    usleep(max_period / 1000 + 1000);
+
+    /* hal_malloc takes the mutex itself; signals may be added while it
+       is released, so the plan is made again below */
+    block = (char *) hal_malloc(size + 16 * HAL_CACHE_LINE);
+    if (block == NULL) {
+	halcmd_error("not enough shared memory to move signals\n");
+	return -ENOMEM;
+    }
+
+    rtapi_mutex_get(&(hal_data->mutex));
+    if (hal_data->threads_running > 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	halcmd_error("realtime threads must be stopped to move signals\n");
+	return -EBUSY;
+    }
+    compact_plan(threads, &max_period);
+    if (compact_size(threads) > size + 16 * HAL_CACHE_LINE) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	halcmd_error("signals changed while moving them, try again\n");
+	return -EAGAIN;
+    }
+    before.clear();
+    for (const compact_thread &ct : threads) {
+	before.push_back(sig_cache_lines(ct.sigs));
+    }
+
+    /* copy the values to their new place */
+    p = (char *) (((uintptr_t) block + HAL_CACHE_LINE - 1) & ~(uintptr_t) (HAL_CACHE_LINE - 1));
+    for (const compact_thread &ct : threads) {
+	for (hal_sig_t *sig : ct.sigs) {
+	    *(hal_data_u *) p = *(hal_data_u *) SHMPTR(sig->data_ptr);
+	    sig->data_ptr = SHMOFF((void **) p);
+	    moved.insert(sig);
+	    p += sizeof(hal_data_u);
+	}
+	p = (char *) (((uintptr_t) p + HAL_CACHE_LINE - 1) & ~(uintptr_t) (HAL_CACHE_LINE - 1));
+    }
+
+    /* and point every pin linked to a moved signal at it, in the
+       address space of the pin's owner (see hal_link) */
+    next_pin = hal_data->pin_list_ptr;
+    while (next_pin != 0) {
+	hal_pin_t *pin = SHMPTR(next_pin);
+	if (pin->signal != 0 && moved.count(SHMPTR(pin->signal))) {
+	    hal_sig_t *sig = SHMPTR(pin->signal);
+	    hal_comp_t *comp = SHMPTR(pin->owner_ptr);
+	    long offset = (char *) SHMPTR(sig->data_ptr) - hal_shmem_base;
+	    *SHMPTR(pin->data_ptr_addr) = (char *) comp->shmem_base + offset;
+	}
+	next_pin = pin->next_ptr;
+    }
+
+    halcmd_output("Thread                Signals  Cache lines (before -> after)\n");
+    for (size_t i = 0; i < threads.size(); i++) {
+	halcmd_output("%-20s  %7zu  %11d -> %d\n", threads[i].thread->name,
+	    threads[i].sigs.size(), before[i], sig_cache_lines(threads[i].sigs));
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+    return 0;
+}
+
+/* Each thread's functions are split into stages for threads that have
+   helper tasks (see thread_helpers(9)).  A function is taken to read
+   the signals on the IN and IO pins and to write the signals on the
+   OUT and IO pins that funct_pins finds for it.  It goes into the
+   first stage after every earlier function that writes a signal it
+   reads or writes, that reads a signal it writes, or that belongs to
+   the same instance: the function name itself if the component has
+   pins below it, else the name up to its last dot, else the component.
+
+   When an instance has several functions in a thread that all get
+   the same pins, like a driver's 'read' and 'write', the report
+   charges its IN pins to the last and its OUT pins to the first of
+   them.  The stages keep the full sets. */
+
+#define DEPENDS_MAX_STAGES 255	/* stage 0xff marks an idle thread */
+
+struct depends_funct {
+    hal_funct_entry_t *entry;
+    hal_funct_t *funct;
+    std::string instance;
+    std::set<hal_sig_t *> reads, writes;
+    std::set<hal_sig_t *> shown_reads, shown_writes;
+    int stage;
+};
+
+struct depends_thread {
+    hal_thread_t *thread;
+    std::vector<depends_funct> functs;
+    int stages;
+};
+
+static bool sets_meet(const std::set<hal_sig_t *> &a,
+    const std::set<hal_sig_t *> &b)
+{
+    auto i = a.begin();
+    auto j = b.begin();
+    while (i != a.end() && j != b.end()) {
+	if (*i < *j) {
+	    ++i;
+	} else if (*j < *i) {
+	    ++j;
+	} else {
+	    return true;
+	}
+    }
+    return false;
+}
+
+/* non-zero if 'later' has to run after 'earlier' */
+static bool funct_depends(const depends_funct &earlier,
+    const depends_funct &later)
+{
+    return earlier.instance == later.instance
+	|| sets_meet(earlier.writes, later.reads)
+	|| sets_meet(earlier.writes, later.writes)
+	|| sets_meet(earlier.reads, later.writes);
+}
+
+static std::string funct_instance(hal_funct_t *funct,
+    const std::vector<hal_pin_t *> &comp_pins)
+{
+    std::string prefix = std::string(funct->name) + ".";
+
+    for (hal_pin_t *pin : comp_pins) {
+	if (strncmp(pin->name, prefix.c_str(), prefix.size()) == 0) {
+	    return funct->name;
+	}
+    }
+    const char *dot = strrchr(funct->name, '.');
+    if (dot != NULL) {
+	return std::string(funct->name, dot - funct->name);
+    }
+    return ((hal_comp_t *) SHMPTR(funct->owner_ptr))->name;
+}
+
+/* build the per-thread dependency stages; call with mutex held */
+static void depends_plan(std::vector<depends_thread> &threads)
+{
+    std::unordered_map<hal_comp_t *, std::vector<hal_pin_t *> > comp_pins;
+    std::vector<hal_pin_t *> pins;
+    SHMFIELD(hal_pin_t) next_pin;
+    SHMFIELD(hal_thread_t) next_thread;
+    hal_list_t *list_root, *list_entry;
+
+    threads.clear();
+    next_pin = hal_data->pin_list_ptr;
+    while (next_pin != 0) {
+	hal_pin_t *pin = SHMPTR(next_pin);
+	if (pin->signal != 0) {
+	    comp_pins[SHMPTR(pin->owner_ptr)].push_back(pin);
+	}
+	next_pin = pin->next_ptr;
+    }
+    next_thread = hal_data->thread_list_ptr;
+    while (next_thread != 0) {
+	hal_thread_t *tptr = SHMPTR(next_thread);
+	depends_thread dt;
+	dt.thread = tptr;
+	dt.stages = 0;
+	list_root = &(tptr->funct_list);
+	list_entry = list_next(list_root);
+	while (list_entry != list_root) {
+	    depends_funct df;
+	    df.entry = (hal_funct_entry_t *) list_entry;
+	    df.funct = SHMPTR(df.entry->funct_ptr);
+	    const std::vector<hal_pin_t *> &cp =
+		comp_pins[SHMPTR(df.funct->owner_ptr)];
+	    df.instance = funct_instance(df.funct, cp);
+	    funct_pins(df.funct, cp, pins);
+	    for (hal_pin_t *pin : pins) {
+		hal_sig_t *sig = SHMPTR(pin->signal);
+		if (pin->dir & HAL_IN) {
+		    df.reads.insert(sig);
+		}
+		if (pin->dir & HAL_OUT) {
+		    df.writes.insert(sig);
+		}
+	    }
+	    df.shown_reads = df.reads;
+	    df.shown_writes = df.writes;
+	    df.stage = 0;
+	    for (const depends_funct &prev : dt.functs) {
+		if (df.stage <= prev.stage && funct_depends(prev, df)) {
+		    df.stage = prev.stage + 1;
+		}
+	    }
+	    if (df.stage + 1 > dt.stages) {
+		dt.stages = df.stage + 1;
+	    }
+	    dt.functs.push_back(df);
+	    list_entry = list_next(list_entry);
+	}
+	/* split the pins of driver style read/write pairs */
+	for (size_t i = 0; i < dt.functs.size(); i++) {
+	    depends_funct &first = dt.functs[i];
+	    size_t last = i;
+	    for (size_t j = i + 1; j < dt.functs.size(); j++) {
+		depends_funct &other = dt.functs[j];
+		if (other.instance == first.instance
+		    && other.reads == first.reads && other.writes == first.writes) {
+		    last = j;
+		}
+	    }
+	    if (last == i || first.shown_reads != first.reads) {
+		continue;
+	    }
+	    for (size_t j = i; j <= last; j++) {
+		depends_funct &other = dt.functs[j];
+		if (other.instance != first.instance
+		    || other.reads != first.reads || other.writes != first.writes) {
+		    continue;
+		}
+		/* IO pins are in both sets and stay with every function */
+		for (hal_sig_t *sig : first.reads) {
+		    if (j != last && !first.writes.count(sig)) {
+			other.shown_reads.erase(sig);
+		    }
+		}
+		for (hal_sig_t *sig : first.writes) {
+		    if (j != i && !first.reads.count(sig)) {
+			other.shown_writes.erase(sig);
+		    }
+		}
+	    }
+	}
+	threads.push_back(dt);
+	next_thread = tptr->next_ptr;
+    }
+}
+
+/* store the stages for the realtime threads; call with mutex held */
+static void depends_schedule(const std::vector<depends_thread> &threads)
+{
+    for (const depends_thread &dt : threads) {
+	hal_thread_t *tptr = dt.thread;
+	/* stale first, so a running thread never sees half a schedule */
+	tptr->sched_serial = hal_data->graph_serial - 1;
+	__sync_synchronize();
+	if (dt.stages > DEPENDS_MAX_STAGES) {
+	    tptr->stages = 0;
+	    continue;
+	}
+	for (const depends_funct &df : dt.functs) {
+	    df.entry->stage = df.stage;
+	    /* claims older than a few cycles may compare as new */
+	    df.entry->claimed = df.entry->done = tptr->par_word;
+	}
+	tptr->stages = dt.stages;
+	__sync_synchronize();
+	tptr->sched_serial = hal_data->graph_serial;
+    }
+}
+
+static void schedule_threads(void)
+{
+    std::vector<depends_thread> threads;
+
+    rtapi_mutex_get(&(hal_data->mutex));
+    depends_plan(threads);
+    depends_schedule(threads);
+    rtapi_mutex_give(&(hal_data->mutex));
+}
+
+static void print_thread_depends(char **patterns)
+{
+    std::vector<depends_thread> threads;
+
+    halcmd_output("Thread Dependencies:\n");
+    rtapi_mutex_get(&(hal_data->mutex));
+    depends_plan(threads);
+    for (const depends_thread &dt : threads) {
+	hal_thread_t *tptr = dt.thread;
+	if (!match(patterns, tptr->name)) {
+	    continue;
+	}
+	halcmd_output("%s: %d stages, %d helpers, schedule %s\n", tptr->name,
+	    dt.stages, tptr->helpers,
+	    tptr->sched_serial == hal_data->graph_serial ? "current" : "stale");
+	halcmd_output("  Stage  Function                        After\n");
+	for (size_t i = 0; i < dt.functs.size(); i++) {
+	    const depends_funct &df = dt.functs[i];
+	    std::string after;
+	    /* only the functions that put it in its stage */
+	    for (size_t j = 0; j < i; j++) {
+		const depends_funct &prev = dt.functs[j];
+		if (prev.stage == df.stage - 1 && funct_depends(prev, df)) {
+		    after += " ";
+		    after += prev.funct->name;
+		}
+	    }
+	    if (after.empty()) {
+		halcmd_output("  %5d  %s\n", df.stage, df.funct->name);
+	    } else {
+		halcmd_output("  %5d  %-31s%s\n", df.stage, df.funct->name,
+		    after.c_str());
+	    }
+	}
+	for (size_t i = 0; i < dt.functs.size(); i++) {
+	    const depends_funct &reader = dt.functs[i];
+	    for (size_t j = i + 1; j < dt.functs.size(); j++) {
+		const depends_funct &writer = dt.functs[j];
+		if (writer.instance == reader.instance) {
+		    continue;
+		}
+		for (hal_sig_t *sig : reader.shown_reads) {
+		    if (writer.shown_writes.count(sig)) {
+			halcmd_output("  order: '%s' reads '%s' before '%s' writes it\n",
+			    reader.funct->name, sig->name, writer.funct->name);
+		    }
+		}
+	    }
+	}
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+    halcmd_output("\n");
+}
+
 int do_echo_cmd(void) {
     printf("Echo on\n");
     return 0;
@@ -1019,6 +1512,8 @@ int do_show_cmd(char *type, char **patterns)
 	print_funct_info(patterns);
     } else if (strcmp(type, "thread") == 0) {
 	print_thread_info(patterns);
+    } else if (strcmp(type, "depends") == 0) {
+	print_thread_depends(patterns);
     } else if (strcmp(type, "alias") == 0) {
 	print_pin_aliases(patterns);
 	print_param_aliases(patterns);
@@ -1087,13 +1582,12 @@ int do_status_cmd(char *type)
     return 0;
 }
 
+static int loadrt_record_args(char *mod_name, char *args[]);
+
 int do_loadrt_cmd(char *mod_name, char *args[])
 {
-    char arg_string[MAX_CMD_LEN+1];
     int m=0, n=0, retval;
-    hal_comp_t *comp;
     const char *argv[MAX_TOK+3];
-    char *cp1;
 #if defined(RTAPI_USPACE)
     argv[m++] = "-Wn";
     argv[m++] = mod_name;
@@ -1164,6 +1658,18 @@ int do_loadrt_cmd(char *mod_name, char *args[])
         , mod_name, retval );
 	return -1;
     }
+    return loadrt_record_args(mod_name, args);
+}
+
+/* after a successful insmod, remember the module arguments in the
+   component so 'show comp' and 'save' can report them */
+static int loadrt_record_args(char *mod_name, char *args[])
+{
+    char arg_string[MAX_CMD_LEN+1];
+    int n;
+    hal_comp_t *comp;
+    char *cp1;
+
     /* make the args that were passed to the module into a single string */
     n = 0;
     arg_string[0] = '\0';
@@ -1196,6 +1702,63 @@ int do_loadrt_cmd(char *mod_name, char *args[])
     return 0;
 }
 
+/* Load several realtime modules at once.  On uspace they go to rtapi_app
+   as one 'batch' command, so there is a single program start and a single
+   wait for the last component instead of one of each per module.  Modules
+   are loaded in order and loading stops at the first failure. */
+int do_loadrt_batch(int count, char *mod_names[], char **args[])
+{
+    int i, retval;
+
+    if (count <= 0) {
+	return 0;
+    }
+#if defined(RTAPI_USPACE)
+    {
+	std::vector<std::string> counts(count);
+	std::vector<const char *> argv;
+
+	/* do_loadusr_cmd looks at the slot before its first argument */
+	argv.push_back("loadusr");
+	argv.push_back("-Wn");
+	argv.push_back(mod_names[count-1]);
+	argv.push_back(EMC2_BIN_DIR "/rtapi_app");
+	argv.push_back("batch");
+	for (i = 0; i < count; i++) {
+	    int n = 0;
+	    while ( args[i][n] && args[i][n][0] != '\0' ) n++;
+	    counts[i] = std::to_string(n + 2);
+	    argv.push_back(counts[i].c_str());
+	    argv.push_back("load");
+	    argv.push_back(mod_names[i]);
+	    argv.insert(argv.end(), args[i], args[i] + n);
+	}
+	argv.push_back(NULL);
+	retval = do_loadusr_cmd(argv.data() + 1);
+    }
+    if ( retval != 0 ) {
+	halcmd_error("batch load of %d modules failed, returned %d\n",
+	    count, retval);
+    }
+    /* record what did load, so a failure names the module that didn't */
+    for (i = 0; i < count; i++) {
+	int r = loadrt_record_args(mod_names[i], args[i]);
+	if ( r != 0 ) {
+	    return r;
+	}
+    }
+    return retval ? -1 : 0;
+#else
+    for (i = 0; i < count; i++) {
+	retval = do_loadrt_cmd(mod_names[i], args[i]);
+	if ( retval != 0 ) {
+	    return retval;
+	}
+    }
+    return 0;
+#endif
+}
+
 int do_delsig_cmd(char *mod_name)
 {
     SHMFIELD(hal_sig_t) next;
@@ -1468,8 +2031,8 @@ int do_loadusr_cmd(const char *args[])
 {
     int wait_flag, wait_comp_flag, ignore_flag;
     const char *prog_name, *new_comp_name=NULL;
-    const char *argv[MAX_TOK+1];
-    int n, m, retval, status;
+    std::vector<const char *> argv;
+    int n, retval, status;
     pid_t pid;
 
     int argc = 0;
@@ -1516,17 +2079,16 @@ int do_loadusr_cmd(const char *args[])
     std::set<std::string> comp_names_pre = get_all_comp_names();
 
     /* prepare to exec() the program */
-    argv[0] = prog_name;
+    argv.push_back(prog_name);
     /* loop thru remaining arguments */
     n = 0;
-    m = 1;
     while ( args[n] && args[n][0] != '\0' ) {
-        argv[m++] = args[n++];
+        argv.push_back(args[n++]);
     }
     /* add a NULL to terminate the argv array */
-    argv[m] = NULL;
+    argv.push_back(NULL);
     /* start the child process */
-    pid = hal_systemv_nowait(argv);
+    pid = hal_systemv_nowait(argv.data());
     /* make sure we reconnected to the HAL */
     if (comp_id < 0) {
 	fprintf(stderr, "halcmd: hal_init() failed after fork: %d\n",
@@ -2956,6 +3518,10 @@ int do_help_cmd(char *command)
 	printf("  'all' with no pattern.  If 'pattern' is specified\n");
 	printf("  it prints only those items whose names match the\n");
 	printf("  pattern, which may be a 'shell glob'.\n");
+	printf("  'depends' lists the stage of each function of the\n");
+	printf("  matching threads, the functions that put it there, and\n");
+	printf("  functions that read a signal before a later function\n");
+	printf("  of the same thread writes it.\n");
     } else if (strcmp(command, "list") == 0) {
 	printf("list type [pattern]\n");
 	printf("  Prints the names of HAL items of the specified type.\n");
@@ -2999,8 +3565,18 @@ int do_help_cmd(char *command)
 	printf("  'comp', 'alias', 'sigu', 'netla', 'param', and 'thread'.\n\n");
         printf("  See the man page ($man halcmd) for save option details\n");
     } else if (strcmp(command, "start") == 0) {
-	printf("start\n");
+	printf("start [compact]\n");
 	printf("  Starts all realtime threads.\n");
+	printf("  With 'compact', first runs 'compact'.  Computes the\n");
+	printf("  stages used by threads with helpers, see 'show depends'.\n");
+    } else if (strcmp(command, "compact") == 0) {
+	printf("compact [report]\n");
+	printf("  Moves the values of the signals used by each realtime\n");
+	printf("  thread into one contiguous, cache line aligned block and\n");
+	printf("  relinks their pins.  Threads must be stopped.\n");
+	printf("  Prints the number of cache lines holding each thread's\n");
+	printf("  signals before and after.  With 'report', only prints\n");
+	printf("  the current numbers.\n");
     } else if (strcmp(command, "stop") == 0) {
 	printf("stop\n");
 	printf("  Stops all realtime threads.\n");
@@ -3073,6 +3649,7 @@ static void print_help_commands(void)
     printf("  debug               Set the rtapi message level\n");
     printf("  save                Print config as commands\n");
     printf("  start, stop         Start/stop realtime threads\n");
+    printf("  compact             Group the signals of each thread in memory\n");
     printf("  alias, unalias      Add or remove pin or parameter name aliases\n");
     printf("  echo, unecho        Echo commands from stdin to stderr\n");
     printf("  print               print filename, line number and optional message to terminal\n");
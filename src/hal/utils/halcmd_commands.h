@@ -53,7 +53,8 @@ extern int do_echo_cmd();
 extern int do_unecho_cmd();
 extern int do_linkps_cmd(char *pin, char *signal);
 extern int do_linksp_cmd(char *signal, char *pin);
-extern int do_start_cmd();
+extern int do_start_cmd(char *how);
+extern int do_compact_cmd(char *how);
 extern int do_stop_cmd();
 extern int do_help_cmd(char *command);
 extern int do_lock_cmd(char *command);
@@ -78,6 +79,7 @@ extern int do_status_cmd(char *type);
 extern int do_set_debug_cmd(char *level);
 extern int do_delsig_cmd(char *mod_name);
 extern int do_loadrt_cmd(char *mod_name, char *args[]);
+extern int do_loadrt_batch(int count, char *mod_names[], char **args[]);
 extern int do_unlinkp_cmd(char *mod_name);
 extern int do_unload_cmd(char *mod_name);
 extern int do_unloadrt_cmd(char *mod_name);
@@ -53,7 +53,7 @@ static const char *command_table[] = {
     "linkps", "linksp", "linkpp", "unlinkp",
     "net", "newsig", "delsig", "getp", "gets", "setp", "sets", "ptype", "stype",
     "addf", "delf", "show", "list", "status", "save", "source",
-    "start", "stop", "quit", "exit", "help", "alias", "unalias", 
+    "start", "stop", "compact", "quit", "exit", "help", "alias", "unalias", 
     NULL,
 };
 
@@ -69,7 +69,7 @@ static const char *alias_table[] = {
 
 static const char *show_table[] = {
     "all", "alias", "comp", "pin", "sig", "param", "funct", "thread",
-    NULL,
+    "depends", NULL,
 };
 
 static const char *save_table[] = {
@@ -94,6 +94,8 @@ static const char *pintype_table[] = {
 
 static const char *lock_table[] = { "none", "tune", "all", NULL };
 static const char *unlock_table[] = { "tune", "all", NULL };
+static const char *start_table[] = { "compact", NULL };
+static const char *compact_table[] = { "report", NULL };
 
 static const char **string_table = NULL;
 
@@ -686,7 +688,7 @@ char **halcmd_completer(const char *text, int start, int end, hal_completer_func
                 result = func(text, parameter_generator);
             } else if (startswith(n, "funct")) {
                 result = func(text, funct_generator);
-            } else if (startswith(n, "thread")) {
+            } else if (startswith(n, "thread") || startswith(n, "depends")) {
                 result = func(text, thread_generator);
             }
         }
@@ -700,6 +702,10 @@ char **halcmd_completer(const char *text, int start, int end, hal_completer_func
         result = completion_matches_table(text, lock_table, func);
     } else if(startswith(buffer, "unlock ") && argno == 1) {
         result = completion_matches_table(text, unlock_table, func);
+    } else if(startswith(buffer, "start ") && argno == 1) {
+        result = completion_matches_table(text, start_table, func);
+    } else if(startswith(buffer, "compact ") && argno == 1) {
+        result = completion_matches_table(text, compact_table, func);
     } else if(startswith(buffer, "addf ") && argno == 1) {
         result = func(text, funct_generator);
     } else if(startswith(buffer, "addf ") && argno == 2) {
@@ -79,6 +79,7 @@ static int get_input(FILE *srcfile, char *buf, size_t bufsize);
 static void print_help_general(int showR);
 static int release_HAL_mutex(void);
 static int propose_completion(char *all, char *fragment, int start);
+static int run_batch(int nfiles, char **files, int keep_going);
 
 static char *prompt             = "";
 static char *prompt_script      = "%%\n";
@@ -95,7 +96,7 @@ int main(int argc, char **argv)
 {
     int c, fd;
     int keep_going, retval, errorcount;
-    int filemode = 0;
+    int filemode = 0, batchmode = 0;
     char *filename = NULL;
     FILE *srcfile = NULL;
     char raw_buf[MAX_CMD_LEN+1];
@@ -113,7 +114,7 @@ int main(int argc, char **argv)
     keep_going = 0;
     /* start parsing the command line, options first */
     while(1) {
-        c = getopt(argc, argv, "+RCfi:kqQsvVhe");
+        c = getopt(argc, argv, "+RCbfi:kqQsvVhe");
         if(c == -1) break;
         switch(c) {
             case 'R':
@@ -160,6 +161,9 @@ int main(int argc, char **argv)
 	    case 'e':
                 echo_mode = 1;
 		break;
+	    case 'b':
+                batchmode = 1;
+		break;
 	    case 'f':
                 filemode = 1;
 		break;
@@ -218,6 +222,17 @@ int main(int argc, char **argv)
 		break;
         }
     }
+    if(batchmode) {
+        /* every remaining argument is a file, read up front */
+        if (!filemode || argc <= optind) {
+            fprintf(stderr, "-b requires -f and at least one file\n");
+            exit(-1);
+        }
+        if ( halcmd_startup(0) != 0 ) return 1;
+        errorcount = run_batch(argc - optind, &argv[optind], keep_going);
+        halcmd_shutdown();
+        return errorcount > 0 ? 1 : 0;
+    }
     if(filemode) {
         /* it's the first -f (ignore repeats) */
         if (argc > optind) {
@@ -409,7 +424,12 @@ static void print_help_general(int showR)
 {
     printf("\nUsage:   halcmd [options] [cmd [args]]\n\n");
     printf("\n         halcmd [options] -f [filename]\n\n");
+    printf("\n         halcmd [options] -b -f filename...\n\n");
     printf("options:\n\n");
+    printf("  -b             Batch startup - with -f, read all of the files\n");
+    printf("                 that follow before running anything, load all\n");
+    printf("                 realtime modules at once, and report the time\n");
+    printf("                 spent in each phase.\n");
     printf("  -e             echo the commands from stdin to stderr\n");
     printf("  -f [filename]  Read commands from 'filename', not command\n");
     printf("                 line.  If no filename, read from stdin.\n");
@@ -436,6 +456,207 @@ static void print_help_general(int showR)
     printf("  help command   Prints detailed help for 'command'\n\n");
 }
 
+/* one preprocessed command of a batch startup */
+struct batch_cmd {
+    char *filename;
+    int linenumber;
+    char *line;
+    char *tokens[MAX_TOK+1];
+};
+
+enum batch_phase {
+    PHASE_PARSE, PHASE_LOADRT, PHASE_NET, PHASE_SETP, PHASE_ADDF,
+    PHASE_OTHER, PHASE_COUNT
+};
+
+static const char *batch_phase_names[PHASE_COUNT] = {
+    "parse", "loadrt", "net/link", "setp/sets", "addf", "other"
+};
+
+static double batch_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static enum batch_phase batch_classify(char **tokens)
+{
+    if (!strcmp(tokens[0], "loadrt")) return PHASE_LOADRT;
+    if (!strcmp(tokens[0], "net") || !strncmp(tokens[0], "link", 4))
+        return PHASE_NET;
+    if (!strcmp(tokens[0], "setp") || !strcmp(tokens[0], "sets")
+            || !strcmp(tokens[1], "="))
+        return PHASE_SETP;
+    if (!strcmp(tokens[0], "addf")) return PHASE_ADDF;
+    return PHASE_OTHER;
+}
+
+/* read, preprocess and store every command in 'name'; returns the number
+   of errors */
+static int batch_read_file(const char *name, struct batch_cmd **cmds,
+                           int *ncmds, int *capacity)
+{
+    static char *empty = "";
+    char raw_buf[MAX_CMD_LEN+1];
+    char eline[(LINELEN + 2) * (MAX_EXTEND_LINES + 1)] = {0,};
+    char *elineptr = eline, *elineend = eline + sizeof(eline);
+    char *filename;
+    int linenumber = 1, errors = 0;
+    FILE *srcfile;
+
+    srcfile = fopen(name, "r");
+    if (srcfile == NULL) {
+        fprintf(stderr, "Could not open command file '%s'\n", name);
+        return 1;
+    }
+    halcmd_set_filename(name);
+    filename = strdup(name);
+
+    while (fgets(raw_buf, MAX_CMD_LEN, srcfile)) {
+        char *tokens[MAX_TOK+1];
+        struct batch_cmd *cmd;
+        int newLinePos, n, retval;
+
+        halcmd_set_linenumber(linenumber++);
+
+        newLinePos = (int)strlen(raw_buf) - 1;
+        if (newLinePos >= 0 && raw_buf[newLinePos] == '\n') {
+            raw_buf[newLinePos] = 0; newLinePos--;
+        }
+        if (newLinePos >= 0 && raw_buf[newLinePos] == '\\') {
+            raw_buf[newLinePos] = 0;
+            elineptr = seprintf(elineptr, elineend, "%s", raw_buf);
+            continue; // get next line to extend
+        }
+        elineptr = seprintf(elineptr, elineend, "%s", raw_buf);
+
+        retval = halcmd_preprocess_line(eline, tokens);
+        if (retval != 0) {
+            errors++;
+        } else if ( ( strcasecmp(tokens[0],"quit") == 0 ) ||
+                    ( strcasecmp(tokens[0],"exit") == 0 ) ) {
+            break;
+        } else if (tokens[0][0]) {
+            if (*ncmds == *capacity) {
+                *capacity = *capacity ? 2 * *capacity : 256;
+                *cmds = realloc(*cmds, *capacity * sizeof(**cmds));
+                if (*cmds == NULL) {
+                    halcmd_error("out of memory\n");
+                    exit(-1);
+                }
+            }
+            cmd = &(*cmds)[(*ncmds)++];
+            cmd->filename = filename;
+            cmd->linenumber = halcmd_get_linenumber();
+            cmd->line = strdup(eline);
+            for (n = 0; n < MAX_TOK && tokens[n][0]; n++) {
+                cmd->tokens[n] = strdup(tokens[n]);
+            }
+            for (; n <= MAX_TOK; n++) {
+                cmd->tokens[n] = empty;
+            }
+        }
+        elineptr = eline;
+        *eline = 0;
+    }
+    fclose(srcfile);
+    return errors;
+}
+
+/* Batch startup: read and preprocess all files first, so syntax and
+   substitution errors show up before HAL is touched; then load every
+   'loadrt' module in one go (in file order, ahead of all other commands),
+   then run the remaining commands in file order.  Prints how long each
+   phase took.  Returns the number of errors. */
+static int run_batch(int nfiles, char **files, int keep_going)
+{
+    struct batch_cmd *cmds = NULL;
+    int ncmds = 0, capacity = 0, errorcount = 0, i, nmods = 0;
+    char **mod_names;
+    char ***mod_args;
+    double t, total, elapsed[PHASE_COUNT] = {0,};
+    int counts[PHASE_COUNT] = {0,};
+
+    total = t = batch_now();
+    for (i = 0; i < nfiles; i++) {
+        errorcount += batch_read_file(files[i], &cmds, &ncmds, &capacity);
+    }
+    elapsed[PHASE_PARSE] = batch_now() - t;
+    counts[PHASE_PARSE] = ncmds;
+    if (errorcount > 0 && keep_going == 0) {
+        return errorcount;
+    }
+
+    mod_names = malloc((ncmds + 1) * sizeof(*mod_names));
+    mod_args = malloc((ncmds + 1) * sizeof(*mod_args));
+    if (mod_names == NULL || mod_args == NULL) {
+        halcmd_error("out of memory\n");
+        exit(-1);
+    }
+    for (i = 0; i < ncmds; i++) {
+        if (strcmp(cmds[i].tokens[0], "loadrt") != 0) continue;
+        if (!cmds[i].tokens[1][0]) {
+            halcmd_set_filename(cmds[i].filename);
+            halcmd_set_linenumber(cmds[i].linenumber);
+            halcmd_error("loadrt requires at least 1 arguments, 0 given\n");
+            errorcount++;
+            continue;
+        }
+        if (nmods == 0) {
+            halcmd_set_filename(cmds[i].filename);
+            halcmd_set_linenumber(cmds[i].linenumber);
+        }
+        if (echo_mode) {
+            halcmd_echo("%s\n", cmds[i].line);
+        }
+        mod_names[nmods] = cmds[i].tokens[1];
+        mod_args[nmods] = &cmds[i].tokens[2];
+        nmods++;
+    }
+    t = batch_now();
+    if (nmods && do_loadrt_batch(nmods, mod_names, mod_args) != 0) {
+        errorcount++;
+    }
+    elapsed[PHASE_LOADRT] = batch_now() - t;
+    counts[PHASE_LOADRT] = nmods;
+    free(mod_names);
+    free(mod_args);
+
+    for (i = 0; i < ncmds && (errorcount == 0 || keep_going); i++) {
+        enum batch_phase phase = batch_classify(cmds[i].tokens);
+        int retval;
+
+        if (phase == PHASE_LOADRT) continue;
+        halcmd_set_filename(cmds[i].filename);
+        halcmd_set_linenumber(cmds[i].linenumber);
+        if (echo_mode) {
+            halcmd_echo("%s\n", cmds[i].line);
+        }
+        t = batch_now();
+        retval = halcmd_parse_cmd(cmds[i].tokens);
+        elapsed[phase] += batch_now() - t;
+        counts[phase]++;
+        /* did a signal happen while we were busy? */
+        if ( halcmd_done ) {
+            errorcount++;
+            break;
+        }
+        if ( retval != 0 ) {
+            errorcount++;
+        }
+    }
+    total = batch_now() - total;
+
+    halcmd_output("Batch startup: %d files, %d commands\n", nfiles, ncmds);
+    for (i = 0; i < PHASE_COUNT; i++) {
+        halcmd_output("  %-10s %6d %10.1f ms\n", batch_phase_names[i],
+            counts[i], elapsed[i] * 1e3);
+    }
+    halcmd_output("  %-10s %6s %10.1f ms\n", "total", "", total * 1e3);
+    return errorcount;
+}
+
 #ifdef HAVE_READLINE
 #include "halcmd_completion.h"
 
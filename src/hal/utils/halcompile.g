@@ -326,6 +326,10 @@ static int comp_id;
             print("%s(%s, %s);" % (decl, name, q(doc)), file=f)
             
     print("", file=f)
+    if options.get("soa"):
+        soa_prologue(f, names)
+        return
+
     print("struct __comp_state {", file=f)
     print("    struct __comp_state *_next;", file=f)
     if has_personality:
@@ -769,9 +773,266 @@ int __comp_parse_names(int *argc, char **argv) {
     print("", file=f)
     print("", file=f)
 
+# With 'option soa', all instances share one 'struct __comp_soa' whose
+# members are arrays indexed by instance number (and, for array pins and
+# params, by instance number * array size + element).  Each function is
+# exported once for the whole component and loops over the instances, so
+# the per-instance state is contiguous in memory.
+def soa_size(array):
+    if isinstance(array, tuple): array = array[0]
+    return array
+
+def soa_index(array, elem):
+    if array: return "__comp_i*(%s)+(%s)" % (soa_size(array), elem)
+    return "__comp_i"
+
+def soa_prologue(f, names):
+    print("struct __comp_soa {", file=f)
+    print("    int count;", file=f)
+    print("    int max;", file=f)
+    for name, type, array, dir, value, personality in pins:
+        print("    hal_%s_t **%s_p;" % (type, to_c(name)), file=f)
+        names[name] = 1
+    for name, type, array, dir, value, personality in params:
+        print("    hal_%s_t *%s_p;" % (type, to_c(name)), file=f)
+        names[name] = 1
+    for type, name, array, value in variables:
+        stars = "*" * name.count("*")
+        name = name.replace("*", "")
+        if array:
+            print("    %s %s(*%s_p)[%d];" % (type, stars, name, array), file=f)
+        else:
+            print("    %s %s*%s_p;" % (type, stars, name), file=f)
+    print("} __comp_soa;", file=f)
+    print("", file=f)
+
+    for name, fp in functions:
+        if name in names:
+            Error("Duplicate item name: %s" % name)
+        print("static inline void %s(long __comp_i, long period);" % to_c(name), file=f)
+        print("static void __comp_soa_%s(void *arg, long period);" % to_c(name), file=f)
+        names[name] = 1
+
+    if options.get("extra_cleanup"):
+        print("static void extra_cleanup(void);", file=f)
+
+    if not options.get("no_convenience_defines"):
+        print("#undef TRUE", file=f)
+        print("#define TRUE (1)", file=f)
+        print("#undef FALSE", file=f)
+        print("#define FALSE (0)", file=f)
+        print("#undef true", file=f)
+        print("#define true (1)", file=f)
+        print("#undef false", file=f)
+        print("#define false (0)", file=f)
+    print("", file=f)
+
+    # allocate the arrays for n instances, before any instance is exported
+    print("static int __comp_soa_alloc(int n) {", file=f)
+    print("    __comp_soa.max = n;", file=f)
+    def alloc(member, count):
+        print("    __comp_soa.%s = hal_malloc((%s) * sizeof(*__comp_soa.%s));" % (member, count, member), file=f)
+        print("    if(!__comp_soa.%s) return -ENOMEM;" % member, file=f)
+        print("    memset((void *)__comp_soa.%s, 0, (%s) * sizeof(*__comp_soa.%s));" % (member, count, member), file=f)
+    for name, type, array, dir, value, personality in pins + params:
+        alloc(to_c(name) + "_p", "n" if not array else "n * (%s)" % soa_size(array))
+    for type, name, array, value in variables:
+        alloc(name.replace("*", "") + "_p", "n")
+    print("    return 0;", file=f)
+    print("}", file=f)
+    print("", file=f)
+
+    print("static int export(char *prefix, long extra_arg) {", file=f)
+    print("    int r = 0;", file=f)
+    print("    long __comp_i = extra_arg;", file=f)
+    if [1 for p in pins + params if p[2]] or [1 for v in variables if v[2]]:
+        print("    int j = 0;", file=f)
+    print("    if(__comp_i < 0 || __comp_i >= __comp_soa.max) {", file=f)
+    print("        rtapi_print_msg(RTAPI_MSG_ERR, \"%s: instance %%ld out of range\\n\", __comp_i);" % comp_name, file=f)
+    print("        return -EINVAL;", file=f)
+    print("    }", file=f)
+    for kind, items in (("pin", pins), ("param", params)):
+        for name, type, array, dir, value, personality in items:
+            if kind == "pin":
+                ref = "__comp_soa.%s_p[%s]" % (to_c(name), soa_index(array, "j"))
+                val = "*(%s)" % ref
+            else:
+                ref = val = "__comp_soa.%s_p[%s]" % (to_c(name), soa_index(array, "j"))
+            if array:
+                print("    for(j=0; j < (%s); j++) {" % soa_size(array), file=f)
+                print("        r = hal_%s_%s_newf(%s, &(%s), comp_id," % (
+                    kind, type, dirmap[dir], ref), file=f)
+                print("            \"%%s%s\", prefix, j);" % to_hal("." + name), file=f)
+                print("        if(r != 0) return r;", file=f)
+                if value is not None:
+                    print("        %s = %s;" % (val, value), file=f)
+                print("    }", file=f)
+            else:
+                print("    r = hal_%s_%s_newf(%s, &(%s), comp_id," % (
+                    kind, type, dirmap[dir], ref), file=f)
+                print("        \"%%s%s\", prefix);" % to_hal("." + name), file=f)
+                print("    if(r != 0) return r;", file=f)
+                if value is not None:
+                    print("    %s = %s;" % (val, value), file=f)
+    for type, name, array, value in variables:
+        if value is None: continue
+        name = name.replace("*", "")
+        if array:
+            print("    for(j=0; j < %s; j++) {" % array, file=f)
+            print("        __comp_soa.%s_p[__comp_i][j] = %s;" % (name, value), file=f)
+            print("    }", file=f)
+        else:
+            print("    __comp_soa.%s_p[__comp_i] = %s;" % (name, value), file=f)
+    print("    if(__comp_i >= __comp_soa.count) __comp_soa.count = __comp_i + 1;", file=f)
+    print("    return 0;", file=f)
+    print("}", file=f)
+
+    soa_rtapi_app(f)
+
+    print("", file=f)
+    if not options.get("no_convenience_defines"):
+        print("#undef FUNCTION", file=f)
+        print("#define FUNCTION(name) static inline void name(long __comp_i, long period)", file=f)
+        print("#undef fperiod", file=f)
+        print("#define fperiod (period * 1e-9)", file=f)
+        for name, type, array, dir, value, personality in pins:
+            c = to_c(name)
+            print("#undef %s" % c, file=f)
+            print("#undef %s_ptr" % c, file=f)
+            zero = "0+" if dir == 'in' else ""
+            if array:
+                print("#define %s_ptr(i) (__comp_soa.%s_p[%s])" % (c, c, soa_index(array, "i")), file=f)
+                print("#define %s(i) (%s*(__comp_soa.%s_p[%s]))" % (c, zero, c, soa_index(array, "i")), file=f)
+            else:
+                print("#define %s_ptr (__comp_soa.%s_p[__comp_i])" % (c, c), file=f)
+                print("#define %s (%s*__comp_soa.%s_p[__comp_i])" % (c, zero, c), file=f)
+        for name, type, array, dir, value, personality in params:
+            c = to_c(name)
+            print("#undef %s" % c, file=f)
+            if array:
+                print("#define %s(i) (__comp_soa.%s_p[%s])" % (c, c, soa_index(array, "i")), file=f)
+            else:
+                print("#define %s (__comp_soa.%s_p[__comp_i])" % (c, c), file=f)
+        for type, name, array, value in variables:
+            name = name.replace("*", "")
+            print("#undef %s" % name, file=f)
+            print("#define %s (__comp_soa.%s_p[__comp_i])" % (name, name), file=f)
+    print("", file=f)
+    print("", file=f)
+
+def soa_rtapi_app(f):
+    print("", file=f)
+    if not options.get("count_function"):
+        print("static int default_count=%s, count=0;" \
+            % options.get("default_count", 1), file=f)
+        print("RTAPI_MP_INT(count, \"number of %s\");" % comp_name, file=f)
+        print("char *names = \"\"; // comma separated names", file=f)
+        print("RTAPI_MP_STRING(names, \"names of %s\");" % comp_name, file=f)
+    else:
+        print("static int get_count(void);", file=f)
+
+    print("int rtapi_app_main(void) {", file=f)
+    print("    int r = 0;", file=f)
+    print("    int i;", file=f)
+    if options.get("count_function"):
+        print("    int count = get_count();", file=f)
+    print("    comp_id = hal_init(\"%s\");" % comp_name, file=f)
+    print("    if(comp_id < 0) return comp_id;", file=f)
+    if options.get("count_function"):
+        print("    r = __comp_soa_alloc(count);", file=f)
+    else:
+        print("    if(count && names[0]) {", file=f)
+        print("        rtapi_print_msg(RTAPI_MSG_ERR," \
+                        "\"count= and names= are mutually exclusive\\n\");", file=f)
+        print("        hal_exit(comp_id);", file=f)
+        print("        return -EINVAL;", file=f)
+        print("    }", file=f)
+        print("    if(!count && !names[0]) count = default_count;", file=f)
+        print("    if(count) {", file=f)
+        print("        r = __comp_soa_alloc(count);", file=f)
+        print("    } else {", file=f)
+        print("        const char *p;", file=f)
+        print("        int n = 1;", file=f)
+        print("        for(p = names; *p; p++) if(*p == ',') n++;", file=f)
+        print("        r = __comp_soa_alloc(n);", file=f)
+        print("    }", file=f)
+    print("    if(r) {", file=f)
+    print("        hal_exit(comp_id);", file=f)
+    print("        return r;", file=f)
+    print("    }", file=f)
+
+    prefix = to_hal(removeprefix(comp_name, "hal_"))
+    if options.get("count_function"):
+        print("    for(i=0; i<count && r == 0; i++) {", file=f)
+    else:
+        print("    if(count) {", file=f)
+        print("        for(i=0; i<count && r == 0; i++) {", file=f)
+    print("            char buf[HAL_NAME_LEN + 1];", file=f)
+    print("            rtapi_snprintf(buf, sizeof(buf), \"%s.%%d\", i);" % prefix, file=f)
+    print("            r = export(buf, i);", file=f)
+    print("        }", file=f)
+    if not options.get("count_function"):
+        print("    } else {", file=f)
+        print("        size_t k, j;", file=f)
+        print("        char buf[HAL_NAME_LEN+1];", file=f)
+        print("        const size_t length = strlen(names);", file=f)
+        print("        for (k = j = i = 0; k <= length; k++) {", file=f)
+        print("            const char c = buf[j] = names[k];", file=f)
+        print("            if ((c == ',') || (c == '\\0')) {", file=f)
+        print("                buf[j] = '\\0';", file=f)
+        print("                r = export(buf, i);", file=f)
+        print("                if(r != 0) {break;}", file=f)
+        print("                i++;", file=f)
+        print("                j = 0;", file=f)
+        print("            } else {", file=f)
+        print("                if (++j == (sizeof(buf) / sizeof(buf[0]))) {", file=f)
+        print("                    buf[j - 1] = '\\0';", file=f)
+        print("                    rtapi_print_msg(RTAPI_MSG_ERR,\"names: \\\"%s\\\" too long\\n\", buf);", file=f)
+        print("                    r = -EINVAL;", file=f)
+        print("                    break;", file=f)
+        print("                }", file=f)
+        print("            }", file=f)
+        print("        }", file=f)
+        print("    }", file=f)
+
+    for name, fp in functions:
+        print("    if(r == 0)", file=f)
+        print("        r = hal_export_funct(\"%s%s\", __comp_soa_%s, 0, %s, 0, comp_id);" % (
+            prefix, to_hal("." + name), to_c(name), int(fp)), file=f)
+    print("    if(r) {", file=f)
+    if options.get("extra_cleanup"):
+        print("        extra_cleanup();", file=f)
+    print("        hal_exit(comp_id);", file=f)
+    print("    } else {", file=f)
+    print("        hal_ready(comp_id);", file=f)
+    print("    }", file=f)
+    print("    return r;", file=f)
+    print("}", file=f)
+    print("", file=f)
+    print("void rtapi_app_exit(void) {", file=f)
+    if options.get("extra_cleanup"):
+        print("    extra_cleanup();", file=f)
+    print("    hal_exit(comp_id);", file=f)
+    print("}", file=f)
+    if options.get("extra_cleanup") and not options.get("no_convenience_defines"):
+        print("#undef EXTRA_CLEANUP", file=f)
+        print("#define EXTRA_CLEANUP() static void extra_cleanup(void)", file=f)
+
+def soa_epilogue(f):
+    for name, fp in functions:
+        print("", file=f)
+        print("static void __comp_soa_%s(void *arg, long period) {" % to_c(name), file=f)
+        print("    long __comp_i;", file=f)
+        print("    for(__comp_i = 0; __comp_i < __comp_soa.count; __comp_i++)", file=f)
+        print("        %s(__comp_i, period);" % to_c(name), file=f)
+        print("}", file=f)
+
 def epilogue(f):
     data = options.get('data')
     print("", file=f)
+    if options.get("soa"):
+        soa_epilogue(f)
+        return
     if data:
         print("static int __comp_get_data_size(void) { return sizeof(%s); }" % data, file=f)
     else:
@@ -970,7 +1231,10 @@ def document(filename, outfilename):
         print(".SH FUNCTIONS", file=f)
         for _, name, fp, doc in finddocs('funct'):
             print(".TP", file=f)
-            print("\\fB%s\\fR" % to_hal_man(name), end='', file=f)
+            if options.get("soa"):
+                print("\\fB%s\\fR" % to_hal_man_unnumbered(name), end='', file=f)
+            else:
+                print("\\fB%s\\fR" % to_hal_man(name), end='', file=f)
             if fp:
                 print(" (requires a floating-point thread)", file=f)
             else:
@@ -1079,6 +1343,16 @@ def process(filename, mode, outfilename):
                 raise SystemExit("Userspace components may not have functions")
         if not pins:
             raise SystemExit("Component must have at least one pin")
+        if options.get("soa"):
+            for o in ("userspace", "singleton", "constructable", "data",
+                    "extra_setup", "homemod", "tpmod"):
+                if options.get(o):
+                    raise SystemExit("Option soa may not be combined with option %s" % o)
+            if not options.get("rtapi_app", 1):
+                raise SystemExit("Option soa requires the automatic rtapi_app_main")
+            for p in pins + params:
+                if p[5] or isinstance(p[2], tuple):
+                    raise SystemExit("Option soa may not be used with personality")
         prologue(f)
         lineno = a.count("\n") + 3
 
@@ -39,6 +39,7 @@ extern "C" {
 #include "cms_xup.hh"		/* class CMS_XDR_UPDATER */
 #include "cms_aup.hh"		/* class CMS_ASCII_UPDATER */
 #include "cms_dup.hh"		/* class CMS_DISPLAY_ASCII_UPDATER */
+#include "cms_pup.hh"		/* class CMS_PACKED_UPDATER */
 #include "rcs_print.hh"		/* rcs_print_error(), separate_words() */
 				/* rcs_print_debug() */
 #include "cmsdiag.hh"
@@ -373,6 +374,10 @@ CMS::CMS(const char *bufline_in, const char *procline_in, int set_to_server)
 	    neutral_encoding_method = CMS_DISPLAY_ASCII_ENCODING;
 	    continue;
 	}
+	if (!strcmp(word[i], "PACKED")) {
+	    neutral_encoding_method = CMS_PACKED_ENCODING;
+	    continue;
+	}
 	if (!strcmp(buflineupper, "ASCII")) {
 	    neutral_encoding_method = CMS_ASCII_ENCODING;
 	    continue;
@@ -632,6 +637,7 @@ void CMS::open(void)
     updater = (CMS_UPDATER *) NULL;
     normal_updater = (CMS_UPDATER *) NULL;
     temp_updater = (CMS_UPDATER *) NULL;
+    packed_updater = (CMS_PACKED_UPDATER *) NULL;
     last_im = CMS_NOT_A_MODE;
     pointer_check_disabled = 0;
 
@@ -681,6 +687,10 @@ void CMS::open(void)
 	    updater = new CMS_DISPLAY_ASCII_UPDATER(this);
 	    break;
 
+	case CMS_PACKED_ENCODING:
+	    updater = packed_updater = new CMS_PACKED_UPDATER(this);
+	    break;
+
 	default:
 	    updater = (CMS_UPDATER *) NULL;
 	    status = CMS_UPDATE_ERROR;
@@ -869,6 +879,7 @@ CMS::~CMS()
     if (NULL != updater) {
 	delete updater;
 	updater = (CMS_UPDATER *) NULL;
+	packed_updater = (CMS_PACKED_UPDATER *) NULL;
     }
 
     /* Free the memory used for the local copy of the global buffer. */
@@ -1125,6 +1136,10 @@ void CMS::set_temp_updater(CMS_NEUTRAL_ENCODING_METHOD temp_encoding_method)
 	    temp_updater = new CMS_DISPLAY_ASCII_UPDATER(this);
 	    break;
 
+	case CMS_PACKED_ENCODING:
+	    temp_updater = new CMS_PACKED_UPDATER(this);
+	    break;
+
 	default:
 	    temp_updater = (CMS_UPDATER *) NULL;
 	    status = CMS_UPDATE_ERROR;
@@ -1136,12 +1151,16 @@ void CMS::set_temp_updater(CMS_NEUTRAL_ENCODING_METHOD temp_encoding_method)
     if (NULL != temp_updater) {
 	updater = temp_updater;
 	temp_updater_encoding_method = temp_encoding_method;
+	packed_updater = temp_encoding_method == CMS_PACKED_ENCODING ?
+	    (CMS_PACKED_UPDATER *) temp_updater : (CMS_PACKED_UPDATER *) NULL;
     }
 }
 
 void CMS::restore_normal_updater()
 {
     updater = normal_updater;
+    packed_updater = neutral_encoding_method == CMS_PACKED_ENCODING ?
+	(CMS_PACKED_UPDATER *) normal_updater : (CMS_PACKED_UPDATER *) NULL;
 }
 
 /* Updater Positioning Functions. */
@@ -1299,8 +1318,12 @@ void CMS::set_cms_status(CMS_STATUS new_status)
 }
 
   /* Access functions for primitive C language data types */
+  /* (for the packed updater, the inline functions are called directly) */
 CMS_STATUS CMS::update(bool &x)
 {
+    if (NULL != packed_updater) {
+	return (packed_updater->update(x));
+    }
     if (NULL != updater) {
 	return (updater->update(x));
     } else {
@@ -1310,6 +1333,9 @@ CMS_STATUS CMS::update(bool &x)
 
 CMS_STATUS CMS::update(char &x)
 {
+    if (NULL != packed_updater) {
+	return (packed_updater->update(x));
+    }
     if (NULL != updater) {
 	return (updater->update(x));
     } else {
@@ -1319,6 +1345,9 @@ CMS_STATUS CMS::update(char &x)
 
 CMS_STATUS CMS::update(unsigned char &x)
 {
+    if (NULL != packed_updater) {
+	return (packed_updater->update(x));
+    }
     if (NULL != updater) {
 	return (updater->update(x));
     } else {
@@ -1328,6 +1357,9 @@ CMS_STATUS CMS::update(unsigned char &x)
 
 CMS_STATUS CMS::update(short int &x)
 {
+    if (NULL != packed_updater) {
+	return (packed_updater->update(x));
+    }
     if (NULL != updater) {
 	return (updater->update(x));
     } else {
@@ -1337,6 +1369,9 @@ CMS_STATUS CMS::update(short int &x)
 
 CMS_STATUS CMS::update(unsigned short int &x)
 {
+    if (NULL != packed_updater) {
+	return (packed_updater->update(x));
+    }
     if (NULL != updater) {
 	return (updater->update(x));
     } else {
@@ -1346,6 +1381,9 @@ CMS_STATUS CMS::update(unsigned short int &x)
 
 CMS_STATUS CMS::update(int &x)
 {
+    if (NULL != packed_updater) {
+	return (packed_updater->update(x));
+    }
     if (NULL != updater) {
 	return (updater->update(x));
     } else {
@@ -1355,6 +1393,9 @@ CMS_STATUS CMS::update(int &x)
 
 CMS_STATUS CMS::update(unsigned int &x)
 {
+    if (NULL != packed_updater) {
+	return (packed_updater->update(x));
+    }
     if (NULL != updater) {
 	return (updater->update(x));
     } else {
@@ -1364,6 +1405,9 @@ CMS_STATUS CMS::update(unsigned int &x)
 
 CMS_STATUS CMS::update(long int &x)
 {
+    if (NULL != packed_updater) {
+	return (packed_updater->update(x));
+    }
     if (NULL != updater) {
 	return (updater->update(x));
     } else {
@@ -1373,6 +1417,9 @@ CMS_STATUS CMS::update(long int &x)
 
 CMS_STATUS CMS::update(unsigned long int &x)
 {
+    if (NULL != packed_updater) {
+	return (packed_updater->update(x));
+    }
     if (NULL != updater) {
 	return (updater->update(x));
     } else {
@@ -1382,6 +1429,9 @@ CMS_STATUS CMS::update(unsigned long int &x)
 
 CMS_STATUS CMS::update(float &x)
 {
+    if (NULL != packed_updater) {
+	return (packed_updater->update(x));
+    }
     if (NULL != updater) {
 	return (updater->update(x));
     } else {
@@ -1391,6 +1441,9 @@ CMS_STATUS CMS::update(float &x)
 
 CMS_STATUS CMS::update(double &x)
 {
+    if (NULL != packed_updater) {
+	return (packed_updater->update(x));
+    }
     if (NULL != updater) {
 	return (updater->update(x));
     } else {
@@ -1400,6 +1453,9 @@ CMS_STATUS CMS::update(double &x)
 
 CMS_STATUS CMS::update(long double &x)
 {
+    if (NULL != packed_updater) {
+	return (packed_updater->update(x));
+    }
     if (NULL != updater) {
 	return (updater->update(x));
     } else {
@@ -1409,6 +1465,9 @@ CMS_STATUS CMS::update(long double &x)
 
 CMS_STATUS CMS::update(char *x, unsigned int len)
 {
+    if (NULL != packed_updater) {
+	return (packed_updater->update(x, len));
+    }
     if (NULL != updater) {
 	return (updater->update(x, len));
     } else {
@@ -1418,6 +1477,9 @@ CMS_STATUS CMS::update(char *x, unsigned int len)
 
 CMS_STATUS CMS::update(unsigned char *x, unsigned int len)
 {
+    if (NULL != packed_updater) {
+	return (packed_updater->update(x, len));
+    }
     if (NULL != updater) {
 	return (updater->update(x, len));
     } else {
@@ -1427,6 +1489,9 @@ CMS_STATUS CMS::update(unsigned char *x, unsigned int len)
 
 CMS_STATUS CMS::update(short *x, unsigned int len)
 {
+    if (NULL != packed_updater) {
+	return (packed_updater->update(x, len));
+    }
     if (NULL != updater) {
 	return (updater->update(x, len));
     } else {
@@ -1436,6 +1501,9 @@ CMS_STATUS CMS::update(short *x, unsigned int len)
 
 CMS_STATUS CMS::update(unsigned short *x, unsigned int len)
 {
+    if (NULL != packed_updater) {
+	return (packed_updater->update(x, len));
+    }
     if (NULL != updater) {
 	return (updater->update(x, len));
     } else {
@@ -1445,6 +1513,9 @@ CMS_STATUS CMS::update(unsigned short *x, unsigned int len)
 
 CMS_STATUS CMS::update(int *x, unsigned int len)
 {
+    if (NULL != packed_updater) {
+	return (packed_updater->update(x, len));
+    }
     if (NULL != updater) {
 	return (updater->update(x, len));
     } else {
@@ -1454,6 +1525,9 @@ CMS_STATUS CMS::update(int *x, unsigned int len)
 
 CMS_STATUS CMS::update(unsigned int *x, unsigned int len)
 {
+    if (NULL != packed_updater) {
+	return (packed_updater->update(x, len));
+    }
     if (NULL != updater) {
 	return (updater->update(x, len));
     } else {
@@ -1463,6 +1537,9 @@ CMS_STATUS CMS::update(unsigned int *x, unsigned int len)
 
 CMS_STATUS CMS::update(long *x, unsigned int len)
 {
+    if (NULL != packed_updater) {
+	return (packed_updater->update(x, len));
+    }
     if (NULL != updater) {
 	return (updater->update(x, len));
     } else {
@@ -1472,6 +1549,9 @@ CMS_STATUS CMS::update(long *x, unsigned int len)
 
 CMS_STATUS CMS::update(unsigned long *x, unsigned int len)
 {
+    if (NULL != packed_updater) {
+	return (packed_updater->update(x, len));
+    }
     if (NULL != updater) {
 	return (updater->update(x, len));
     } else {
@@ -1481,6 +1561,9 @@ CMS_STATUS CMS::update(unsigned long *x, unsigned int len)
 
 CMS_STATUS CMS::update(float *x, unsigned int len)
 {
+    if (NULL != packed_updater) {
+	return (packed_updater->update(x, len));
+    }
     if (NULL != updater) {
 	return (updater->update(x, len));
     } else {
@@ -1490,6 +1573,9 @@ CMS_STATUS CMS::update(float *x, unsigned int len)
 
 CMS_STATUS CMS::update(double *x, unsigned int len)
 {
+    if (NULL != packed_updater) {
+	return (packed_updater->update(x, len));
+    }
     if (NULL != updater) {
 	return (updater->update(x, len));
     } else {
@@ -1499,6 +1585,9 @@ CMS_STATUS CMS::update(double *x, unsigned int len)
 
 CMS_STATUS CMS::update(long double *x, unsigned int len)
 {
+    if (NULL != packed_updater) {
+	return (packed_updater->update(x, len));
+    }
     if (NULL != updater) {
 	return (updater->update(x, len));
     } else {
@@ -163,12 +163,14 @@ enum CMS_NEUTRAL_ENCODING_METHOD {
     CMS_NO_ENCODING,
     CMS_XDR_ENCODING,
     CMS_ASCII_ENCODING,
-    CMS_DISPLAY_ASCII_ENCODING
+    CMS_DISPLAY_ASCII_ENCODING,
+    CMS_PACKED_ENCODING
 };
 
 /* CMS class declaration. */
 class CMS;
 class CMS_UPDATER;
+class CMS_PACKED_UPDATER;
 
 /* CMS class definition. */
 class CMS {
@@ -431,6 +433,8 @@ class CMS {
     CMS_UPDATER *updater;
     CMS_UPDATER *normal_updater;
     CMS_UPDATER *temp_updater;
+    CMS_PACKED_UPDATER *packed_updater;	/* updater, if that is packed, to
+					   call it without virtual calls */
 
   private:
     unsigned long encode_state;	/* Store position for save, restore. */
@@ -0,0 +1,188 @@
+/********************************************************************
+* Description: cms_pup.cc
+*   Buffer handling of the packed binary CMS updater, see cms_pup.hh.
+*   The update functions themselves are inline in the header.
+*
+* License: LGPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+********************************************************************/
+
+extern "C" {
+#include <stdlib.h>		/* malloc(), free() */
+}
+
+#include "cms.hh"		/* class CMS */
+#include "cms_pup.hh"		/* class CMS_PACKED_UPDATER */
+#include "rcs_print.hh"		/* rcs_print_error() */
+
+/* Member functions for CMS_PACKED_UPDATER Class */
+CMS_PACKED_UPDATER::CMS_PACKED_UPDATER(CMS * _cms_parent):
+CMS_UPDATER(_cms_parent, 0, 2)
+{
+    buffer = NULL;
+    buffer_size = 0;
+    memset(offsets, 0, sizeof(offsets));
+    position = &offsets[CMS_NO_UPDATE];
+    encoded_header = NULL;
+    encoded_queuing_header = NULL;
+
+    if (!cms_parent->isserver) {
+	encoded_data = NULL;
+    }
+    using_external_encoded_data = 0;
+
+    /* Nothing packs to more than twice its size in memory, so these
+       are large enough without finding out the size of each. */
+    encoded_header = malloc(neutral_size_factor * sizeof(CMS_HEADER));
+    if (encoded_header == NULL) {
+	rcs_print_error("CMS:can't malloc encoded_header");
+	status = CMS_CREATE_ERROR;
+	return;
+    }
+    if (cms_parent->queuing_enabled) {
+	encoded_queuing_header =
+	    malloc(neutral_size_factor * sizeof(CMS_QUEUING_HEADER));
+	if (encoded_queuing_header == NULL) {
+	    rcs_print_error("CMS:can't malloc encoded_queuing_header");
+	    status = CMS_CREATE_ERROR;
+	    return;
+	}
+    }
+    if (!cms_parent->isserver) {
+	if (cms_parent->enc_max_size > 0
+	    && cms_parent->enc_max_size < neutral_size_factor * size) {
+	    set_encoded_data(malloc(cms_parent->enc_max_size),
+		cms_parent->enc_max_size);
+	} else {
+	    set_encoded_data(malloc(neutral_size_factor * size),
+		neutral_size_factor * size);
+	}
+    }
+    using_external_encoded_data = 0;
+}
+
+CMS_PACKED_UPDATER::~CMS_PACKED_UPDATER()
+{
+    if (NULL != encoded_data && !using_external_encoded_data) {
+	free(encoded_data);
+	encoded_data = NULL;
+    }
+    if (NULL != encoded_header) {
+	free(encoded_header);
+	encoded_header = NULL;
+    }
+    if (NULL != encoded_queuing_header) {
+	free(encoded_queuing_header);
+	encoded_queuing_header = NULL;
+    }
+}
+
+void CMS_PACKED_UPDATER::set_encoded_data(void *_encoded_data,
+    long _encoded_data_size)
+{
+    /* If the encoded data area has already been setup then release it. */
+    if (NULL != encoded_data && !using_external_encoded_data) {
+	free(encoded_data);
+	encoded_data = NULL;
+    }
+
+    encoded_data_size = _encoded_data_size;
+    encoded_data = _encoded_data;
+    using_external_encoded_data = 1;
+    if (encoded_data == NULL) {
+	rcs_print_error
+	    ("CMS: Attempt to set  encoded_data buffer to NULL.\n");
+	status = CMS_MISC_ERROR;
+	return;
+    }
+    offsets[CMS_ENCODE_DATA] = offsets[CMS_DECODE_DATA] = 0;
+    if (mode == CMS_ENCODE_DATA || mode == CMS_DECODE_DATA) {
+	set_mode(mode);
+    }
+}
+
+int CMS_PACKED_UPDATER::set_mode(CMS_UPDATER_MODE _mode)
+{
+    if (CMS_UPDATER::set_mode(_mode) < 0) {
+	return (-1);
+    }
+    position = &offsets[mode];
+    switch (mode) {
+    case CMS_NO_UPDATE:
+	buffer = NULL;
+	buffer_size = 0;
+	break;
+
+    case CMS_ENCODE_DATA:
+    case CMS_DECODE_DATA:
+	/* limited like the XDR data streams */
+	buffer = (unsigned char *) encoded_data;
+	buffer_size = encoded_data_size;
+	if (cms_parent->max_encoded_message_size > 0
+	    && buffer_size > cms_parent->max_encoded_message_size) {
+	    buffer_size = cms_parent->max_encoded_message_size;
+	}
+	if (cms_parent->enc_max_size > 0
+	    && buffer_size > cms_parent->enc_max_size) {
+	    buffer_size = cms_parent->enc_max_size;
+	}
+	break;
+
+    case CMS_ENCODE_HEADER:
+    case CMS_DECODE_HEADER:
+	buffer = (unsigned char *) encoded_header;
+	buffer_size = neutral_size_factor * sizeof(CMS_HEADER);
+	break;
+
+    case CMS_ENCODE_QUEUING_HEADER:
+    case CMS_DECODE_QUEUING_HEADER:
+	buffer = (unsigned char *) encoded_queuing_header;
+	buffer_size = neutral_size_factor * sizeof(CMS_QUEUING_HEADER);
+	break;
+    }
+    return (0);
+}
+
+int CMS_PACKED_UPDATER::check_pointer(char *_pointer, long _bytes)
+{
+    return room(_pointer, _bytes, _bytes);
+}
+
+int CMS_PACKED_UPDATER::full(long packed_bytes)
+{
+    if (NULL == buffer) {
+	rcs_print_error("CMS_PACKED_UPDATER: Required pointer is NULL.\n");
+	return (-1);
+    }
+    rcs_print_error
+	("Encoded message buffer full. (position=%ld,_bytes=%ld,(position+_bytes)=%ld,buffer_size=%ld)\n",
+	*position, packed_bytes, *position + packed_bytes, buffer_size);
+    return (-1);
+}
+
+/* Repositions the data buffer to the very beginning */
+void CMS_PACKED_UPDATER::rewind()
+{
+    CMS_UPDATER::rewind();
+    if (NULL != buffer) {
+	*position = 0;
+    } else {
+	rcs_print_error
+	    ("CMS_PACKED_UPDATER: Can't rewind because there is no buffer.\n");
+    }
+    if (NULL != cms_parent) {
+	cms_parent->format_size = 0;
+    }
+}
+
+int CMS_PACKED_UPDATER::get_encoded_msg_size()
+{
+    if (NULL == buffer) {
+	rcs_print_error
+	    ("CMS_PACKED_UPDATER can not provide encoded_msg_size because there is no buffer.\n");
+	return (-1);
+    }
+    return ((int) *position);
+}
@@ -0,0 +1,164 @@
+/********************************************************************
+* Description: cms_pup.hh
+*   Packed binary neutral encoding, selected with "packed" on the
+*   buffer line of the NML file instead of "xdr".
+*
+*   Each value is stored little-endian at a fixed size, without any
+*   padding: bool and char take 1 byte, short 2, int and float 4, long
+*   and double 8, and a long double goes as a double.  A message is laid
+*   out in the order of the update calls of its type, like with XDR.
+*   Where that is also how the values sit in memory (arrays of
+*   everything but long double on a little-endian host, and long on
+*   64 bit ones) they are copied in one piece, and CMS calls the
+*   scalar functions of this class directly rather than through the
+*   virtual CMS_UPDATER interface.
+*
+*   Both ends of a channel have to be configured with the same encoding.
+*
+* License: LGPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+********************************************************************/
+
+#ifndef CMS_PUP_HH
+#define CMS_PUP_HH
+
+#include <stdint.h>		/* int64_t */
+#include <string.h>		/* memcpy() */
+#include "cms_up.hh"		/* class CMS_UPDATER */
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define CMS_PACKED_HOST_ORDER 1
+#else
+#define CMS_PACKED_HOST_ORDER 0
+#endif
+
+class CMS_PACKED_UPDATER final:public CMS_UPDATER {
+  public:
+    CMS_STATUS update(bool &x) {
+	if (-1 == room((char *) &x, sizeof(bool), 1)) {
+	    return (CMS_UPDATE_ERROR);
+	}
+	if (encoding) {
+	    buffer[*position] = x ? 1 : 0;
+	} else {
+	    x = buffer[*position] != 0;
+	}
+	(*position)++;
+	return (status);
+    }
+    CMS_STATUS update(char &x) { return copy(&x, 1); }
+    CMS_STATUS update(unsigned char &x) { return copy(&x, 1); }
+    CMS_STATUS update(short int &x) { return copy(&x, 1); }
+    CMS_STATUS update(unsigned short int &x) { return copy(&x, 1); }
+    CMS_STATUS update(int &x) { return copy(&x, 1); }
+    CMS_STATUS update(unsigned int &x) { return copy(&x, 1); }
+    CMS_STATUS update(long int &x) { return update(&x, 1); }
+    CMS_STATUS update(unsigned long int &x) { return update(&x, 1); }
+    CMS_STATUS update(float &x) { return copy(&x, 1); }
+    CMS_STATUS update(double &x) { return copy(&x, 1); }
+    CMS_STATUS update(long double &x) { return convert<long double, double>(&x, 1); }
+    CMS_STATUS update(char *x, unsigned int len) { return copy(x, len); }
+    CMS_STATUS update(unsigned char *x, unsigned int len) { return copy(x, len); }
+    CMS_STATUS update(short *x, unsigned int len) { return copy(x, len); }
+    CMS_STATUS update(unsigned short *x, unsigned int len) { return copy(x, len); }
+    CMS_STATUS update(int *x, unsigned int len) { return copy(x, len); }
+    CMS_STATUS update(unsigned int *x, unsigned int len) { return copy(x, len); }
+    CMS_STATUS update(long *x, unsigned int len) {
+	return sizeof(long) == sizeof(int64_t) ? copy(x, len) :
+	    convert<long, int64_t>(x, len);
+    }
+    CMS_STATUS update(unsigned long *x, unsigned int len) {
+	return sizeof(unsigned long) == sizeof(uint64_t) ? copy(x, len) :
+	    convert<unsigned long, uint64_t>(x, len);
+    }
+    CMS_STATUS update(float *x, unsigned int len) { return copy(x, len); }
+    CMS_STATUS update(double *x, unsigned int len) { return copy(x, len); }
+    CMS_STATUS update(long double *x, unsigned int len) {
+	return convert<long double, double>(x, len);
+    }
+    int set_mode(CMS_UPDATER_MODE);
+    void rewind();
+    int get_encoded_msg_size();
+    void set_encoded_data(void *, long _encoded_data_size);
+  protected:
+    int check_pointer(char *, long);
+      CMS_PACKED_UPDATER(CMS *);
+      virtual ~ CMS_PACKED_UPDATER();
+    friend class CMS;
+
+  private:
+    /* Checks that bytes at x are in the message and packed_bytes more fit
+       into the current buffer. */
+    int room(char *x, long bytes, long packed_bytes) {
+	if (NULL == buffer || *position + packed_bytes > buffer_size) {
+	    return full(packed_bytes);
+	}
+	return (cms_parent->check_pointer(x, bytes));
+    }
+    int full(long packed_bytes);
+
+    /* Moves n bytes of one value between x and the buffer. */
+    void move(void *x, size_t n) {
+	unsigned char *p = buffer + *position;
+	if (CMS_PACKED_HOST_ORDER || n == 1) {
+	    if (encoding) {
+		memcpy(p, x, n);
+	    } else {
+		memcpy(x, p, n);
+	    }
+	} else {
+	    for (size_t i = 0; i < n; i++) {
+		if (encoding) {
+		    p[i] = ((unsigned char *) x)[n - 1 - i];
+		} else {
+		    ((unsigned char *) x)[n - 1 - i] = p[i];
+		}
+	    }
+	}
+	*position += n;
+    }
+
+    /* Values packed as they are in memory, in one piece on a
+       little-endian host. */
+    template <class T> CMS_STATUS copy(T *x, unsigned int len) {
+	long bytes = (long) sizeof(T) * len;
+	if (-1 == room((char *) x, bytes, bytes)) {
+	    return (CMS_UPDATE_ERROR);
+	}
+	if (CMS_PACKED_HOST_ORDER || sizeof(T) == 1) {
+	    move(x, bytes);
+	} else {
+	    for (unsigned int i = 0; i < len; i++) {
+		move(&x[i], sizeof(T));
+	    }
+	}
+	return (status);
+    }
+
+    /* Values packed as type P. */
+    template <class T, class P> CMS_STATUS convert(T *x, unsigned int len) {
+	if (-1 == room((char *) x, (long) sizeof(T) * len,
+		(long) sizeof(P) * len)) {
+	    return (CMS_UPDATE_ERROR);
+	}
+	for (unsigned int i = 0; i < len; i++) {
+	    P p = (P) x[i];
+	    move(&p, sizeof(P));
+	    if (!encoding) {
+		x[i] = (T) p;
+	    }
+	}
+	return (status);
+    }
+
+    unsigned char *buffer;	/* the data, header or queuing header */
+    long buffer_size;
+    long *position;		/* in buffer, one of offsets */
+    long offsets[CMS_DECODE_QUEUING_HEADER + 1];	/* for each mode, as
+							   the XDR streams */
+};
+
+#endif
+// !defined(CMS_PUP_HH)
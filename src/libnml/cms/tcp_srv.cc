@@ -29,8 +29,9 @@ extern "C" {
 #include <string.h>		/* memset(), strerror() */
 #include <stdlib.h>		// malloc(), free()
 #include <unistd.h>
+#include <fcntl.h>		/* fcntl(), O_NONBLOCK */
 #include <sys/socket.h>
-#include <sys/ioctl.h>
+#include <sys/epoll.h>		/* epoll_create1(), epoll_wait() */
 #include <errno.h>		/* errno */
 #include <signal.h>		// SIGPIPE, signal()
 
@@ -39,7 +40,6 @@ extern "C" {
 #endif
 
 #include <sys/types.h>
-#include <sys/wait.h>		// waitpid
 
 #include <arpa/inet.h>		/* inet_ntoa */
 #include "cms.hh"		/* class CMS */
@@ -51,16 +51,18 @@ extern "C" {
 #include "timer.hh"		// esleep()
 #include "_timer.h"
 #include "cmsdiag.hh"		// class CMS_DIAGNOSTICS_INFO
-extern "C" {
-#include "recvn.h"		/* recvn() */
-#include "sendn.h"		/* sendn() */
-}
 #include "physmem.hh"           // PHYSMEM_HANDLE
 
-int tcpsvr_threads_created = 0;
-int tcpsvr_threads_killed = 0;
-int tcpsvr_threads_exited = 0;
-int tcpsvr_threads_returned_early = 0;
+/* The server runs as one loop over all clients, waiting with epoll.
+   Requests are collected from the non-blocking sockets until complete
+   and handled one at a time.  Replies go out as far as the socket takes
+   them, the rest is queued for the client and sent when it can take
+   more, so that a slow client holds up nobody but itself.  A blocking
+   read waits for a new message on the client instead of on a thread or
+   process of its own, with the loop looking at its buffer again every
+   TCPSVR_BLOCKING_READ_POLL_MILLIS and after each request.  */
+
+struct TCPSVR_STATS tcpsvr_stats;
 
 TCPSVR_BLOCKING_READ_REQUEST::TCPSVR_BLOCKING_READ_REQUEST()
 {
@@ -78,6 +80,7 @@ TCPSVR_BLOCKING_READ_REQUEST::TCPSVR_BLOCKING_READ_REQUEST()
     _reply = NULL;
     _data = NULL;
     read_reply = NULL;
+    deadline = -1.0;
 }
 
 static inline double tcp_svr_reverse_double(double in)
@@ -133,7 +136,8 @@ CMS_SERVER_REMOTE_PORT(_cms_server)
     client_ports = (LinkedList *) NULL;
     connection_socket = 0;
     connection_port = 0;
-    maxfdpl = 0;
+    epoll_fd = -1;
+    server = NULL;
     dtimeout = 20.0;
 
     memset(&server_socket_address, 0, sizeof(server_socket_address));
@@ -147,13 +151,8 @@ CMS_SERVER_REMOTE_PORT(_cms_server)
 	return;
     }
     polling_enabled = 0;
-    memset(&select_timeout, 0, sizeof(select_timeout));
-    select_timeout.tv_sec = 30;
-    select_timeout.tv_usec = 30;
     subscription_buffers = NULL;
     current_poll_interval_millis = 30000;
-    memset(&read_fd_set, 0, sizeof(read_fd_set));
-    memset(&write_fd_set, 0, sizeof(write_fd_set));
 }
 
 CMS_SERVER_REMOTE_TCP_PORT::~CMS_SERVER_REMOTE_TCP_PORT()
@@ -166,23 +165,6 @@ CMS_SERVER_REMOTE_TCP_PORT::~CMS_SERVER_REMOTE_TCP_PORT()
     }
 }
 
-void blocking_thread_kill(long int id)
-{
-
-    if (id <= 0) {
-	return;
-    }
-#ifdef POSIX_THREADS
-    pthread_kill(id, SIGINT);
-    pthread_join(id, NULL);
-#endif
-#ifdef NO_THREADS
-    kill(id, SIGINT);
-    waitpid(id, NULL, 0);
-#endif
-    tcpsvr_threads_killed++;
-}
-
 void CMS_SERVER_REMOTE_TCP_PORT::unregister_port()
 {
     CLIENT_TCP_PORT *client;
@@ -219,6 +201,11 @@ void CMS_SERVER_REMOTE_TCP_PORT::unregister_port()
 	close(connection_socket);
 	connection_socket = 0;
     }
+    if (epoll_fd >= 0) {
+	print_stats(PRINT_CMS_CONFIG_INFO);
+	close(epoll_fd);
+	epoll_fd = -1;
+    }
 }
 
 int CMS_SERVER_REMOTE_TCP_PORT::accept_local_port_cms(CMS * _cms)
@@ -301,361 +288,642 @@ static void handle_pipe_error(int signum)
     rcs_print_error("SIGPIPE intercepted.\n");
 }
 
+static volatile sig_atomic_t tcpsvr_print_stats_requested = 0;
+
+static void handle_print_stats(int signum)
+{
+    tcpsvr_print_stats_requested = 1;
+}
+
+static void putbe32(char *addr, uint32_t val) {
+    val = htonl(val);
+    memcpy(addr, &val, sizeof(val));
+}
+
+static uint32_t getbe32(char *addr) {
+    uint32_t val;
+    memcpy(&val, addr, sizeof(val));
+    return ntohl(val);
+}
+
+/* Makes a request or reply buffer hold at least size bytes. */
+static int tcpsvr_grow(char **buffer, long *buffer_size, long size)
+{
+    if (size <= *buffer_size) {
+	return 0;
+    }
+    long new_size = 2 * *buffer_size;
+    if (new_size < 0x2000) {
+	new_size = 0x2000;
+    }
+    if (new_size < size) {
+	new_size = size;
+    }
+    char *new_buffer = (char *) realloc(*buffer, new_size);
+    if (NULL == new_buffer) {
+	rcs_print_error("TCP server: can not allocate %ld bytes.\n",
+	    new_size);
+	return -1;
+    }
+    *buffer = new_buffer;
+    *buffer_size = new_size;
+    return 0;
+}
+
+#define TCPSVR_MAX_EVENTS 64
+
 void CMS_SERVER_REMOTE_TCP_PORT::run()
 {
-    int bytes_ready;
+    struct epoll_event events[TCPSVR_MAX_EVENTS];
+    struct epoll_event connection_event;
     int ready_descriptors;
+    int timeout_millis;
+    int blocking_reads = 0;
     if (NULL == client_ports) {
 	rcs_print_error("CMS_SERVER: List of client ports is NULL.\n");
 	return;
     }
-    CLIENT_TCP_PORT *new_client_port, *client_port_to_check;
-    FD_ZERO(&read_fd_set);
-    FD_ZERO(&write_fd_set);
-    FD_SET(connection_socket, &read_fd_set);
-    maxfdpl = connection_socket + 1;
+    CLIENT_TCP_PORT *client_port_to_check;
+    server = find_server(getpid(), 0);
+    if (NULL == server) {
+	rcs_print_error
+	    ("CMS_SERVER_REMOTE_TCP_PORT::run() Cannot find server object for pid = %d.\n",
+	    getpid());
+	return;
+    }
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+	rcs_print_error("server: epoll_create1 error.(errno = %d | %s)\n",
+	    errno, strerror(errno));
+	return;
+    }
+    fcntl(connection_socket, F_SETFL,
+	fcntl(connection_socket, F_GETFL) | O_NONBLOCK);
+    memset(&connection_event, 0, sizeof(connection_event));
+    connection_event.events = EPOLLIN;
+    connection_event.data.ptr = NULL;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, connection_socket,
+	    &connection_event) < 0) {
+	rcs_print_error("server: epoll_ctl error.(errno = %d | %s)\n",
+	    errno, strerror(errno));
+	return;
+    }
     signal(SIGPIPE, handle_pipe_error);
+    signal(SIGUSR1, handle_print_stats);
     rcs_print_debug(PRINT_CMS_CONFIG_INFO,
 	"running server for TCP port %d (connection_socket = %d).\n",
 	ntohs(server_socket_address.sin_port), connection_socket);
 
     cms_server_count++;
-    fd_set read_fd_set_copy, write_fd_set_copy;
-    FD_ZERO(&read_fd_set_copy);
-    FD_ZERO(&write_fd_set_copy);
-    FD_SET(connection_socket, &read_fd_set_copy);
 
     while (1) {
+	timeout_millis = -1;
 	if (polling_enabled) {
-	    memcpy(&read_fd_set_copy, &read_fd_set, sizeof(fd_set));
-	    memcpy(&write_fd_set_copy, &write_fd_set, sizeof(fd_set));
-	    select_timeout.tv_sec = current_poll_interval_millis / 1000;
-	    select_timeout.tv_usec =
-		(current_poll_interval_millis % 1000) * 1000;
-	    ready_descriptors =
-		select(maxfdpl, &read_fd_set, &write_fd_set,
-		(fd_set *) NULL, (timeval *) & select_timeout);
-	    if (ready_descriptors == 0) {
-		update_subscriptions();
-		memcpy(&read_fd_set, &read_fd_set_copy, sizeof(fd_set));
-		memcpy(&write_fd_set, &write_fd_set_copy, sizeof(fd_set));
-		continue;
-	    }
-	} else {
-	    ready_descriptors =
-		select(maxfdpl, &read_fd_set, &write_fd_set,
-		(fd_set *) NULL, (timeval *) NULL);
-
-	}
-	if (ready_descriptors < 0) {
-	    rcs_print_error("server: select error.(errno = %d | %s)\n",
-		errno, strerror(errno));
+	    timeout_millis = current_poll_interval_millis;
 	}
-	if (NULL == client_ports) {
-	    rcs_print_error("CMS_SERVER: List of client ports is NULL.\n");
-	    return;
+	if (blocking_reads > 0 && (timeout_millis < 0 ||
+		timeout_millis > TCPSVR_BLOCKING_READ_POLL_MILLIS)) {
+	    timeout_millis = TCPSVR_BLOCKING_READ_POLL_MILLIS;
 	}
-	client_port_to_check = (CLIENT_TCP_PORT *) client_ports->get_head();
-	while (NULL != client_port_to_check) {
-	    if (FD_ISSET(client_port_to_check->socket_fd, &read_fd_set)) {
-		ioctl(client_port_to_check->socket_fd, FIONREAD,
-		    (caddr_t) & bytes_ready);
-		if (bytes_ready <= 0) {
-		    rcs_print_debug(PRINT_SOCKET_CONNECT,
-			"Socket closed by host with IP address %s.\n",
-			inet_ntoa(client_port_to_check->address.sin_addr));
-		    if (NULL != client_port_to_check->subscriptions) {
-			TCP_CLIENT_SUBSCRIPTION_INFO *clnt_sub_info =
-			    (TCP_CLIENT_SUBSCRIPTION_INFO *)
-			    client_port_to_check->subscriptions->get_head();
-			while (NULL != clnt_sub_info) {
-			    if (NULL != clnt_sub_info->sub_buf_info &&
-				clnt_sub_info->subscription_list_id >= 0) {
-				if (NULL !=
-				    clnt_sub_info->sub_buf_info->
-				    sub_clnt_info) {
-				    clnt_sub_info->sub_buf_info->
-					sub_clnt_info->
-					delete_node(clnt_sub_info->
-					subscription_list_id);
-				    if (clnt_sub_info->sub_buf_info->
-					sub_clnt_info->list_size < 1) {
-					delete clnt_sub_info->sub_buf_info->
-					    sub_clnt_info;
-					clnt_sub_info->sub_buf_info->
-					    sub_clnt_info = NULL;
-					if (NULL != subscription_buffers
-					    && clnt_sub_info->sub_buf_info->
-					    list_id >= 0) {
-					    subscription_buffers->
-						delete_node(clnt_sub_info->
-						sub_buf_info->list_id);
-					    delete clnt_sub_info->
-						sub_buf_info;
-					    clnt_sub_info->sub_buf_info =
-						NULL;
-					}
-				    }
-				    clnt_sub_info->sub_buf_info = NULL;
-				}
-				delete clnt_sub_info;
-				clnt_sub_info =
-				    (TCP_CLIENT_SUBSCRIPTION_INFO *)
-				    client_port_to_check->subscriptions->
-				    get_next();
-			    }
-			    delete client_port_to_check->subscriptions;
-			    client_port_to_check->subscriptions = NULL;
-			    recalculate_polling_interval();
-			}
-		    }
-		    if (client_port_to_check->threadId > 0
-			&& client_port_to_check->blocking) {
-			blocking_thread_kill(client_port_to_check->threadId);
-		    }
-		    close(client_port_to_check->socket_fd);
-		    FD_CLR(client_port_to_check->socket_fd, &read_fd_set);
-		    client_port_to_check->socket_fd = -1;
-		    delete client_port_to_check;
-		    client_ports->delete_current_node();
-		} else {
-		    if (client_port_to_check->blocking) {
-			if (client_port_to_check->threadId > 0) {
-			    rcs_print_debug(PRINT_SERVER_THREAD_ACTIVITY,
-				"Data received from %s:%d when it should be blocking (bytes_ready=%d).\n",
-				inet_ntoa
-				(client_port_to_check->address.
-				    sin_addr),
-				client_port_to_check->socket_fd, bytes_ready);
-			    rcs_print_debug(PRINT_SERVER_THREAD_ACTIVITY,
-				"Killing handler %d.\n",
-				client_port_to_check->threadId);
-
-			    blocking_thread_kill
-				(client_port_to_check->threadId);
-#if 0
-			    *((uint32_t *) temp_buffer) =
-				htonl(client_port_to_check->serial_number);
-			    *((uint32_t *) temp_buffer + 1) =
-				htonl((unsigned long)
-				CMS_SERVER_SIDE_ERROR);
-			    putbe32(temp_buffer + 8, 0);	/* size
-									 */
-			    putbe32(temp_buffer + 12, 0);	/* write_id
-									 */
-			    putbe32(temp_buffer + 16, 0);	/* was_read
-									 */
-			    sendn(client_port_to_check->socket_fd,
-				temp_buffer, 20, 0, dtimeout);
-#endif
-			    client_port_to_check->threadId = 0;
-			    client_port_to_check->blocking = 0;
-			}
-		    }
-		    handle_request(client_port_to_check);
-		}
-		ready_descriptors--;
-	    } else {
-		FD_SET(client_port_to_check->socket_fd, &read_fd_set);
+	ready_descriptors =
+	    epoll_wait(epoll_fd, events, TCPSVR_MAX_EVENTS, timeout_millis);
+	if (ready_descriptors < 0) {
+	    if (errno != EINTR) {
+		rcs_print_error("server: epoll_wait error.(errno = %d | %s)\n",
+		    errno, strerror(errno));
 	    }
-	    client_port_to_check =
-		(CLIENT_TCP_PORT *) client_ports->get_next();
-	}
-	if (FD_ISSET(connection_socket, &read_fd_set)
-	    && ready_descriptors > 0) {
-	    ready_descriptors--;
-	    socklen_t client_address_length;
-	    new_client_port = new CLIENT_TCP_PORT();
-	    client_address_length = sizeof(new_client_port->address);
-	    new_client_port->socket_fd = accept(connection_socket,
-		(struct sockaddr *)
-		&new_client_port->address, &client_address_length);
-	    current_clients++;
-	    if (current_clients > max_clients) {
-		max_clients = current_clients;
+	    ready_descriptors = 0;
+	}
+	for (int i = 0; i < ready_descriptors; i++) {
+	    client_port_to_check = (CLIENT_TCP_PORT *) events[i].data.ptr;
+	    if (NULL == client_port_to_check) {
+		accept_clients();
+		continue;
 	    }
-	    if (new_client_port->socket_fd < 0) {
-		rcs_print_error("server: accept error -- %d %s \n", errno,
-		    strerror(errno));
+	    if (client_port_to_check->closing) {
 		continue;
 	    }
-	    rcs_print_debug(PRINT_SOCKET_CONNECT,
-		"Socket opened by host with IP address %s.\n",
-		inet_ntoa(new_client_port->address.sin_addr));
-	    new_client_port->serial_number = 0;
-	    new_client_port->blocking = 0;
-	    if (NULL != client_ports) {
-		client_ports->store_at_tail(new_client_port,
-		    sizeof(new_client_port), 0);
+	    if (events[i].events & EPOLLOUT) {
+		send_queued(client_port_to_check);
 	    }
-	    if (maxfdpl < new_client_port->socket_fd + 1) {
-		maxfdpl = new_client_port->socket_fd + 1;
+	    if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+		&& !client_port_to_check->closing) {
+		read_requests(client_port_to_check);
 	    }
-	    FD_SET(new_client_port->socket_fd, &read_fd_set);
-	} else {
-	    FD_SET(connection_socket, &read_fd_set);
-	}
-	if (0 != ready_descriptors) {
-	    rcs_print_error("%d descriptors ready but not serviced.\n",
-		ready_descriptors);
 	}
+	blocking_reads = poll_blocking_reads();
 	update_subscriptions();
+	remove_closed_clients();
+	if (tcpsvr_print_stats_requested) {
+	    tcpsvr_print_stats_requested = 0;
+	    print_stats(0);
+	}
     }
 }
 
-static int tcpsvr_handle_blocking_request_sigint_count = 0;
-static int tcpsvr_last_sig = 0;
-
-void tcpsvr_handle_blocking_request_sigint_handler(int sig)
+void CMS_SERVER_REMOTE_TCP_PORT::accept_clients()
 {
-    tcpsvr_last_sig = sig;
-    tcpsvr_handle_blocking_request_sigint_count++;
-}
+    CLIENT_TCP_PORT *new_client_port;
+    socklen_t client_address_length;
+    struct epoll_event event;
 
-static void putbe32(char *addr, uint32_t val) {
-    val = htonl(val);
-    memcpy(addr, &val, sizeof(val));
+    while (1) {
+	new_client_port = new CLIENT_TCP_PORT();
+	client_address_length = sizeof(new_client_port->address);
+	new_client_port->socket_fd = accept4(connection_socket,
+	    (struct sockaddr *) &new_client_port->address,
+	    &client_address_length, SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if (new_client_port->socket_fd < 0) {
+	    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+		rcs_print_error("server: accept error -- %d %s \n", errno,
+		    strerror(errno));
+	    }
+	    delete new_client_port;
+	    return;
+	}
+	rcs_print_debug(PRINT_SOCKET_CONNECT,
+	    "Socket opened by host with IP address %s.\n",
+	    inet_ntoa(new_client_port->address.sin_addr));
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.ptr = new_client_port;
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, new_client_port->socket_fd,
+		&event) < 0) {
+	    rcs_print_error("server: epoll_ctl error.(errno = %d | %s)\n",
+		errno, strerror(errno));
+	    delete new_client_port;
+	    continue;
+	}
+	new_client_port->events = EPOLLIN;
+	current_clients++;
+	if (current_clients > max_clients) {
+	    max_clients = current_clients;
+	}
+	tcpsvr_stats.connections++;
+	client_ports->store_at_tail(new_client_port,
+	    sizeof(new_client_port), 0);
+    }
 }
 
-static uint32_t getbe32(char *addr) {
-    uint32_t val;
-    memcpy(&val, addr, sizeof(val));
-    return ntohl(val);
+/* Takes what a client sent and handles the requests it completes. */
+void CMS_SERVER_REMOTE_TCP_PORT::read_requests(CLIENT_TCP_PORT * clnt)
+{
+    if (tcpsvr_grow(&clnt->in, &clnt->in_size, clnt->in_used + 1) < 0) {
+	clnt->closing = 1;
+	return;
+    }
+    ssize_t bytes = recv(clnt->socket_fd, clnt->in + clnt->in_used,
+	clnt->in_size - clnt->in_used, 0);
+    if (bytes == 0) {
+	rcs_print_debug(PRINT_SOCKET_CONNECT,
+	    "Socket closed by host with IP address %s.\n",
+	    inet_ntoa(clnt->address.sin_addr));
+	clnt->closing = 1;
+	return;
+    }
+    if (bytes < 0) {
+	if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+	    rcs_print_debug(PRINT_SOCKET_CONNECT,
+		"Can not read from client port (%d) from %s: %s\n",
+		clnt->socket_fd, inet_ntoa(clnt->address.sin_addr),
+		strerror(errno));
+	    clnt->closing = 1;
+	}
+	return;
+    }
+    clnt->in_used += bytes;
+    serve_requests(clnt);
 }
 
-#if defined(POSIX_THREADS) || defined(NO_THREADS)
-void *tcpsvr_handle_blocking_request(void *_req)
+/* Handles the complete requests received from a client, for as long as
+   the replies to it do not pile up. */
+void CMS_SERVER_REMOTE_TCP_PORT::serve_requests(CLIENT_TCP_PORT * clnt)
 {
-    signal(SIGINT, tcpsvr_handle_blocking_request_sigint_handler);
-    TCPSVR_BLOCKING_READ_REQUEST *blocking_read_req =
-	(TCPSVR_BLOCKING_READ_REQUEST *) _req;
-    char temp_buffer[0x2000];
-    if (_req == NULL) {
-	tcpsvr_threads_returned_early++;
-	return 0;
+    while (!clnt->closing
+	&& clnt->out_end - clnt->out_start < TCPSVR_MAX_QUEUED_BYTES) {
+	long size = request_size(clnt);
+	if (size < 0
+	    || tcpsvr_grow(&clnt->in, &clnt->in_size, size) < 0) {
+	    clnt->closing = 1;
+	    break;
+	}
+	if (clnt->in_used < size) {
+	    break;
+	}
+	clnt->in_pos = 0;
+	handle_request(clnt);
+	clnt->in_used -= size;
+	memmove(clnt->in, clnt->in + size, clnt->in_used);
+	if (clnt->out_end == clnt->out_start) {
+	    replied(clnt);
+	}
     }
-    double dtimeout =
-	((double) (blocking_read_req->timeout_millis + 10)) / 1000.0;
-    if (dtimeout < 0) {
-	dtimeout = 600.0;
+    watch(clnt);
+}
+
+/* Bytes in the request at the start of what a client sent, as far as
+   that can be told yet, or -1 if it is not one.  Without its size the
+   rest of the stream cannot be told apart, so an unknown request type
+   ends the connection. */
+long CMS_SERVER_REMOTE_TCP_PORT::request_size(CLIENT_TCP_PORT * clnt)
+{
+    if (clnt->in_used < 20) {
+	return 20;
     }
-    if (dtimeout < 0.5) {
-	dtimeout = 0.5;
+    long request_type = getbe32(clnt->in + 4);
+    long buffer_number = getbe32(clnt->in + 8);
+    int subdivided = max_total_subdivisions > 1 &&
+	server->get_total_subdivisions(buffer_number) > 1;
+
+    switch (request_type) {
+    case REMOTE_CMS_SET_DIAG_INFO_REQUEST_TYPE:
+	return 20 + 68;
+
+    case REMOTE_CMS_BLOCKING_READ_REQUEST_TYPE:
+	return 20 + (subdivided ? 8 : 4);
+
+    case REMOTE_CMS_READ_REQUEST_TYPE:
+	return 20 + (subdivided ? 4 : 0);
+
+    case REMOTE_CMS_WRITE_REQUEST_TYPE:
+	{
+	    long size = getbe32(clnt->in + 16);
+	    if (size > server->maximum_cms_size) {
+		rcs_print_error
+		    ("Write of %ld bytes from %s is larger than any buffer.\n",
+		    size, inet_ntoa(clnt->address.sin_addr));
+		return -1;
+	    }
+	    return 20 + (subdivided ? 4 : 0) + size;
+	}
+
+    case REMOTE_CMS_GET_KEYS_REQUEST_TYPE:
+	return 20 + 16;
+
+    case REMOTE_CMS_LOGIN_REQUEST_TYPE:
+	return 20 + 32;
+
+    case REMOTE_CMS_GET_DIAG_INFO_REQUEST_TYPE:
+    case REMOTE_CMS_GET_BUF_NAME_REQUEST_TYPE:
+    case REMOTE_CMS_CHECK_IF_READ_REQUEST_TYPE:
+    case REMOTE_CMS_GET_MSG_COUNT_REQUEST_TYPE:
+    case REMOTE_CMS_GET_QUEUE_LENGTH_REQUEST_TYPE:
+    case REMOTE_CMS_GET_SPACE_AVAILABLE_REQUEST_TYPE:
+    case REMOTE_CMS_CLEAR_REQUEST_TYPE:
+    case REMOTE_CMS_CLEAN_REQUEST_TYPE:
+    case REMOTE_CMS_CLOSE_CHANNEL_REQUEST_TYPE:
+    case REMOTE_CMS_SET_SUBSCRIPTION_REQUEST_TYPE:
+	return 20;
+
+    default:
+	rcs_print_error
+	    ("Unrecognized request type %ld from %s, closing the connection.\n",
+	    request_type, inet_ntoa(clnt->address.sin_addr));
+	return -1;
     }
-    if (dtimeout > 600.0) {
-	dtimeout = 600.0;
+}
+
+/* Copies the next bytes of the request being handled. */
+int CMS_SERVER_REMOTE_TCP_PORT::take(CLIENT_TCP_PORT * clnt, void *dest,
+    long bytes)
+{
+    if (clnt->in_pos + bytes > clnt->in_used) {
+	return -1;
     }
-    CLIENT_TCP_PORT *_client_tcp_port = blocking_read_req->_client_tcp_port;
-    CMS_SERVER *server = blocking_read_req->server;
+    memcpy(dest, clnt->in + clnt->in_pos, bytes);
+    clnt->in_pos += bytes;
+    return 0;
+}
 
-    if (NULL == server || NULL == _client_tcp_port) {
-	tcpsvr_threads_returned_early++;
+/* Sends a reply as far as the socket takes it and queues the rest. */
+int CMS_SERVER_REMOTE_TCP_PORT::queue_reply(CLIENT_TCP_PORT * clnt,
+    const void *data, long bytes)
+{
+    const char *ptr = (const char *) data;
+
+    if (clnt->closing) {
+	return -1;
+    }
+    while (clnt->out_end == clnt->out_start && bytes > 0) {
+	ssize_t sent = send(clnt->socket_fd, ptr, bytes, MSG_NOSIGNAL);
+	if (sent < 0) {
+	    if (errno == EINTR) {
+		continue;
+	    }
+	    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+		break;
+	    }
+	    rcs_print_debug(PRINT_SOCKET_CONNECT,
+		"Can not send to client port (%d) at %s: %s\n",
+		clnt->socket_fd, inet_ntoa(clnt->address.sin_addr),
+		strerror(errno));
+	    clnt->closing = 1;
+	    return -1;
+	}
+	ptr += sent;
+	bytes -= sent;
+	tcpsvr_stats.bytes_sent += sent;
+    }
+    if (bytes <= 0) {
 	return 0;
     }
-    memset(temp_buffer, 0, 0x2000);
-    REMOTE_BLOCKING_READ_REPLY *read_reply;
-
-    if (NULL != _client_tcp_port->diag_info) {
-	_client_tcp_port->diag_info->buffer_number =
-	    blocking_read_req->buffer_number;
-	server->set_diag_info(_client_tcp_port->diag_info);
-    } else if (server->diag_enabled) {
-	server->reset_diag_info(blocking_read_req->buffer_number);
+    if (clnt->out_start > 0) {
+	memmove(clnt->out, clnt->out + clnt->out_start,
+	    clnt->out_end - clnt->out_start);
+	clnt->out_end -= clnt->out_start;
+	clnt->out_start = 0;
+    }
+    if (tcpsvr_grow(&clnt->out, &clnt->out_size, clnt->out_end + bytes) < 0) {
+	clnt->closing = 1;
+	return -1;
+    }
+    memcpy(clnt->out + clnt->out_end, ptr, bytes);
+    clnt->out_end += bytes;
+    if (clnt->out_end > tcpsvr_stats.max_send_queue) {
+	tcpsvr_stats.max_send_queue = clnt->out_end;
     }
+    watch(clnt);
+    return 0;
+}
 
-    read_reply = (REMOTE_BLOCKING_READ_REPLY *)
-	server->process_request(blocking_read_req);
-    blocking_read_req->read_reply = read_reply;
+/* Replies to a read or blocking read of a client. */
+void CMS_SERVER_REMOTE_TCP_PORT::queue_read_reply(CLIENT_TCP_PORT * clnt,
+    REMOTE_READ_REPLY * read_reply)
+{
     if (NULL == read_reply) {
-	_client_tcp_port->blocking = 0;
 	rcs_print_error("Server could not process request.\n");
-	putbe32(temp_buffer, _client_tcp_port->serial_number);
+	putbe32(temp_buffer, clnt->serial_number);
 	putbe32(temp_buffer + 4, CMS_SERVER_SIDE_ERROR);
 	putbe32(temp_buffer + 8, 0);	/* size */
-	putbe32(temp_buffer + 12, 0)	/* write_id */;
-	putbe32(temp_buffer + 16, 0)	/* was_read */;
-	sendn(_client_tcp_port->socket_fd, temp_buffer, 20, 0, dtimeout);
-	_client_tcp_port->errors++;
-	_client_tcp_port->blocking_read_req = NULL;
-	delete blocking_read_req;
-	_client_tcp_port->threadId = 0;
-	tcpsvr_threads_returned_early++;
-	return 0;
+	putbe32(temp_buffer + 12, 0);	/* write_id */
+	putbe32(temp_buffer + 16, 0);	/* was_read */
+	queue_reply(clnt, temp_buffer, 20);
+	return;
     }
-    putbe32(temp_buffer, _client_tcp_port->serial_number);
+    putbe32(temp_buffer, clnt->serial_number);
     putbe32(temp_buffer + 4, read_reply->status);
     putbe32(temp_buffer + 8, read_reply->size);
     putbe32(temp_buffer + 12, read_reply->write_id);
     putbe32(temp_buffer + 16, read_reply->was_read);
     if (read_reply->size < (0x2000 - 20) && read_reply->size > 0) {
 	memcpy(temp_buffer + 20, read_reply->data, read_reply->size);
-	_client_tcp_port->blocking = 0;
-	if (sendn
-	    (_client_tcp_port->socket_fd, temp_buffer, 20 + read_reply->size,
-		0, dtimeout) < 0) {
-	    _client_tcp_port->blocking = 0;
-	    _client_tcp_port->errors++;
-	    _client_tcp_port->blocking_read_req = NULL;
-	    delete blocking_read_req;
-	    _client_tcp_port->threadId = 0;
-	    tcpsvr_threads_returned_early++;
-	    return 0;
+	if (queue_reply(clnt, temp_buffer, 20 + read_reply->size) < 0) {
+	    clnt->errors++;
 	}
     } else {
-	_client_tcp_port->blocking = 0;
-	if (sendn(_client_tcp_port->socket_fd, temp_buffer, 20, 0, dtimeout) <
-	    0) {
-	    _client_tcp_port->blocking = 0;
-	    _client_tcp_port->errors++;
-	    _client_tcp_port->blocking_read_req = NULL;
-	    delete blocking_read_req;
-	    _client_tcp_port->threadId = 0;
-	    tcpsvr_threads_returned_early++;
-	    return 0;
+	if (queue_reply(clnt, temp_buffer, 20) < 0) {
+	    clnt->errors++;
+	    return;
 	}
 	if (read_reply->size > 0) {
-	    if (sendn
-		(_client_tcp_port->socket_fd, read_reply->data,
-		    read_reply->size, 0, dtimeout) < 0) {
-		_client_tcp_port->blocking = 0;
-		_client_tcp_port->errors++;
-		_client_tcp_port->blocking_read_req = NULL;
-		delete blocking_read_req;
-		_client_tcp_port->threadId = 0;
-		tcpsvr_threads_returned_early++;
-		return 0;
+	    if (queue_reply(clnt, read_reply->data, read_reply->size) < 0) {
+		clnt->errors++;
 	    }
 	}
     }
-    _client_tcp_port->blocking_read_req = NULL;
-    delete blocking_read_req;
-    _client_tcp_port->threadId = 0;
-    tcpsvr_threads_exited++;
-#ifdef POSIX_THREADS
-    pthread_exit(0);
-#endif
-#ifdef NO_THREADS
-    exit(0);
-#endif
 }
 
-#endif
+/* Sends what is queued for a client as far as the socket takes it. */
+void CMS_SERVER_REMOTE_TCP_PORT::send_queued(CLIENT_TCP_PORT * clnt)
+{
+    int was_full = clnt->out_end - clnt->out_start >= TCPSVR_MAX_QUEUED_BYTES;
 
-void CMS_SERVER_REMOTE_TCP_PORT::handle_request(CLIENT_TCP_PORT *
-    _client_tcp_port)
+    while (clnt->out_start < clnt->out_end) {
+	ssize_t sent = send(clnt->socket_fd, clnt->out + clnt->out_start,
+	    clnt->out_end - clnt->out_start, MSG_NOSIGNAL);
+	if (sent < 0) {
+	    if (errno == EINTR) {
+		continue;
+	    }
+	    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+		break;
+	    }
+	    rcs_print_debug(PRINT_SOCKET_CONNECT,
+		"Can not send to client port (%d) at %s: %s\n",
+		clnt->socket_fd, inet_ntoa(clnt->address.sin_addr),
+		strerror(errno));
+	    clnt->closing = 1;
+	    return;
+	}
+	clnt->out_start += sent;
+	tcpsvr_stats.bytes_sent += sent;
+    }
+    if (clnt->out_start == clnt->out_end) {
+	clnt->out_start = clnt->out_end = 0;
+	replied(clnt);
+    }
+    if (was_full) {
+	/* go on with the requests held back */
+	serve_requests(clnt);
+    } else {
+	watch(clnt);
+    }
+}
+
+/* Counts the time since the request being answered came in, now that
+   the whole reply is sent. */
+void CMS_SERVER_REMOTE_TCP_PORT::replied(CLIENT_TCP_PORT * clnt)
 {
-    CLIENT_TCP_PORT *client_port_to_check = NULL;
-    pid_t pid = getpid();
-    pid_t tid = 0;
-    CMS_SERVER *server;
-    server = find_server(pid, tid);
-    if (NULL == server) {
-	rcs_print_error
-	    ("CMS_SERVER_REMOTE_TCP_PORT::handle_request() Cannot find server object for pid = %d.\n",
-	    pid);
+    if (clnt->request_time <= 0.0) {
 	return;
     }
+    double latency = etime() - clnt->request_time;
+    clnt->request_time = 0.0;
+    if (latency < 0.0) {
+	latency = 0.0;
+    }
+    int bucket = 0;
+    for (double limit = 1e-4;
+	bucket < TCPSVR_LATENCY_BUCKETS - 1 && latency >= limit;
+	limit *= 10.0) {
+	bucket++;
+    }
+    tcpsvr_stats.latency_histogram[bucket]++;
+    tcpsvr_stats.latency_count++;
+    tcpsvr_stats.latency_total += latency;
+    if (latency > tcpsvr_stats.latency_max) {
+	tcpsvr_stats.latency_max = latency;
+    }
+}
+
+/* Waits for more requests from a client unless too many replies to it
+   are queued, and for room to send them while any are. */
+void CMS_SERVER_REMOTE_TCP_PORT::watch(CLIENT_TCP_PORT * clnt)
+{
+    struct epoll_event event;
+    long queued = clnt->out_end - clnt->out_start;
+
+    if (clnt->closing) {
+	return;
+    }
+    memset(&event, 0, sizeof(event));
+    if (queued < TCPSVR_MAX_QUEUED_BYTES) {
+	event.events |= EPOLLIN;
+    } else if (clnt->events & EPOLLIN) {
+	tcpsvr_stats.send_queue_stalls++;
+    }
+    if (queued > 0) {
+	event.events |= EPOLLOUT;
+    }
+    if (event.events == clnt->events) {
+	return;
+    }
+    event.data.ptr = clnt;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, clnt->socket_fd, &event) < 0) {
+	rcs_print_error("server: epoll_ctl error.(errno = %d | %s)\n",
+	    errno, strerror(errno));
+	clnt->closing = 1;
+	return;
+    }
+    clnt->events = event.events;
+}
+
+/* Answers the blocking reads that have a new message or timed out and
+   returns how many are still waiting. */
+int CMS_SERVER_REMOTE_TCP_PORT::poll_blocking_reads()
+{
+    REMOTE_READ_REPLY timed_out;
+    REMOTE_READ_REPLY *read_reply;
+    TCPSVR_BLOCKING_READ_REQUEST *blocking_read_req;
+    int waiting = 0;
+    double now = 0.0;
+
+    CLIENT_TCP_PORT *clnt = (CLIENT_TCP_PORT *) client_ports->get_head();
+    for (; NULL != clnt; clnt = (CLIENT_TCP_PORT *) client_ports->get_next()) {
+	blocking_read_req = clnt->blocking_read_req;
+	if (!clnt->blocking || clnt->closing || NULL == blocking_read_req) {
+	    continue;
+	}
+	if (0.0 == now) {
+	    now = etime();
+	}
+	if (NULL != clnt->diag_info) {
+	    clnt->diag_info->buffer_number = blocking_read_req->buffer_number;
+	    server->set_diag_info(clnt->diag_info);
+	} else if (server->diag_enabled) {
+	    server->reset_diag_info(blocking_read_req->buffer_number);
+	}
+	server->read_req.buffer_number = blocking_read_req->buffer_number;
+	server->read_req.access_type = blocking_read_req->access_type;
+	server->read_req.last_id_read = blocking_read_req->last_id_read;
+	server->read_req.subdiv = blocking_read_req->subdiv;
+	read_reply = (REMOTE_READ_REPLY *)
+	    server->process_request(&server->read_req);
+	if (NULL != read_reply && read_reply->status == CMS_READ_OLD) {
+	    if (blocking_read_req->deadline < 0.0
+		|| now < blocking_read_req->deadline) {
+		waiting++;
+		continue;
+	    }
+	    timed_out.status = CMS_TIMED_OUT;
+	    timed_out.size = 0;
+	    timed_out.write_id = blocking_read_req->last_id_read;
+	    timed_out.was_read = 0;
+	    timed_out.data = NULL;
+	    read_reply = &timed_out;
+	    tcpsvr_stats.blocking_reads_timed_out++;
+	}
+	clnt->blocking = 0;
+	queue_read_reply(clnt, read_reply);
+    }
+    return waiting;
+}
+
+/* Drops a client together with its subscriptions. */
+void CMS_SERVER_REMOTE_TCP_PORT::close_client(CLIENT_TCP_PORT * clnt)
+{
+    if (NULL != clnt->subscriptions) {
+	TCP_CLIENT_SUBSCRIPTION_INFO *clnt_sub_info =
+	    (TCP_CLIENT_SUBSCRIPTION_INFO *) clnt->subscriptions->get_head();
+	while (NULL != clnt_sub_info) {
+	    TCP_BUFFER_SUBSCRIPTION_INFO *sub_buf_info =
+		clnt_sub_info->sub_buf_info;
+	    if (NULL != sub_buf_info && NULL != sub_buf_info->sub_clnt_info) {
+		sub_buf_info->sub_clnt_info->
+		    delete_node(clnt_sub_info->buffer_list_id);
+		if (sub_buf_info->sub_clnt_info->list_size < 1) {
+		    delete sub_buf_info->sub_clnt_info;
+		    sub_buf_info->sub_clnt_info = NULL;
+		    if (NULL != subscription_buffers
+			&& sub_buf_info->list_id >= 0) {
+			subscription_buffers->delete_node(sub_buf_info->
+			    list_id);
+			delete sub_buf_info;
+		    }
+		}
+	    }
+	    clnt_sub_info->sub_buf_info = NULL;
+	    delete clnt_sub_info;
+	    clnt_sub_info = (TCP_CLIENT_SUBSCRIPTION_INFO *)
+		clnt->subscriptions->get_next();
+	}
+	delete clnt->subscriptions;
+	clnt->subscriptions = NULL;
+	recalculate_polling_interval();
+    }
+    if (clnt->blocking) {
+	clnt->blocking = 0;
+	tcpsvr_stats.blocking_reads_cancelled++;
+    }
+    if (clnt->socket_fd >= 0) {
+	close(clnt->socket_fd);
+	clnt->socket_fd = -1;
+    }
+    current_clients--;
+    tcpsvr_stats.disconnections++;
+}
+
+void CMS_SERVER_REMOTE_TCP_PORT::remove_closed_clients()
+{
+    CLIENT_TCP_PORT *clnt = (CLIENT_TCP_PORT *) client_ports->get_head();
+    while (NULL != clnt) {
+	if (clnt->closing) {
+	    close_client(clnt);
+	    delete clnt;
+	    client_ports->delete_current_node();
+	}
+	clnt = (CLIENT_TCP_PORT *) client_ports->get_next();
+    }
+}
+
+/* With debug_flag 0 always, else like rcs_print_debug(). */
+void CMS_SERVER_REMOTE_TCP_PORT::print_stats(long debug_flag)
+{
+    struct TCPSVR_STATS *stats = &tcpsvr_stats;
+    char text[1024];
+    double average = 0.0;
+
+    if (stats->latency_count > 0) {
+	average = stats->latency_total / stats->latency_count;
+    }
+    snprintf(text, sizeof(text),
+	"TCP server on port %d: %d clients, at most %d, %ld connected, %ld disconnected.\n"
+	"  %ld requests, %ld bytes sent, latency %.3f ms average, %.3f ms max.\n"
+	"  latency <0.1 ms: %ld, <1 ms: %ld, <10 ms: %ld, <100 ms: %ld, <1 s: %ld, more: %ld\n"
+	"  %ld stalls on full send queues, at most %ld bytes queued.\n"
+	"  %ld subscription updates, %ld held back for slow clients.\n"
+	"  %ld blocking reads, %ld timed out, %ld cancelled.\n",
+	ntohs(server_socket_address.sin_port), current_clients, max_clients,
+	stats->connections, stats->disconnections,
+	stats->requests, stats->bytes_sent, average * 1e3,
+	stats->latency_max * 1e3,
+	stats->latency_histogram[0], stats->latency_histogram[1],
+	stats->latency_histogram[2], stats->latency_histogram[3],
+	stats->latency_histogram[4], stats->latency_histogram[5],
+	stats->send_queue_stalls, stats->max_send_queue,
+	stats->subscription_updates, stats->subscription_updates_held,
+	stats->blocking_reads, stats->blocking_reads_timed_out,
+	stats->blocking_reads_cancelled);
+    if (debug_flag) {
+	rcs_print_debug(debug_flag, "%s", text);
+    } else {
+	rcs_print("%s", text);
+    }
+}
 
+void CMS_SERVER_REMOTE_TCP_PORT::handle_request(CLIENT_TCP_PORT *
+    _client_tcp_port)
+{
     if (server->using_passwd_file) {
 	current_user_info = get_connected_user(_client_tcp_port->socket_fd);
     }
@@ -663,29 +931,27 @@ void CMS_SERVER_REMOTE_TCP_PORT::handle_request(CLIENT_TCP_PORT *
     if (_client_tcp_port->errors >= _client_tcp_port->max_errors) {
 	rcs_print_error("Too many errors - closing connection(%d)\n",
 	    _client_tcp_port->socket_fd);
-	client_port_to_check = (CLIENT_TCP_PORT *) client_ports->get_head();
-	while (NULL != client_port_to_check) {
-	    if (client_port_to_check->socket_fd ==
-		_client_tcp_port->socket_fd) {
-		delete client_port_to_check;
-		client_ports->delete_current_node();
-	    }
-	    client_port_to_check =
-		(CLIENT_TCP_PORT *) client_ports->get_next();
-	}
-	close(_client_tcp_port->socket_fd);
-	current_clients--;
-	FD_CLR(_client_tcp_port->socket_fd, &read_fd_set);
-	_client_tcp_port->socket_fd = -1;
+	_client_tcp_port->closing = 1;
+	return;
     }
 
-    if (recvn(_client_tcp_port->socket_fd, temp_buffer, 20, 0, -1, NULL) < 0) {
+    if (take(_client_tcp_port, temp_buffer, 20) < 0) {
 	rcs_print_error("Can not read from client port (%d) from %s\n",
 	    _client_tcp_port->socket_fd,
 	    inet_ntoa(_client_tcp_port->address.sin_addr));
 	_client_tcp_port->errors++;
 	return;
     }
+    if (_client_tcp_port->blocking) {
+	rcs_print_debug(PRINT_SERVER_THREAD_ACTIVITY,
+	    "Data received from %s:%d when it should be blocking.\n",
+	    inet_ntoa(_client_tcp_port->address.sin_addr),
+	    _client_tcp_port->socket_fd);
+	_client_tcp_port->blocking = 0;
+	tcpsvr_stats.blocking_reads_cancelled++;
+    }
+    _client_tcp_port->request_time = etime();
+    tcpsvr_stats.requests++;
     long request_type, buffer_number, received_serial_number;
     received_serial_number = getbe32(temp_buffer);
     if (received_serial_number != _client_tcp_port->serial_number) {
@@ -733,7 +999,6 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
     long request_type, long buffer_number, long received_serial_number)
 {
     int total_subdivisions = 1;
-    CLIENT_TCP_PORT *client_port_to_check = NULL;
     switch (request_type) {
     case REMOTE_CMS_SET_DIAG_INFO_REQUEST_TYPE:
 	{
@@ -741,9 +1006,8 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 		_client_tcp_port->diag_info =
 		    new REMOTE_SET_DIAG_INFO_REQUEST();
 	    }
-	    if (recvn
-		(_client_tcp_port->socket_fd, server->set_diag_info_buf, 68,
-		    0, -1, NULL) < 0) {
+	    if (take
+		(_client_tcp_port, server->set_diag_info_buf, 68) < 0) {
 		rcs_print_error
 		    ("Can not read from client port (%d) from %s\n",
 		    _client_tcp_port->socket_fd,
@@ -784,9 +1048,8 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    if (NULL == diagreply) {
 		putbe32(temp_buffer, _client_tcp_port->serial_number);
 		putbe32(temp_buffer+4, CMS_SERVER_SIDE_ERROR);
-		if (sendn
-		    (_client_tcp_port->socket_fd, temp_buffer, 24, 0,
-			dtimeout) < 0) {
+		if (queue_reply
+		    (_client_tcp_port, temp_buffer, 24) < 0) {
 		    _client_tcp_port->errors++;
 		}
 		return;
@@ -794,9 +1057,8 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    if (NULL == diagreply->cdi) {
 		putbe32(temp_buffer, _client_tcp_port->serial_number);
 		putbe32(temp_buffer + 4, CMS_SERVER_SIDE_ERROR);
-		if (sendn
-		    (_client_tcp_port->socket_fd, temp_buffer, 24, 0,
-			dtimeout) < 0) {
+		if (queue_reply
+		    (_client_tcp_port, temp_buffer, 24) < 0) {
 		    _client_tcp_port->errors++;
 		}
 		return;
@@ -943,9 +1205,8 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    }
 	    *((uint32_t *) temp_buffer + 6) = htonl(dpi_count);
 	    *((uint32_t *) temp_buffer + 7) = htonl(dpi_offset);
-	    if (sendn
-		(_client_tcp_port->socket_fd, temp_buffer, dpi_offset, 0,
-		    dtimeout) < 0) {
+	    if (queue_reply
+		(_client_tcp_port, temp_buffer, dpi_offset) < 0) {
 		_client_tcp_port->errors++;
 		return;
 	    }
@@ -965,18 +1226,16 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 		putbe32(temp_buffer, _client_tcp_port->serial_number);
 		putbe32(temp_buffer + 4, namereply->status);
 		strncpy(temp_buffer + 8, namereply->name, 31);
-		if (sendn
-		    (_client_tcp_port->socket_fd, temp_buffer, 40, 0,
-			dtimeout) < 0) {
+		if (queue_reply
+		    (_client_tcp_port, temp_buffer, 40) < 0) {
 		    _client_tcp_port->errors++;
 		    return;
 		}
 	    } else {
 		putbe32(temp_buffer, _client_tcp_port->serial_number);
 		putbe32(temp_buffer + 4, CMS_SERVER_SIDE_ERROR);
-		if (sendn
-		    (_client_tcp_port->socket_fd, temp_buffer, 40, 0,
-			dtimeout) < 0) {
+		if (queue_reply
+		    (_client_tcp_port, temp_buffer, 40) < 0) {
 		    _client_tcp_port->errors++;
 		    return;
 		}
@@ -986,33 +1245,27 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 
     case REMOTE_CMS_BLOCKING_READ_REQUEST_TYPE:
 	{
-	    TCPSVR_BLOCKING_READ_REQUEST *blocking_read_req;
-
-#ifdef NO_THREADS
 	    if (NULL == _client_tcp_port->blocking_read_req) {
 		_client_tcp_port->blocking_read_req =
 		    new TCPSVR_BLOCKING_READ_REQUEST();
 	    }
-	    blocking_read_req = _client_tcp_port->blocking_read_req;
-#else
-	    blocking_read_req;
-	    = new TCPSVR_BLOCKING_READ_REQUEST();
-#endif
+	    TCPSVR_BLOCKING_READ_REQUEST *blocking_read_req =
+		_client_tcp_port->blocking_read_req;
 	    blocking_read_req->buffer_number = buffer_number;
 	    blocking_read_req->access_type =
 		ntohl(*((uint32_t *) temp_buffer + 3));
 	    blocking_read_req->last_id_read =
 		ntohl(*((uint32_t *) temp_buffer + 4));
+	    blocking_read_req->subdiv = 0;
 	    total_subdivisions = 1;
 	    if (max_total_subdivisions > 1) {
 		total_subdivisions =
 		    server->get_total_subdivisions(buffer_number);
 	    }
 	    if (total_subdivisions > 1) {
-		if (recvn
-		    (_client_tcp_port->socket_fd,
-			(char *) (((uint32_t *) temp_buffer) + 5), 8, 0, -1,
-			NULL) < 0) {
+		if (take
+		    (_client_tcp_port,
+			(char *) (((uint32_t *) temp_buffer) + 5), 8) < 0) {
 		    rcs_print_error
 			("Can not read from client port (%d) from %s\n",
 			_client_tcp_port->socket_fd,
@@ -1023,10 +1276,9 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 		blocking_read_req->subdiv =
 		    ntohl(*((uint32_t *) temp_buffer + 6));
 	    } else {
-		if (recvn
-		    (_client_tcp_port->socket_fd,
-			(char *) (((uint32_t *) temp_buffer) + 5), 4, 0, -1,
-			NULL) < 0) {
+		if (take
+		    (_client_tcp_port,
+			(char *) (((uint32_t *) temp_buffer) + 5), 4) < 0) {
 		    rcs_print_error
 			("Can not read from client port (%d) from %s\n",
 			_client_tcp_port->socket_fd,
@@ -1036,77 +1288,20 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 		}
 	    }
 	    blocking_read_req->timeout_millis =
-		ntohl(*((uint32_t *) temp_buffer + 5));
+		(int32_t) ntohl(*((uint32_t *) temp_buffer + 5));
 	    blocking_read_req->server = server;
 	    blocking_read_req->remport = this;
-	    _client_tcp_port->blocking = 1;
 	    blocking_read_req->_client_tcp_port = _client_tcp_port;
-#ifdef POSIX_THREADS
-	    int thr_retval = pthread_create(&(_client_tcp_port->threadId),	/* ptr to new-thread-id */
-		NULL,		// pthread_attr_t *, ptr to attributes
-		tcpsvr_handle_blocking_request,	// start_func
-		blocking_read_req	// arg for start_func
-		);
-	    if (thr_retval != 0) {
-		_client_tcp_port->blocking = 0;
-		rcs_print_error("pthread_create error: thr_retval = %d\n",
-		    thr_retval);
-		rcs_print_error("pthread_create error: %d %s\n", errno,
-		    strerror(errno));
-		*((uint32_t *) temp_buffer) =
-		    htonl(_client_tcp_port->serial_number);
-		*((uint32_t *) temp_buffer + 1) =
-		    htonl((unsigned long) CMS_SERVER_SIDE_ERROR);
-		putbe32(temp_buffer + 8, 0);	/* size */
-		putbe32(temp_buffer + 12, 0);	/* write_id */
-		putbe32(temp_buffer + 16, 0);	/* was_read */
-		sendn(_client_tcp_port->socket_fd, temp_buffer, 20, 0,
-		    dtimeout);
-		return;
-	    }
-#else
-#ifdef NO_THREADS
-	    int fork_ret = fork();
-	    switch (fork_ret) {
-	    case 0:		// child
-		_client_tcp_port->threadId = getpid();
-		tcpsvr_handle_blocking_request(blocking_read_req);
-		exit(0);
-		break;
-
-	    case -1:		// Error
-		rcs_print_error("fork error: %d %s\n", errno,
-		    strerror(errno));
-		_client_tcp_port->blocking = 0;
-		putbe32(temp_buffer, _client_tcp_port->serial_number);
-		putbe32(temp_buffer + 4, CMS_SERVER_SIDE_ERROR);
-		putbe32(temp_buffer + 8, 0);
-		putbe32(temp_buffer + 12, 0);
-		putbe32(temp_buffer + 16, 0);
-		sendn(_client_tcp_port->socket_fd, temp_buffer, 20, 0,
-		    dtimeout);
-		break;
-
-	    default:		// parent;
-		_client_tcp_port->threadId = fork_ret;
-		break;
+	    blocking_read_req->deadline = -1.0;
+	    if (blocking_read_req->timeout_millis >= 0) {
+		blocking_read_req->deadline =
+		    etime() + blocking_read_req->timeout_millis / 1000.0;
 	    }
-#else
-	    rcs_print_error
-		("Blocking read not supported on this platform.\n");
-	    *((uint32_t *) temp_buffer) =
-		htonl(_client_tcp_port->serial_number);
-	    *((uint32_t *) temp_buffer + 1) =
-		htonl((unsigned long) CMS_SERVER_SIDE_ERROR);
-	    putbe32(temp_buffer + 8, 0);	/* size */
-	    putbe32(temp_buffer + 12, 0);	/* write_id */
-	    putbe32(temp_buffer + 16, 0);	/* was_read */
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 20, 0, dtimeout);
-	    return;
-
-#endif
-#endif
-	    tcpsvr_threads_created++;
+	    /* answered by poll_blocking_reads() once there is a new
+	       message or the time is up */
+	    _client_tcp_port->blocking = 1;
+	    _client_tcp_port->request_time = 0.0;
+	    tcpsvr_stats.blocking_reads++;
 	}
 	break;
 
@@ -1121,10 +1316,9 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 		server->get_total_subdivisions(buffer_number);
 	}
 	if (total_subdivisions > 1) {
-	    if (recvn
-		(_client_tcp_port->socket_fd,
-		    (char *) (((uint32_t *) temp_buffer) + 5), 4, 0, -1,
-		    NULL) < 0) {
+	    if (take
+		(_client_tcp_port,
+		    (char *) (((uint32_t *) temp_buffer) + 5), 4) < 0) {
 		rcs_print_error
 		    ("Can not read from client port (%d) from %s\n",
 		    _client_tcp_port->socket_fd,
@@ -1136,47 +1330,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	} else {
 	    server->read_req.subdiv = 0;
 	}
-	if (NULL == server->read_reply) {
-	    rcs_print_error("Server could not process request.\n");
-	    putbe32(temp_buffer, _client_tcp_port->serial_number);
-	    putbe32(temp_buffer + 4, CMS_SERVER_SIDE_ERROR);
-	    putbe32(temp_buffer + 8, 0);
-	    putbe32(temp_buffer + 12, 0);
-	    putbe32(temp_buffer + 16, 0);
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 20, 0, dtimeout);
-	    return;
-	}
-	putbe32(temp_buffer, _client_tcp_port->serial_number);
-	putbe32(temp_buffer + 4, server->read_reply->status);
-	putbe32(temp_buffer + 8, server->read_reply->size);
-	putbe32(temp_buffer + 12, server->read_reply->write_id);
-	putbe32(temp_buffer + 16, server->read_reply->was_read);
-	if (server->read_reply->size < (0x2000 - 20)
-	    && server->read_reply->size > 0) {
-	    memcpy(temp_buffer + 20, server->read_reply->data,
-		server->read_reply->size);
-	    if (sendn
-		(_client_tcp_port->socket_fd, temp_buffer,
-		    20 + server->read_reply->size, 0, dtimeout) < 0) {
-		_client_tcp_port->errors++;
-		return;
-	    }
-	} else {
-	    if (sendn
-		(_client_tcp_port->socket_fd, temp_buffer, 20, 0,
-		    dtimeout) < 0) {
-		_client_tcp_port->errors++;
-		return;
-	    }
-	    if (server->read_reply->size > 0) {
-		if (sendn
-		    (_client_tcp_port->socket_fd, server->read_reply->data,
-			server->read_reply->size, 0, dtimeout) < 0) {
-		    _client_tcp_port->errors++;
-		    return;
-		}
-	    }
-	}
+	queue_read_reply(_client_tcp_port, server->read_reply);
 	break;
 
     case REMOTE_CMS_WRITE_REQUEST_TYPE:
@@ -1189,10 +1343,9 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 		server->get_total_subdivisions(buffer_number);
 	}
 	if (total_subdivisions > 1) {
-	    if (recvn
-		(_client_tcp_port->socket_fd,
-		    (char *) (((uint32_t *) temp_buffer) + 5), 4, 0, -1,
-		    NULL) < 0) {
+	    if (take
+		(_client_tcp_port,
+		    (char *) (((uint32_t *) temp_buffer) + 5), 4) < 0) {
 		rcs_print_error
 		    ("Can not read from client port (%d) from %s\n",
 		    _client_tcp_port->socket_fd,
@@ -1205,9 +1358,9 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    server->write_req.subdiv = 0;
 	}
 	if (server->write_req.size > 0) {
-	    if (recvn
-		(_client_tcp_port->socket_fd, server->write_req.data,
-		    server->write_req.size, 0, -1, NULL) < 0) {
+	    if (take
+		(_client_tcp_port, server->write_req.data,
+		    server->write_req.size) < 0) {
 		_client_tcp_port->errors++;
 		return;
 	    }
@@ -1222,16 +1375,14 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	        putbe32(temp_buffer, reply->write_id);
 		putbe32(temp_buffer + 4, CMS_SERVER_SIDE_ERROR);
 		putbe32(temp_buffer + 8, 0);	/* was_read */
-		sendn(_client_tcp_port->socket_fd, temp_buffer, 12, 0,
-		    dtimeout);
+		queue_reply(_client_tcp_port, temp_buffer, 12);
 		return;
 	    }
 	    putbe32(temp_buffer, reply->write_id);
 	    putbe32(temp_buffer + 4, reply->status);
 	    putbe32(temp_buffer + 8, reply->was_read);
-	    if (sendn
-		(_client_tcp_port->socket_fd, temp_buffer, 12, 0,
-		    dtimeout) < 0) {
+	    if (queue_reply
+		(_client_tcp_port, temp_buffer, 12) < 0) {
 		_client_tcp_port->errors++;
 	    }
 	} else {
@@ -1253,7 +1404,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    putbe32(temp_buffer, _client_tcp_port->serial_number);
 	    putbe32(temp_buffer + 4, CMS_SERVER_SIDE_ERROR);
 	    putbe32(temp_buffer + 8, 0);	/* was_read */
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 12, 0, dtimeout);
+	    queue_reply(_client_tcp_port, temp_buffer, 12);
 	    return;
 	}
 	putbe32(temp_buffer, _client_tcp_port->serial_number);
@@ -1261,7 +1412,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    htonl(server->check_if_read_reply->status);
 	*((uint32_t *) temp_buffer + 2) =
 	    htonl(server->check_if_read_reply->was_read);
-	if (sendn(_client_tcp_port->socket_fd, temp_buffer, 12, 0, dtimeout) <
+	if (queue_reply(_client_tcp_port, temp_buffer, 12) <
 	    0) {
 	    _client_tcp_port->errors++;
 	}
@@ -1279,7 +1430,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    putbe32(temp_buffer, _client_tcp_port->serial_number);
 	    putbe32(temp_buffer + 4, CMS_SERVER_SIDE_ERROR);
 	    putbe32(temp_buffer + 8, 0);	/* was_read */
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 12, 0, dtimeout);
+	    queue_reply(_client_tcp_port, temp_buffer, 12);
 	    return;
 	}
 	putbe32(temp_buffer, _client_tcp_port->serial_number);
@@ -1287,7 +1438,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    htonl(server->get_msg_count_reply->status);
 	*((uint32_t *) temp_buffer + 2) =
 	    htonl(server->get_msg_count_reply->count);
-	if (sendn(_client_tcp_port->socket_fd, temp_buffer, 12, 0, dtimeout) <
+	if (queue_reply(_client_tcp_port, temp_buffer, 12) <
 	    0) {
 	    _client_tcp_port->errors++;
 	}
@@ -1305,7 +1456,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    putbe32(temp_buffer, _client_tcp_port->serial_number);
 	    putbe32(temp_buffer + 4, CMS_SERVER_SIDE_ERROR);
 	    putbe32(temp_buffer + 8, 0);	/* was_read */
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 12, 0, dtimeout);
+	    queue_reply(_client_tcp_port, temp_buffer, 12);
 	    return;
 	}
 	putbe32(temp_buffer, _client_tcp_port->serial_number);
@@ -1313,7 +1464,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    htonl(server->get_queue_length_reply->status);
 	*((uint32_t *) temp_buffer + 2) =
 	    htonl(server->get_queue_length_reply->queue_length);
-	if (sendn(_client_tcp_port->socket_fd, temp_buffer, 12, 0, dtimeout) <
+	if (queue_reply(_client_tcp_port, temp_buffer, 12) <
 	    0) {
 	    _client_tcp_port->errors++;
 	}
@@ -1331,7 +1482,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    putbe32(temp_buffer, _client_tcp_port->serial_number);
 	    putbe32(temp_buffer + 4, CMS_SERVER_SIDE_ERROR);
 	    putbe32(temp_buffer + 8, 0);	/* was_read */
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 12, 0, dtimeout);
+	    queue_reply(_client_tcp_port, temp_buffer, 12);
 	    return;
 	}
 	putbe32(temp_buffer, _client_tcp_port->serial_number);
@@ -1339,7 +1490,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    htonl(server->get_space_available_reply->status);
 	*((uint32_t *) temp_buffer + 2) =
 	    htonl(server->get_space_available_reply->space_available);
-	if (sendn(_client_tcp_port->socket_fd, temp_buffer, 12, 0, dtimeout) <
+	if (queue_reply(_client_tcp_port, temp_buffer, 12) <
 	    0) {
 	    _client_tcp_port->errors++;
 	}
@@ -1355,12 +1506,12 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    rcs_print_error("Server could not process request.\n");
 	    putbe32(temp_buffer, _client_tcp_port->serial_number);
 	    putbe32(temp_buffer + 4, CMS_SERVER_SIDE_ERROR);
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 8, 0, dtimeout);
+	    queue_reply(_client_tcp_port, temp_buffer, 8);
 	    return;
 	}
 	putbe32(temp_buffer, _client_tcp_port->serial_number);
 	putbe32(temp_buffer + 4, server->clear_reply->status);
-	if (sendn(_client_tcp_port->socket_fd, temp_buffer, 8, 0, dtimeout) <
+	if (queue_reply(_client_tcp_port, temp_buffer, 8) <
 	    0) {
 	    _client_tcp_port->errors++;
 	}
@@ -1372,30 +1523,14 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	break;
 
     case REMOTE_CMS_CLOSE_CHANNEL_REQUEST_TYPE:
-	client_port_to_check = (CLIENT_TCP_PORT *) client_ports->get_head();
-	while (NULL != client_port_to_check) {
-	    if (client_port_to_check->socket_fd ==
-		_client_tcp_port->socket_fd) {
-		break;
-	    }
-	    client_port_to_check =
-		(CLIENT_TCP_PORT *) client_ports->get_next();
-	}
-	FD_CLR(_client_tcp_port->socket_fd, &read_fd_set);
-	close(_client_tcp_port->socket_fd);
-	current_clients--;
-	if (NULL != _client_tcp_port->subscriptions) {
-	    remove_subscription_client(_client_tcp_port, buffer_number);
-	}
-	_client_tcp_port->socket_fd = -1;
-	delete _client_tcp_port;
-	client_ports->delete_current_node();
+	/* closed with its subscriptions by remove_closed_clients() */
+	_client_tcp_port->closing = 1;
 	break;
 
     case REMOTE_CMS_GET_KEYS_REQUEST_TYPE:
 	server->get_keys_req.buffer_number = buffer_number;
-	if (recvn(_client_tcp_port->socket_fd,
-		server->get_keys_req.name, 16, 0, -1, NULL) < 0) {
+	if (take(_client_tcp_port,
+		server->get_keys_req.name, 16) < 0) {
 	    _client_tcp_port->errors++;
 	    return;
 	}
@@ -1408,7 +1543,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    putbe32(temp_buffer, _client_tcp_port->serial_number);
 	    server->gen_random_key(((char *) temp_buffer) + 4, 2);
 	    server->gen_random_key(((char *) temp_buffer) + 12, 2);
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 20, 0, dtimeout);
+	    queue_reply(_client_tcp_port, temp_buffer, 20);
 	    return;
 	} else {
 	    putbe32(temp_buffer, _client_tcp_port->serial_number);
@@ -1417,20 +1552,20 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    memcpy(((char *) temp_buffer) + 12, server->get_keys_reply->key2,
 		8);
 	    /* successful ? */
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 20, 0, dtimeout);
+	    queue_reply(_client_tcp_port, temp_buffer, 20);
 	    return;
 	}
 	break;
 
     case REMOTE_CMS_LOGIN_REQUEST_TYPE:
 	server->login_req.buffer_number = buffer_number;
-	if (recvn(_client_tcp_port->socket_fd,
-		server->login_req.name, 16, 0, -1, NULL) < 0) {
+	if (take(_client_tcp_port,
+		server->login_req.name, 16) < 0) {
 	    _client_tcp_port->errors++;
 	    return;
 	}
-	if (recvn(_client_tcp_port->socket_fd,
-		server->login_req.passwd, 16, 0, -1, NULL) < 0) {
+	if (take(_client_tcp_port,
+		server->login_req.passwd, 16) < 0) {
 	    _client_tcp_port->errors++;
 	    return;
 	}
@@ -1441,13 +1576,13 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    rcs_print_error("Server could not process request.\n");
 	    putbe32(temp_buffer, _client_tcp_port->serial_number);
 	    putbe32(temp_buffer + 4, 0);	/* not successful */
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 8, 0, dtimeout);
+	    queue_reply(_client_tcp_port, temp_buffer, 8);
 	    return;
 	} else {
 	    putbe32(temp_buffer, _client_tcp_port->serial_number);
 	    putbe32(temp_buffer + 4, server->login_reply->success);
 	    /* successful ? */
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 8, 0, dtimeout);
+	    queue_reply(_client_tcp_port, temp_buffer, 8);
 	    return;
 	}
 	break;
@@ -1465,7 +1600,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    rcs_print_error("Server could not process request.\n");
 	    putbe32(temp_buffer, _client_tcp_port->serial_number);
 	    putbe32(temp_buffer + 4, 0);	/* not successful */
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 8, 0, dtimeout);
+	    queue_reply(_client_tcp_port, temp_buffer, 8);
 	    return;
 	} else {
 	    if (server->set_subscription_reply->success) {
@@ -1489,7 +1624,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	    *((uint32_t *) temp_buffer + 1) =
 		htonl(server->set_subscription_reply->success);
 	    /* successful ? */
-	    sendn(_client_tcp_port->socket_fd, temp_buffer, 8, 0, dtimeout);
+	    queue_reply(_client_tcp_port, temp_buffer, 8);
 	    return;
 	}
 	break;
@@ -1554,7 +1689,8 @@ void CMS_SERVER_REMOTE_TCP_PORT::add_subscription_client(int buffer_number,
 	temp_clnt_info->subscription_list_id =
 	    clnt->subscriptions->store_at_tail(temp_clnt_info,
 	    sizeof(*temp_clnt_info), 0);
-	buf_info->sub_clnt_info->store_at_tail(temp_clnt_info,
+	temp_clnt_info->buffer_list_id =
+	    buf_info->sub_clnt_info->store_at_tail(temp_clnt_info,
 	    sizeof(*temp_clnt_info), 0);
     }
     temp_clnt_info->subscription_type = subscription_type;
@@ -1572,7 +1708,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::remove_subscription_client(CLIENT_TCP_PORT *
 	    if (NULL != temp_clnt_info->sub_buf_info) {
 		if (NULL != temp_clnt_info->sub_buf_info->sub_clnt_info) {
 		    temp_clnt_info->sub_buf_info->sub_clnt_info->
-			delete_node(temp_clnt_info->subscription_list_id);
+			delete_node(temp_clnt_info->buffer_list_id);
 		    if (temp_clnt_info->sub_buf_info->sub_clnt_info->
 			list_size == 0) {
 			subscription_buffers->delete_node(temp_clnt_info->
@@ -1584,6 +1720,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::remove_subscription_client(CLIENT_TCP_PORT *
 		    }
 		}
 	    }
+	    clnt->subscriptions->delete_current_node();
 	    delete temp_clnt_info;
 	    temp_clnt_info = NULL;
 	    break;
@@ -1624,8 +1761,6 @@ void CMS_SERVER_REMOTE_TCP_PORT::recalculate_polling_interval()
     } else {
 	current_poll_interval_millis = ((int) (clk_tck() * 1000.0));
     }
-    select_timeout.tv_sec = current_poll_interval_millis / 1000;
-    select_timeout.tv_usec = (current_poll_interval_millis % 1000) * 1000;
     dtimeout = (current_poll_interval_millis + 10) * 1000.0;
     if (dtimeout < 0.5) {
 	dtimeout = 0.5;
@@ -1634,16 +1769,6 @@ void CMS_SERVER_REMOTE_TCP_PORT::recalculate_polling_interval()
 
 void CMS_SERVER_REMOTE_TCP_PORT::update_subscriptions()
 {
-    pid_t pid = getpid();
-    pid_t tid = 0;
-    CMS_SERVER *server;
-    server = find_server(pid, tid);
-    if (NULL == server) {
-	rcs_print_error
-	    ("CMS_SERVER_REMOTE_TCP_PORT::update_subscriptions Cannot find server object for pid = %d.\n",
-	    pid);
-	return;
-    }
     if (NULL == subscription_buffers) {
 	return;
     }
@@ -1688,34 +1813,37 @@ void CMS_SERVER_REMOTE_TCP_PORT::update_subscriptions()
 		    || temp_clnt_info->subscription_type ==
 		    CMS_VARIABLE_SUBSCRIPTION)
 		&& temp_clnt_info->last_id_read !=
-		server->read_reply->write_id) {
-		temp_clnt_info->last_id_read = server->read_reply->write_id;
-		temp_clnt_info->last_sub_sent_time = cur_time;
-		temp_clnt_info->clnt_port->serial_number++;
-		putbe32(temp_buffer, temp_clnt_info->clnt_port->serial_number);
-		if (server->read_reply->size < 0x2000 - 20
-		    && server->read_reply->size > 0) {
-		    memcpy(temp_buffer + 20, server->read_reply->data,
-			server->read_reply->size);
-		    if (sendn
-			(temp_clnt_info->clnt_port->socket_fd, temp_buffer,
-			    20 + server->read_reply->size, 0, dtimeout) < 0) {
-			temp_clnt_info->clnt_port->errors++;
-			return;
-		    }
+		server->read_reply->write_id
+		&& !temp_clnt_info->clnt_port->closing) {
+		if (temp_clnt_info->clnt_port->out_end >
+		    temp_clnt_info->clnt_port->out_start) {
+		    /* Still sending it an earlier one, it gets whatever is
+		       newest then. */
+		    tcpsvr_stats.subscription_updates_held++;
 		} else {
-		    if (sendn(temp_clnt_info->clnt_port->socket_fd,
-			    temp_buffer, 20, 0, dtimeout) < 0) {
-			temp_clnt_info->clnt_port->errors++;
-			return;
-		    }
-		    if (server->read_reply->size > 0) {
-			if (sendn(temp_clnt_info->clnt_port->socket_fd,
-				server->read_reply->data,
-				server->read_reply->size, 0, dtimeout) < 0) {
+		    temp_clnt_info->last_id_read =
+			server->read_reply->write_id;
+		    temp_clnt_info->last_sub_sent_time = cur_time;
+		    temp_clnt_info->clnt_port->serial_number++;
+		    putbe32(temp_buffer,
+			temp_clnt_info->clnt_port->serial_number);
+		    tcpsvr_stats.subscription_updates++;
+		    if (server->read_reply->size < 0x2000 - 20
+			&& server->read_reply->size > 0) {
+			memcpy(temp_buffer + 20, server->read_reply->data,
+			    server->read_reply->size);
+			if (queue_reply(temp_clnt_info->clnt_port,
+				temp_buffer,
+				20 + server->read_reply->size) < 0) {
 			    temp_clnt_info->clnt_port->errors++;
-			    return;
 			}
+		    } else if (queue_reply(temp_clnt_info->clnt_port,
+			    temp_buffer, 20) < 0
+			|| (server->read_reply->size > 0
+			    && queue_reply(temp_clnt_info->clnt_port,
+				server->read_reply->data,
+				server->read_reply->size) < 0)) {
+			temp_clnt_info->clnt_port->errors++;
 		    }
 		}
 	    }
@@ -1755,6 +1883,7 @@ TCP_CLIENT_SUBSCRIPTION_INFO::TCP_CLIENT_SUBSCRIPTION_INFO()
     poll_interval_millis = 30000;
     last_sub_sent_time = 0.0;
     subscription_list_id = -1;
+    buffer_list_id = -1;
     buffer_number = -1;
     subscription_paused = 0;
     last_id_read = 0;
@@ -1768,6 +1897,7 @@ TCP_CLIENT_SUBSCRIPTION_INFO::~TCP_CLIENT_SUBSCRIPTION_INFO()
     poll_interval_millis = 30000;
     last_sub_sent_time = 0.0;
     subscription_list_id = -1;
+    buffer_list_id = -1;
     buffer_number = -1;
     subscription_paused = 0;
     last_id_read = 0;
@@ -1787,9 +1917,16 @@ CLIENT_TCP_PORT::CLIENT_TCP_PORT()
     subscriptions = NULL;
     tid = -1;
     pid = -1;
+    blocking = 0;
     blocking_read_req = NULL;
-    threadId = 0;
     diag_info = NULL;
+    closing = 0;
+    events = 0;
+    in = NULL;
+    in_size = in_used = in_pos = 0;
+    out = NULL;
+    out_size = out_start = out_end = 0;
+    request_time = 0.0;
 }
 
 CLIENT_TCP_PORT::~CLIENT_TCP_PORT()
@@ -1809,14 +1946,20 @@ CLIENT_TCP_PORT::~CLIENT_TCP_PORT()
 	delete subscriptions;
 	subscriptions = NULL;
     }
-#ifdef NO_THREADS
     if (NULL != blocking_read_req) {
 	delete blocking_read_req;
 	blocking_read_req = NULL;
     }
-#endif
     if (NULL != diag_info) {
 	delete diag_info;
 	diag_info = NULL;
     }
+    if (NULL != in) {
+	free(in);
+	in = NULL;
+    }
+    if (NULL != out) {
+	free(out);
+	out = NULL;
+    }
 }
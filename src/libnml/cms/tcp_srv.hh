@@ -33,16 +33,43 @@ extern "C" {
 }
 #endif
 
-#ifndef NO_THREADS
-#define NO_THREADS
+#define MAX_TCP_BUFFER_SIZE 16
 
-#ifdef POSIX_THREADS
-#include <pthread.h>
-#endif
-#endif
+/* Requests of a client are left unread while this many bytes of replies
+   to it wait to be sent. */
+#define TCPSVR_MAX_QUEUED_BYTES 0x40000
+
+/* How often a blocking read looks for a new message in its buffer. */
+#define TCPSVR_BLOCKING_READ_POLL_MILLIS 10
+
+/* Request to reply latency below 0.1, 1, 10, 100 and 1000 ms and above. */
+#define TCPSVR_LATENCY_BUCKETS 6
+
+/* Counters of the TCP servers of a process, printed by them on SIGUSR1. */
+struct TCPSVR_STATS {
+    long connections;		/* accepted */
+    long disconnections;
+    long requests;
+    long bytes_sent;
+    long send_queue_stalls;	/* times reading from a client was held
+				   back until its replies were sent */
+    long max_send_queue;	/* the most bytes queued for a client */
+    long subscription_updates;
+    long subscription_updates_held;	/* for a client still sending the
+					   previous one */
+    long blocking_reads;
+    long blocking_reads_timed_out;
+    long blocking_reads_cancelled;	/* by another request */
+    long latency_count;		/* requests answered */
+    double latency_total;	/* seconds from request to sent reply */
+    double latency_max;
+    long latency_histogram[TCPSVR_LATENCY_BUCKETS];
+};
+
+extern struct TCPSVR_STATS tcpsvr_stats;
 
-#define MAX_TCP_BUFFER_SIZE 16
 class CLIENT_TCP_PORT;
+class TCPSVR_BLOCKING_READ_REQUEST;
 
 class CMS_SERVER_REMOTE_TCP_PORT:public CMS_SERVER_REMOTE_PORT {
   public:
@@ -54,9 +81,23 @@ class CMS_SERVER_REMOTE_TCP_PORT:public CMS_SERVER_REMOTE_PORT {
     void unregister_port();
     double dtimeout;
   protected:
-      fd_set read_fd_set, write_fd_set;
+    int epoll_fd;
+    CMS_SERVER *server;		/* of this process, found once by run() */
+    void accept_clients();
+    void read_requests(CLIENT_TCP_PORT *);
+    void serve_requests(CLIENT_TCP_PORT *);
+    long request_size(CLIENT_TCP_PORT *);
+    int take(CLIENT_TCP_PORT *, void *, long);
     void handle_request(CLIENT_TCP_PORT *);
-    int maxfdpl;
+    int queue_reply(CLIENT_TCP_PORT *, const void *, long);
+    void queue_read_reply(CLIENT_TCP_PORT *, REMOTE_READ_REPLY *);
+    void send_queued(CLIENT_TCP_PORT *);
+    void replied(CLIENT_TCP_PORT *);
+    void watch(CLIENT_TCP_PORT *);
+    int poll_blocking_reads();
+    void close_client(CLIENT_TCP_PORT *);
+    void remove_closed_clients();
+    void print_stats(long debug_flag);
     LinkedList *client_ports;
     LinkedList *subscription_buffers;
     int connection_socket;
@@ -66,7 +107,6 @@ class CMS_SERVER_REMOTE_TCP_PORT:public CMS_SERVER_REMOTE_PORT {
     char temp_buffer[0x2000];
     int current_poll_interval_millis;
     int polling_enabled;
-    struct timeval select_timeout;
     void update_subscriptions();
     void add_subscription_client(int buffer_number, int subscription_type,
 	int poll_interval_millis, CLIENT_TCP_PORT * clnt);
@@ -97,6 +137,7 @@ class TCP_CLIENT_SUBSCRIPTION_INFO {
     int poll_interval_millis;
     double last_sub_sent_time;
     int subscription_list_id;
+    int buffer_list_id;		/* in sub_buf_info->sub_clnt_info */
     int buffer_number;
     int subscription_paused;
     int last_id_read;
@@ -104,8 +145,6 @@ class TCP_CLIENT_SUBSCRIPTION_INFO {
     CLIENT_TCP_PORT *clnt_port;
 };
 
-class TCPSVR_BLOCKING_READ_REQUEST;
-
 class CLIENT_TCP_PORT {
   public:
     CLIENT_TCP_PORT();
@@ -117,14 +156,17 @@ class CLIENT_TCP_PORT {
     LinkedList *subscriptions;
     pid_t tid;
     pid_t pid;
-    int blocking;
-#ifdef POSIX_THREADS
-    pthread_t threadId;
-#else
-    int threadId;
-#endif
+    int blocking;		/* waiting in blocking_read_req */
     TCPSVR_BLOCKING_READ_REQUEST *blocking_read_req;
     REMOTE_SET_DIAG_INFO_REQUEST *diag_info;
+    int closing;		/* to be removed after this loop */
+    unsigned int events;	/* waited for with epoll */
+    char *in;			/* received, starting with a request */
+    long in_size, in_used;
+    long in_pos;		/* taken of the request being handled */
+    char *out;			/* replies not yet sent */
+    long out_size, out_start, out_end;
+    double request_time;	/* of the request being answered, or 0 */
 
 };
 
@@ -136,6 +178,7 @@ class TCPSVR_BLOCKING_READ_REQUEST:public REMOTE_BLOCKING_READ_REQUEST {
     CMS_SERVER_REMOTE_TCP_PORT *remport;
     CMS_SERVER *server;
     REMOTE_BLOCKING_READ_REPLY *read_reply;
+    double deadline;		/* etime() to time out at, or -1 */
 };
 
 #endif /* TCP_SRV_HH */
@@ -18,6 +18,7 @@
 #include <string.h>             /* strstr() */
 #include <ctype.h>              /* isspace() */
 #include <fcntl.h>
+#include <sys/stat.h>
 
 
 #include "config.h"
@@ -51,9 +52,12 @@ IniFile::IniFile(int _errMask, FILE *_fp)
     fp = _fp;
     errMask = _errMask;
     owned = false;
+    released = false;
+    parseError = ERR_NONE;
+    lineCount = 0;
 
-    if(fp != NULL)
-        LockFile();
+    if(fp != NULL && LockFile())
+        Parse();
 }
 
 
@@ -78,6 +82,8 @@ IniFile::Open(const char *file)
     if(!LockFile())
         return(false);
 
+    Parse();
+
     return(true);
 }
 
@@ -100,10 +106,191 @@ IniFile::Close()
         fp = NULL;
     }
 
+    released = false;
+    entries.clear();
+    sections.clear();
+    global.tags.clear();
+
     return(rVal == 0);
 }
 
 
+/*! Lets go of the file, closing it if it was opened by Open(), but keeps
+   what was read from it, so Find() goes on working until Close(). */
+void
+IniFile::Release(void)
+{
+    if(fp != NULL){
+        lock.l_type = F_UNLCK;
+        fcntl(fileno(fp), F_SETLKW, &lock);
+
+        if(owned)
+            fclose(fp);
+
+        fp = NULL;
+        released = true;
+    }
+}
+
+
+/*! Reads the whole file once and indexes every "tag = value" line by tag,
+   both file-wide and within the first [section] of each name.  Lookups
+   afterwards never touch the file again.
+
+   The indices reproduce what a top-to-bottom scan would see: a scope
+   stops collecting at the next section header, and a read error (an
+   ambiguous carriage return or an over-long continuation) ends the
+   scopes it occurs in, so lookups past that point report it. */
+void
+IniFile::Parse(void)
+{
+    IniScope                    *current = NULL;
+    std::string                 logical;
+    int                         extend_ct = 0;
+    unsigned int                n = 0;
+    char                        *line = NULL;
+    size_t                      size = 0;
+    ssize_t                     len;
+
+    entries.clear();
+    sections.clear();
+    global.tags.clear();
+    global.endLineNo = 0;
+    global.errCode = ERR_TAG_NOT_FOUND;
+    global.open = true;
+    parseError = ERR_NONE;
+    lineCount = 0;
+
+    rewind(fp);
+
+    while((len = getline(&line, &size, fp)) >= 0) {
+        if(check_line_endings(line)) {
+            parseError = ERR_CONVERSION;
+            break;
+        }
+
+        n++;
+
+        /* strip off newline */
+        if(len > 0 && line[len - 1] == '\n')
+            line[--len] = 0;
+
+        // honor backslash (\) as line-end escape
+        if(len > 0 && line[len - 1] == '\\') {
+            logical.append(line, len - 1);
+            if(++extend_ct > MAX_EXTEND_LINES) {
+                fprintf(stderr,
+                   "INIFILE lineno=%d:Too many backslash line extends (limit=%d)\n",
+                   n, MAX_EXTEND_LINES);
+                CloseScope(&global, n, ERR_OVER_EXTENDED);
+                if(current)
+                    CloseScope(current, n, ERR_OVER_EXTENDED);
+                current = NULL;
+                logical.clear();
+                extend_ct = 0;
+            }
+            continue; // get next line to extend
+        }
+
+        logical.append(line, len);
+        extend_ct = 0;
+        AddLine(logical.c_str(), n, &current);
+        logical.clear();
+    }
+
+    free(line);
+    lineCount = n;
+
+    if(current)
+        CloseScope(current, n, parseError ? parseError : ERR_TAG_NOT_FOUND);
+    CloseScope(&global, n, parseError ? parseError : ERR_TAG_NOT_FOUND);
+}
+
+
+/*! Indexes one logical line (continuations already joined) that ends on
+   line number n of the file. */
+void
+IniFile::AddLine(const char *line, unsigned int n, IniScope **current)
+{
+    const char                  *nonWhite;
+    const char                  *valueString;
+    size_t                      len;
+    IniEntry                    entry;
+
+    /* skip leading whitespace */
+    if(NULL == (nonWhite = SkipWhite(line))) {
+        /* blank line-- skip */
+        return;
+    }
+
+    /* a '[' starts a new section and ends the current one; only the first
+       section of a given name is searchable */
+    if(nonWhite[0] == '[') {
+        if(*current)
+            CloseScope(*current, n, ERR_TAG_NOT_FOUND);
+        *current = NULL;
+
+        const char *end = strchr(nonWhite, ']');
+        if(end == NULL)
+            return;
+
+        std::string name(nonWhite + 1, end);
+        if(sections.count(name))
+            return;
+
+        IniScope &scope = sections[name];
+        scope.endLineNo = 0;
+        scope.errCode = ERR_TAG_NOT_FOUND;
+        scope.open = true;
+        *current = &scope;
+        return;
+    }
+
+    /* the tag runs up to whitespace or '=' */
+    len = strcspn(nonWhite, " \t\r\n=");
+    if(nonWhite[len] == 0) {
+        /* a bare word is not a tag line */
+        return;
+    }
+
+    entry.lineNo = n;
+    entry.hasValue = false;
+    if(NULL != (valueString = AfterEqual(nonWhite + len))) {
+        /* Eliminate white space at the end of a line also. */
+        size_t vlen = strlen(valueString);
+        while(vlen > 0 && (valueString[vlen - 1] == ' '
+                           || valueString[vlen - 1] == '\t'
+                           || valueString[vlen - 1] == '\r'))
+            vlen--;
+        entry.value.assign(valueString, vlen);
+        entry.hasValue = true;
+    }
+
+    size_t index = entries.size();
+    entries.push_back(entry);
+
+    std::string tag(nonWhite, len);
+    if(global.open)
+        global.tags[tag].push_back(index);
+    if(*current)
+        (*current)->tags[tag].push_back(index);
+}
+
+
+/*! Stops a scope from collecting further entries.  Lookups that run past
+   its last entry report errCode at line n. */
+void
+IniFile::CloseScope(IniScope *scope, unsigned int n, ErrorCode errCode)
+{
+    if(!scope->open)
+        return;
+
+    scope->open = false;
+    scope->endLineNo = n;
+    scope->errCode = errCode;
+}
+
+
 IniFile::ErrorCode
 IniFile::Find(int *result, StrIntPair *pPair,
      const char *tag, const char *section, int num, int *lineno)
@@ -188,25 +375,12 @@ IniFile::Find(double *result, StrDoublePair *pPair,
 
    @param num (optionally) the Nth occurrence of the tag.
 
-   @return pointer to the the variable after the '=' delimiter */
+   @return pointer to the the variable after the '=' delimiter, valid until
+   the file is closed */
 const char *
 IniFile::Find(const char *_tag, const char *_section, int _num, int *lineno)
 {
-    // WTF, return a pointer to the middle of a local buffer?
-    // FIX: this is totally non-reentrant.
-    static char                 line[LINELEN + 2] = "";        /* 1 for newline, 1 for NULL */
-    char                        bracketSection[LINELEN + 2] = "";
-    char                        *nonWhite;
-    int                         newLinePos;                /* position of newline to strip */
-    int                         len;
-    char                        tagEnd;
-    char                        *valueString;
-    char                        *endValueString;
-
-    char  eline [(LINELEN + 2) * (MAX_EXTEND_LINES + 1)];
-    char* elineptr;
-    char* elinenext = eline;
-    int   extend_ct = 0;
+    const IniScope              *scope = &global;
 
     // For exceptions.
     lineNo = 0;
@@ -218,165 +392,39 @@ IniFile::Find(const char *_tag, const char *_section, int _num, int *lineno)
     if(!CheckIfOpen())
         return(NULL);
 
-    /* start from beginning */
-    rewind(fp);
-
-    /* check for section first-- if it's non-NULL, then position file at
-       line after [section] */
     if(section != NULL){
-        sprintf(bracketSection, "[%s]", section);
-
-        /* find [section], and position fp just after it */
-        while (!feof(fp)) {
-
-            if (NULL == fgets(line, LINELEN + 1, fp)) {
-                /* got to end of file without finding it */
-                ThrowException(ERR_SECTION_NOT_FOUND);
-                return(NULL);
-            }
-
-            if(check_line_endings(line)) {
-                ThrowException(ERR_CONVERSION);
-                return(NULL);
-            }
-
-            /* got a line */
-            lineNo++;
-
-            /* strip off newline */
-            newLinePos = strlen(line) - 1;        /* newline is on back from 0 */
-            if (newLinePos < 0) {
-                newLinePos = 0;
-            }
-            if (line[newLinePos] == '\n') {
-                line[newLinePos] = 0;        /* make the newline 0 */
-            }
-
-            if (NULL == (nonWhite = SkipWhite(line))) {
-                /* blank line-- skip */
-                continue;
-            }
-
-            /* not a blank line, and nonwhite is first char */
-            if (strncmp(bracketSection, nonWhite, strlen(bracketSection)) != 0){
-                /* not on this line */
-                continue;
-            }
-
-            /* it matches-- fp is now set up for search on tag */
-            break;
-        }
-    }
-
-    while (!feof(fp)) {
-        /* check for end of file */
-        if (NULL == fgets(line, LINELEN + 1, (FILE *) fp)) {
-            /* got to end of file without finding it */
-            ThrowException(ERR_TAG_NOT_FOUND);
-            return(NULL);
-        }
-
-        if(check_line_endings(line)) {
-            ThrowException(ERR_CONVERSION);
+        std::unordered_map<std::string, IniScope>::const_iterator s =
+            sections.find(section);
+        if(s == sections.end()) {
+            /* a read error may have hidden it */
+            lineNo = lineCount;
+            ThrowException(parseError == ERR_CONVERSION ?
+                           ERR_CONVERSION : ERR_SECTION_NOT_FOUND);
             return(NULL);
         }
+        scope = &s->second;
+    }
 
-        /* got a line */
-        lineNo++;
-
-        /* strip off newline */
-        newLinePos = strlen(line) - 1;        /* newline is on back from 0 */
-        if (newLinePos < 0) {
-            newLinePos = 0;
-        }
-        if (line[newLinePos] == '\n') {
-            line[newLinePos] = 0;        /* make the newline 0 */
-        }
-        // honor backslash (\) as line-end escape
-        if (newLinePos > 0 && line[newLinePos-1] == '\\') {
-           newLinePos = newLinePos-1;
-           line[newLinePos] = 0;
-           if (!extend_ct) {
-               elineptr = (char*)eline; //first time
-               strncpy(elineptr,line,newLinePos);
-               elinenext = elineptr + newLinePos;
-           } else {
-               strncpy(elinenext,line,newLinePos);
-               elinenext = elinenext + newLinePos;
-           }
-           *elinenext = 0;
-           extend_ct++;
-           if (extend_ct > MAX_EXTEND_LINES) {
-              fprintf(stderr,
-                 "INIFILE lineno=%d:Too many backslash line extends (limit=%d)\n",
-                 lineNo, MAX_EXTEND_LINES);
-              ThrowException(ERR_OVER_EXTENDED);
-              return(NULL);
-           }
-           continue; // get next line to extend
-        } else {
-            if (extend_ct) {
-               strncpy(elinenext,line,newLinePos);
-               elinenext = elinenext + newLinePos;
-               *elinenext = 0;
-            }
-        }
-        if (!extend_ct) {
-           elineptr = (char*)line;
-        }
-        extend_ct = 0;
-
-        /* skip leading whitespace */
-        if (NULL == (nonWhite = SkipWhite(elineptr))) {
-            /* blank line-- skip */
-            continue;
-        }
+    std::unordered_map<std::string, std::vector<size_t> >::const_iterator t =
+        scope->tags.find(tag);
+    size_t index = _num > 1 ? _num - 1 : 0;
 
-        /* check for '[' char-- if so, it's a section tag, and we're out
-           of our section */
-        if (NULL != section && nonWhite[0] == '[') {
-            ThrowException(ERR_TAG_NOT_FOUND);
-            return(NULL);
-        }
-
-        len = strlen(tag);
-        if (strncmp(tag, nonWhite, len) != 0) {
-            /* not on this line */
-            continue;
-        }
+    if(t == scope->tags.end() || index >= t->second.size()) {
+        lineNo = scope->endLineNo;
+        ThrowException(scope->errCode);
+        return(NULL);
+    }
 
-        /* it matches the first part of the string-- if whitespace or = is
-           next char then call it a match */
-        tagEnd = nonWhite[len];
-        if (tagEnd == ' ' || tagEnd == '\r' || tagEnd == '\t'
-            || tagEnd == '\n' || tagEnd == '=') {
-            /* it matches-- return string after =, or NULL */
-            if (--_num > 0) {
-                /* Not looking for this one, so skip it... */
-                continue;
-            }
-            nonWhite += len;
-            valueString = AfterEqual(nonWhite);
-            /* Eliminate white space at the end of a line also. */
-            if (NULL == valueString) {
-                ThrowException(ERR_TAG_NOT_FOUND);
-                return(NULL);
-            }
-            endValueString = valueString + strlen(valueString) - 1;
-            while (*endValueString == ' ' || *endValueString == '\t'
-                   || *endValueString == '\r') {
-                *endValueString = 0;
-                endValueString--;
-            }
-	    if (lineno)
-		*lineno = lineNo;
-            return(valueString);
-        }
-        /* else continue */
+    const IniEntry &entry = entries[t->second[index]];
+    lineNo = entry.lineNo;
+    if(!entry.hasValue) {
+        ThrowException(ERR_TAG_NOT_FOUND);
+        return(NULL);
     }
 
-    ThrowException(ERR_TAG_NOT_FOUND);
-    return(NULL);
+    if (lineno)
+        *lineno = lineNo;
+    return(entry.value.c_str());
 }
 
 const char *
@@ -408,7 +456,7 @@ IniFile::FindPath(char *dest, size_t n, const char *_tag, const char *_section,
 bool
 IniFile::CheckIfOpen(void)
 {
-    if(IsOpen())
+    if(IsOpen() || released)
         return(true);
 
     ThrowException(ERR_NOT_OPEN);
@@ -503,7 +551,7 @@ IniFile::ThrowException(ErrorCode errCode)
 
    @return NULL or pointer to first non-white char after the delimiter
 
-   Called By: find() and section() only. */
+   Called By: AddLine() only. */
 char *
 IniFile::AfterEqual(const char *string)
 {
@@ -544,7 +592,7 @@ IniFile::AfterEqual(const char *string)
 
    @return NULL if not found or a valid pointer.
 
-   Called By: find() and section() only. */
+   Called By: AddLine() only. */
 char *
 IniFile::SkipWhite(const char *string)
 {
@@ -610,24 +658,65 @@ IniFile::Exception::Print(FILE *fp)
 }
 
 
+/* The C functions only get a FILE *, with nowhere to keep an index.  Each
+   thread keeps the index of the file it last looked in, without holding
+   on to the FILE *, and reads the file again only when it is a different
+   one or has changed since. */
+struct IniFileCache {
+    bool                        valid;
+    dev_t                       dev;
+    ino_t                       ino;
+    off_t                       size;
+    struct timespec             mtime;
+    IniFile                     *f;
+
+    IniFileCache() : valid(false), f(NULL) {}
+    ~IniFileCache() { delete f; }
+};
+
+static thread_local IniFileCache iniFileCache;
+
+static IniFile *
+iniFileCached(FILE *fp)
+{
+    IniFileCache                &c = iniFileCache;
+    struct stat                 st;
+    bool                        known = fstat(fileno(fp), &st) == 0;
+
+    if(known && c.valid && c.dev == st.st_dev && c.ino == st.st_ino &&
+       c.size == st.st_size && c.mtime.tv_sec == st.st_mtim.tv_sec &&
+       c.mtime.tv_nsec == st.st_mtim.tv_nsec)
+        return(c.f);
+
+    delete c.f;
+    c.f = new IniFile(false, fp);
+    c.valid = known && c.f->IsOpen();
+    c.f->Release();
+    if(c.valid){
+        c.dev = st.st_dev;
+        c.ino = st.st_ino;
+        c.size = st.st_size;
+        c.mtime = st.st_mtim;
+    }
+    return(c.f);
+}
+
+/*! The returned string stays valid until the calling thread looks in a
+   different or changed file. */
 extern "C" const char *
 iniFind(FILE *fp, const char *tag, const char *section)
 {
-    IniFile                     f(false, fp);
-
-    return(f.Find(tag, section));
+    return(iniFileCached(fp)->Find(tag, section));
 }
 
 extern "C" const int
 iniFindInt(FILE *fp, const char *tag, const char *section, int *result)
 {
-    IniFile f(false, fp);
-    return(f.Find(result, tag, section));
+    return(iniFileCached(fp)->Find(result, tag, section));
 }
 
 extern "C" const int
 iniFindDouble(FILE *fp, const char *tag, const char *section, double *result)
 {
-    IniFile f(false, fp);
-    return(f.Find(result, tag, section));
+    return(iniFileCached(fp)->Find(result, tag, section));
 }
@@ -18,6 +18,8 @@
 
 #include <inifile.h>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <boost/lexical_cast.hpp>
 
 #ifndef __cplusplus
@@ -56,6 +58,7 @@ public:
     bool                        Open(const char *file);
     bool                        Close(void);
     bool                        IsOpen(void){ return(fp != NULL); }
+    void                        Release(void);
 
     const char *                Find(const char *tag, const char *section=NULL,
                                      int num = 1, int *lineno = NULL);
@@ -144,9 +147,27 @@ protected:
 
 
 private:
+    /* One "tag = value" line, after backslash continuations are joined. */
+    struct IniEntry {
+        std::string             value;
+        bool                    hasValue;
+        unsigned int            lineNo;
+    };
+
+    /* Tag lookup for the whole file or for one [section].  Each tag maps
+       to the indices of its entries in file order, so the Nth occurrence
+       is a direct lookup. */
+    struct IniScope {
+        std::unordered_map<std::string, std::vector<size_t> > tags;
+        unsigned int            endLineNo;
+        ErrorCode               errCode;
+        bool                    open;
+    };
+
     FILE                        *fp;
     struct flock                lock;
     bool                        owned;
+    bool                        released;
 
     Exception                   exception;
     int                         errMask;
@@ -156,8 +177,19 @@ private:
     const char *                section;
     int                         num;
 
+    std::vector<IniEntry>       entries;
+    IniScope                    global;
+    std::unordered_map<std::string, IniScope> sections;
+    ErrorCode                   parseError;
+    unsigned int                lineCount;
+
     bool                        CheckIfOpen(void);
     bool                        LockFile(void);
+    void                        Parse(void);
+    void                        AddLine(const char *line, unsigned int n,
+                                        IniScope **current);
+    static void                 CloseScope(IniScope *scope, unsigned int n,
+                                           ErrorCode errCode);
     void                        ThrowException(ErrorCode);
     char                        *AfterEqual(const char *string);
     char                        *SkipWhite(const char *string);
@@ -785,6 +785,31 @@ static int task_delete(int task_id)
     return 0;
 }
 
+int rtapi_task_set_cpu(int task_id, int cpu)
+{
+    task_data *task;
+
+    /* validate task ID */
+    if ((task_id < 1) || (task_id > RTAPI_MAX_TASKS)) {
+	return -EINVAL;
+    }
+    /* point to the task's data */
+    task = &(task_array[task_id]);
+    if (task->state != PAUSED) {
+	return -EINVAL;
+    }
+    if (cpu == -1) {
+	cpu = rtapi_data->rt_cpu;
+    }
+    if ((cpu < 0) || (cpu >= num_online_cpus())) {
+	return -EINVAL;
+    }
+    rt_set_runnable_on_cpuid(ostask_array[task_id], cpu);
+    rtapi_print_msg(RTAPI_MSG_DBG, "RTAPI: task %02d on cpu %d\n", task_id,
+	cpu);
+    return 0;
+}
+
 int rtapi_task_start(int task_id, unsigned long int period_nsec)
 {
     int retval;
@@ -1723,6 +1748,7 @@ EXPORT_SYMBOL(rtapi_prio_next_lower);
 EXPORT_SYMBOL(rtapi_task_new);
 EXPORT_SYMBOL(rtapi_task_delete);
 EXPORT_SYMBOL(rtapi_task_start);
+EXPORT_SYMBOL(rtapi_task_set_cpu);
 EXPORT_SYMBOL(rtapi_wait);
 EXPORT_SYMBOL(rtapi_task_resume);
 EXPORT_SYMBOL(rtapi_task_pause);
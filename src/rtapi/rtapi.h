@@ -384,6 +384,17 @@ RTAPI_BEGIN_DECLS
 */
     extern int rtapi_task_start(int task_id, unsigned long int period_nsec);
 
+/** 'rtapi_task_set_cpu()' selects the CPU that task 'task_id' will
+    run on once it is started.  'cpu' is a zero based CPU number, or
+    -1 for the default realtime CPU.  Must be called after
+    rtapi_task_new() and before rtapi_task_start().  Returns 0 on
+    success, -EINVAL for a bad task or CPU number, or -ENOSYS if
+    tasks cannot run concurrently on separate CPUs (for instance in
+    non-realtime simulation, where tasks take turns).
+    Call only from within init/cleanup code, not from realtime tasks.
+*/
+    extern int rtapi_task_set_cpu(int task_id, int cpu);
+
 /** 'rtapi_wait()' suspends execution of the current task until the
     next period.  The task must be periodic, if not, the result is
     undefined.  The function will return at the beginning of the
@@ -57,6 +57,7 @@ struct rtapi_task {
   int uses_fp;
   size_t stacksize;
   int prio;
+  int cpu;			/* -1: default realtime cpu */
   long period;
   struct timespec nextstart;
   unsigned ratio;
@@ -85,6 +86,7 @@ struct RtapiApp
     static struct rtapi_task *get_task(int task_id);
     void unexpected_realtime_delay(rtapi_task *task, int nperiod=1);
     virtual int task_delete(int id) = 0;
+    int task_set_cpu(int task_id, int cpu);
     virtual int task_start(int task_id, unsigned long period_nsec) = 0;
     virtual int task_pause(int task_id) = 0;
     virtual int task_resume(int task_id) = 0;
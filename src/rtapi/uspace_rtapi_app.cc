@@ -382,11 +382,35 @@ static void write_strings(int fd, vector<string> strings) {
     if(write(fd, buf.data(), buf.size()) != (ssize_t)buf.size()) throw WriteError();
 }
 
+static int handle_command(vector<string> args);
+
+/* "batch N cmd... N cmd..." runs several commands for one round trip,
+   stopping at the first one that fails */
+static int do_batch_cmd(vector<string> args) {
+    size_t i = 1;
+    while(i < args.size()) {
+        char *endp;
+        long n = strtol(args[i].c_str(), &endp, 10);
+        if(*endp || n <= 0 || (size_t)n > args.size() - i - 1) {
+            rtapi_print_msg(RTAPI_MSG_ERR,
+                    "batch: malformed command count `%s'\n", args[i].c_str());
+            return -1;
+        }
+        vector<string> cmd(args.begin() + i + 1, args.begin() + i + 1 + n);
+        int result = handle_command(cmd);
+        if(result != 0) return result;
+        i += n + 1;
+    }
+    return 0;
+}
+
 static int handle_command(vector<string> args) {
     if(args.size() == 0) { return 0; }
     if(args.size() == 1 && args[0] == "exit") {
         force_exit = 1;
         return 0;
+    } else if(args[0] == "batch") {
+        return do_batch_cmd(args);
     } else if(args.size() >= 2 && args[0] == "load") {
         string name = args[1];
         args.erase(args.begin());
@@ -595,7 +619,7 @@ struct rtapi_module {
 #define MODULE_OFFSET 32768
 
 rtapi_task::rtapi_task()
-    : magic{}, id{}, owner{}, stacksize{}, prio{},
+    : magic{}, id{}, owner{}, stacksize{}, prio{}, cpu(-1),
       period{}, nextstart{},
       ratio{}, arg{}, taskcode{}
 {}
@@ -924,6 +948,16 @@ int RtapiApp::task_new(void (*taskcode) (void*), void *arg,
   return n;
 }
 
+int RtapiApp::task_set_cpu(int task_id, int cpu) {
+  rtapi_task *task = get_task(task_id);
+  if(!task) return -EINVAL;
+  // without realtime scheduling all tasks take turns on one lock
+  if(policy != SCHED_FIFO) return -ENOSYS;
+  if(cpu < -1 || cpu >= sysconf(_SC_NPROCESSORS_CONF)) return -EINVAL;
+  task->cpu = cpu;
+  return 0;
+}
+
 rtapi_task *RtapiApp::get_task(int task_id) {
     if(task_id < 0 || task_id >= MAX_TASKS) return NULL;
     /* validate task handle */
@@ -1040,14 +1074,15 @@ int Posix::task_start(int task_id, unsigned long int period_nsec)
       return -errno;
   if(nprocs > 1) {
       const static int rt_cpu_number = find_rt_cpu_number();
-      if(rt_cpu_number != -1) {
+      int cpu_number = task->cpu != -1 ? task->cpu : rt_cpu_number;
+      if(cpu_number != -1) {
 #ifdef __FreeBSD__
           cpuset_t cpuset;
 #else
           cpu_set_t cpuset;
 #endif
           CPU_ZERO(&cpuset);
-          CPU_SET(rt_cpu_number, &cpuset);
+          CPU_SET(cpu_number, &cpuset);
           if(pthread_attr_setaffinity_np(&attr, sizeof(cpuset), &cpuset) < 0)
                return -errno;
       }
@@ -1213,6 +1248,11 @@ int rtapi_task_delete(int id) {
     return App().task_delete(id);
 }
 
+int rtapi_task_set_cpu(int task_id, int cpu)
+{
+    return App().task_set_cpu(task_id, cpu);
+}
+
 int rtapi_task_start(int task_id, unsigned long period_nsec)
 {
     return App().task_start(task_id, period_nsec);
@@ -53,7 +53,8 @@ struct XenomaiApp : RtapiApp {
         cpu_set_t cpuset;
         CPU_ZERO(&cpuset);
         int nprocs = sysconf( _SC_NPROCESSORS_ONLN );
-        CPU_SET(nprocs-1, &cpuset); // assumes processor numbers are contiguous
+        // assumes processor numbers are contiguous
+        CPU_SET(task->cpu != -1 ? task->cpu : nprocs-1, &cpuset);
 
         pthread_attr_t attr;
         if(pthread_attr_init(&attr) < 0)
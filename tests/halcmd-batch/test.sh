@@ -0,0 +1,2 @@
+#!/bin/sh
+halrun test.hal | sed -e 's/[0-9.]* ms$/ms/'
@@ -0,0 +1,48 @@
+#!/bin/bash
+set -e
+
+# aos_test is the same component without 'option soa', so both memory
+# layouts can be checked against each other and timed side by side
+sed -e 's/soa_test/aos_test/g' -e '/^option soa/d' soa_test.comp > aos_test.comp
+
+${SUDO} halcompile --install soa_test.comp
+${SUDO} halcompile --install aos_test.comp
+
+N=16
+{
+    echo "loadrt threads name1=t period1=1000000"
+    echo "loadrt soa_test count=$N"
+    echo "loadrt aos_test count=$N"
+    echo "addf soa-test t"
+    for i in $(seq 0 $((N-1))); do
+        echo "addf aos-test.$i t"
+        for c in soa aos; do
+            echo "setp $c-test.$i.in $i"
+            echo "setp $c-test.$i.bias-02 0.25"
+            echo "setp $c-test.$i.gain $((i % 3))"
+        done
+    done
+    echo "start"
+    echo "loadusr -w sleep 1"
+    echo "stop"
+    for i in 0 1 7 15; do
+        for c in soa aos; do
+            for p in out prev; do
+                echo "getp $c-test.$i.$p"
+            done
+        done
+    done
+    # one call of the soa function services all instances
+    echo "getp soa-test.tmax"
+    for i in $(seq 0 $((N-1))); do
+        echo "getp aos-test.$i.tmax"
+    done
+} > soa.hal
+
+halrun -f soa.hal > soa.out
+head -n 16 soa.out > soa.result
+
+# benchmark: worst case time of all instances, in cpu clocks
+SOA=$(sed -n 17p soa.out)
+AOS=$(tail -n $N soa.out | awk '{ s += $1 } END { print s }')
+echo "tmax soa: $SOA aos (sum of $N functs): $AOS"
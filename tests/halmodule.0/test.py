@@ -83,6 +83,13 @@ try:
 
     try_set_pin(pu, 0)
     try_set_pin(pu, -1)
+
+    h["s"] = 0; h["u"] = 0; h["f"] = 0; h["param"] = 0
+    w = hal.watch(["x.s", "x.u", "x.f", "x.param"])
+    print("watch {} {}".format(len(w), w.snapshot()))
+    print("watch {}".format(w.snapshot()))
+    h["u"] = 7; h["f"] = 0.5
+    print("watch {} {} {}".format(w.snapshot(), w.values(), memoryview(w).tolist()))
 except:
     import traceback
     print("Exception: {}".format(traceback.format_exc()))
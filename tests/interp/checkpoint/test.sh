@@ -0,0 +1,72 @@
+#!/bin/bash
+# Checkpoints for run-from-line: a run leaves them behind and a later
+# run from a line further on picks them up, the preview leaves none,
+# and probing or other probe results keep them from being used.
+export LINUXCNC_PROGRAM_CACHE=$PWD/cache
+export INI_FILE_NAME=$PWD/test.ini
+rm -rf cache
+trap 'rm -rf cache prog.ngc probe.ngc run.var run.var.bak' EXIT
+
+# 12000 lines, well over the size checkpoints are kept for; 'probe'
+# puts a probe move in the middle
+program() {
+    awk -v probe=$1 'BEGIN {
+        print "G21 G90 G17 G94 F100"
+        print "#1 = 0"
+        print "#2 = 0"
+        print "#<_total> = 0"
+        print "#<_calls> = 0"
+        print "o100 sub"
+        print "  #<_calls> = [#<_calls> + 1]"
+        print "o100 endsub"
+        for (i = 9; i < 12000; i++) {
+            if (i == 4000) print "G64 P0.05"
+            else if (i == 7000) print "G20"
+            else if (probe && i == 5500) print "G38.2 Z-1.5"
+            else if (probe && i == 5501) print "#2 = #5063"
+            else if (i % 500 == 0) print "o100 call"
+            else if (i % 10 == 0) print "#1 = [#1 + 1] #<_total> = [#<_total> + 2]"
+            else printf "G1 X%d.1234 Y%d.5678 Z-0.5 (padding the line)\n", i % 100, (i * 7) % 100
+        }
+        print "(debug, n=#1 total=#<_total> calls=#<_calls> probe=#2 metric=#<_metric>)"
+        print "M2"
+    }'
+}
+
+# runs from line $2 of $1 and prints where it started and what the
+# program found at its end
+run() {
+    rs274 -g -t /dev/null -v run.var -i test.ini -r $2 $1 2>&1 |
+        grep -o -e 'restored checkpoint at line [0-9]*' -e 'MESSAGE(.*'
+}
+
+checkpoints() {
+    ls cache 2>/dev/null | grep -c '^checkpoints-'
+}
+
+program 0 > prog.ngc
+program 1 > probe.ngc
+
+echo "preview:"
+python3 canon.py prog.ngc
+echo "checkpoints after the preview: $(checkpoints)"
+
+echo "run from the start:"
+: > run.var; run prog.ngc 0
+echo "checkpoints after the run: $(checkpoints)"
+echo "run from line 9500:"
+: > run.var; run prog.ngc 9500
+echo "run from line 800:"
+: > run.var; run prog.ngc 800
+
+echo "probing program from the start:"
+: > run.var; run probe.ngc 0
+echo "probing program from line 9500:"
+: > run.var; run probe.ngc 9500
+echo "probing program from line 9500 with another probe result:"
+printf '5063\t7.000000\n' > run.var; run probe.ngc 9500
+echo "and again:"
+printf '5063\t7.000000\n' > run.var; run probe.ngc 9500
+echo "with the first probe result again:"
+: > run.var; run probe.ngc 9500
+exit 0
@@ -0,0 +1,23 @@
+#!/usr/bin/env python3
+# parses a program the way the preview does; the M400 handler prints
+# when the program is interpreted rather than replayed from the cache
+import gcode
+import sys
+
+class Canon:
+    def __getattr__(self, attr):
+        return lambda *args: None
+
+    def get_external_length_units(self): return 1.0
+    def get_external_angular_units(self): return 1.0
+    def get_axis_mask(self): return 7 # (x y z)
+    def get_block_delete(self): return False
+    def get_tool(self, pocket):
+        return -1, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0
+
+canon = Canon()
+# the name is part of the cache key, so it must not change between runs
+canon.parameter_file = "preview.var"
+result, seq = gcode.parse(sys.argv[1], canon, '', '', '')
+if result > gcode.MIN_ERROR: raise SystemExit(gcode.strerror(result))
+print("parsed")
@@ -0,0 +1,65 @@
+#!/bin/bash
+# The preview cache: a second parse of a large program is replayed,
+# and changing a subroutine it calls, a subroutine that shadows it,
+# the remap module or the program itself makes it interpret again.
+export PYTHONUNBUFFERED=1
+export LINUXCNC_PROGRAM_CACHE=$PWD/cache
+export INI_FILE_NAME=$PWD/test.ini
+rm -rf cache python subs-a subs-b
+trap 'rm -rf cache python subs-a subs-b prog.ngc preview.var*' EXIT
+mkdir python subs-a subs-b
+: > preview.var
+
+echo "import remap" > python/toplevel.py
+remap() {
+    cat > python/remap.py <<EOT
+import interpreter
+
+def m400(self, **words):
+    print("m400 handler ran, version $1")
+    return interpreter.INTERP_OK
+EOT
+}
+sub() {
+    printf 'o<sub1> sub\n#<_from> = %s\no<sub1> endsub\n' $1 > $2/sub1.ngc
+}
+
+# 12000 lines, well over the size the cache keeps
+program() {
+    awk -v last="$1" 'BEGIN {
+        print "G21 G90 G17 G94 F100"
+        print "M400"
+        print "o<sub1> call"
+        for (i = 3; i < 12000; i++)
+            printf "G1 X%d.1234 Y%d.5678 Z-0.5 (padding the line)\n", i % 100, (i * 7) % 100
+        print last
+        print "M2"
+    }'
+}
+
+parse() {
+    echo "$1:"
+    python3 canon.py prog.ngc 2>&1
+}
+
+remap 1
+sub 1 subs-b
+# the first parse fills in the parameter file, which is part of the key
+echo M2 > prog.ngc
+python3 canon.py prog.ngc > /dev/null
+program "" > prog.ngc
+parse "first parse"
+parse "second parse"
+sub 2 subs-b
+parse "subroutine changed"
+parse "again"
+sub 3 subs-a
+parse "subroutine shadowed by one earlier in the path"
+parse "again"
+remap 2
+parse "remap module changed"
+parse "again"
+program "G0 X0" > prog.ngc
+parse "program changed"
+parse "again"
+exit 0
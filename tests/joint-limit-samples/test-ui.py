@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+
+# Runs a C move whose joint 1 speed peaks in the middle, where neither
+# end point shows it, and checks that motion kept joint 1 within its
+# MAX_VELOCITY all along.
+
+import linuxcnc
+import linuxcnc_util
+import hal
+
+import sys
+import time
+
+# joint 1 MAX_VELOCITY in test.ini, and what the samples may miss of
+# the peak between them
+max_vel = 2.0
+tolerance = 0.05
+
+retval = 0
+
+c = linuxcnc.command()
+s = linuxcnc.stat()
+e = linuxcnc.error_channel()
+l = linuxcnc_util.LinuxCNC(command=c, status=s, error=e)
+
+l.wait_for_linuxcnc_startup()
+
+c.state(linuxcnc.STATE_ESTOP_RESET)
+c.state(linuxcnc.STATE_ON)
+c.mode(linuxcnc.MODE_MANUAL)
+c.home(-1)
+l.wait_for_home([1, 1, 1, 1, 1, 0, 0, 0, 0])
+
+c.mode(linuxcnc.MODE_AUTO)
+c.wait_complete()
+c.program_open("test.ngc")
+c.auto(linuxcnc.AUTO_RUN, 0)
+started = False
+timeout = time.time() + 60
+while time.time() < timeout:
+    s.poll()
+    if s.interp_state != linuxcnc.INTERP_IDLE:
+        started = True
+    elif started:
+        break
+    time.sleep(0.01)
+else:
+    print("program did not finish")
+    retval = 1
+
+msg = e.poll()
+if msg:
+    print("error: %s" % msg[1])
+    retval = 1
+
+s.poll()
+if abs(s.position[5] - 85) > 0.001:
+    print("C ended at %f instead of 85" % s.position[5])
+    retval = 1
+
+peak = max(hal.get_value("minmax.0.max"), -hal.get_value("minmax.0.min"))
+print("joint 1 peaked at %f" % peak)
+if peak > max_vel * (1 + tolerance):
+    print("joint 1 went past its MAX_VELOCITY of %f" % max_vel)
+    retval = 1
+
+sys.exit(retval)
@@ -0,0 +1,153 @@
+#include <evring.h>
+#include <pthread.h>
+#include <assert.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+
+// several writers put records while two readers follow the ring, each
+// with its own cursor; every record must come out whole and in order,
+// or be counted as lost
+
+#define WRITERS 4
+#define READERS 2
+#define RECORDS 200000
+
+static struct evring ring;
+static volatile int writing;
+
+struct payload {
+    unsigned int writer, n;
+    unsigned char fill[64];
+};
+
+static unsigned put(unsigned int writer, unsigned int n) {
+    struct payload p;
+    unsigned len = sizeof(p) - sizeof(p.fill) + n % sizeof(p.fill);
+    p.writer = writer;
+    p.n = n;
+    memset(p.fill, (writer * 31 + n) & 0xff, sizeof(p.fill));
+    return evring_put(&ring, EVRING_TRACE, writer, &p, len) == 0;
+}
+
+static int whole(const struct evring_record *rec) {
+    struct payload p;
+    if(rec->type != EVRING_TRACE || rec->len < sizeof(p) - sizeof(p.fill))
+        return 0;
+    memcpy(&p, rec->data, rec->len);
+    if(rec->level != p.writer || p.writer >= WRITERS
+            || rec->len != sizeof(p) - sizeof(p.fill) + p.n % sizeof(p.fill))
+        return 0;
+    for(unsigned i=0; i < p.n % sizeof(p.fill); i++)
+        if(p.fill[i] != ((p.writer * 31 + p.n) & 0xff)) return 0;
+    return 1;
+}
+
+static void *writer(void *arg) {
+    unsigned int w = (unsigned int)(long)arg;
+    for(unsigned int i=0; i<RECORDS; i++) put(w, i);
+    return NULL;
+}
+
+struct result {
+    long got, torn, unordered;
+    unsigned int lost;
+};
+
+static void *reader(void *arg) {
+    struct result *res = arg;
+    struct evring_reader rd;
+    struct evring_record rec;
+    long last[WRITERS];
+    for(int w=0; w<WRITERS; w++) last[w] = -1;
+    evring_reader_init(&ring, &rd, 0);
+    for(;;) {
+        int done = __atomic_load_n(&writing, __ATOMIC_ACQUIRE) == 0;
+        if(evring_read(&ring, &rd, &rec) < 0) {
+            if(done) break;
+            sched_yield();
+            continue;
+        }
+        res->got++;
+        if(!whole(&rec)) {
+            res->torn++;
+            continue;
+        }
+        struct payload p;
+        memcpy(&p, rec.data, sizeof(unsigned int) * 2);
+        if((long)p.n <= last[p.writer]) res->unordered++;
+        last[p.writer] = p.n;
+    }
+    res->lost = rd.lost;
+    return NULL;
+}
+
+int main() {
+    struct evring_reader rd;
+    struct evring_record rec;
+    char text[100];
+    long got;
+    unsigned int last;
+
+    // messages keep their format and arguments until they are read
+    evring_init(&ring);
+    evring_reader_init(&ring, &rd, 0);
+    evring_putf(&ring, EVRING_MESSAGE, 1, "joint %d following error %.3f", 2, 0.125);
+    assert(evring_read(&ring, &rd, &rec) == 0);
+    evring_format(&rec, text, sizeof(text));
+    printf("message: type=%d level=%d \"%s\"\n", rec.type, rec.level, text);
+    assert(evring_read(&ring, &rd, &rec) < 0);
+
+    // a reader that falls a lap behind loses the oldest records
+    evring_init(&ring);
+    evring_reader_init(&ring, &rd, 0);
+    for(unsigned int i=0; i<EVRING_SLOTS + 10; i++) put(0, i);
+    assert(evring_read(&ring, &rd, &rec) == 0 && whole(&rec));
+    printf("lapped: first=%u lost=%u\n", rec.pos, rd.lost);
+    got = 1;
+    while(evring_read(&ring, &rd, &rec) == 0) got++;
+    printf("lapped: got=%ld last=%u\n", got, rec.pos);
+
+    // a second reader started with the oldest records is independent
+    evring_reader_init(&ring, &rd, 1);
+    assert(evring_read(&ring, &rd, &rec) == 0);
+    printf("oldest: first=%u lost=%u\n", rec.pos, rd.lost);
+
+    // positions wrap around without losing or repeating records
+    // the slots hold what the lap before left in them
+    evring_init(&ring);
+    ring.head = 0xffffffe0u;
+    for(unsigned int pos = ring.head - EVRING_SLOTS; pos != ring.head; pos++)
+        ring.slot[pos % EVRING_SLOTS].seq = 2 * pos + 2;
+    evring_reader_init(&ring, &rd, 0);
+    got = 0;
+    last = 0xffffffdfu;
+    for(unsigned int i=0; i<4; i++) {
+        for(unsigned int j=0; j<EVRING_SLOTS / 2; j++) put(0, i * EVRING_SLOTS + j);
+        while(evring_read(&ring, &rd, &rec) == 0) {
+            assert(whole(&rec) && rec.pos == last + 1);
+            last = rec.pos;
+            got++;
+        }
+    }
+    printf("wrap: got=%ld lost=%u last=%u\n", got, rd.lost, last);
+
+    pthread_t w[WRITERS], r[READERS];
+    struct result res[READERS];
+    memset(res, 0, sizeof(res));
+    evring_init(&ring);
+    writing = 1;
+    for(int i=0; i<READERS; i++) pthread_create(&r[i], NULL, reader, &res[i]);
+    for(long i=0; i<WRITERS; i++) pthread_create(&w[i], NULL, writer, (void*)i);
+    for(int i=0; i<WRITERS; i++) pthread_join(w[i], NULL);
+    __atomic_store_n(&writing, 0, __ATOMIC_RELEASE);
+    for(int i=0; i<READERS; i++) pthread_join(r[i], NULL);
+    for(int i=0; i<READERS; i++) {
+        printf("reader %d: torn=%ld unordered=%ld\n", i, res[i].torn, res[i].unordered);
+        assert(res[i].got + res[i].lost == WRITERS * RECORDS);
+        printf("reader %d: all records read or counted as lost\n", i);
+        assert(res[i].torn == 0 && res[i].unordered == 0);
+    }
+    printf("test passed\n");
+    return 0;
+}
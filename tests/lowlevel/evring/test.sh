@@ -0,0 +1,6 @@
+#!/bin/sh
+gcc -O -I${HEADERS} test.c -o test -DULAPI -std=gnu99 -pthread \
+    -L${LIBDIR} -Wl,-rpath,${LIBDIR} -llinuxcnctelemetry -llinuxcnchal || exit 1
+./test; exitval=$?
+rm -f test
+exit $exitval
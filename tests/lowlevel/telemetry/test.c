@@ -0,0 +1,113 @@
+#include <telemetry.h>
+#include <pthread.h>
+#include <assert.h>
+#include <sched.h>
+#include <stdio.h>
+
+// the servo thread fills samples as fast as it can while a reader
+// drains them; every sample must come out whole or be counted as lost
+
+#define SAMPLES 2000000
+
+static struct telemetry ring;
+static volatile int writing;
+
+static void put(unsigned int n) {
+    struct telemetry_sample *s = telemetry_begin(&ring);
+    s->id = s->cycle;
+    s->time = 3LL * s->cycle;
+    s->feed_scale = s->cycle * 0.5;
+    for(int j=0; j<EMCMOT_MAX_JOINTS; j++) {
+        s->joint_cmd[j] = s->cycle + j;
+        s->joint_fb[j] = s->cycle - j;
+        s->ferror[j] = 2.0 * j;
+    }
+    s->carte_cmd.tran.x = n;
+    telemetry_commit(&ring);
+}
+
+static int whole(const struct telemetry_sample *s) {
+    if(s->id != (int)s->cycle || s->time != 3LL * s->cycle
+            || s->feed_scale != s->cycle * 0.5
+            || s->carte_cmd.tran.x != s->cycle) return 0;
+    for(int j=0; j<EMCMOT_MAX_JOINTS; j++) {
+        if(s->joint_cmd[j] != (double)(s->cycle + j)
+                || s->joint_fb[j] != (double)(s->cycle - j)
+                || s->ferror[j] != 2.0 * j) return 0;
+    }
+    return 1;
+}
+
+static void *writer(void *arg) {
+    (void)arg;
+    for(unsigned int i=0; i<SAMPLES; i++) put(i);
+    __atomic_store_n(&writing, 0, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+int main() {
+    struct telemetry_reader rd;
+    struct telemetry_sample s;
+    pthread_t t;
+    long got;
+    unsigned int last;
+
+    // a reader that falls a lap behind loses the oldest samples
+    telemetry_init(&ring, EMCMOT_MAX_JOINTS, 1000000);
+    telemetry_reader_init(&ring, &rd, 0);
+    for(unsigned int i=0; i<TELEMETRY_SLOTS + 100; i++) put(i);
+    assert(telemetry_read(&ring, &rd, &s) == 0 && whole(&s));
+    printf("lapped: first=%u lost=%u\n", s.cycle, rd.lost);
+    got = 1;
+    while(telemetry_read(&ring, &rd, &s) == 0) got++;
+    printf("lapped: got=%ld last=%u\n", got, s.cycle);
+
+    // a reader started with the oldest samples gets what is still there
+    telemetry_reader_init(&ring, &rd, 1);
+    assert(telemetry_read(&ring, &rd, &s) == 0);
+    printf("oldest: first=%u lost=%u\n", s.cycle, rd.lost);
+
+    // the cycle count wraps around without losing or repeating samples
+    telemetry_init(&ring, EMCMOT_MAX_JOINTS, 1000000);
+    ring.head = 0xffffff00u;
+    telemetry_reader_init(&ring, &rd, 0);
+    for(unsigned int i=0; i<512; i++) put(0xffffff00u + i);
+    got = 0;
+    last = 0xfffffeffu;
+    while(telemetry_read(&ring, &rd, &s) == 0) {
+        assert(whole(&s) && s.cycle == last + 1);
+        last = s.cycle;
+        got++;
+    }
+    printf("wrap: got=%ld lost=%u last=%u\n", got, rd.lost, last);
+
+    telemetry_init(&ring, EMCMOT_MAX_JOINTS, 1000000);
+    telemetry_reader_init(&ring, &rd, 0);
+    writing = 1;
+    pthread_create(&t, NULL, writer, NULL);
+    long torn = 0, unordered = 0;
+    got = 0;
+    last = 0;
+    for(;;) {
+        int done = __atomic_load_n(&writing, __ATOMIC_ACQUIRE) == 0;
+        if(telemetry_read(&ring, &rd, &s) < 0) {
+            if(done) break;
+            sched_yield();
+            continue;
+        }
+        if(!whole(&s)) {
+            torn++;
+        } else if(got > 0 && s.cycle <= last) {
+            unordered++;
+        }
+        last = s.cycle;
+        got++;
+    }
+    pthread_join(t, NULL);
+    printf("concurrent: torn=%ld unordered=%ld\n", torn, unordered);
+    assert(got + rd.lost == SAMPLES);
+    printf("concurrent: all samples read or counted as lost\n");
+    assert(torn == 0 && unordered == 0);
+    printf("test passed\n");
+    return 0;
+}
@@ -0,0 +1,48 @@
+#!/usr/bin/env python3
+# Minimal Modbus TCP server for the mb2hal tests.
+# Holding registers only (fnct 03 and 16), every request is logged.
+import socketserver
+import struct
+import sys
+
+regs = [100 + i for i in range(64)]
+
+def recv_exact(sock, n):
+    data = b""
+    while len(data) < n:
+        chunk = sock.recv(n - len(data))
+        if not chunk:
+            return None
+        data += chunk
+    return data
+
+class Handler(socketserver.BaseRequestHandler):
+    def handle(self):
+        while True:
+            hdr = recv_exact(self.request, 7)
+            if hdr is None:
+                return
+            tid, pid, length, unit = struct.unpack(">HHHB", hdr)
+            pdu = recv_exact(self.request, length - 1)
+            if pdu is None:
+                return
+            fc = pdu[0]
+            if fc == 3:
+                start, count = struct.unpack(">HH", pdu[1:5])
+                log.write("03 %d %d\n" % (start, count))
+                body = struct.pack(">BB%dH" % count, 3, 2 * count, *regs[start:start + count])
+            elif fc == 16:
+                start, count, nbytes = struct.unpack(">HHB", pdu[1:6])
+                values = struct.unpack(">%dH" % count, pdu[6:6 + nbytes])
+                regs[start:start + count] = values
+                log.write("16 %d %d %s\n" % (start, count, " ".join(map(str, values))))
+                body = struct.pack(">BHH", 16, start, count)
+            else:
+                body = struct.pack(">BB", fc | 0x80, 1)
+            self.request.sendall(struct.pack(">HHHB", tid, 0, len(body) + 1, unit) + body)
+
+socketserver.TCPServer.allow_reuse_address = True
+server = socketserver.TCPServer(("127.0.0.1", int(sys.argv[1])), Handler)
+# the log file tells the test the server is listening
+log = open(sys.argv[2], "w", buffering=1)
+server.serve_forever()
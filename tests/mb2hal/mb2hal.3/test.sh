@@ -0,0 +1,14 @@
+#!/bin/bash
+
+rm -f server.log
+python3 server.py 15020 server.log &
+SERVER=$!
+trap "kill $SERVER" EXIT
+while [ ! -e server.log ]; do sleep 0.1; done
+
+halrun test.hal
+
+# TRANSACTION_00 and _01 are read by one request
+grep -q '^03 0 8$' server.log && ! grep -q '^03 [04] 4$' server.log && echo "reads coalesced"
+# one write of the initial values and one after setp
+grep '^16 ' server.log
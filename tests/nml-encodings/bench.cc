@@ -0,0 +1,162 @@
+/* Encodes and decodes NML messages with each CMS updater, checks that
+   the exact ones bring them back unchanged and prints how fast each is.
+
+   usage: bench [count] */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "rcs.hh"
+#include "cms.hh"
+#include "emc.hh"
+#include "emc_nml.hh"
+
+static const struct {
+    const char *name;
+    CMS_NEUTRAL_ENCODING_METHOD method;
+    bool exact;
+} encodings[] = {
+    { "xdr", CMS_XDR_ENCODING, true },
+    { "ascii", CMS_ASCII_ENCODING, false },
+    { "disp", CMS_DISPLAY_ASCII_ENCODING, false },
+    { "packed", CMS_PACKED_ENCODING, true },
+};
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int encode(CMS *cms, NMLmsg *msg)
+{
+    cms->set_mode(CMS_ENCODE);
+    cms->format_low_ptr = (char *) msg;
+    cms->format_high_ptr = (char *) msg + msg->size;
+    cms->rewind();
+    emcFormat(msg->type, msg, cms);
+    if (cms->status == CMS_UPDATE_ERROR || cms->status == CMS_MISC_ERROR) {
+	return -1;
+    }
+    return cms->get_encoded_msg_size();
+}
+
+static int decode(CMS *cms, NMLmsg *msg)
+{
+    cms->set_mode(CMS_DECODE);
+    cms->format_low_ptr = (char *) msg;
+    cms->format_high_ptr = (char *) msg + msg->size;
+    cms->rewind();
+    emcFormat(msg->type, msg, cms);
+    if (cms->status == CMS_UPDATE_ERROR || cms->status == CMS_MISC_ERROR) {
+	return -1;
+    }
+    return 0;
+}
+
+static void fill(EMC_STAT *stat)
+{
+    EmcPose *pos = &stat->motion.traj.position;
+    double *p = &pos->tran.x;
+    for (int i = 0; i < 9; i++) {
+	p[i] = 1.25 * i - 3.0 / 7.0;
+    }
+    stat->motion.traj.actualPosition = *pos;
+    stat->motion.traj.velocity = 12.5;
+    for (int j = 0; j < EMCMOT_MAX_JOINTS; j++) {
+	stat->motion.joint[j].output = j + 1.0 / 3.0;
+	stat->motion.joint[j].input = j - 1.0 / 3.0;
+	stat->motion.joint[j].homed = j & 1;
+    }
+    for (int k = 0; k < ACTIVE_G_CODES; k++) {
+	stat->task.activeGCodes[k] = k * 10;
+    }
+    snprintf(stat->task.file, sizeof(stat->task.file), "bench.ngc");
+    stat->task.motionLine = 4242;
+    stat->io.tool.toolInSpindle = 7;
+}
+
+static bool same(EMC_STAT *a, EMC_STAT *b)
+{
+    return !memcmp(&a->motion.traj.position, &b->motion.traj.position, sizeof(EmcPose))
+	&& !memcmp(&a->motion.traj.actualPosition, &b->motion.traj.actualPosition, sizeof(EmcPose))
+	&& a->motion.traj.velocity == b->motion.traj.velocity
+	&& a->motion.joint[EMCMOT_MAX_JOINTS - 1].output == b->motion.joint[EMCMOT_MAX_JOINTS - 1].output
+	&& a->motion.joint[EMCMOT_MAX_JOINTS - 1].input == b->motion.joint[EMCMOT_MAX_JOINTS - 1].input
+	&& a->motion.joint[1].homed == b->motion.joint[1].homed
+	&& !memcmp(a->task.activeGCodes, b->task.activeGCodes, sizeof(a->task.activeGCodes))
+	&& !strcmp(a->task.file, b->task.file)
+	&& a->task.motionLine == b->task.motionLine
+	&& a->io.tool.toolInSpindle == b->io.tool.toolInSpindle;
+}
+
+static bool same(EMC_TRAJ_LINEAR_MOVE *a, EMC_TRAJ_LINEAR_MOVE *b)
+{
+    return !memcmp(&a->end, &b->end, sizeof(EmcPose))
+	&& a->vel == b->vel && a->acc == b->acc && a->type == b->type;
+}
+
+template <class T> static bool run(const char *name, T *msg, int count)
+{
+    bool ok = true;
+
+    for (auto &e : encodings) {
+	T *copy = new T;
+	CMS *cms = new CMS(8 * msg->size + 1024);
+	cms->set_temp_updater(e.method);
+
+	int bytes = 0;
+	double t0 = now();
+	for (int i = 0; i < count && bytes >= 0; i++) {
+	    bytes = encode(cms, msg);
+	}
+	double t1 = now();
+	int status = 0;
+	for (int i = 0; i < count && status == 0; i++) {
+	    status = decode(cms, copy);
+	}
+	double t2 = now();
+
+	const char *result = "ok";
+	if (bytes < 0 || status < 0 || (e.exact && !same(msg, copy))) {
+	    result = "*fail*";
+	    ok = false;
+	} else if (!e.exact) {
+	    result = "lossy";
+	}
+	printf("%-20s %-7s %7d %7ld %12.0f %12.0f  %s\n", name, e.name,
+	       bytes, msg->size, count / (t1 - t0), count / (t2 - t1), result);
+
+	cms->restore_normal_updater();
+	delete cms;
+	delete copy;
+    }
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 2000;
+    bool ok = true;
+
+    printf("%-20s %-7s %7s %7s %12s %12s\n", "message", "coding",
+	   "bytes", "native", "encode/s", "decode/s");
+
+    EMC_STAT *stat = new EMC_STAT;
+    fill(stat);
+    ok = run("EMC_STAT", stat, count) && ok;
+
+    EMC_TRAJ_LINEAR_MOVE *move = new EMC_TRAJ_LINEAR_MOVE;
+    move->end = stat->motion.traj.position;
+    move->vel = 25.0;
+    move->ini_maxvel = 50.0;
+    move->acc = 100.0;
+    move->type = 2;
+    ok = run("EMC_TRAJ_LINEAR_MOVE", move, count * 50) && ok;
+
+    return ok ? 0 : 1;
+}
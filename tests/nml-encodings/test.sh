@@ -0,0 +1,8 @@
+#!/bin/sh
+set -e
+# liblinuxcnc.a is built without TOOL_NML by default, so is this
+g++ -O2 -DULAPI -I${HEADERS} -o bench bench.cc \
+    -L${LIBDIR} -Wl,-rpath,${LIBDIR} \
+    -llinuxcnc -lnml -ltooldata -llinuxcncini -llinuxcnchal
+./bench 200
+rm -f bench
@@ -0,0 +1,357 @@
+/* Runs the NML TCP server for one status buffer and checks it with
+   several clients at once: blocking reads that time out or get a
+   write, a polled subscription, a reader that lets its replies pile up
+   past the send queue limit and a request of unknown type.
+
+   usage: tcpsrv tcp.nml */
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "rcs.hh"
+#include "cms.hh"
+#include "emc.hh"
+#include "emc_nml.hh"
+#include "nml_srv.hh"
+#include "timer.hh"
+
+#define PORT 15765		// TCP= in tcp.nml
+#define BUFFER_NUMBER 1
+#define MAX_QUEUED (256 * 1024)	// TCPSVR_MAX_QUEUED_BYTES
+
+static const char *nmlfile;
+static bool ok = true;
+
+static void check(const char *what, bool good)
+{
+    printf("%-50s %s\n", what, good ? "ok" : "*fail*");
+    fflush(stdout);
+    ok = ok && good;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// the server may not listen yet
+static RCS_STAT_CHANNEL *open_channel(const char *process)
+{
+    for (int i = 0; i < 50; i++) {
+	RCS_STAT_CHANNEL *c =
+	    new RCS_STAT_CHANNEL(emcFormat, "stat", process, nmlfile);
+	if (c->valid()) {
+	    return c;
+	}
+	delete c;
+	esleep(0.1);
+    }
+    return NULL;
+}
+
+static int motion_line(RCS_STAT_CHANNEL *c)
+{
+    return ((EMC_STAT *) c->get_address())->task.motionLine;
+}
+
+static void publish(RCS_STAT_CHANNEL *writer, EMC_STAT *stat, int line)
+{
+    stat->task.motionLine = line;
+    writer->write(stat);
+}
+
+// time for count peeks on each of n clients
+static double peeks(RCS_STAT_CHANNEL **clients, int n, int count)
+{
+    double t0 = now();
+    for (int i = 0; i < count; i++) {
+	for (int k = 0; k < n; k++) {
+	    if (clients[k]->peek() < 0) {
+		return 1e9;
+	    }
+	}
+    }
+    return now() - t0;
+}
+
+static void putbe32(char *addr, uint32_t val)
+{
+    val = htonl(val);
+    memcpy(addr, &val, 4);
+}
+
+static uint32_t getbe32(const char *addr)
+{
+    uint32_t val;
+    memcpy(&val, addr, 4);
+    return ntohl(val);
+}
+
+static int raw_connect(int rcvbuf)
+{
+    struct sockaddr_in addr;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (rcvbuf > 0) {
+	setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+	close(fd);
+	return -1;
+    }
+    return fd;
+}
+
+// false if the server does not take it now
+static bool raw_request(int fd, int serial, int type, int access)
+{
+    char request[20];
+    putbe32(request, serial);
+    putbe32(request + 4, type);
+    putbe32(request + 8, BUFFER_NUMBER);
+    putbe32(request + 12, access);
+    putbe32(request + 16, 0);
+    return send(fd, request, sizeof(request), MSG_DONTWAIT) == sizeof(request);
+}
+
+// reads into buf until it has got bytes or timeout passed; returns
+// what it got, 0 after the server closed
+static ssize_t recv_all(int fd, char *buf, size_t bytes, double timeout)
+{
+    size_t got = 0;
+    double end = now() + timeout;
+    while (got < bytes && now() < end) {
+	struct pollfd pfd = { fd, POLLIN, 0 };
+	if (poll(&pfd, 1, 100) <= 0) {
+	    continue;
+	}
+	ssize_t n = recv(fd, buf + got, bytes - got, 0);
+	if (n <= 0) {
+	    return got > 0 ? (ssize_t) got : n;
+	}
+	got += n;
+    }
+    return got;
+}
+
+// reads the statistics the server prints on SIGUSR1
+static bool server_stats(pid_t server, int out, long *max_queued,
+			 long *blocking, long *ended)
+{
+    long timed_out, cancelled;
+    char text[4096];
+    size_t used = 0;
+    double end = now() + 5.0;
+    const char *q, *b;
+
+    kill(server, SIGUSR1);
+    while (now() < end && used < sizeof(text) - 1) {
+	struct pollfd pfd = { out, POLLIN, 0 };
+	if (poll(&pfd, 1, 100) <= 0) {
+	    continue;
+	}
+	ssize_t n = read(out, text + used, sizeof(text) - 1 - used);
+	if (n <= 0) {
+	    break;
+	}
+	used += n;
+	text[used] = 0;
+	if ((q = strstr(text, "bytes queued")) && (b = strstr(q, "cancelled"))) {
+	    break;
+	}
+    }
+    text[used] = 0;
+    q = strstr(text, "stalls on full send queues, at most ");
+    b = strstr(text, "subscription updates, ");
+    if (q == NULL || b == NULL ||
+	sscanf(q, "stalls on full send queues, at most %ld", max_queued) != 1 ||
+	sscanf(b, "subscription updates, %*d held back for slow clients.\n"
+	       "  %ld blocking reads, %ld timed out, %ld cancelled",
+	       blocking, &timed_out, &cancelled) != 3) {
+	return false;
+    }
+    // the client gives up at the same time as the server
+    *ended = timed_out + cancelled;
+    return true;
+}
+
+// a client of its own that waits in a blocking read; tells the parent
+// through ready when it is about to
+static pid_t blocking_reader(int ready, double timeout, int want_line)
+{
+    pid_t pid = fork();
+    if (pid != 0) {
+	return pid;
+    }
+    RCS_STAT_CHANNEL *c = open_channel("client");
+    if (c == NULL || c->read() != EMC_STAT_TYPE) {
+	_exit(2);
+    }
+    if (write(ready, "r", 1) != 1) {
+	_exit(2);
+    }
+    double t0 = now();
+    NMLTYPE type = c->blocking_read(timeout);
+    double waited = now() - t0;
+    if (want_line == 0) {
+	// timed out, after about the time asked for
+	_exit(type == 0 && waited > timeout * 0.8 && waited < timeout + 2.0 ? 0 : 1);
+    }
+    _exit(type == EMC_STAT_TYPE && motion_line(c) == want_line &&
+	  waited < timeout ? 0 : 1);
+}
+
+static bool exited_ok(pid_t pid)
+{
+    int status;
+    pid_t r;
+    while ((r = waitpid(pid, &status, 0)) < 0 && errno == EINTR) {
+    }
+    return r == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main(int argc, char **argv)
+{
+    const int n = 4;
+    RCS_STAT_CHANNEL *clients[n];
+    int out[2], ready[2];
+    char c;
+
+    if (argc < 2) {
+	fprintf(stderr, "usage: %s tcp.nml\n", argv[0]);
+	return 2;
+    }
+    nmlfile = argv[1];
+    signal(SIGPIPE, SIG_IGN);
+
+    RCS_STAT_CHANNEL *writer =
+	new RCS_STAT_CHANNEL(emcFormat, "stat", "writer", nmlfile);
+    if (!writer->valid()) {
+	check("open the buffer", false);
+	return 1;
+    }
+    EMC_STAT *stat = new EMC_STAT;
+    publish(writer, stat, 1);
+
+    if (pipe(out) < 0 || pipe(ready) < 0) {
+	perror("pipe");
+	return 1;
+    }
+    pid_t server = fork();
+    if (server == 0) {
+	dup2(out[1], 1);
+	setvbuf(stdout, NULL, _IOLBF, 0);
+	new RCS_STAT_CHANNEL(emcFormat, "stat", "server", nmlfile);
+	run_nml_servers();
+	_exit(1);
+    }
+
+    bool opened = true;
+    for (int k = 0; k < n; k++) {
+	clients[k] = open_channel("client");
+	opened = opened && clients[k] != NULL;
+    }
+    check("several clients connect", opened);
+    if (!opened) {
+	kill(server, SIGINT);
+	exited_ok(server);
+	return 1;
+    }
+    bool all = true;
+    for (int k = 0; k < n; k++) {
+	all = all && clients[k]->read() == EMC_STAT_TYPE && motion_line(clients[k]) == 1;
+    }
+    check("each client reads what was written", all);
+
+    // the server must go on serving the others meanwhile
+    pid_t waiting = blocking_reader(ready[1], 1.0, 0);
+    check("blocking read started", read(ready[0], &c, 1) == 1);
+    check("others served during a blocking read", peeks(clients, n, 20) < 0.8);
+    check("blocking read times out", exited_ok(waiting));
+
+    waiting = blocking_reader(ready[1], 5.0, 2);
+    check("blocking read started", read(ready[0], &c, 1) == 1);
+    esleep(0.2);
+    publish(writer, stat, 2);
+    check("blocking read gets a write", exited_ok(waiting));
+
+    RCS_STAT_CHANNEL *sub = open_channel("sub");
+    bool updated = false;
+    if (sub != NULL) {
+	sub->read();
+	publish(writer, stat, 3);
+	double end = now() + 3.0;
+	while (!updated && now() < end) {
+	    updated = sub->read() == EMC_STAT_TYPE && motion_line(sub) == 3;
+	    esleep(0.01);
+	}
+    }
+    check("subscription brings a write", updated);
+
+    // a reader with a small receive buffer that asks for far more than
+    // the server may queue for it, and reads nothing for a while
+    int requests = 0;
+    int slow = raw_connect(4096);
+    while (requests < 5000 && raw_request(slow, requests,
+	    REMOTE_CMS_READ_REQUEST_TYPE, CMS_PEEK_ACCESS)) {
+	requests++;
+    }
+    esleep(0.5);
+    check("others served while a reader is stuck", peeks(clients, n, 20) < 1.0);
+
+    long max_queued = 0, blocking = 0, ended = 0;
+    check("server prints its statistics",
+	  server_stats(server, out[0], &max_queued, &blocking, &ended));
+    check("send queue filled up", max_queued >= MAX_QUEUED);
+    check("both blocking reads counted", blocking == 2);
+    check("blocking read ended by its timeout", ended == 1);
+
+    int replies = 0;
+    char header[20];
+    char *data = (char *) malloc(sizeof(EMC_STAT) * 2);
+    while (replies < requests &&
+	   recv_all(slow, header, 20, 10.0) == 20) {
+	uint32_t size = getbe32(header + 8);
+	if (getbe32(header) != (uint32_t) replies + 1 ||
+	    size > sizeof(EMC_STAT) * 2 ||
+	    recv_all(slow, data, size, 10.0) != (ssize_t) size) {
+	    break;
+	}
+	replies++;
+    }
+    free(data);
+    close(slow);
+    check("slow reader gets every reply in order", replies == requests);
+
+    int bad = raw_connect(0);
+    raw_request(bad, 0, 12345, 0);
+    check("unknown request type closes the connection",
+	  recv_all(bad, header, sizeof(header), 5.0) == 0);
+    close(bad);
+    check("server still serves after that", peeks(clients, n, 1) < 1.0);
+
+    delete sub;
+    for (int k = 0; k < n; k++) {
+	delete clients[k];
+    }
+    kill(server, SIGINT);
+    check("server exits on SIGINT", exited_ok(server));
+    delete writer;
+    delete stat;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,7 @@
+#!/bin/sh
+set -e
+g++ -O2 -DULAPI -I${HEADERS} -o tcpsrv tcpsrv.cc \
+    -L${LIBDIR} -Wl,-rpath,${LIBDIR} \
+    -llinuxcnc -lnml -ltooldata -llinuxcncini -llinuxcnchal
+./tcpsrv tcp.nml
+rm -f tcpsrv
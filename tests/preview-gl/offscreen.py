@@ -0,0 +1,97 @@
+# An OpenGL context without a window, from Mesa's surfaceless EGL
+# platform, drawing into a small pbuffer.
+
+import ctypes
+import ctypes.util
+
+EGL_PLATFORM_SURFACELESS_MESA = 0x31DD
+EGL_SURFACE_TYPE = 0x3033
+EGL_PBUFFER_BIT = 0x0001
+EGL_RENDERABLE_TYPE = 0x3040
+EGL_OPENGL_BIT = 0x0008
+EGL_RED_SIZE = 0x3024
+EGL_WIDTH = 0x3057
+EGL_HEIGHT = 0x3056
+EGL_NONE = 0x3038
+EGL_OPENGL_API = 0x30A2
+
+GL_PROJECTION = 0x1701
+GL_MODELVIEW = 0x1700
+GL_COLOR_BUFFER_BIT = 0x4000
+GL_RGBA = 0x1908
+GL_UNSIGNED_BYTE = 0x1401
+
+def attribs(*a):
+    return (ctypes.c_int * (len(a) + 1))(*(a + (EGL_NONE,)))
+
+class Context:
+    def __init__(self, size):
+        self.size = size
+        egl = ctypes.CDLL(ctypes.util.find_library("EGL"))
+        gl = ctypes.CDLL(ctypes.util.find_library("OpenGL")
+                or ctypes.util.find_library("GL"))
+        egl.eglGetProcAddress.restype = ctypes.c_void_p
+        egl.eglGetProcAddress.argtypes = [ctypes.c_char_p]
+        for f in ("eglCreatePbufferSurface", "eglCreateContext"):
+            getattr(egl, f).restype = ctypes.c_void_p
+        egl.eglCreatePbufferSurface.argtypes = [ctypes.c_void_p] * 3
+        egl.eglCreateContext.argtypes = [ctypes.c_void_p] * 4
+        egl.eglInitialize.argtypes = [ctypes.c_void_p] * 3
+        egl.eglChooseConfig.argtypes = [ctypes.c_void_p, ctypes.c_void_p,
+                ctypes.c_void_p, ctypes.c_int, ctypes.c_void_p]
+        egl.eglMakeCurrent.argtypes = [ctypes.c_void_p] * 4
+        get_display = ctypes.CFUNCTYPE(ctypes.c_void_p, ctypes.c_int,
+                ctypes.c_void_p, ctypes.c_void_p)(
+                egl.eglGetProcAddress(b"eglGetPlatformDisplayEXT") or 0)
+        if not get_display:
+            raise RuntimeError("no eglGetPlatformDisplayEXT")
+        display = get_display(EGL_PLATFORM_SURFACELESS_MESA, None, None)
+        if not display or not egl.eglInitialize(display, None, None):
+            raise RuntimeError("no EGL display")
+        config = ctypes.c_void_p()
+        n = ctypes.c_int()
+        if not egl.eglChooseConfig(display, attribs(EGL_SURFACE_TYPE,
+                    EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                    EGL_RED_SIZE, 8), ctypes.byref(config), 1,
+                ctypes.byref(n)) or n.value < 1:
+            raise RuntimeError("no EGL config for OpenGL")
+        surface = egl.eglCreatePbufferSurface(display, config,
+                attribs(EGL_WIDTH, size, EGL_HEIGHT, size))
+        egl.eglBindAPI(EGL_OPENGL_API)
+        context = egl.eglCreateContext(display, config, None, None)
+        if not surface or not context or \
+                not egl.eglMakeCurrent(display, surface, surface, context):
+            raise RuntimeError("cannot make an EGL context current")
+        gl.glOrtho.argtypes = [ctypes.c_double] * 6
+        gl.glColor3f.argtypes = [ctypes.c_float] * 3
+        self.egl = egl
+        self.gl = gl
+
+    # shows the square from -extent to extent in x and y
+    def view(self, extent):
+        gl = self.gl
+        gl.glMatrixMode(GL_PROJECTION)
+        gl.glLoadIdentity()
+        gl.glOrtho(-extent, extent, -extent, extent, -extent, extent)
+        gl.glMatrixMode(GL_MODELVIEW)
+        gl.glLoadIdentity()
+
+    def clear(self):
+        self.gl.glClear(GL_COLOR_BUFFER_BIT)
+
+    # red bytes of the pixels, bottom row first
+    def pixels(self):
+        buf = (ctypes.c_ubyte * (4 * self.size * self.size))()
+        self.gl.glFinish()
+        self.gl.glReadPixels(0, 0, self.size, self.size, GL_RGBA,
+                GL_UNSIGNED_BYTE, buf)
+        return bytes(buf[0::4])
+
+    # pixels lit in the rectangle of columns x0..x1, rows y0..y1
+    def lit(self, x0, y0, x1, y1):
+        p = self.pixels()
+        return sum(1 for y in range(y0, y1 + 1) for x in range(x0, x1 + 1)
+                if p[y * self.size + x])
+
+    def error(self):
+        return self.gl.glGetError()
@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+
+# Draws preview lines and the live plot of the position logger into an
+# offscreen context and looks at the pixels.  The view shows -2..2 in X
+# and Y on 64 pixels, 16 pixels to the unit.
+
+import linuxcnc
+import linuxcnc_util
+
+import sys
+import threading
+import time
+
+import offscreen
+
+retval = 0
+
+def check(what, good):
+    global retval
+    print("%-50s %s" % (what, "ok" if good else "*fail*"))
+    if not good:
+        retval = 1
+
+def row(x, y):
+    return (x, y, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0)
+
+def move_to(x, y):
+    c.mdi("G0 X%f Y%f" % (x, y))
+    c.wait_complete()
+    l.wait_for_axis_to_stop_at('x', x)
+    l.wait_for_axis_to_stop_at('y', y)
+    # let the logger take the last point
+    time.sleep(0.2)
+
+gl = offscreen.Context(64)
+gl.view(2)
+
+# a line split into colinear pieces, then two more corners
+n = 37
+pieces = [(1, row(-1.5 + 3.0 * i / n, -1.5 + 1.5 * i / n),
+           row(-1.5 + 3.0 * (i + 1) / n, -1.5 + 1.5 * (i + 1) / n))
+          for i in range(n)]
+pieces += [(2, row(1.5, 0.0), row(1.7, 1.2)), (3, row(1.7, 1.2), row(0.3, 1.6))]
+gl.clear()
+linuxcnc.draw_lines("XYZ", pieces, 0, 0)
+plain = gl.pixels()
+gl.clear()
+linuxcnc.draw_lines("XYZ", pieces, 0, 1)
+merged = gl.pixels()
+check("preview lines are drawn", sum(1 for p in plain if p) > 50)
+check("merging colinear vertices looks the same",
+      sum(1 for a, b in zip(plain, merged) if bool(a) != bool(b)) <= 2)
+
+c = linuxcnc.command()
+s = linuxcnc.stat()
+e = linuxcnc.error_channel()
+l = linuxcnc_util.LinuxCNC(command=c, status=s, error=e)
+
+l.wait_for_linuxcnc_startup()
+c.state(linuxcnc.STATE_ESTOP_RESET)
+c.state(linuxcnc.STATE_ON)
+c.mode(linuxcnc.MODE_MDI)
+c.wait_complete()
+
+white = (255, 255, 255, 255)
+logger = linuxcnc.positionlogger(linuxcnc.stat(),
+        white, white, white, white, white, white, "XYZ")
+thread = threading.Thread(target=logger.start, args=(0.01,))
+thread.start()
+time.sleep(0.2)
+
+# the diagonal from 0,0 to 1,1 runs through pixels 32..48
+move_to(1, 1)
+gl.clear()
+logger.call()
+check("live plot shows the move", gl.lit(34, 34, 46, 46) > 5)
+
+# along x = 1 and y = -1, away from the diagonal
+logger.clear()
+move_to(1, -1)
+move_to(-1, -1)
+gl.clear()
+logger.call()
+check("live plot shows the moves after clearing", gl.lit(18, 14, 46, 18) > 10)
+check("cleared live plot forgets the old move", gl.lit(34, 34, 46, 46) == 0)
+
+logger.stop()
+thread.join()
+del logger
+
+# the buffer object of the old logger goes with the next draw
+logger = linuxcnc.positionlogger(linuxcnc.stat(),
+        white, white, white, white, white, white, "XYZ")
+gl.clear()
+logger.call()
+check("a new logger draws after the old one is gone", gl.error() == 0)
+
+msg = e.poll()
+if msg:
+    print("error: %s" % msg[1])
+    retval = 1
+
+sys.exit(retval)
@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+
+# The program's ten moves take 0.5 seconds each.  The interpreter reads
+# them all long before the first one is done, so the task status must
+# count ten segments and about five seconds right after the start, and
+# fewer as they run.
+
+import linuxcnc
+import linuxcnc_util
+
+import sys
+import time
+
+moves = 10
+move_time = 0.5
+# accelerations and blends that the estimate leaves out
+tolerance = 0.2
+
+retval = 0
+
+c = linuxcnc.command()
+s = linuxcnc.stat()
+e = linuxcnc.error_channel()
+l = linuxcnc_util.LinuxCNC(command=c, status=s, error=e)
+
+l.wait_for_linuxcnc_startup()
+
+c.state(linuxcnc.STATE_ESTOP_RESET)
+c.state(linuxcnc.STATE_ON)
+c.mode(linuxcnc.MODE_MANUAL)
+c.home(-1)
+l.wait_for_home([1, 1, 1, 0, 0, 0, 0, 0, 0])
+
+def check(what, good):
+    global retval
+    print("%-50s %s" % (what, "ok" if good else "*fail*"))
+    if not good:
+        retval = 1
+
+s.poll()
+check("nothing read ahead when idle",
+      s.readahead_segments == 0 and s.readahead_time == 0.0)
+
+c.mode(linuxcnc.MODE_AUTO)
+c.wait_complete()
+c.program_open("test.ngc")
+c.auto(linuxcnc.AUTO_RUN, 0)
+
+# the first move goes nowhere, so the rest is what counts
+timeout = time.time() + 5
+while time.time() < timeout:
+    s.poll()
+    if s.readahead_segments >= moves:
+        break
+    time.sleep(0.01)
+print("read ahead: %d segments, %.2f seconds" % (s.readahead_segments, s.readahead_time))
+check("whole program read ahead", s.readahead_segments >= moves)
+check("time estimated for it",
+      abs(s.readahead_time - moves * move_time) < moves * move_time * tolerance)
+
+time.sleep(2.0)
+s.poll()
+print("after 2 seconds: %d segments, %.2f seconds" % (s.readahead_segments, s.readahead_time))
+check("segments run are gone", 4 <= s.readahead_segments <= 8)
+check("so is their time",
+      abs(s.readahead_time - (moves * move_time - 2.0)) < 1.0)
+
+started = False
+timeout = time.time() + 30
+while time.time() < timeout:
+    s.poll()
+    if s.interp_state != linuxcnc.INTERP_IDLE:
+        started = True
+    elif started:
+        break
+    time.sleep(0.01)
+else:
+    check("program finishes", False)
+
+msg = e.poll()
+if msg:
+    print("error: %s" % msg[1])
+    retval = 1
+
+s.poll()
+check("program ends where it should", abs(s.position[0] - 5.0) < 0.0001)
+check("nothing left ahead at the end",
+      s.readahead_segments == 0 and s.readahead_time == 0.0)
+
+sys.exit(retval)
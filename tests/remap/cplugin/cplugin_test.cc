@@ -0,0 +1,98 @@
+// native counterparts of the Python handlers in remap-reentry
+#include <stdio.h>
+#include <math.h>
+#include "interp_cplugin.hh"
+
+static void check_coords(struct cplugin_call *call, char axis, double actual,
+			 double wanted)
+{
+    char msg[80];
+
+    if (fabs(actual - wanted) > 0.000001) {
+	snprintf(msg, sizeof(msg), "ERROR  %c:  %0.1f != %0.1f", axis, actual, wanted);
+    } else {
+	snprintf(msg, sizeof(msg), "%c: %0.1f = %0.1f", axis, actual, wanted);
+    }
+    call->ops->COMMENT(msg);
+}
+
+static double position(struct cplugin_call *call, char axis)
+{
+    switch (axis) {
+    case 'x': return call->settings->current_x;
+    case 'y': return call->settings->current_y;
+    default: return call->settings->current_z;
+    }
+}
+
+// moves 'axis' to 1, 2 and 3, waiting for each move to finish and
+// checking where it ended up
+static int three_moves(struct cplugin_call *call, const char *name, char axis)
+{
+    char line[80];
+    int step = call->resumed;
+
+    if (step == 0) {
+	snprintf(line, sizeof(line), "(%s begin)", name);
+	call->ops->execute(call, line);
+    } else {
+	check_coords(call, axis, position(call, axis), step);
+	call->state[0]++;
+    }
+    if (step < 3) {
+	snprintf(line, sizeof(line), "G0 %c%d", axis, step + 1);
+	call->ops->execute(call, line);
+	return INTERP_EXECUTE_FINISH;
+    }
+    snprintf(line, sizeof(line), "(%s end)", name);
+    call->ops->execute(call, line);
+    return INTERP_OK;
+}
+
+extern "C" int body_405(struct cplugin_call *call)
+{
+    double p;
+    char msg[80];
+
+    if (call->resumed == 0) {
+	if (call->ops->get_param(call, "p", &p) != INTERP_OK) {
+	    return INTERP_ERROR;
+	}
+	snprintf(msg, sizeof(msg), "body_M405 p=%0.1f", p);
+	call->ops->COMMENT(msg);
+    }
+    return three_moves(call, "body_M405", 'y');
+}
+
+extern "C" int prolog_406(struct cplugin_call *call)
+{
+    return three_moves(call, "prolog_M406", 'x');
+}
+
+extern "C" int epilog_406(struct cplugin_call *call)
+{
+    char msg[80];
+
+    if (call->resumed == 0) {
+	// the state outlives the prolog and the ngc body
+	snprintf(msg, sizeof(msg), "epilog_M406 after %0.0f prolog moves",
+		 call->state[0]);
+	call->ops->COMMENT(msg);
+    }
+    return three_moves(call, "epilog_M406", 'z');
+}
+
+// yields before it has done anything, like a handler waiting for an
+// input; only the body runs, there is no ngc to fall back to
+extern "C" int body_407(struct cplugin_call *call)
+{
+    char msg[80];
+
+    if (call->resumed < 2) {
+	snprintf(msg, sizeof(msg), "body_M407 waiting, call %d", call->resumed + 1);
+	call->ops->COMMENT(msg);
+	return INTERP_EXECUTE_FINISH;
+    }
+    call->ops->COMMENT("body_M407 done");
+    return INTERP_OK;
+}
@@ -0,0 +1,8 @@
+#!/bin/bash -e
+${CXX:-g++} -shared -fPIC -I$HEADERS -o libcplugin_test.so cplugin_test.cc
+# ./libcplugin_test.so in test.ini is relative to the INI file, not to
+# where the interpreter runs
+mkdir -p run
+cd run
+rs274 -g -i ../test.ini ../test.ngc | awk '{$1=""; print}'
+exit ${PIPESTATUS[0]}
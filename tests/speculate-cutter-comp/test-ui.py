@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+
+# Reads ahead past an input wait into a branch with cutter compensation
+# that has to be rolled back.  Moves compensation queued while reading
+# ahead must not survive into the branch that really runs.
+
+import linuxcnc
+import linuxcnc_util
+import hal
+
+import subprocess
+import sys
+import time
+
+retval = 0
+
+c = linuxcnc.command()
+s = linuxcnc.stat()
+e = linuxcnc.error_channel()
+l = linuxcnc_util.LinuxCNC(command=c, status=s, error=e)
+
+h = hal.component("test-ui")
+h.newpin("din", hal.HAL_BIT, hal.HAL_OUT)
+h.ready()
+h['din'] = 1
+
+l.wait_for_linuxcnc_startup()
+subprocess.check_call(["halcmd", "net", "din", "test-ui.din", "motion.digital-in-00"])
+
+c.state(linuxcnc.STATE_ESTOP_RESET)
+c.state(linuxcnc.STATE_ON)
+c.mode(linuxcnc.MODE_AUTO)
+c.wait_complete()
+c.program_open("test.ngc")
+c.auto(linuxcnc.AUTO_RUN, 0)
+
+min_x = 0.0
+max_x = 0.0
+started = False
+timeout = time.time() + 30
+while time.time() < timeout:
+    s.poll()
+    min_x = min(min_x, s.position[0])
+    max_x = max(max_x, s.position[0])
+    if s.interp_state != linuxcnc.INTERP_IDLE:
+        started = True
+    elif started:
+        break
+    msg = e.poll()
+    if msg:
+        print("error: %s" % msg[1])
+        retval = 1
+    time.sleep(0.001)
+else:
+    print("program did not finish")
+    retval = 1
+
+if min_x < -0.5:
+    print("ran the branch read ahead, x went to %f" % min_x)
+    retval = 1
+if max_x < 0.9:
+    print("did not run the branch for the real input, x only got to %f" % max_x)
+    retval = 1
+if abs(s.position[0]) > 0.0001 or abs(s.position[1]) > 0.0001:
+    print("ended at %f %f instead of 0 0" % (s.position[0], s.position[1]))
+    retval = 1
+
+sys.exit(retval)
@@ -63,10 +63,49 @@ TEST pmCartCartAntiParallel_numerical() {
     PASS();
 }
 
+TEST findJerkStopVel_roundtrip() {
+    const double a_max = 100.0;
+    const double j_max = 1000.0;
+    // Short stops never reach a_max, long ones cruise at a_max for a while
+    const double distances[] = {1e-4, 0.01, 0.5, 1.0, 10.0, 500.0};
+
+    for (unsigned i = 0; i < sizeof(distances) / sizeof(distances[0]); ++i) {
+        double v = findJerkStopVel(a_max, j_max, distances[i]);
+        ASSERT(v > 0.0);
+        ASSERT_IN_RANGE(distances[i],
+                findJerkStopDistance(v, 0.0, 0.0, a_max, j_max),
+                1e-9 * fmax(distances[i], 1.0));
+    }
+
+    ASSERT_EQ(0.0, findJerkStopVel(a_max, j_max, 0.0));
+    ASSERT_EQ(0.0, findJerkStopVel(a_max, j_max, -1.0));
+    PASS();
+}
+
+TEST findJerkStopDistance_accel() {
+    const double a_max = 100.0;
+    const double j_max = 1000.0;
+    double d_rest = findJerkStopDistance(10.0, 0.0, 0.0, a_max, j_max);
+
+    // Still accelerating takes longer, already braking is quicker
+    ASSERT(findJerkStopDistance(10.0, 50.0, 0.0, a_max, j_max) > d_rest);
+    ASSERT(findJerkStopDistance(10.0, -50.0, 0.0, a_max, j_max) < d_rest);
+
+    // Nothing to do at the final velocity with zero acceleration
+    ASSERT_EQ(0.0, findJerkStopDistance(5.0, 0.0, 5.0, a_max, j_max));
+
+    // Symmetric S-curve from 10 to 5: two ramps of sqrt(dv / j) each, at
+    // the average velocity
+    ASSERT_IN_RANGE(7.5 * 2.0 * sqrt(5.0 / j_max),
+            findJerkStopDistance(10.0, 0.0, 5.0, a_max, j_max), 1e-9);
+    PASS();
+}
 
  SUITE(blendmath) {
      RUN_TEST(pmCartCartParallel_numerical);
      RUN_TEST(pmCartCartAntiParallel_numerical);
+     RUN_TEST(findJerkStopVel_roundtrip);
+     RUN_TEST(findJerkStopDistance_accel);
 
  }
 
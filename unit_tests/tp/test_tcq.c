@@ -0,0 +1,161 @@
+#include "greatest.h"
+#include "tcq.h"
+#include "tc_types.h"
+#include "rtapi.h"
+
+GREATEST_MAIN_DEFS();
+
+#define QUEUE_SIZE 300
+#define DIO_SIZE 40
+
+static TC_STRUCT space[QUEUE_SIZE];
+static syncdio_t pool[DIO_SIZE];
+static TC_QUEUE_STRUCT tcq;
+
+// a line of the given length, with outputs to set when dio is set
+static TC_STRUCT make_tc(int id, double target, double reqvel, syncdio_t *dio)
+{
+    TC_STRUCT tc;
+    memset(&tc, 0, sizeof(tc));
+    tc.id = id;
+    tc.target = target;
+    tc.reqvel = reqvel;
+    tc.syncdio = dio;
+    return tc;
+}
+
+static void setup(void *arg)
+{
+    (void)arg;
+    tcqCreate(&tcq, QUEUE_SIZE, space, DIO_SIZE, pool);
+}
+
+TEST tcqCreate_rejects_small_pool() {
+    TC_QUEUE_STRUCT q;
+    ASSERT_EQ(-1, tcqCreate(&q, QUEUE_SIZE, space, DIO_SIZE - 1, pool));
+    ASSERT_EQ(DIO_SIZE, tcqDioSize(10));
+    ASSERT_EQ(1000, tcqDioSize(4000));
+    PASS();
+}
+
+TEST tcqPut_copies_dio_into_pool() {
+    syncdio_t dio;
+    memset(&dio, 0, sizeof(dio));
+    dio.anychanged = 1;
+    dio.dios[3] = 1;
+
+    TC_STRUCT tc = make_tc(1, 1.0, 1.0, &dio);
+    ASSERT_EQ(0, tcqPut(&tcq, &tc));
+    TC_STRUCT *queued = tcqItem(&tcq, 0);
+    ASSERT(queued->syncdio != NULL);
+    ASSERT(queued->syncdio != &dio);
+    ASSERT(queued->syncdio >= pool && queued->syncdio < pool + DIO_SIZE);
+    ASSERT_EQ(1, queued->syncdio->dios[3]);
+    ASSERT_EQ(1, tcq.dioUsed);
+
+    // nothing to write takes no entry
+    dio.anychanged = 0;
+    tc = make_tc(2, 1.0, 1.0, &dio);
+    ASSERT_EQ(0, tcqPut(&tcq, &tc));
+    ASSERT_EQ(NULL, tcqItem(&tcq, 1)->syncdio);
+    ASSERT_EQ(1, tcq.dioUsed);
+
+    tcqReleaseDio(&tcq, queued);
+    ASSERT_EQ(NULL, queued->syncdio);
+    ASSERT_EQ(0, tcq.dioUsed);
+    PASS();
+}
+
+TEST tcq_pool_exhaustion() {
+    syncdio_t dio;
+    memset(&dio, 0, sizeof(dio));
+    dio.anychanged = 1;
+    int i;
+
+    // full for the planner once only the margin is left, far from the
+    // queue's own margin
+    for (i = 0; i < DIO_SIZE / 2; i++) {
+        ASSERT_FALSE(tcqFull(&tcq));
+        TC_STRUCT tc = make_tc(i, 1.0, 1.0, &dio);
+        ASSERT_EQ(0, tcqPut(&tcq, &tc));
+    }
+    ASSERT(tcqFull(&tcq));
+
+    // the margin still takes what was already on its way
+    for (; i < DIO_SIZE; i++) {
+        TC_STRUCT tc = make_tc(i, 1.0, 1.0, &dio);
+        ASSERT_EQ(0, tcqPut(&tcq, &tc));
+    }
+    ASSERT_EQ(DIO_SIZE, tcq.dioUsed);
+
+    // an empty pool refuses a move with IO and leaves the queue alone
+    TC_STRUCT tc = make_tc(i, 1.0, 1.0, &dio);
+    ASSERT_EQ(-1, tcqPut(&tcq, &tc));
+    ASSERT_EQ(DIO_SIZE, tcqLen(&tcq));
+    ASSERT_IN_RANGE(DIO_SIZE, tcqTime(&tcq), 1e-9);
+
+    // but not one without
+    tc = make_tc(i, 1.0, 1.0, NULL);
+    ASSERT_EQ(0, tcqPut(&tcq, &tc));
+    ASSERT_EQ(DIO_SIZE + 1, tcqLen(&tcq));
+    tcqPopBack(&tcq);
+
+    // every way off the queue gives the entry back
+    ASSERT_EQ(0, tcqRemove(&tcq, 5));
+    ASSERT_EQ(0, tcqPop(&tcq));
+    ASSERT_EQ(0, tcqPopBack(&tcq));
+    ASSERT_EQ(DIO_SIZE - 7, tcq.dioUsed);
+    ASSERT_EQ(DIO_SIZE - 7, tcqLen(&tcq));
+
+    // entries freed anywhere in the pool are found again
+    for (i = 0; i < 7; i++) {
+        tc = make_tc(100 + i, 1.0, 1.0, &dio);
+        ASSERT_EQ(0, tcqPut(&tcq, &tc));
+    }
+    ASSERT_EQ(DIO_SIZE, tcq.dioUsed);
+    for (i = 0; i < DIO_SIZE; i++) {
+        int k;
+        for (k = i + 1; k < DIO_SIZE; k++) {
+            ASSERT(tcqItem(&tcq, i)->syncdio != tcqItem(&tcq, k)->syncdio);
+        }
+    }
+
+    // and an abort empties it
+    tcqInit(&tcq);
+    ASSERT_EQ(0, tcq.dioUsed);
+    ASSERT_FALSE(tcqFull(&tcq));
+    PASS();
+}
+
+TEST tcqTime_sums_queued_moves() {
+    TC_STRUCT tc = make_tc(1, 2.0, 4.0, NULL);
+    ASSERT_EQ(0, tcqPut(&tcq, &tc));
+    tc = make_tc(2, 3.0, 1.0, NULL);
+    ASSERT_EQ(0, tcqPut(&tcq, &tc));
+    // a move without a velocity adds nothing
+    tc = make_tc(3, 3.0, 0.0, NULL);
+    ASSERT_EQ(0, tcqPut(&tcq, &tc));
+    ASSERT_IN_RANGE(3.5, tcqTime(&tcq), 1e-9);
+
+    ASSERT_EQ(0, tcqPop(&tcq));
+    ASSERT_IN_RANGE(3.0, tcqTime(&tcq), 1e-9);
+    ASSERT_EQ(0, tcqBackStep(&tcq));
+    ASSERT_IN_RANGE(3.5, tcqTime(&tcq), 1e-9);
+    ASSERT_EQ(0, tcqRemove(&tcq, 3));
+    ASSERT_EQ(0.0, tcqTime(&tcq));
+    PASS();
+}
+
+SUITE(queue) {
+    SET_SETUP(setup, NULL);
+    RUN_TEST(tcqCreate_rejects_small_pool);
+    RUN_TEST(tcqPut_copies_dio_into_pool);
+    RUN_TEST(tcq_pool_exhaustion);
+    RUN_TEST(tcqTime_sums_queued_moves);
+}
+
+int main(int argc, char **argv) {
+    GREATEST_MAIN_BEGIN();
+    RUN_SUITE(queue);
+    GREATEST_MAIN_END();
+}